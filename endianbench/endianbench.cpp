@@ -0,0 +1,236 @@
+#include <TiffEndian.hpp>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace TiffWang::Tiff;
+
+/// <summary>
+/// The number of IFD entries in the synthetic directory, and the default number of passes over it.
+/// </summary>
+static constexpr size_t EntryCount	= 4096;
+static constexpr size_t DefaultPasses	= 2000;
+
+/// <summary>
+/// The runtime-endian reader libtiffwang used before TiffEndian: a table of std::function lambdas, selected once by
+/// the byte order of the file, that each read the next integer from a cursor and swap it into host byte order.
+/// </summary>
+struct RuntimeEndianReader {
+	std::function<uint16_t()>	Uint16;
+	std::function<uint32_t()>	Uint32;
+};
+
+/// <summary>
+/// A cursor over a directory in memory, read one integer at a time.
+/// </summary>
+class MemoryCursor {
+	private:
+		const uint8_t*	m_Data;
+		size_t			m_Offset = 0;
+
+	public:
+		MemoryCursor(const uint8_t* data) : m_Data(data) { }
+
+		template <typename T>
+		T Read() noexcept {
+			T value;
+			memcpy(&value, m_Data + m_Offset, sizeof(value));
+			m_Offset += sizeof(value);
+			return value;
+		}
+
+		void Rewind() noexcept {
+			m_Offset = 0;
+		}
+};
+
+/// <summary>
+/// A cursor over a directory in a stream, read one integer at a time like TiffFile used to read from its ifstream.
+/// </summary>
+class StreamCursor {
+	private:
+		std::istringstream	m_Stream;
+
+	public:
+		StreamCursor(const std::vector<uint8_t>& data) : m_Stream(std::string(data.begin(), data.end()), std::ios::binary) { }
+
+		template <typename T>
+		T Read() {
+			T value;
+			m_Stream.read(reinterpret_cast<char*>(&value), sizeof(value));
+			return value;
+		}
+
+		void Rewind() {
+			m_Stream.clear();
+			m_Stream.seekg(0);
+		}
+};
+
+/// <summary>
+/// Build the runtime-endian reader for a byte order over a cursor, the way TiffFile::Init used to.
+/// </summary>
+/// <param name="order">The byte order of the data.</param>
+/// <param name="cursor">The cursor the reader reads from.</param>
+/// <returns>The reader.</returns>
+template <typename TCursor>
+RuntimeEndianReader make_runtime_reader(TiffByteOrder order, TCursor& cursor) {
+	if (order == TiffByteOrder::Intel) {
+		return {
+			[&]() { return static_cast<uint16_t>(le_to_host_ushort(cursor.template Read<uint16_t>())); },
+			[&]() { return static_cast<uint32_t>(le_to_host_ulong(cursor.template Read<uint32_t>())); }
+		};
+	}
+
+	return {
+		[&]() { return static_cast<uint16_t>(be_to_host_ushort(cursor.template Read<uint16_t>())); },
+		[&]() { return static_cast<uint32_t>(be_to_host_ulong(cursor.template Read<uint32_t>())); }
+	};
+}
+
+/// <summary>
+/// Build a directory of 12-byte IFD entries (tag, type, count and value) in a byte order.
+/// </summary>
+/// <param name="order">The byte order to encode the entries in.</param>
+/// <returns>The encoded entries.</returns>
+std::vector<uint8_t> make_directory(TiffByteOrder order) {
+	std::vector<uint8_t> data(EntryCount * 12);
+	uint32_t seed = 0x2545f491u;
+
+	auto put = [&](uint8_t* target, uint64_t value, size_t size) {
+		for (size_t i = 0; i < size; ++i) {
+			auto shift = 8 * (order == TiffByteOrder::Intel ? i : size - 1 - i);
+			target[i]  = static_cast<uint8_t>(value >> shift);
+		}
+	};
+
+	for (size_t i = 0; i < EntryCount; ++i) {
+		seed ^= seed << 13;
+		seed ^= seed >> 17;
+		seed ^= seed << 5;
+
+		auto entry = data.data() + i * 12;
+		put(entry + 0, 0x0100 + (seed & 0xff), 2);
+		put(entry + 2, 1 + (seed >> 8) % 12, 2);
+		put(entry + 4, seed >> 12, 4);
+		put(entry + 8, seed, 4);
+	}
+
+	return data;
+}
+
+/// <summary>
+/// Decode every entry of the directory with the runtime-endian reader.
+/// </summary>
+/// <param name="reader">The reader.</param>
+/// <param name="rewind">Moves the cursor of the reader back to the first entry.</param>
+/// <returns>A checksum over the decoded values.</returns>
+uint64_t decode_runtime(const RuntimeEndianReader& reader, const std::function<void()>& rewind) {
+	uint64_t sum = 0;
+	rewind();
+
+	for (size_t i = 0; i < EntryCount; ++i) {
+		sum += reader.Uint16();
+		sum += reader.Uint16();
+		sum += reader.Uint32();
+		sum += reader.Uint32();
+	}
+
+	return sum;
+}
+
+/// <summary>
+/// Decode every entry of the directory with the compile-time reader, straight from the raw bytes.
+/// </summary>
+/// <param name="data">The encoded entries.</param>
+/// <returns>A checksum over the decoded values.</returns>
+template <typename TEndian>
+uint64_t decode_compile_time(const uint8_t* data) {
+	uint64_t sum = 0;
+
+	for (size_t i = 0; i < EntryCount; ++i, data += 12) {
+		sum += TEndian::Uint16(data + 0);
+		sum += TEndian::Uint16(data + 2);
+		sum += TEndian::Uint32(data + 4);
+		sum += TEndian::Uint32(data + 8);
+	}
+
+	return sum;
+}
+
+/// <summary>
+/// Time a number of passes of a decoder and print the time per entry.
+/// </summary>
+/// <param name="name">The name of the reader.</param>
+/// <param name="passes">The number of passes over the directory.</param>
+/// <param name="decode">Decodes the directory once and returns its checksum.</param>
+/// <returns>The checksum of the last pass.</returns>
+uint64_t run(const char* name, size_t passes, const std::function<uint64_t()>& decode) {
+	// One untimed pass, so that the first timed pass does not pay for cold caches.
+	auto checksum = decode();
+	auto sink	  = static_cast<uint64_t>(0);
+	auto start	  = std::chrono::steady_clock::now();
+
+	for (size_t pass = 0; pass < passes; ++pass)
+		sink += decode();
+
+	auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+	printf("  %-24s %8.2f ns/entry  (checksum %016llx)\n", name, elapsed / (static_cast<double>(passes) * EntryCount),
+		static_cast<unsigned long long>(checksum));
+
+	// Every pass must decode the same values, this also keeps the compiler from dropping the timed passes.
+	if (sink != checksum * passes)
+		printf("  error: the passes of %s decoded different values\n", name);
+
+	return checksum;
+}
+
+/// <summary>
+/// Compare the runtime-endian reader with the compile-time reader on a directory in one byte order.
+/// </summary>
+/// <param name="order">The byte order of the directory.</param>
+/// <param name="passes">The number of passes over the directory.</param>
+/// <returns>True when every reader decoded the same values.</returns>
+template <typename TEndian>
+bool compare(TiffByteOrder order, size_t passes) {
+	auto data = make_directory(order);
+
+	MemoryCursor memory(data.data());
+	StreamCursor stream(data);
+	auto memoryReader = make_runtime_reader(order, memory);
+	auto streamReader = make_runtime_reader(order, stream);
+
+	printf("%s, %zu entries, %zu passes\n", order == TiffByteOrder::Intel ? "II (little endian)" : "MM (big endian)", EntryCount, passes);
+
+	auto a = run("std::function, istream", passes, [&]() { return decode_runtime(streamReader, [&]() { stream.Rewind(); }); });
+	auto b = run("std::function, memory", passes, [&]() { return decode_runtime(memoryReader, [&]() { memory.Rewind(); }); });
+	auto c = run("TiffEndian, memory", passes, [&]() { return decode_compile_time<TEndian>(data.data()); });
+
+	if (a != c || b != c) {
+		printf("  error: the readers decoded different values\n");
+		return false;
+	}
+
+	return true;
+}
+
+/// <summary>
+/// Benchmark entry point, the optional argument is the number of passes over each directory.
+/// </summary>
+/// <param name="argc">Program argument count.</param>
+/// <param name="argv">Program arguments.</param>
+/// <returns>Status code, nonzero when the readers disagree.</returns>
+int main(int argc, char* argv[]) {
+	auto passes = (argc > 1) ? static_cast<size_t>(std::stoull(argv[1])) : DefaultPasses;
+	if (passes == 0)
+		passes = 1;
+
+	auto intel	  = compare<TiffIntelEndian>(TiffByteOrder::Intel, passes);
+	auto motorola = compare<TiffMotorolaEndian>(TiffByteOrder::Motorola, passes);
+
+	return (intel && motorola) ? 0 : 1;
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+#include "pch.h"
+
+#ifndef byte_view_h
+#define byte_view_h
+
+	namespace TiffWang {
+		namespace Tiff {
+			/// <summary>
+			/// ByteView is a lightweight, non-owning and bounds-checked view over a contiguous range of bytes,
+			/// similar to a std::span&lt;const uint8_t&gt;. It is used to hand out tag values directly from a
+			/// memory mapped file without copying them. The view is only valid as long as the memory it refers
+			/// to is alive, i.e. as long as the <see cref="TiffFile"/> or <see cref="MappedFile"/> it was obtained from.
+			/// </summary>
+			class ByteView {
+				private:
+					const uint8_t*	m_Data = nullptr;
+					size_t			m_Size = 0;
+
+				public:
+					/// <summary>
+					/// Construct a new, empty view.
+					/// </summary>
+					constexpr ByteView() noexcept = default;
+
+					/// <summary>
+					/// Construct a new view over <paramref name="size"/> bytes, starting at <paramref name="data"/>.
+					/// </summary>
+					/// <param name="data">The first byte in the view.</param>
+					/// <param name="size">The number of bytes in the view.</param>
+					constexpr ByteView(const uint8_t* data, size_t size) noexcept
+						: m_Data(data), m_Size(size) {
+
+					}
+
+					/// <summary>
+					/// Construct a new view over the contents of a vector of bytes.
+					/// </summary>
+					/// <param name="data">The vector to view, the view is invalidated when this vector is resized or destroyed.</param>
+					ByteView(const std::vector<uint8_t>& data) noexcept
+						: m_Data(data.data()), m_Size(data.size()) {
+
+					}
+
+					/// <summary>
+					/// Get a pointer to the first byte in the view.
+					/// </summary>
+					/// <returns>The pointer, which is nullptr for an empty default constructed view.</returns>
+					constexpr const uint8_t* Data() const noexcept {
+						return m_Data;
+					}
+
+					/// <summary>
+					/// Get the number of bytes in this view.
+					/// </summary>
+					/// <returns>The size in bytes.</returns>
+					constexpr size_t Size() const noexcept {
+						return m_Size;
+					}
+
+					/// <summary>
+					/// Determines if this view contains no bytes.
+					/// </summary>
+					/// <returns>True when <see cref="Size"/>() == 0.</returns>
+					constexpr bool Empty() const noexcept {
+						return m_Size == 0;
+					}
+
+					/// <summary>
+					/// Get a byte at a specific index in the view.
+					/// </summary>
+					/// <param name="index">The index of the byte.</param>
+					/// <returns>The byte value.</returns>
+					/// <exception cref="std::out_of_range">When <paramref name="index"/> is out of range.</exception>
+					uint8_t At(size_t index) const {
+						if (index >= m_Size)
+							throw std::out_of_range("byte view index is out of range");
+						return m_Data[index];
+					}
+
+					/// <summary>
+					/// Get a byte at a specific index in the view, without bounds checking.
+					/// </summary>
+					/// <param name="index">The index of the byte.</param>
+					/// <returns>The byte value.</returns>
+					constexpr uint8_t operator[](size_t index) const noexcept {
+						return m_Data[index];
+					}
+
+					/// <summary>
+					/// Get a view on a part of this view.
+					/// </summary>
+					/// <param name="offset">The offset, relative to the start of this view.</param>
+					/// <param name="count">The number of bytes in the resulting view.</param>
+					/// <returns>The new view.</returns>
+					/// <exception cref="std::out_of_range">When the requested range does not fit in this view.</exception>
+					ByteView SubView(size_t offset, size_t count) const {
+						if (offset > m_Size || count > m_Size - offset)
+							throw std::out_of_range("byte view range is out of range");
+						return ByteView(m_Data + offset, count);
+					}
+
+					/// <summary>
+					/// Get a view on a part of this view, from an offset up to the end.
+					/// </summary>
+					/// <param name="offset">The offset, relative to the start of this view.</param>
+					/// <returns>The new view.</returns>
+					/// <exception cref="std::out_of_range">When <paramref name="offset"/> is beyond the end of this view.</exception>
+					ByteView SubView(size_t offset) const {
+						if (offset > m_Size)
+							throw std::out_of_range("byte view offset is out of range");
+						return ByteView(m_Data + offset, m_Size - offset);
+					}
+
+					constexpr const uint8_t* begin() const noexcept { return m_Data; }
+					constexpr const uint8_t* end() const noexcept { return m_Data + m_Size; }
+			};
+		}
+	}
+
+#endif
@@ -0,0 +1,565 @@
+#include "pch.h"
+#include "CcittDecoder.hpp"
+
+using namespace TiffWang::Tiff;
+
+namespace {
+	/// <summary>
+	/// A single code in the ITU-T T.4 code tables, the bits are written out as a string of '0' and '1' characters.
+	/// </summary>
+	struct CcittCode {
+		const char* Bits;
+		int16_t		Value;
+	};
+
+	/// <summary>
+	/// A single entry in a decoding lookup table.
+	/// </summary>
+	struct CcittLookup {
+		int16_t		Value  = -1;	// The run length or mode, negative values are special codes.
+		uint8_t		Length = 0;		// The length of the code in bits.
+	};
+
+	constexpr int16_t  CodeInvalid    = -1;		// The bits do not form a valid code.
+	constexpr int16_t  CodeEndOfLine  = -2;		// EOL, 000000000001.
+	constexpr int16_t  CodeExtension  = -3;		// 2D extension code, i.e. uncompressed mode.
+
+	constexpr uint32_t WhiteLookupBits = 12;		// The longest white code, including EOL.
+	constexpr uint32_t BlackLookupBits = 13;		// The longest black code.
+	constexpr uint32_t ModeLookupBits  = 7;		// The longest 2D mode code.
+
+	/// <summary>
+	/// The two-dimensional coding modes.
+	/// </summary>
+	enum CcittMode : int16_t {
+		ModePass,
+		ModeHorizontal,
+		ModeVertical0,
+		ModeVerticalR1,
+		ModeVerticalR2,
+		ModeVerticalR3,
+		ModeVerticalL1,
+		ModeVerticalL2,
+		ModeVerticalL3
+	};
+
+	/// <summary>
+	/// Extended makeup codes, shared by white and black runs.
+	/// </summary>
+	constexpr CcittCode ExtendedMakeupCodes[] = {
+		{ "00000001000", 1792 }, { "00000001100", 1856 }, { "00000001101", 1920 }, { "000000010010", 1984 },
+		{ "000000010011", 2048 }, { "000000010100", 2112 }, { "000000010101", 2176 }, { "000000010110", 2240 },
+		{ "000000010111", 2304 }, { "000000011100", 2368 }, { "000000011101", 2432 }, { "000000011110", 2496 },
+		{ "000000011111", 2560 }, { "000000000001", CodeEndOfLine }
+	};
+
+	/// <summary>
+	/// White terminating and makeup codes.
+	/// </summary>
+	constexpr CcittCode WhiteCodes[] = {
+		{ "00110101", 0 }, { "000111", 1 }, { "0111", 2 }, { "1000", 3 }, { "1011", 4 }, { "1100", 5 }, { "1110", 6 },
+		{ "1111", 7 }, { "10011", 8 }, { "10100", 9 }, { "00111", 10 }, { "01000", 11 }, { "001000", 12 }, { "000011", 13 },
+		{ "110100", 14 }, { "110101", 15 }, { "101010", 16 }, { "101011", 17 }, { "0100111", 18 }, { "0001100", 19 },
+		{ "0001000", 20 }, { "0010111", 21 }, { "0000011", 22 }, { "0000100", 23 }, { "0101000", 24 }, { "0101011", 25 },
+		{ "0010011", 26 }, { "0100100", 27 }, { "0011000", 28 }, { "00000010", 29 }, { "00000011", 30 }, { "00011010", 31 },
+		{ "00011011", 32 }, { "00010010", 33 }, { "00010011", 34 }, { "00010100", 35 }, { "00010101", 36 }, { "00010110", 37 },
+		{ "00010111", 38 }, { "00101000", 39 }, { "00101001", 40 }, { "00101010", 41 }, { "00101011", 42 }, { "00101100", 43 },
+		{ "00101101", 44 }, { "00000100", 45 }, { "00000101", 46 }, { "00001010", 47 }, { "00001011", 48 }, { "01010010", 49 },
+		{ "01010011", 50 }, { "01010100", 51 }, { "01010101", 52 }, { "00100100", 53 }, { "00100101", 54 }, { "01011000", 55 },
+		{ "01011001", 56 }, { "01011010", 57 }, { "01011011", 58 }, { "01001010", 59 }, { "01001011", 60 }, { "00110010", 61 },
+		{ "00110011", 62 }, { "00110100", 63 },
+
+		{ "11011", 64 }, { "10010", 128 }, { "010111", 192 }, { "0110111", 256 }, { "00110110", 320 }, { "00110111", 384 },
+		{ "01100100", 448 }, { "01100101", 512 }, { "01101000", 576 }, { "01100111", 640 }, { "011001100", 704 },
+		{ "011001101", 768 }, { "011010010", 832 }, { "011010011", 896 }, { "011010100", 960 }, { "011010101", 1024 },
+		{ "011010110", 1088 }, { "011010111", 1152 }, { "011011000", 1216 }, { "011011001", 1280 }, { "011011010", 1344 },
+		{ "011011011", 1408 }, { "010011000", 1472 }, { "010011001", 1536 }, { "010011010", 1600 }, { "011000", 1664 },
+		{ "010011011", 1728 }
+	};
+
+	/// <summary>
+	/// Black terminating and makeup codes.
+	/// </summary>
+	constexpr CcittCode BlackCodes[] = {
+		{ "0000110111", 0 }, { "010", 1 }, { "11", 2 }, { "10", 3 }, { "011", 4 }, { "0011", 5 }, { "0010", 6 },
+		{ "00011", 7 }, { "000101", 8 }, { "000100", 9 }, { "0000100", 10 }, { "0000101", 11 }, { "0000111", 12 },
+		{ "00000100", 13 }, { "00000111", 14 }, { "000011000", 15 }, { "0000010111", 16 }, { "0000011000", 17 },
+		{ "0000001000", 18 }, { "00001100111", 19 }, { "00001101000", 20 }, { "00001101100", 21 }, { "00000110111", 22 },
+		{ "00000101000", 23 }, { "00000010111", 24 }, { "00000011000", 25 }, { "000011001010", 26 }, { "000011001011", 27 },
+		{ "000011001100", 28 }, { "000011001101", 29 }, { "000001101000", 30 }, { "000001101001", 31 }, { "000001101010", 32 },
+		{ "000001101011", 33 }, { "000011010010", 34 }, { "000011010011", 35 }, { "000011010100", 36 }, { "000011010101", 37 },
+		{ "000011010110", 38 }, { "000011010111", 39 }, { "000001101100", 40 }, { "000001101101", 41 }, { "000011011010", 42 },
+		{ "000011011011", 43 }, { "000001010100", 44 }, { "000001010101", 45 }, { "000001010110", 46 }, { "000001010111", 47 },
+		{ "000001100100", 48 }, { "000001100101", 49 }, { "000001010010", 50 }, { "000001010011", 51 }, { "000000100100", 52 },
+		{ "000000110111", 53 }, { "000000111000", 54 }, { "000000100111", 55 }, { "000000101000", 56 }, { "000001011000", 57 },
+		{ "000001011001", 58 }, { "000000101011", 59 }, { "000000101100", 60 }, { "000001011010", 61 }, { "000001100110", 62 },
+		{ "000001100111", 63 },
+
+		{ "0000001111", 64 }, { "000011001000", 128 }, { "000011001001", 192 }, { "000001011011", 256 }, { "000000110011", 320 },
+		{ "000000110100", 384 }, { "000000110101", 448 }, { "0000001101100", 512 }, { "0000001101101", 576 },
+		{ "0000001001010", 640 }, { "0000001001011", 704 }, { "0000001001100", 768 }, { "0000001001101", 832 },
+		{ "0000001110010", 896 }, { "0000001110011", 960 }, { "0000001110100", 1024 }, { "0000001110101", 1088 },
+		{ "0000001110110", 1152 }, { "0000001110111", 1216 }, { "0000001010010", 1280 }, { "0000001010011", 1344 },
+		{ "0000001010100", 1408 }, { "0000001010101", 1472 }, { "0000001011010", 1536 }, { "0000001011011", 1600 },
+		{ "0000001100100", 1664 }, { "0000001100101", 1728 }
+	};
+
+	/// <summary>
+	/// Two-dimensional mode codes.
+	/// </summary>
+	constexpr CcittCode ModeCodes[] = {
+		{ "0001", ModePass }, { "001", ModeHorizontal }, { "1", ModeVertical0 }, { "011", ModeVerticalR1 },
+		{ "000011", ModeVerticalR2 }, { "0000011", ModeVerticalR3 }, { "010", ModeVerticalL1 }, { "000010", ModeVerticalL2 },
+		{ "0000010", ModeVerticalL3 }, { "0000001", CodeExtension }
+	};
+
+	/// <summary>
+	/// A decoding lookup table, indexed by the next TBits bits of the data. Each code of N bits occupies 2^(TBits - N) entries.
+	/// </summary>
+	template <uint32_t TBits>
+	class CcittLookupTable {
+		private:
+			std::vector<CcittLookup> m_Entries;
+
+		public:
+			CcittLookupTable()
+				: m_Entries(static_cast<size_t>(1) << TBits) {
+
+			}
+
+			template <size_t TCount>
+			void Add(const CcittCode (&codes)[TCount]) {
+				for (const auto& code : codes) {
+					uint32_t length = static_cast<uint32_t>(strlen(code.Bits));
+					uint32_t value  = 0;
+
+					for (uint32_t i = 0; i < length; ++i)
+						value = (value << 1) | (code.Bits[i] == '1' ? 1 : 0);
+
+					auto first = value << (TBits - length);
+					auto count = 1u << (TBits - length);
+
+					for (uint32_t i = 0; i < count; ++i)
+						m_Entries[first + i] = { code.Value, static_cast<uint8_t>(length) };
+				}
+			}
+
+			const CcittLookup& operator[](uint32_t bits) const noexcept {
+				return m_Entries[bits];
+			}
+	};
+
+	/// <summary>
+	/// All the lookup tables, built once on first use.
+	/// </summary>
+	struct CcittTables {
+		CcittLookupTable<WhiteLookupBits>	White;
+		CcittLookupTable<BlackLookupBits>	Black;
+		CcittLookupTable<ModeLookupBits>	Mode;
+		uint8_t								Reverse[256];	// Bit reversal of each byte, for TiffFillOrder::LsbToMsb.
+
+		CcittTables() {
+			White.Add(WhiteCodes);
+			White.Add(ExtendedMakeupCodes);
+			Black.Add(BlackCodes);
+			Black.Add(ExtendedMakeupCodes);
+			Mode.Add(ModeCodes);
+
+			for (uint32_t i = 0; i < 256; ++i) {
+				uint8_t reversed = 0;
+				for (uint32_t bit = 0; bit < 8; ++bit)
+					if (i & (1u << bit))
+						reversed |= static_cast<uint8_t>(0x80u >> bit);
+				Reverse[i] = reversed;
+			}
+		}
+
+		static const CcittTables& Get() {
+			static const CcittTables tables;
+			return tables;
+		}
+	};
+}
+
+/// <summary>
+/// Construct a new decoder for a certain encoding and image width.
+/// </summary>
+/// <param name="compression">The compression scheme, either CcittRle, CcittT4 or CcittT6.</param>
+/// <param name="width">The width of the image in pixels.</param>
+/// <param name="options">The value of the T4Options tag for CcittT4, or the T6Options tag for CcittT6.</param>
+/// <param name="reverseBits">True when the data is stored with <see cref="TiffFillOrder::LsbToMsb"/>.</param>
+/// <exception cref="std::runtime_error">When the compression scheme or options are not supported.</exception>
+CcittDecoder::CcittDecoder(TiffCompression compression, uint32_t width, uint32_t options, bool reverseBits)
+	: m_Compression(compression),
+	  m_Width(width),
+	  m_Options(options),
+	  m_ReverseBits(reverseBits) {
+
+	if (compression != TiffCompression::CcittRle && compression != TiffCompression::CcittT4 && compression != TiffCompression::CcittT6)
+		throw std::runtime_error("unsupported compression scheme for CCITT decoder");
+
+	if (width == 0 || width > static_cast<uint32_t>(INT32_MAX))
+		throw std::runtime_error("unsupported image width for CCITT decoder");
+
+	// T4Options and T6Options share the meaning of the uncompressed mode bit.
+	if (compression != TiffCompression::CcittRle && (options & static_cast<uint32_t>(TiffT4Options::Uncompressed)) != 0)
+		throw std::runtime_error("CCITT uncompressed mode is not supported");
+
+	// Build the tables now, rather than while decoding the first row.
+	CcittTables::Get();
+}
+
+/// <summary>
+/// Start decoding a new strip, each strip is coded independently.
+/// </summary>
+/// <param name="data">The compressed strip data, which must remain valid while decoding the strip.</param>
+void CcittDecoder::Reset(ByteView data) {
+	m_Data     = data;
+	m_Position = 0;
+	m_Bits     = 0;
+	m_BitCount = 0;
+	m_Row      = 0;
+
+	// The reference line of the first row is an imaginary white row.
+	m_Coding.clear();
+}
+
+/// <summary>
+/// Decode the next row of the current strip.
+/// </summary>
+/// <exception cref="std::runtime_error">When the data is corrupt or ends prematurely.</exception>
+void CcittDecoder::DecodeRow() {
+	// The changing elements of the previous row become the reference line, followed by sentinels at the end of the row.
+	m_Reference.swap(m_Coding);
+	m_Reference.insert(m_Reference.end(), 3, m_Width);
+	m_Coding.clear();
+
+	Refill();
+
+	switch (m_Compression) {
+		case TiffCompression::CcittRle:
+			// Each row starts on a byte boundary.
+			if (m_Row != 0)
+				Consume(m_BitCount % 8);
+
+			DecodeRow1D();
+			break;
+
+		case TiffCompression::CcittT4:
+			SkipEndOfLine();
+
+			// In 2D mode, each row is tagged with a bit telling if it is coded 1D (1) or 2D (0).
+			if ((m_Options & static_cast<uint32_t>(TiffT4Options::TwoDimensional)) != 0) {
+				auto oneDimensional = Peek(1) == 1;
+				Consume(1);
+
+				if (!oneDimensional) {
+					DecodeRow2D();
+					break;
+				}
+			}
+
+			DecodeRow1D();
+			break;
+
+		default:
+			DecodeRow2D();
+			break;
+	}
+
+	++m_Row;
+}
+
+/// <summary>
+/// Get the changing elements of the last decoded row. The first element is the column where the first black run
+/// starts, the second where it ends, and so on. When the number of elements is odd, the last black run extends to
+/// the end of the row.
+/// </summary>
+/// <returns>A const reference to the ascending list of changing elements.</returns>
+const std::vector<uint32_t>& CcittDecoder::GetTransitions() const noexcept {
+	return m_Coding;
+}
+
+/// <summary>
+/// Expand the last decoded row into a bit-packed row, see <see cref="TiffBitmap"/>.
+/// </summary>
+/// <param name="row">The output row, at least <see cref="TiffBitmap::GetStride"/>(width) bytes.</param>
+void CcittDecoder::FillRow(uint8_t* row) const noexcept {
+	memset(row, 0, TiffBitmap::GetStride(m_Width));
+
+	for (size_t i = 0; i < m_Coding.size(); i += 2) {
+		auto end = i + 1 < m_Coding.size() ? m_Coding[i + 1] : m_Width;
+		FillRun(row, m_Coding[i], end);
+	}
+}
+
+/// <summary>
+/// Decode a complete bilevel CCITT compressed page from a Tiff file, strip by strip, straight into the rows of a
+/// bitmap owned by the caller. Set bits are pixels in black runs regardless of <see cref="TiffImageLayout::Photometric"/>.
+/// </summary>
+/// <param name="file">The Tiff file.</param>
+/// <param name="pageIndex">The IFD (page) index.</param>
+/// <param name="bits">The first row of the bitmap, which holds as many rows as the page is high.</param>
+/// <param name="stride">The number of bytes from one row to the next, at least <see cref="TiffBitmap::GetStride"/>(width).</param>
+/// <exception cref="std::runtime_error">When the page is not supported or the data is corrupt.</exception>
+/// <exception cref="std::invalid_argument">When the stride is less than a row of the page.</exception>
+void CcittDecoder::DecodePage(const TiffFile& file, size_t pageIndex, uint8_t* bits, size_t stride) {
+	const auto& dimensions = file.GetDimensions(pageIndex);
+	const auto& layout     = file.GetImageLayout(pageIndex);
+
+	if (!IsSupported(layout))
+		throw std::runtime_error("page is not a bilevel CCITT compressed image");
+
+	if (layout.StripOffsets.size() != layout.StripByteCounts.size())
+		throw std::runtime_error("page has a different number of strip offsets and strip byte counts");
+
+	if (stride < TiffBitmap::GetStride(dimensions.Width))
+		throw std::invalid_argument("the rows of the bitmap are too narrow for the page");
+
+	auto options	  = layout.Compression == TiffCompression::CcittT6 ? layout.T6Options : layout.T4Options;
+	auto rowsPerStrip = layout.RowsPerStrip == 0 ? dimensions.Height : layout.RowsPerStrip;
+
+	CcittDecoder		 decoder(layout.Compression, dimensions.Width, options, layout.FillOrder == TiffFillOrder::LsbToMsb);
+	std::vector<uint8_t> buffer;
+	uint32_t			 row = 0;
+
+	for (size_t strip = 0; strip < layout.StripOffsets.size() && row < dimensions.Height; ++strip) {
+		decoder.Reset(file.GetStripData(pageIndex, strip, buffer));
+
+		for (uint32_t i = 0; i < rowsPerStrip && row < dimensions.Height; ++i, ++row) {
+			decoder.DecodeRow();
+			decoder.FillRow(bits + row * stride);
+		}
+	}
+
+	if (row < dimensions.Height)
+		throw std::runtime_error("page holds less rows of image data than its height");
+}
+
+/// <summary>
+/// Determines if the image data of a page can be decoded by this class.
+/// </summary>
+/// <param name="layout">The layout of the page.</param>
+/// <returns>True when the page is a bilevel CCITT compressed image.</returns>
+bool CcittDecoder::IsSupported(const TiffImageLayout& layout) noexcept {
+	switch (layout.Compression) {
+		case TiffCompression::CcittRle:
+		case TiffCompression::CcittT4:
+		case TiffCompression::CcittT6:
+			break;
+		default:
+			return false;
+	}
+
+	if (layout.BitsPerSample != 1 || layout.SamplesPerPixel != 1)
+		return false;
+
+	return (layout.Compression == TiffCompression::CcittRle || (layout.T4Options & static_cast<uint32_t>(TiffT4Options::Uncompressed)) == 0)
+		&& (layout.Compression != TiffCompression::CcittT6 || (layout.T6Options & static_cast<uint32_t>(TiffT4Options::Uncompressed)) == 0);
+}
+
+/// <summary>
+/// Set the bits of a range of pixels in a bit-packed row. Whole bytes in the middle of the run are written with
+/// memset, which the runtime implements with wide vector stores.
+/// </summary>
+/// <param name="row">The bit-packed row.</param>
+/// <param name="start">The first pixel to set.</param>
+/// <param name="end">The pixel after the last pixel to set.</param>
+void CcittDecoder::FillRun(uint8_t* row, uint32_t start, uint32_t end) noexcept {
+	if (start >= end)
+		return;
+
+	auto first     = start >> 3;
+	auto last      = (end - 1) >> 3;
+	auto firstMask = static_cast<uint8_t>(0xFFu >> (start & 7));
+	auto lastMask  = static_cast<uint8_t>(0xFFu << (7 - ((end - 1) & 7)));
+
+	if (first == last) {
+		row[first] |= firstMask & lastMask;
+		return;
+	}
+
+	row[first] |= firstMask;
+	memset(row + first + 1, 0xFF, last - first - 1);
+	row[last] |= lastMask;
+}
+
+/// <summary>
+/// Decode a row coded with one-dimensional Modified Huffman run lengths.
+/// </summary>
+void CcittDecoder::DecodeRow1D() {
+	uint64_t position = 0;
+	bool     black    = false;
+
+	while (position < m_Width) {
+		position += ReadRun(black);
+		AddTransition(position);
+		black = !black;
+	}
+}
+
+/// <summary>
+/// Decode a row coded with two-dimensional (Modified READ) codes, relative to the previous row.
+/// </summary>
+void CcittDecoder::DecodeRow2D() {
+	const auto&	tables = CcittTables::Get();
+	const auto	width  = static_cast<int64_t>(m_Width);
+
+	int64_t a0    = -1;		/* imaginary white changing element before the first pixel */
+	bool	black = false;
+	size_t	b     = 0;
+
+	while (a0 < width) {
+		// b1 is the first changing element on the reference line to the right of a0, of the opposite color of a0. Changing
+		// elements at even indices change to black, those at odd indices change to white.
+		while (static_cast<int64_t>(m_Reference[b]) <= a0)
+			++b;
+
+		auto b1Index = b + ((b & 1) != (black ? 1u : 0u) ? 1 : 0);
+		auto b1      = static_cast<int64_t>(m_Reference[b1Index]);
+		auto b2      = static_cast<int64_t>(m_Reference[b1Index + 1]);
+
+		Refill();
+
+		const auto& mode = tables.Mode[Peek(ModeLookupBits)];
+		if (mode.Value < 0) {
+			if (mode.Value == CodeExtension)
+				throw std::runtime_error("CCITT uncompressed mode is not supported");
+			throw std::runtime_error("invalid CCITT mode code");
+		}
+
+		Consume(mode.Length);
+
+		switch (mode.Value) {
+			case ModePass:
+				a0 = b2;
+				break;
+
+			case ModeHorizontal: {
+				auto a1 = (a0 < 0 ? 0 : a0) + ReadRun(black);
+				auto a2 = a1 + ReadRun(!black);
+
+				AddTransition(static_cast<uint64_t>(a1));
+				AddTransition(static_cast<uint64_t>(a2));
+				a0 = a2;
+				break;
+			}
+
+			default: {
+				auto a1 = b1 + (mode.Value - ModeVertical0);
+				if (mode.Value >= ModeVerticalL1)
+					a1 = b1 - (mode.Value - ModeVerticalR3);
+
+				if (a1 < 0 || a1 < a0)
+					throw std::runtime_error("invalid CCITT vertical mode code");
+
+				AddTransition(static_cast<uint64_t>(a1));
+				a0    = a1;
+				black = !black;
+				break;
+			}
+		}
+	}
+}
+
+/// <summary>
+/// Skip any fill bits and end-of-line codes before a T.4 row.
+/// </summary>
+void CcittDecoder::SkipEndOfLine() {
+	for (;;) {
+		Refill();
+
+		if (m_BitCount < 12 || Peek(11) != 0)
+			return;
+
+		// Eleven or more zero bits can only be fill bits or the start of an EOL code.
+		auto zeros = m_Bits == 0 ? m_BitCount : 0u;
+		while (zeros < m_BitCount && (m_Bits & (0x8000000000000000ull >> zeros)) == 0)
+			++zeros;
+
+		if (zeros >= m_BitCount) {
+			Consume(m_BitCount);
+			continue;
+		}
+
+		// Consume the zeros and the 1 bit that ends the EOL code.
+		Consume(zeros + 1);
+	}
+}
+
+/// <summary>
+/// Decode a complete run length, all makeup codes followed by a terminating code.
+/// </summary>
+/// <param name="black">True to decode a black run, false for a white run.</param>
+/// <returns>The run length in pixels.</returns>
+uint32_t CcittDecoder::ReadRun(bool black) {
+	const auto& tables = CcittTables::Get();
+	uint32_t	run    = 0;
+
+	for (;;) {
+		Refill();
+
+		const auto& code = black ? tables.Black[Peek(BlackLookupBits)] : tables.White[Peek(WhiteLookupBits)];
+		if (code.Value < 0) {
+			if (code.Value == CodeEndOfLine)
+				throw std::runtime_error("unexpected CCITT end of line code within row");
+			throw std::runtime_error("invalid CCITT run length code");
+		}
+
+		Consume(code.Length);
+
+		run += static_cast<uint32_t>(code.Value);
+		if (run > m_Width)
+			throw std::runtime_error("CCITT run length exceeds image width");
+
+		// Terminating codes are below 64, makeup codes are followed by more codes.
+		if (code.Value < 64)
+			return run;
+	}
+}
+
+/// <summary>
+/// Add a changing element to the current row, a changing element equal to the previous one cancels it out.
+/// </summary>
+/// <param name="position">The column of the changing element.</param>
+void CcittDecoder::AddTransition(uint64_t position) {
+	if (position >= m_Width)
+		return;
+
+	if (!m_Coding.empty()) {
+		if (m_Coding.back() == position) {
+			m_Coding.pop_back();
+			return;
+		}
+
+		if (m_Coding.back() > position)
+			throw std::runtime_error("invalid CCITT data, changing elements are out of order");
+	}
+
+	m_Coding.push_back(static_cast<uint32_t>(position));
+}
+
+void CcittDecoder::Refill() noexcept {
+	const auto& reverse = CcittTables::Get().Reverse;
+
+	while (m_BitCount <= 56 && m_Position < m_Data.Size()) {
+		uint8_t byte = m_Data[m_Position++];
+		if (m_ReverseBits)
+			byte = reverse[byte];
+
+		m_Bits     |= static_cast<uint64_t>(byte) << (56 - m_BitCount);
+		m_BitCount += 8;
+	}
+}
+
+uint32_t CcittDecoder::Peek(uint32_t count) const noexcept {
+	return static_cast<uint32_t>(m_Bits >> (64 - count));
+}
+
+void CcittDecoder::Consume(uint32_t count) {
+	if (count > m_BitCount)
+		throw std::runtime_error("unexpected end of CCITT data");
+
+	m_Bits       = count == 64 ? 0 : m_Bits << count;
+	m_BitCount  -= count;
+}
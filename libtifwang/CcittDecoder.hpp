@@ -0,0 +1,152 @@
+#pragma once
+
+#include "pch.h"
+
+#ifndef ccitt_decoder_h
+#define ccitt_decoder_h
+	#include "TiffFile.hpp"
+	#include "TiffBitmap.hpp"
+
+	namespace TiffWang {
+		namespace Tiff {
+			/// <summary>
+			/// The CcittDecoder class is a table-driven decoder for CCITT bilevel image data, as found in Tiff files compressed with
+			/// <see cref="TiffCompression::CcittRle"/>, <see cref="TiffCompression::CcittT4"/> (Group 3, 1D and 2D) and
+			/// <see cref="TiffCompression::CcittT6"/> (Group 4). It decodes one strip at a time, row by row. Each decoded row is
+			/// available as a list of changing elements (run boundaries) and can be expanded into a bit-packed row.
+			/// </summary>
+			class __EXPORTED_API CcittDecoder {
+				private:
+					#pragma warning ( push )
+					#pragma warning ( disable: 4251 ) /* "needs to have dll-interface to be used by clients of class" - members are not public */
+					TiffCompression			m_Compression;
+					uint32_t				m_Width;
+					uint32_t				m_Options;
+					bool					m_ReverseBits;
+
+					ByteView				m_Data;
+					size_t					m_Position = 0;		// The next byte in m_Data to load into m_Bits.
+					uint64_t				m_Bits = 0;			// Bit accumulator, the next bit to decode is the most significant bit.
+					uint32_t				m_BitCount = 0;		// The number of valid bits in m_Bits.
+					uint32_t				m_Row = 0;			// The number of rows decoded in the current strip.
+
+					std::vector<uint32_t>	m_Reference;		// The changing elements of the previous row, followed by sentinels.
+					std::vector<uint32_t>	m_Coding;			// The changing elements of the current row.
+					#pragma warning ( pop )
+
+				public:
+					/// <summary>
+					/// Construct a new decoder for a certain encoding and image width.
+					/// </summary>
+					/// <param name="compression">The compression scheme, either CcittRle, CcittT4 or CcittT6.</param>
+					/// <param name="width">The width of the image in pixels.</param>
+					/// <param name="options">The value of the T4Options tag for CcittT4, or the T6Options tag for CcittT6.</param>
+					/// <param name="reverseBits">True when the data is stored with <see cref="TiffFillOrder::LsbToMsb"/>.</param>
+					/// <exception cref="std::runtime_error">When the compression scheme or options are not supported.</exception>
+					CcittDecoder(TiffCompression compression, uint32_t width, uint32_t options = 0, bool reverseBits = false);
+
+					/// <summary>
+					/// Start decoding a new strip, each strip is coded independently.
+					/// </summary>
+					/// <param name="data">The compressed strip data, which must remain valid while decoding the strip.</param>
+					void Reset(ByteView data);
+
+					/// <summary>
+					/// Decode the next row of the current strip.
+					/// </summary>
+					/// <exception cref="std::runtime_error">When the data is corrupt or ends prematurely.</exception>
+					void DecodeRow();
+
+					/// <summary>
+					/// Get the changing elements of the last decoded row. The first element is the column where the first black run
+					/// starts, the second where it ends, and so on. When the number of elements is odd, the last black run extends to
+					/// the end of the row.
+					/// </summary>
+					/// <returns>A const reference to the ascending list of changing elements.</returns>
+					const std::vector<uint32_t>& GetTransitions() const noexcept;
+
+					/// <summary>
+					/// Expand the last decoded row into a bit-packed row, see <see cref="TiffBitmap"/>.
+					/// </summary>
+					/// <param name="row">The output row, at least <see cref="TiffBitmap::GetStride"/>(width) bytes.</param>
+					void FillRow(uint8_t* row) const noexcept;
+
+					/// <summary>
+					/// Decode a complete bilevel CCITT compressed page from a Tiff file, strip by strip, straight into the rows of a
+					/// bitmap owned by the caller. Set bits are pixels in black runs regardless of <see cref="TiffImageLayout::Photometric"/>.
+					/// </summary>
+					/// <param name="file">The Tiff file.</param>
+					/// <param name="pageIndex">The IFD (page) index.</param>
+					/// <param name="bits">The first row of the bitmap, which holds as many rows as the page is high.</param>
+					/// <param name="stride">The number of bytes from one row to the next, at least <see cref="TiffBitmap::GetStride"/>(width).</param>
+					/// <exception cref="std::runtime_error">When the page is not supported or the data is corrupt.</exception>
+					/// <exception cref="std::invalid_argument">When the stride is less than a row of the page.</exception>
+					static void DecodePage(const TiffFile& file, size_t pageIndex, uint8_t* bits, size_t stride);
+
+					/// <summary>
+					/// Determines if the image data of a page can be decoded by this class.
+					/// </summary>
+					/// <param name="layout">The layout of the page.</param>
+					/// <returns>True when the page is a bilevel CCITT compressed image.</returns>
+					static bool IsSupported(const TiffImageLayout& layout) noexcept;
+
+					/// <summary>
+					/// Set the bits of a range of pixels in a bit-packed row.
+					/// </summary>
+					/// <param name="row">The bit-packed row.</param>
+					/// <param name="start">The first pixel to set.</param>
+					/// <param name="end">The pixel after the last pixel to set.</param>
+					static void FillRun(uint8_t* row, uint32_t start, uint32_t end) noexcept;
+
+				private:
+					/// <summary>
+					/// Decode a row coded with one-dimensional Modified Huffman run lengths.
+					/// </summary>
+					void DecodeRow1D();
+
+					/// <summary>
+					/// Decode a row coded with two-dimensional (Modified READ) codes, relative to the previous row.
+					/// </summary>
+					void DecodeRow2D();
+
+					/// <summary>
+					/// Skip any fill bits and end-of-line codes before a T.4 row.
+					/// </summary>
+					void SkipEndOfLine();
+
+					/// <summary>
+					/// Decode a complete run length, all makeup codes followed by a terminating code.
+					/// </summary>
+					/// <param name="black">True to decode a black run, false for a white run.</param>
+					/// <returns>The run length in pixels.</returns>
+					uint32_t ReadRun(bool black);
+
+					/// <summary>
+					/// Add a changing element to the current row, a changing element equal to the previous one cancels it out.
+					/// </summary>
+					/// <param name="position">The column of the changing element.</param>
+					void AddTransition(uint64_t position);
+
+					/// <summary>
+					/// Make sure at least 57 bits are available in the accumulator, when there is data left.
+					/// </summary>
+					void Refill() noexcept;
+
+					/// <summary>
+					/// Look at the next bits without consuming them.
+					/// </summary>
+					/// <param name="count">The number of bits, 1 to 32.</param>
+					/// <returns>The bits, right aligned.</returns>
+					uint32_t Peek(uint32_t count) const noexcept;
+
+					/// <summary>
+					/// Consume bits that have been looked at with <see cref="Peek"/>.
+					/// </summary>
+					/// <param name="count">The number of bits.</param>
+					/// <exception cref="std::runtime_error">When there are fewer bits left in the strip.</exception>
+					void Consume(uint32_t count);
+			};
+		}
+	}
+
+#endif
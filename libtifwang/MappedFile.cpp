@@ -0,0 +1,110 @@
+#include "pch.h"
+#include "MappedFile.hpp"
+
+using namespace TiffWang::Tiff;
+
+/// <summary>
+/// Map a file from ascii filepath.
+/// </summary>
+/// <param name="filepath">The file to map.</param>
+/// <exception cref="std::runtime_error">When the file cannot be opened or mapped.</exception>
+MappedFile::MappedFile(const std::string& filepath) {
+	m_File = CreateFileA(filepath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (m_File == INVALID_HANDLE_VALUE)
+		throw std::runtime_error("cannot open file");
+
+	Map();
+}
+
+/// <summary>
+/// Map a file from unicode filepath.
+/// </summary>
+/// <param name="filepath">The file to map.</param>
+/// <exception cref="std::runtime_error">When the file cannot be opened or mapped.</exception>
+MappedFile::MappedFile(const std::wstring& filepath) {
+	m_File = CreateFileW(filepath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (m_File == INVALID_HANDLE_VALUE)
+		throw std::runtime_error("cannot open file");
+
+	Map();
+}
+
+/// <summary>
+/// Unmap the view and close all handles.
+/// </summary>
+MappedFile::~MappedFile() {
+	Close();
+}
+
+/// <summary>
+/// Get a view on the complete mapped file.
+/// </summary>
+/// <returns>The view, which is valid for as long as this instance lives. The memory is writable, see <see cref="MappedFile"/>.</returns>
+ByteView MappedFile::GetView() const noexcept {
+	return ByteView(m_Data, m_Size);
+}
+
+/// <summary>
+/// Get the size of the mapped file.
+/// </summary>
+/// <returns>The size in bytes.</returns>
+size_t MappedFile::GetSize() const noexcept {
+	return m_Size;
+}
+
+/// <summary>
+/// Create the mapping for the opened file handle.
+/// </summary>
+/// <exception cref="std::runtime_error">When the file cannot be mapped.</exception>
+void MappedFile::Map() {
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(m_File, &size)) {
+		Close();
+		throw std::runtime_error("cannot determine file size");
+	}
+
+	// The complete file has to fit in the address space, which is not always the case for 32-bit builds.
+	if (static_cast<uint64_t>(size.QuadPart) > static_cast<uint64_t>(SIZE_MAX)) {
+		Close();
+		throw std::runtime_error("file is too large to be mapped in this process");
+	}
+
+	m_Size = static_cast<size_t>(size.QuadPart);
+
+	// An empty file cannot be mapped, but it can be represented by an empty view.
+	if (m_Size == 0)
+		return;
+
+	// The view is copy-on-write instead of read-only: libtiffconvert selects the page to decode by patching the IFD0 offset in
+	// the header in place. Written pages become private to this process, the file itself is never modified.
+	m_Mapping = CreateFileMappingW(m_File, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+	if (m_Mapping == nullptr) {
+		Close();
+		throw std::runtime_error("cannot create file mapping");
+	}
+
+	m_Data = static_cast<const uint8_t*>(MapViewOfFile(m_Mapping, FILE_MAP_COPY, 0, 0, 0));
+	if (m_Data == nullptr) {
+		Close();
+		throw std::runtime_error("cannot map view of file");
+	}
+}
+
+/// <summary>
+/// Release the view and all handles, if any.
+/// </summary>
+void MappedFile::Close() noexcept {
+	if (m_Data != nullptr)
+		UnmapViewOfFile(m_Data);
+
+	if (m_Mapping != nullptr)
+		CloseHandle(m_Mapping);
+
+	if (m_File != INVALID_HANDLE_VALUE)
+		CloseHandle(m_File);
+
+	m_Data    = nullptr;
+	m_Mapping = nullptr;
+	m_File    = INVALID_HANDLE_VALUE;
+	m_Size    = 0;
+}
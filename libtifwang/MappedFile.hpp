@@ -0,0 +1,79 @@
+#pragma once
+
+#include "pch.h"
+
+#ifndef mapped_file_h
+#define mapped_file_h
+	#include "ByteView.hpp"
+
+	namespace TiffWang {
+		namespace Tiff {
+			/// <summary>
+			/// The MappedFile class maps a complete file copy-on-write into the address space of the process. The contents
+			/// of the file can then be accessed through a <see cref="ByteView"/>, without any seek or read system calls;
+			/// the operating system pages the data in on demand.
+			/// <br/>
+			/// Note: the view is const for the parsers in this library, but the memory behind it is writable. libtiffconvert
+			/// decodes pages from the same memory and temporarily patches IFD offsets in it while it does (CatchTIFFPage). 
+			/// Those writes go to private copies of the pages they touch, the file itself is never modified.
+			/// </summary>
+			class __EXPORTED_API MappedFile {
+				private:
+					HANDLE			m_File    = INVALID_HANDLE_VALUE;
+					HANDLE			m_Mapping = nullptr;
+					const uint8_t*	m_Data    = nullptr;
+					size_t			m_Size    = 0;
+
+				public:
+					/// <summary>
+					/// Map a file from ascii filepath.
+					/// </summary>
+					/// <param name="filepath">The file to map.</param>
+					/// <exception cref="std::runtime_error">When the file cannot be opened or mapped.</exception>
+					MappedFile(const std::string& filepath);
+
+					/// <summary>
+					/// Map a file from unicode filepath.
+					/// </summary>
+					/// <param name="filepath">The file to map.</param>
+					/// <exception cref="std::runtime_error">When the file cannot be opened or mapped.</exception>
+					MappedFile(const std::wstring& filepath);
+
+					/// <summary>
+					/// Unmap the view and close all handles.
+					/// </summary>
+					~MappedFile();
+
+					MappedFile(const MappedFile&) = delete;
+					MappedFile& operator=(const MappedFile&) = delete;
+					MappedFile(MappedFile&&) = delete;
+					MappedFile& operator=(MappedFile&&) = delete;
+
+					/// <summary>
+					/// Get a view on the complete mapped file.
+					/// </summary>
+					/// <returns>The view, which is valid for as long as this instance lives. The memory is writable, see <see cref="MappedFile"/>.</returns>
+					ByteView GetView() const noexcept;
+
+					/// <summary>
+					/// Get the size of the mapped file.
+					/// </summary>
+					/// <returns>The size in bytes.</returns>
+					size_t GetSize() const noexcept;
+
+				private:
+					/// <summary>
+					/// Create the mapping for the opened file handle.
+					/// </summary>
+					/// <exception cref="std::runtime_error">When the file cannot be mapped.</exception>
+					void Map();
+
+					/// <summary>
+					/// Release the view and all handles, if any.
+					/// </summary>
+					void Close() noexcept;
+			};
+		}
+	}
+
+#endif
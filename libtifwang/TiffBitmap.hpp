@@ -0,0 +1,102 @@
+#pragma once
+
+#include "pch.h"
+
+#ifndef tiff_bitmap_h
+#define tiff_bitmap_h
+
+	namespace TiffWang {
+		namespace Tiff {
+			/// <summary>
+			/// TiffBitmap is a bit-packed, bilevel (1 bit per pixel) image. Rows are stored top-down, each row starts on a byte
+			/// boundary and the leftmost pixel is stored in the most significant bit. A set bit is a black (ink) pixel.
+			/// </summary>
+			class TiffBitmap {
+				private:
+					uint32_t				m_Width  = 0;
+					uint32_t				m_Height = 0;
+					size_t					m_Stride = 0;
+					std::vector<uint8_t>	m_Bits;
+
+				public:
+					/// <summary>
+					/// Construct a new, empty bitmap.
+					/// </summary>
+					TiffBitmap() = default;
+
+					/// <summary>
+					/// Construct a new, white bitmap of a certain size.
+					/// </summary>
+					/// <param name="width">The width in pixels.</param>
+					/// <param name="height">The height in pixels.</param>
+					TiffBitmap(uint32_t width, uint32_t height)
+						: m_Width(width),
+						  m_Height(height),
+						  m_Stride(GetStride(width)),
+						  m_Bits(GetStride(width) * height, 0) {
+
+					}
+
+					/// <summary>
+					/// Get the width of the bitmap.
+					/// </summary>
+					/// <returns>The width in pixels.</returns>
+					uint32_t GetWidth() const noexcept {
+						return m_Width;
+					}
+
+					/// <summary>
+					/// Get the height of the bitmap.
+					/// </summary>
+					/// <returns>The height in pixels.</returns>
+					uint32_t GetHeight() const noexcept {
+						return m_Height;
+					}
+
+					/// <summary>
+					/// Get the number of bytes per row.
+					/// </summary>
+					/// <returns>The stride in bytes.</returns>
+					size_t GetStride() const noexcept {
+						return m_Stride;
+					}
+
+					/// <summary>
+					/// Get a pointer to the first byte of a row, without bounds checking.
+					/// </summary>
+					/// <param name="row">The row index.</param>
+					/// <returns>The pointer to <see cref="GetStride"/>() bytes.</returns>
+					uint8_t* GetRow(uint32_t row) noexcept {
+						return m_Bits.data() + row * m_Stride;
+					}
+
+					/// <summary>
+					/// Get a pointer to the first byte of a row, without bounds checking.
+					/// </summary>
+					/// <param name="row">The row index.</param>
+					/// <returns>The pointer to <see cref="GetStride"/>() bytes.</returns>
+					const uint8_t* GetRow(uint32_t row) const noexcept {
+						return m_Bits.data() + row * m_Stride;
+					}
+
+					/// <summary>
+					/// Get all the bit-packed pixel data.
+					/// </summary>
+					/// <returns>A const reference to the <see cref="GetStride"/>() * <see cref="GetHeight"/>() bytes.</returns>
+					const std::vector<uint8_t>& GetBits() const noexcept {
+						return m_Bits;
+					}
+
+					/// <summary>
+					/// Get the number of bytes per row for a bilevel image of a certain width.
+					/// </summary>
+					/// <param name="width">The width in pixels.</param>
+					/// <returns>The stride in bytes.</returns>
+					static size_t GetStride(uint32_t width) noexcept {
+						return (static_cast<size_t>(width) + 7) / 8;
+					}
+			};
+		}
+	}
+
+#endif
@@ -0,0 +1,130 @@
+#pragma once
+
+#include "pch.h"
+
+#ifndef tiff_endian_h
+#define tiff_endian_h
+
+	namespace TiffWang {
+		namespace Tiff {
+			/// <summary>
+			/// The byte order of a Tiff file, as indicated by the first two bytes of the header.
+			/// </summary>
+			enum class TiffByteOrder {
+				Intel,		// II, little endian.
+				Motorola	// MM, big endian.
+			};
+
+			/// <summary>
+			/// TiffEndian decodes integers and floating point numbers from raw bytes in a byte order that is known at compile
+			/// time. All methods are static and inline, so a reader specialized for one byte order compiles down to a load and
+			/// (when the byte order differs from the host) a byte swap intrinsic, without any indirect calls.
+			/// </summary>
+			/// <typeparam name="TOrder">The byte order of the data.</typeparam>
+			template <TiffByteOrder TOrder>
+			struct TiffEndian {
+				static constexpr TiffByteOrder Order = TOrder;
+
+				/// <summary>
+				/// Decode an unsigned 16-bit integer.
+				/// </summary>
+				/// <param name="data">A pointer to at least 2 bytes.</param>
+				/// <returns>The value in host byte order.</returns>
+				static inline uint16_t Uint16(const uint8_t* data) noexcept {
+					uint16_t value;
+					memcpy(&value, data, sizeof(value));
+
+					if constexpr (TOrder == TiffByteOrder::Intel)
+						return le_to_host_ushort(value);
+					else
+						return be_to_host_ushort(value);
+				}
+
+				/// <summary>
+				/// Decode an unsigned 32-bit integer.
+				/// </summary>
+				/// <param name="data">A pointer to at least 4 bytes.</param>
+				/// <returns>The value in host byte order.</returns>
+				static inline uint32_t Uint32(const uint8_t* data) noexcept {
+					uint32_t value;
+					memcpy(&value, data, sizeof(value));
+
+					if constexpr (TOrder == TiffByteOrder::Intel)
+						return le_to_host_ulong(value);
+					else
+						return be_to_host_ulong(value);
+				}
+
+				/// <summary>
+				/// Decode an unsigned 64-bit integer.
+				/// </summary>
+				/// <param name="data">A pointer to at least 8 bytes.</param>
+				/// <returns>The value in host byte order.</returns>
+				static inline uint64_t Uint64(const uint8_t* data) noexcept {
+					uint64_t value;
+					memcpy(&value, data, sizeof(value));
+
+					if constexpr (TOrder == TiffByteOrder::Intel)
+						return le_to_host_uint64(value);
+					else
+						return be_to_host_uint64(value);
+				}
+
+				/// <summary>
+				/// Decode a signed 16-bit integer.
+				/// </summary>
+				/// <param name="data">A pointer to at least 2 bytes.</param>
+				/// <returns>The value in host byte order.</returns>
+				static inline int16_t Int16(const uint8_t* data) noexcept {
+					return static_cast<int16_t>(Uint16(data));
+				}
+
+				/// <summary>
+				/// Decode a signed 32-bit integer.
+				/// </summary>
+				/// <param name="data">A pointer to at least 4 bytes.</param>
+				/// <returns>The value in host byte order.</returns>
+				static inline int32_t Int32(const uint8_t* data) noexcept {
+					return static_cast<int32_t>(Uint32(data));
+				}
+
+				/// <summary>
+				/// Decode a signed 64-bit integer.
+				/// </summary>
+				/// <param name="data">A pointer to at least 8 bytes.</param>
+				/// <returns>The value in host byte order.</returns>
+				static inline int64_t Int64(const uint8_t* data) noexcept {
+					return static_cast<int64_t>(Uint64(data));
+				}
+
+				/// <summary>
+				/// Decode a single precision floating point number.
+				/// </summary>
+				/// <param name="data">A pointer to at least 4 bytes.</param>
+				/// <returns>The value in host byte order.</returns>
+				static inline float Float(const uint8_t* data) noexcept {
+					auto  bits = Uint32(data);
+					float value;
+					memcpy(&value, &bits, sizeof(value));
+					return value;
+				}
+
+				/// <summary>
+				/// Decode a double precision floating point number.
+				/// </summary>
+				/// <param name="data">A pointer to at least 8 bytes.</param>
+				/// <returns>The value in host byte order.</returns>
+				static inline double Double(const uint8_t* data) noexcept {
+					auto   bits = Uint64(data);
+					double value;
+					memcpy(&value, &bits, sizeof(value));
+					return value;
+				}
+			};
+
+			using TiffIntelEndian	 = TiffEndian<TiffByteOrder::Intel>;		// Little endian decoding.
+			using TiffMotorolaEndian = TiffEndian<TiffByteOrder::Motorola>;		// Big endian decoding.
+		}
+	}
+
+#endif
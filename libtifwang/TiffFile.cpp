@@ -9,14 +9,12 @@ namespace fs = std::filesystem;
 /// Construct a new TiffFile instance from ascii filepath.
 /// </summary>
 /// <param name="filepath">The Tiff-file to parse.</param>
-TiffFile::TiffFile(const std::string& filepath)
-	: m_Stream(std::ifstream(filepath, std::ios::in | std::ios::binary)), 
-	  m_StreamSize(static_cast<size_t>(fs::file_size(filepath))),
+/// <param name="mode">How to access the file, either streamed or memory mapped.</param>
+TiffFile::TiffFile(const std::string& filepath, TiffAccessMode mode)
+	: m_StreamSize(0),
 	  m_Header({}) {
 
-	if (!m_Stream.is_open())
-		throw std::runtime_error("cannot open file");
-
+	Open(filepath, mode);
 	Init();
 }
 
@@ -24,158 +22,174 @@ TiffFile::TiffFile(const std::string& filepath)
 /// Construct a new TiffFile instance from unicode filepath.
 /// </summary>
 /// <param name="filepath">The Tiff-file to parse.</param>
-TiffFile::TiffFile(const std::wstring& filepath) 
-	: m_Stream(std::ifstream(filepath, std::ios::in | std::ios::binary)), 
-	  m_StreamSize(static_cast<size_t>(fs::file_size(filepath))),
+/// <param name="mode">How to access the file, either streamed or memory mapped.</param>
+TiffFile::TiffFile(const std::wstring& filepath, TiffAccessMode mode)
+	: m_StreamSize(0),
+	  m_Header({}) {
+
+	Open(filepath, mode);
+	Init();
+}
+
+/// <summary>
+/// Construct a new TiffFile instance over Tiff data that is already in memory, such as a <see cref="MappedFile"/> 
+/// that is shared with the image decoder. No data is copied, the instance behaves as if it was opened in 
+/// <see cref="TiffAccessMode::Mapped"/> mode.
+/// </summary>
+/// <param name="data">The Tiff data.</param>
+/// <param name="owner">The owner of the memory <paramref name="data"/> refers to, which is kept alive for as long as this instance lives.</param>
+TiffFile::TiffFile(ByteView data, std::shared_ptr<const void> owner)
+	: m_StreamSize(static_cast<uint64_t>(data.Size())),
+	  m_Mode(TiffAccessMode::Mapped),
+	  m_Owner(std::move(owner)),
+	  m_View(data),
 	  m_Header({}) {
 
+	Init();
+}
+
+/// <summary>
+/// Open the file either as stream or as memory mapped file.
+/// </summary>
+/// <param name="filepath">The Tiff-file to open.</param>
+/// <param name="mode">How to access the file.</param>
+template <typename TPath>
+void TiffFile::Open(const TPath& filepath, TiffAccessMode mode) {
+	if (mode == TiffAccessMode::Mapped) {
+		auto mapping = std::make_shared<MappedFile>(filepath);
+
+		m_Mode       = TiffAccessMode::Mapped;
+		m_View       = mapping->GetView();
+		m_Owner      = std::move(mapping);
+		m_StreamSize = static_cast<uint64_t>(m_View.Size());
+		return;
+	}
+
+	m_Stream.open(filepath, std::ios::in | std::ios::binary);
 	if (!m_Stream.is_open())
 		throw std::runtime_error("cannot open file");
 
-	Init();
+	m_StreamSize = static_cast<uint64_t>(fs::file_size(filepath));
+}
+
+/// <summary>
+/// Invoke a function with the <see cref="TiffEndian"/> decoder for the byte order of this file. The byte order 
+/// is only tested here, so everything inside <paramref name="function"/> decodes with inlined byte swaps.
+/// </summary>
+/// <param name="function">A generic callable, accepting either <see cref="TiffIntelEndian"/> or <see cref="TiffMotorolaEndian"/>.</param>
+/// <returns>The result of <paramref name="function"/>.</returns>
+template <typename TFunction>
+auto TiffFile::Dispatch(TFunction&& function) const {
+	if (m_ByteOrder == TiffByteOrder::Motorola)
+		return function(TiffMotorolaEndian());
+	return function(TiffIntelEndian());
 }
 
 /// <summary>
 /// Initialize the opened file stream, read and process the file header.
 /// </summary>
 void TiffFile::Init() {
-	// Read TiffHeader
-	Read(m_Header);
+	// The classic header is 8 bytes, the BigTIFF header is 16 bytes; read as much of it as there is at once.
+	std::vector<uint8_t> buffer;
+	auto header = ReadRange(0, m_StreamSize < 16 ? m_StreamSize : 16, buffer);
+
+	if (header.Size() < 8)
+		throw std::runtime_error("malformed or unsupported TIFF header, insufficient data");
+
+	// The byte order indication, everything after it depends on it.
+	memcpy(m_Header.ByteOrder, header.Data(), sizeof(m_Header.ByteOrder));
 
 	// Is it little endian?
-	if (memcmp(m_Header.ByteOrder, IntelEndian, 2) == 0) {
-		m_IntegerReader = {
-			[&]() { return static_cast<int16_t>(le_to_host_ushort(Read<uint16_t>())); },
-			[&]() { return le_to_host_ushort(Read<uint16_t>()); },
-			[&]() { return static_cast<int32_t>(le_to_host_ulong(Read<uint32_t>())); },
-			[&]() { return le_to_host_ulong(Read<uint32_t>()); },
-			[&]() { return static_cast<int64_t>(le_to_host_uint64(Read<uint64_t>())); },
-			[&]() { return le_to_host_uint64(Read<uint64_t>()); },
-			[&]() { return le_to_host_float(Read<float>()); },
-			[&]() { return le_to_host_double(Read<double>()); },
-
-			[&]() { return static_cast<int16_t>(le_to_host_ushort(Read<uint16_t>())); },
-			[&]() { return le_to_host_ushort(Read<uint16_t>()); },
-			[&]() { return static_cast<int32_t>(le_to_host_ulong(Read<uint32_t>())); },
-			[&]() { return le_to_host_ulong(Read<uint32_t>()); },
-			[&]() { return static_cast<int64_t>(le_to_host_uint64(Read<uint64_t>())); },
-			[&]() { return le_to_host_uint64(Read<uint64_t>()); },
-			[&]() { return le_to_host_float(Read<float>()); },
-			[&]() { return le_to_host_double(Read<double>()); }
-		};
-
-		m_Header.Magic			= le_to_host_ushort(m_Header.Magic);
-		m_Header.OffsetFirstIfd = le_to_host_ulong(m_Header.OffsetFirstIfd);
-	} 
-	
+	if (memcmp(m_Header.ByteOrder, IntelEndian, 2) == 0)
+		m_ByteOrder = TiffByteOrder::Intel;
+
 	// Is it big endian?
-	else if (memcmp(m_Header.ByteOrder, MotorolaEndian, 2) == 0) {
-		m_IntegerReader = {
-			[&]() { return static_cast<int16_t>(be_to_host_ushort(Read<uint16_t>())); },
-			[&]() { return be_to_host_ushort(Read<uint16_t>()); },
-			[&]() { return static_cast<int32_t>(be_to_host_ulong(Read<uint32_t>())); },
-			[&]() { return be_to_host_ulong(Read<uint32_t>()); },
-			[&]() { return static_cast<int64_t>(be_to_host_uint64(Read<uint64_t>())); },
-			[&]() { return be_to_host_uint64(Read<uint64_t>()); },
-			[&]() { return be_to_host_float(Read<float>()); },
-			[&]() { return be_to_host_double(Read<double>()); },
-
-			[&]() { return static_cast<int16_t>(le_to_host_ushort(Read<uint16_t>())); },
-			[&]() { return le_to_host_ushort(Read<uint16_t>()); },
-			[&]() { return static_cast<int32_t>(le_to_host_ulong(Read<uint32_t>())); },
-			[&]() { return le_to_host_ulong(Read<uint32_t>()); },
-			[&]() { return static_cast<int64_t>(le_to_host_uint64(Read<uint64_t>())); },
-			[&]() { return le_to_host_uint64(Read<uint64_t>()); },
-			[&]() { return le_to_host_float(Read<float>()); },
-			[&]() { return le_to_host_double(Read<double>()); }
-		};
-
-		m_Header.Magic			= be_to_host_ushort(m_Header.Magic);
-		m_Header.OffsetFirstIfd = be_to_host_ulong(m_Header.OffsetFirstIfd);
-	} 
+	else if (memcmp(m_Header.ByteOrder, MotorolaEndian, 2) == 0)
+		m_ByteOrder = TiffByteOrder::Motorola;
 
 	// Unknown endianness, stop. Must be malformed image.
-	else { 
+	else
 		throw std::runtime_error("malformed or unsupported TIFF header, byte order indication not 'II' or 'MM'");
-	}
 
-	// Verify that the magic number is equal to what we expect.
-	if (m_Header.Magic != Magic)
-		throw std::runtime_error("malformed or unsupported TIFF header, magic number is not the expected '" + std::to_string(Magic) + "'");
+	Dispatch([&](auto endian) {
+		m_Header.Magic = endian.Uint16(header.Data() + 2);
+
+		// Classic Tiff: a 32-bit offset to the first IFD follows.
+		if (m_Header.Magic == Magic) {
+			m_Header.OffsetFirstIfd = endian.Uint32(header.Data() + 4);
+			return;
+		}
+
+		// Verify that the magic number is equal to what we expect.
+		if (m_Header.Magic != BigTiffMagic)
+			throw std::runtime_error("malformed or unsupported TIFF header, magic number is not the expected '" + std::to_string(Magic) + "' or '" + std::to_string(BigTiffMagic) + "'");
+
+		if (header.Size() < 16)
+			throw std::runtime_error("malformed or unsupported BigTIFF header, insufficient data");
+
+		// BigTIFF: the size of offsets (always 8), a reserved word (always 0) and a 64-bit offset to the first IFD follow.
+		auto offsetSize = endian.Uint16(header.Data() + 4);
+		auto reserved   = endian.Uint16(header.Data() + 6);
+
+		if (offsetSize != BigTiffOffsetSize || reserved != 0)
+			throw std::runtime_error("malformed or unsupported BigTIFF header, offset size is not the expected '" + std::to_string(BigTiffOffsetSize) + "'");
+
+		m_Header.OffsetFirstIfd = endian.Uint64(header.Data() + 8);
+	});
 }
 
 /// <summary>
-/// Process all the Image File Directories.
+/// Index all the Image File Directories. This only records the location of each IFD and determines the 
+/// page order, the tags of a page are decoded when the page is accessed for the first time.
 /// </summary>
 void TiffFile::ReadIfdCollection() {
-	// Seek to the first IFD and keep reading until we cannot.
-	m_Stream.seekg(m_Header.OffsetFirstIfd, std::ios::beg);
-
-	while (true) {
-		auto  entries = m_IntegerReader.Uint16();			/* the number of tags in this IFD */
-		auto& ifd	  = m_PageIfdCollection.emplace_back(); /* construct a new list of tags in-place */
-
-		// read the entries in this directory
-		for (auto i = 0; i < entries; ++i) {
-			auto& entry       = ifd.emplace_back(); /* construct a new tag in place */
-			entry.TagId       = static_cast<TiffTagId>(m_IntegerReader.Uint16());
-			entry.TagType     = static_cast<TiffTagType>(m_IntegerReader.Uint16());
-			entry.ValueCount  = m_IntegerReader.Uint32();
-			entry.ValueOffset = m_IntegerReader.Uint32();
-			entry.IsWangTag   = entry.TagId == TiffTagId::TIFF_WANG_TAG && entry.TagType == TiffTagType::BYTE;
-		}
+	std::unordered_set<uint64_t> visited;	/* IFD offsets seen before, to protect against cyclic IFD chains */
+	std::vector<size_t>			 pageNumbers;
+	bool						 hasPageNumbers = true;
 
-		// determine if we have more IFD to read
-		auto nextOffset = m_IntegerReader.Uint32();
-		if (nextOffset == 0)
-			break; /* all IFD's read */
+	m_Pages.clear();
+	m_PageOrder.clear();
+	m_ChainOrder.clear();
 
-		// seek to the next directory and continue the loop
-		m_Stream.seekg(nextOffset, std::ios::beg);
-	}
+	Dispatch([&](auto endian) {
+		std::vector<uint8_t> buffer;
 
-	// Fix the IFD order, as the order they were written in might not match the render order.
-	CorrectIfdOrder();
+		// Walk the chain of IFDs, starting at the first one, reading each directory with a single read.
+		auto offset = m_Header.OffsetFirstIfd;
 
-	// Prepare collections for some IFD-specific information.
-	m_Dimensions.resize(GetPageCount());
-	m_Software.resize(GetPageCount());
-	m_Artist.resize(GetPageCount());
-	m_DateTime.resize(GetPageCount());
+		while (offset != 0 && visited.insert(offset).second) {
+			auto count = ReadRange(offset, GetEntryCountSize(), buffer);
 
-	// Try to find some common tags that might be useful.
-	for (size_t pageIndex = 0; pageIndex < GetPageCount(); ++pageIndex) {
-		const auto& page = m_PageIfdCollection[pageIndex];
+			auto& page		= m_Pages.emplace_back();
+			page.Offset		= offset;
+			page.EntryCount = IsBigTiff() ? endian.Uint64(count.Data()) : static_cast<uint64_t>(endian.Uint16(count.Data()));
 
-		for (const auto& entry : page) {
-			switch (entry.TagId) {
-				case TiffTagId::TIFF_IMAGE_YRESOLUTION:
-					m_Dimensions[pageIndex].ResolutionY = ReadRational(entry);
-					break;
-				case TiffTagId::TIFF_IMAGE_XRESOLUTION:
-					m_Dimensions[pageIndex].ResolutionX = ReadRational(entry);
-					break;
-				case TiffTagId::TIFF_IMAGE_LENGTH_TAG:
-					m_Dimensions[pageIndex].Height = entry.ValueOffset;
-					break;
-				case TiffTagId::TIFF_IMAGE_WIDTH_TAG:
-					m_Dimensions[pageIndex].Width = entry.ValueOffset;
-					break;
-				case TiffTagId::TIFF_IMAGE_RESOLUTION_UNIT:
-					m_Dimensions[pageIndex].ResolutionUnit = static_cast<TiffResolutionUnit>(entry.ValueOffset);
-					break;
-				case TiffTagId::TIFF_IMAGE_SOFTWARE:
-					m_Software[pageIndex] = ReadAsciiString(entry);
-					break;
-				case TiffTagId::TIFF_IMAGE_DATETIME:
-					m_DateTime[pageIndex] = ReadAsciiString(entry);
-					break;
-				case TiffTagId::TIFF_IMAGE_ARTIST:
-					m_Artist[pageIndex] = ReadAsciiString(entry);
-					break;
-			}
+			if (page.EntryCount > m_StreamSize / GetEntrySize())
+				throw std::runtime_error("insufficient data left in stream");
+
+			// All the entries, followed by the offset of the next IFD.
+			auto entries = ReadRange(offset + GetEntryCountSize(), page.EntryCount * GetEntrySize() + GetOffsetSize(), buffer);
+
+			// Remember the page number, if all IFDs up to here had one.
+			size_t pageNumber = 0;
+			hasPageNumbers = hasPageNumbers && FindPageNumber(endian, page, entries, pageNumber);
+			if (hasPageNumbers)
+				pageNumbers.push_back(pageNumber);
+
+			// Determine if we have more IFDs to read.
+			offset = DecodeOffset(endian, entries.Data() + page.EntryCount * GetEntrySize());
 		}
-	}
+	});
+
+	// Determine the page order, as the order the IFDs were written in might not match the render order.
+	if (!hasPageNumbers)
+		pageNumbers.clear();
+
+	BuildPageOrder(pageNumbers);
+
+	m_ChainOrder.resize(m_PageOrder.size());
+	for (size_t pageIndex = 0; pageIndex < m_PageOrder.size(); ++pageIndex)
+		m_ChainOrder[m_PageOrder[pageIndex]] = pageIndex;
 }
 
 /// <summary>
@@ -183,7 +197,31 @@ void TiffFile::ReadIfdCollection() {
 /// </summary>
 /// <returns>The number of directories (or pages).</returns>
 size_t TiffFile::GetPageCount() const noexcept {
-	return m_PageIfdCollection.size();
+	return m_PageOrder.size();
+}
+
+/// <summary>
+/// Get the position of an IFD (page) in the IFD chain of the file. Pages are ordered by their page number 
+/// tags when these are present, decoders that count pages along the chain must be given this index instead.
+/// </summary>
+/// <param name="pageIndex">The IFD (page) index.</param>
+/// <returns>The index of the IFD in the order of reading.</returns>
+/// <exception cref="std::out_of_range">When the index is out of range.</exception>
+size_t TiffFile::GetPageIfdChainIndex(size_t pageIndex) const {
+	AssertPageIndex(pageIndex);
+	return m_PageOrder[pageIndex];
+}
+
+/// <summary>
+/// Get the page index of an IFD by its position in the IFD chain of the file, the inverse of 
+/// <see cref="GetPageIfdChainIndex"/>.
+/// </summary>
+/// <param name="ifdChainIndex">The index of the IFD in the order of reading.</param>
+/// <returns>The IFD (page) index.</returns>
+/// <exception cref="std::out_of_range">When the index is out of range.</exception>
+size_t TiffFile::GetPageIndexOfIfdChainIndex(size_t ifdChainIndex) const {
+	AssertPageIndex(ifdChainIndex);
+	return m_ChainOrder[ifdChainIndex];
 }
 
 /// <summary>
@@ -193,9 +231,7 @@ size_t TiffFile::GetPageCount() const noexcept {
 /// <returns>The number of tags in this IFD.</returns>
 /// <exception cref="std::out_of_range">When indices are out of range.</exception>
 size_t TiffFile::GetPageIfdCount(size_t pageIndex) const {
-	AssertPageIndex(pageIndex);
-
-	return m_PageIfdCollection.at(pageIndex).size();
+	return GetPage(pageIndex).Entries.size();
 }
 
 /// <summary>
@@ -208,7 +244,7 @@ size_t TiffFile::GetPageIfdCount(size_t pageIndex) const {
 const TiffIfdEntry& TiffFile::GetPageIfd(size_t pageIndex, size_t ifdIndex) const {
 	AssertPageIfdIndex(pageIndex, ifdIndex);
 
-	return m_PageIfdCollection.at(pageIndex).at(ifdIndex);
+	return GetPage(pageIndex).Entries[ifdIndex];
 }
 
 /// <summary>
@@ -218,9 +254,35 @@ const TiffIfdEntry& TiffFile::GetPageIfd(size_t pageIndex, size_t ifdIndex) cons
 /// <returns>A const reference to the dimensions and resolution instance.</returns>
 /// <exception cref="std::out_of_range">When indices are out of range.</exception>
 const TiffDimensions& TiffFile::GetDimensions(size_t pageIndex) const {
-	AssertPageIndex(pageIndex);
+	return GetPage(pageIndex).Dimensions;
+}
+
+/// <summary>
+/// Get the layout and encoding of the image data for a specific IFD (page).
+/// </summary>
+/// <param name="pageIndex">The IFD (page) index.</param>
+/// <returns>A const reference to the image layout.</returns>
+/// <exception cref="std::out_of_range">When indices are out of range.</exception>
+const TiffImageLayout& TiffFile::GetImageLayout(size_t pageIndex) const {
+	return GetPage(pageIndex).Layout;
+}
+
+/// <summary>
+/// Get the raw (compressed) data of a single strip of a specific IFD (page).
+/// </summary>
+/// <param name="pageIndex">The IFD (page) index.</param>
+/// <param name="strip">The strip index.</param>
+/// <param name="buffer">The buffer to read to when the file is not mapped.</param>
+/// <returns>A view on the strip data, valid until <paramref name="buffer"/> is modified or this instance is destroyed.</returns>
+/// <exception cref="std::out_of_range">When indices are out of range.</exception>
+/// <exception cref="std::runtime_error">When the strip is out of bounds of the file.</exception>
+ByteView TiffFile::GetStripData(size_t pageIndex, size_t strip, std::vector<uint8_t>& buffer) const {
+	const auto& layout = GetPage(pageIndex).Layout;
 
-	return m_Dimensions[pageIndex];
+	if (strip >= layout.StripOffsets.size() || strip >= layout.StripByteCounts.size())
+		throw std::out_of_range("requested strip index is out of range");
+
+	return ReadRange(layout.StripOffsets[strip], layout.StripByteCounts[strip], buffer);
 }
 
 /// <summary>
@@ -230,8 +292,7 @@ const TiffDimensions& TiffFile::GetDimensions(size_t pageIndex) const {
 /// <returns>The software name or an empty string if unavailable.</returns>
 /// <exception cref="std::out_of_range">When indices are out of range.</exception>
 const std::string& TiffFile::GetSoftware(size_t pageIndex) const {
-	AssertPageIndex(pageIndex);
-	return m_Software[pageIndex];
+	return GetPage(pageIndex).Software;
 }
 
 /// <summary>
@@ -241,8 +302,7 @@ const std::string& TiffFile::GetSoftware(size_t pageIndex) const {
 /// <returns>The formatted timestamp or an empty string if unavailable.</returns>
 /// <exception cref="std::out_of_range">When indices are out of range.</exception>
 const std::string& TiffFile::GetDateTime(size_t pageIndex) const {
-	AssertPageIndex(pageIndex);
-	return m_DateTime[pageIndex];
+	return GetPage(pageIndex).DateTime;
 }
 
 /// <summary>
@@ -252,65 +312,320 @@ const std::string& TiffFile::GetDateTime(size_t pageIndex) const {
 /// <returns>The artist name or an empty string if unavailable.</returns>
 /// <exception cref="std::out_of_range">When indices are out of range.</exception>
 const std::string& TiffFile::GetArtist(size_t pageIndex) const {
+	return GetPage(pageIndex).Artist;
+}
+
+/// <summary>
+/// Determines if this file was opened in <see cref="TiffAccessMode::Mapped"/> mode.
+/// </summary>
+/// <returns>True when the file is memory mapped.</returns>
+bool TiffFile::IsMapped() const noexcept {
+	return m_Mode == TiffAccessMode::Mapped;
+}
+
+/// <summary>
+/// Determines if this file is a BigTIFF file, with 64-bit offsets and counts.
+/// </summary>
+/// <returns>True when the file is a BigTIFF file.</returns>
+bool TiffFile::IsBigTiff() const noexcept {
+	return m_Header.Magic == BigTiffMagic;
+}
+
+/// <summary>
+/// Get a view on the raw value bytes of a tag, directly in the memory mapped file. No data is copied, the
+/// view remains valid for as long as this <see cref="TiffFile"/> instance lives.
+/// </summary>
+/// <param name="entry">The TiffIfdEntry to get the values for.</param>
+/// <returns>A view on all the value bytes of the tag, in file byte order.</returns>
+/// <exception cref="::std::runtime_error">When the file is not mapped or the values are out of bounds.</exception>
+ByteView TiffFile::GetValueView(const TiffIfdEntry& entry) const {
+	if (!IsMapped())
+		throw std::runtime_error("tag value views are only available for memory mapped files");
+
+	auto offset = GetValueOffset(entry);
+	auto size   = GetValueSize(entry);
+
+	AssertRange(offset, size);
+
+	return m_View.SubView(static_cast<size_t>(offset), static_cast<size_t>(size));
+}
+
+/// <summary>
+/// Get the size of a single value of a certain tag type.
+/// </summary>
+/// <param name="type">The tag type.</param>
+/// <returns>The size in bytes, or 0 for unknown types.</returns>
+size_t TiffFile::GetTypeSize(TiffTagType type) noexcept {
+	switch (type) {
+		case TiffTagType::BYTE:
+		case TiffTagType::ASCII:
+		case TiffTagType::SBYTE:
+		case TiffTagType::UNDEFINED:
+			return 1;
+		case TiffTagType::SHORT:
+		case TiffTagType::SSHORT:
+			return 2;
+		case TiffTagType::LONG:
+		case TiffTagType::SLONG:
+		case TiffTagType::FLOAT:
+		case TiffTagType::IFD:
+			return 4;
+		case TiffTagType::RATIONAL:
+		case TiffTagType::SRATIONAL:
+		case TiffTagType::DOUBLE:
+		case TiffTagType::LONG8:
+		case TiffTagType::SLONG8:
+		case TiffTagType::IFD8:
+			return 8;
+	}
+
+	return 0;
+}
+
+/// <summary>
+/// Find the page number of an IFD, by only looking at the tag identifiers.
+/// </summary>
+/// <param name="endian">The decoder for the byte order of this file.</param>
+/// <param name="page">The page index entry of the IFD.</param>
+/// <param name="entries">The raw entries of the IFD.</param>
+/// <param name="pageNumber">The resulting page number, if found.</param>
+/// <returns>True when the IFD contains a valid page number tag.</returns>
+template <typename TEndian>
+bool TiffFile::FindPageNumber(TEndian endian, const TiffPage& page, ByteView entries, size_t& pageNumber) const {
+	auto first = page.Offset + GetEntryCountSize();
+
+	for (uint64_t i = 0; i < page.EntryCount; ++i) {
+		auto data = entries.Data() + i * GetEntrySize();
+
+		if (static_cast<TiffTagId>(endian.Uint16(data)) != TiffTagId::TIFF_PAGE_NUMBER)
+			continue;
+
+		auto entry = DecodeEntry(endian, data, first + i * GetEntrySize());
+		if (entry.TagType != TiffTagType::SHORT || entry.ValueCount == 0)
+			return false;
+
+		pageNumber = ReadUnsignedShortArray(entry)[0];
+		return true;
+	}
+
+	return false;
+}
+
+/// <summary>
+/// Build the page order permutation based on page number tags, if any. If one of the IFDs (pages) 
+/// does not contain a valid page number tag, the order of reading is maintained.
+/// </summary>
+/// <param name="pageNumbers">The page number of each IFD, in the order of reading, or an empty list when not all are known.</param>
+void TiffFile::BuildPageOrder(const std::vector<size_t>& pageNumbers) {
+	m_PageOrder.resize(m_Pages.size());
+
+	// Start with the order of reading.
+	for (size_t i = 0; i < m_PageOrder.size(); ++i)
+		m_PageOrder[i] = i;
+
+	if (pageNumbers.size() != m_Pages.size())
+		return;
+
+	// Place each IFD at its written page number, but only when the page numbers form a valid permutation.
+	TiffPageOrder	  ordered(m_Pages.size());
+	std::vector<bool> taken(m_Pages.size(), false);
+
+	for (size_t unorderedIndex = 0; unorderedIndex < pageNumbers.size(); ++unorderedIndex) {
+		auto correctIndex = pageNumbers[unorderedIndex];
+
+		if (correctIndex >= ordered.size() || taken[correctIndex]) /* invalid data, can't reorder */
+			return;
+
+		ordered[correctIndex] = unorderedIndex;
+		taken[correctIndex]   = true;
+	}
+
+	// When we made it to here, the page numbers are a valid permutation.
+	m_PageOrder = std::move(ordered);
+}
+
+/// <summary>
+/// Get a page from the index by page index, decoding its tags when this has not been done before. This is safe to call
+/// from multiple threads, so pages of one file can be processed concurrently.
+/// </summary>
+/// <param name="pageIndex">The IFD (page) index.</param>
+/// <returns>A const reference to the decoded page.</returns>
+/// <exception cref="std::out_of_range">When the index is out of range.</exception>
+const TiffPage& TiffFile::GetPage(size_t pageIndex) const {
 	AssertPageIndex(pageIndex);
-	return m_Artist[pageIndex];
+
+	std::lock_guard<std::mutex> lock(m_PageMutex);
+
+	auto& page = m_Pages[m_PageOrder[pageIndex]];
+	if (!page.Loaded)
+		LoadPage(page);
+
+	return page;
 }
 
 /// <summary>
-/// Correct the order of IFD collections based on page index tags, if any. If one of 
-/// the IFDs (pages) does not contain a page index tag, the order of reading is maintained.
+/// Decode all the tags of a page and the information derived from them.
 /// </summary>
-void TiffFile::CorrectIfdOrder() {
-	// The resulting ordered list of IFD's
-	TiffIfdList orderedList(m_PageIfdCollection.size());
-	
-	// Iterate over the current list.
-	for (size_t unorderedIndex = 0; unorderedIndex < m_PageIfdCollection.size(); ++unorderedIndex) {
-		const auto& collection = m_PageIfdCollection[unorderedIndex];
-		size_t		correctIndex = 0;
-		bool		correctIndexFound = false;
+/// <param name="page">The page to decode.</param>
+void TiffFile::LoadPage(TiffPage& page) const {
+	auto first = page.Offset + GetEntryCountSize();
 
-		// try to find the page number tag.
-		for (size_t ifdIndex = 0; ifdIndex < collection.size(); ++ifdIndex) {
-			const auto& entry = collection[ifdIndex];
+	// Read all the entries in this directory at once.
+	std::vector<uint8_t>	  buffer;
+	std::vector<TiffIfdEntry> entries;
+	entries.reserve(static_cast<size_t>(page.EntryCount));
 
-			if (entry.TagId == TiffTagId::TIFF_PAGE_NUMBER) {
-				auto pageInfo     = ReadUnsignedShortArray(entry);
-				correctIndexFound = true;
-				correctIndex      = pageInfo[0];
+	auto data = ReadRange(first, page.EntryCount * GetEntrySize(), buffer);
 
-				if (correctIndex >= GetPageCount()) /* invalid data, can't reorder as written index exceeds number of IFD's */
-					return;
+	Dispatch([&](auto endian) {
+		for (uint64_t i = 0; i < page.EntryCount; ++i)
+			entries.push_back(DecodeEntry(endian, data.Data() + i * GetEntrySize(), first + i * GetEntrySize()));
+	});
 
+	// Try to find some common tags that might be useful.
+	for (const auto& entry : entries) {
+		switch (entry.TagId) {
+			case TiffTagId::TIFF_IMAGE_YRESOLUTION:
+				page.Dimensions.ResolutionY = ReadRational(entry);
+				break;
+			case TiffTagId::TIFF_IMAGE_XRESOLUTION:
+				page.Dimensions.ResolutionX = ReadRational(entry);
+				break;
+			case TiffTagId::TIFF_IMAGE_LENGTH_TAG:
+				page.Dimensions.Height = static_cast<uint32_t>(ReadUnsignedInteger(entry));
+				break;
+			case TiffTagId::TIFF_IMAGE_WIDTH_TAG:
+				page.Dimensions.Width = static_cast<uint32_t>(ReadUnsignedInteger(entry));
+				break;
+			case TiffTagId::TIFF_IMAGE_RESOLUTION_UNIT:
+				page.Dimensions.ResolutionUnit = static_cast<TiffResolutionUnit>(ReadUnsignedInteger(entry));
+				break;
+			case TiffTagId::TIFF_IMAGE_BITS_PER_SAMPLE:
+				page.Layout.BitsPerSample = static_cast<uint16_t>(ReadUnsignedInteger(entry));
+				break;
+			case TiffTagId::TIFF_IMAGE_SAMPLES_PER_PIXEL:
+				page.Layout.SamplesPerPixel = static_cast<uint16_t>(ReadUnsignedInteger(entry));
+				break;
+			case TiffTagId::TIFF_IMAGE_COMPRESSION:
+				page.Layout.Compression = static_cast<TiffCompression>(ReadUnsignedInteger(entry));
+				break;
+			case TiffTagId::TIFF_IMAGE_PHOTOMETRIC:
+				page.Layout.Photometric = static_cast<TiffPhotometric>(ReadUnsignedInteger(entry));
+				break;
+			case TiffTagId::TIFF_IMAGE_FILL_ORDER:
+				page.Layout.FillOrder = static_cast<TiffFillOrder>(ReadUnsignedInteger(entry));
+				break;
+			case TiffTagId::TIFF_IMAGE_ROWS_PER_STRIP:
+				page.Layout.RowsPerStrip = static_cast<uint32_t>(ReadUnsignedInteger(entry));
+				break;
+			case TiffTagId::TIFF_IMAGE_T4_OPTIONS:
+				page.Layout.T4Options = static_cast<uint32_t>(ReadUnsignedInteger(entry));
+				break;
+			case TiffTagId::TIFF_IMAGE_T6_OPTIONS:
+				page.Layout.T6Options = static_cast<uint32_t>(ReadUnsignedInteger(entry));
+				break;
+			case TiffTagId::TIFF_IMAGE_STRIP_OFFSETS:
+				page.Layout.StripOffsets = ReadUnsignedIntegerArray(entry);
+				break;
+			case TiffTagId::TIFF_IMAGE_STRIP_BYTE_COUNTS:
+				page.Layout.StripByteCounts = ReadUnsignedIntegerArray(entry);
+				break;
+			case TiffTagId::TIFF_IMAGE_SOFTWARE:
+				page.Software = ReadAsciiString(entry);
+				break;
+			case TiffTagId::TIFF_IMAGE_DATETIME:
+				page.DateTime = ReadAsciiString(entry);
+				break;
+			case TiffTagId::TIFF_IMAGE_ARTIST:
+				page.Artist = ReadAsciiString(entry);
 				break;
-			}
 		}
+	}
 
-		// no page number stored in this IFD, so we can't reorder.
-		if (!correctIndexFound)
-			return;
+	// Only publish the entries when everything has been decoded, a failure leaves the page unloaded.
+	page.Entries = std::move(entries);
+	page.Loaded  = true;
+}
 
-		// Place at correct index.
-		orderedList[correctIndex] = collection;
-	}
+/// <summary>
+/// Decode a single IFD entry.
+/// </summary>
+/// <param name="endian">The decoder for the byte order of this file.</param>
+/// <param name="data">The raw entry, <see cref="GetEntrySize"/>() bytes.</param>
+/// <param name="position">The offset (from the beginning of the stream) of the raw entry.</param>
+/// <returns>The entry.</returns>
+template <typename TEndian>
+TiffIfdEntry TiffFile::DecodeEntry(TEndian endian, const uint8_t* data, uint64_t position) const noexcept {
+	auto valueField = 4 + GetOffsetSize();
+
+	TiffIfdEntry entry;
+	entry.TagId        = static_cast<TiffTagId>(endian.Uint16(data));
+	entry.TagType      = static_cast<TiffTagType>(endian.Uint16(data + 2));
+	entry.ValueCount   = DecodeOffset(endian, data + 4);
+	entry.InlineOffset = position + valueField;
+	entry.ValueOffset  = DecodeOffset(endian, data + valueField);
+	entry.IsWangTag    = entry.TagId == TiffTagId::TIFF_WANG_TAG && entry.TagType == TiffTagType::BYTE;
+	return entry;
+}
+
+/// <summary>
+/// Decode an offset or count, which is a LONG in classic Tiff files and a LONG8 in BigTIFF files.
+/// </summary>
+/// <param name="endian">The decoder for the byte order of this file.</param>
+/// <param name="data">The raw value, <see cref="GetOffsetSize"/>() bytes.</param>
+/// <returns>The decoded value.</returns>
+template <typename TEndian>
+uint64_t TiffFile::DecodeOffset(TEndian endian, const uint8_t* data) const noexcept {
+	if (IsBigTiff())
+		return endian.Uint64(data);
+	return endian.Uint32(data);
+}
+
+/// <summary>
+/// Get the size of a single IFD entry, 12 bytes in classic Tiff files and 20 bytes in BigTIFF files.
+/// </summary>
+/// <returns>The size in bytes.</returns>
+uint64_t TiffFile::GetEntrySize() const noexcept {
+	return IsBigTiff() ? 20 : 12;
+}
+
+uint64_t TiffFile::GetEntryCountSize() const noexcept {
+	return IsBigTiff() ? sizeof(uint64_t) : sizeof(uint16_t);
+}
 
-	// When we made it to here, we reordered the list successfully.
-	m_PageIfdCollection = orderedList;
+uint64_t TiffFile::GetOffsetSize() const noexcept {
+	return IsBigTiff() ? sizeof(uint64_t) : sizeof(uint32_t);
 }
 
-size_t TiffFile::SizeLeft() const {
-	if (m_Stream.tellg() >= static_cast<std::streampos>(m_StreamSize))
-		return 0;
-	return static_cast<size_t>(m_StreamSize - m_Stream.tellg());
+ByteView TiffFile::ReadRange(uint64_t offset, uint64_t size, std::vector<uint8_t>& buffer) const {
+	AssertRange(offset, size);
+
+	if (IsMapped())
+		return m_View.SubView(static_cast<size_t>(offset), static_cast<size_t>(size));
+
+	buffer.resize(static_cast<size_t>(size));
+
+	std::lock_guard<std::mutex> lock(m_StreamMutex);
+	m_Stream.seekg(static_cast<std::streamoff>(offset), std::ios::beg);
+	m_Stream.read(reinterpret_cast<char*>(buffer.data()), static_cast<std::streamsize>(size));
+	if (!m_Stream)
+		throw std::runtime_error("cannot read from stream");
+
+	return ByteView(buffer);
 }
 
-void TiffFile::AssertSizeLeft(size_t required) const {
-	if (SizeLeft() < required)
-		throw std::runtime_error("insufficient data left in stream");
+uint64_t TiffFile::GetValueSize(const TiffIfdEntry& entry) noexcept {
+	return GetTypeSize(entry.TagType) * entry.ValueCount;
 }
 
-void TiffFile::AssertOffset(size_t offset) const {
-	if (offset >= m_StreamSize)
+uint64_t TiffFile::GetValueOffset(const TiffIfdEntry& entry) const noexcept {
+	if (GetValueSize(entry) <= GetOffsetSize())
+		return entry.InlineOffset;
+	return entry.ValueOffset;
+}
+
+void TiffFile::AssertRange(uint64_t offset, uint64_t size) const {
+	if (offset >= m_StreamSize || size > m_StreamSize - offset)
 		throw std::runtime_error("insufficient data, cannot seek to offset");
 }
 
@@ -326,43 +641,6 @@ void TiffFile::AssertPageIfdIndex(size_t pageIndex, size_t ifdIndex) const {
 		throw std::out_of_range("requested IFD index is out of range");
 }
 
-/// <summary>
-/// Read a struct or class value from the stream.
-/// </summary>
-/// <param name="value">A reference to the value to read to.</param>
-/// <typeparam name="The type of struct or class to read."></typeparam>
-/// <exception cref="::std::runtime_error">When insufficient data is available, an exception is thrown.</exception>
-template <
-	typename TValue,
-	std::enable_if_t<std::is_class_v<TValue>, int>
->
-void TiffFile::Read(TValue& value) {
-	AssertSizeLeft(sizeof(TValue));
-	m_Stream.read(reinterpret_cast<char*>(&value), sizeof(TValue));
-}
-
-/// <summary>
-/// Read an integral or floating point value from the stream.
-/// </summary>
-/// <typeparam name="TValue">The type of integral or floating point value to read.</typeparam>
-/// <returns>The read value.</returns>
-/// <exception cref="::std::runtime_error">When insufficient data is available, an exception is thrown.</exception>
-template <typename TValue,
-	std::enable_if_t<
-		std::conjunction<
-			std::disjunction<std::is_integral<TValue>, std::is_floating_point<TValue>>,
-			std::negation<std::is_pointer<TValue>>,
-			std::negation<std::is_reference<TValue>>
-		>::value,
-		int
-	>
->
-TValue TiffFile::Read() {
-	TValue value;
-	m_Stream.read(reinterpret_cast<char*>(&value), sizeof(TValue));
-	return value;
-}
-
 /// <summary>
 /// Read all the associated tag data from a BYTE tag to a buffer.
 /// </summary>
@@ -374,16 +652,12 @@ void TiffFile::Read(const TiffIfdEntry& entry, uint8_t* buffer, size_t size) con
 	if (entry.TagType != TiffTagType::BYTE)
 		throw std::runtime_error("unexpected type for IFD tag encountered, should be BYTE");
 
-	AssertOffset(entry.ValueOffset);
-
 	if (size < entry.ValueCount)
 		throw std::runtime_error("insufficient data in output buffer, should be " + std::to_string(entry.ValueCount) + " bytes large");
 
-	auto offset = m_Stream.tellg();
-	m_Stream.seekg(entry.ValueOffset, std::ios::beg);
-	AssertSizeLeft(size);
-	m_Stream.read(reinterpret_cast<char*>(buffer), entry.ValueCount);
-	m_Stream.seekg(offset, std::ios::beg);
+	std::vector<uint8_t> data;
+	auto bytes = ReadRange(GetValueOffset(entry), entry.ValueCount, data);
+	memcpy(buffer, bytes.Data(), bytes.Size());
 }
 
 /// <summary>
@@ -399,8 +673,10 @@ void TiffFile::Read(const TiffIfdEntry& entry, std::vector<uint8_t>& result) con
 	if (entry.ValueCount == 0)
 		throw std::runtime_error("cannot process provided TiffIfdEntry, entry holds no values");
 
-	result.resize(static_cast<size_t>(entry.ValueCount));
-	Read(entry, &result[0], result.size());
+	// When not mapped, the values are read straight into the result.
+	auto bytes = ReadRange(GetValueOffset(entry), entry.ValueCount, result);
+	if (IsMapped())
+		result.assign(bytes.begin(), bytes.end());
 }
 
 /// <summary>
@@ -409,27 +685,107 @@ void TiffFile::Read(const TiffIfdEntry& entry, std::vector<uint8_t>& result) con
 /// <param name="entry">The TiffIfdEntry to read.</param>
 /// <returns>A vector of read unsigned shorts.</returns>
 /// <exception cref="::std::runtime_error">When insufficient data is available, an exception is thrown.</exception>
-std::vector<uint16_t> TiffFile::ReadUnsignedShortArray(const TiffIfdEntry& entry) {
+std::vector<uint16_t> TiffFile::ReadUnsignedShortArray(const TiffIfdEntry& entry) const {
 	std::vector<uint16_t> result;
 
 	if (entry.TagType != TiffTagType::SHORT)
 		throw std::runtime_error("unexpected type for IFD tag encountered, should be SHORT");
 
-	AssertOffset(entry.ValueOffset);
+	std::vector<uint8_t> buffer;
+	auto bytes = ReadRange(GetValueOffset(entry), GetValueSize(entry), buffer);
+
+	result.resize(static_cast<size_t>(entry.ValueCount));
+
+	Dispatch([&](auto endian) {
+		for (size_t i = 0; i < result.size(); ++i)
+			result[i] = endian.Uint16(bytes.Data() + i * sizeof(uint16_t));
+	});
 
-	auto offset = m_Stream.tellg();
+	return result;
+}
+
+/// <summary>
+/// Read all values of a SHORT, LONG or LONG8 tag as unsigned integers.
+/// </summary>
+/// <param name="entry">The TiffIfdEntry to read.</param>
+/// <returns>A vector of read values.</returns>
+/// <exception cref="::std::runtime_error">When insufficient data is available or the type is not an unsigned integer type, an exception is thrown.</exception>
+std::vector<uint64_t> TiffFile::ReadUnsignedIntegerArray(const TiffIfdEntry& entry) const {
+	switch (entry.TagType) {
+		case TiffTagType::SHORT:
+		case TiffTagType::LONG:
+		case TiffTagType::LONG8:
+			break;
+		default:
+			throw std::runtime_error("unexpected type for IFD tag encountered, should be SHORT, LONG or LONG8");
+	}
 
-	m_Stream.seekg(entry.ValueOffset, std::ios::beg);
-	AssertSizeLeft(sizeof(std::uint16_t) * entry.ValueCount);
-	result.resize(entry.ValueCount);
-	for (uint32_t i = 0; i < entry.ValueCount; ++i)
-		result[i] = m_IntegerReader.Uint16();
+	std::vector<uint8_t> buffer;
+	auto bytes = ReadRange(GetValueOffset(entry), GetValueSize(entry), buffer);
+	auto size  = GetTypeSize(entry.TagType);
 
-	m_Stream.seekg(offset, std::ios::beg);
+	std::vector<uint64_t> result(static_cast<size_t>(entry.ValueCount));
+
+	Dispatch([&](auto endian) {
+		for (size_t i = 0; i < result.size(); ++i) {
+			auto data = bytes.Data() + i * size;
+
+			switch (size) {
+				case sizeof(uint16_t):
+					result[i] = endian.Uint16(data);
+					break;
+				case sizeof(uint32_t):
+					result[i] = endian.Uint32(data);
+					break;
+				default:
+					result[i] = endian.Uint64(data);
+					break;
+			}
+		}
+	});
 
 	return result;
 }
 
+/// <summary>
+/// Read the first value of a BYTE, SHORT, LONG or LONG8 tag as unsigned integer.
+/// </summary>
+/// <param name="entry">The TiffIfdEntry to read.</param>
+/// <returns>The value.</returns>
+/// <exception cref="::std::runtime_error">When insufficient data is available or the type is not an unsigned integer type, an exception is thrown.</exception>
+uint64_t TiffFile::ReadUnsignedInteger(const TiffIfdEntry& entry) const {
+	if (entry.ValueCount == 0)
+		throw std::runtime_error("cannot process provided TiffIfdEntry, entry holds no values");
+
+	switch (entry.TagType) {
+		case TiffTagType::BYTE:
+		case TiffTagType::SHORT:
+		case TiffTagType::LONG:
+		case TiffTagType::IFD:
+		case TiffTagType::LONG8:
+		case TiffTagType::IFD8:
+			break;
+		default:
+			throw std::runtime_error("unexpected type for IFD tag encountered, should be BYTE, SHORT, LONG or LONG8");
+	}
+
+	std::vector<uint8_t> buffer;
+	auto bytes = ReadRange(GetValueOffset(entry), GetTypeSize(entry.TagType), buffer);
+
+	return Dispatch([&](auto endian) -> uint64_t {
+		switch (bytes.Size()) {
+			case sizeof(uint8_t):
+				return bytes[0];
+			case sizeof(uint16_t):
+				return endian.Uint16(bytes.Data());
+			case sizeof(uint32_t):
+				return endian.Uint32(bytes.Data());
+			default:
+				return endian.Uint64(bytes.Data());
+		}
+	});
+}
+
 /// <summary>
 /// Read a rational number (two TiffTagType::LONG values) and produce a rational number,
 /// by dividing the numerator by the denominator.
@@ -437,28 +793,22 @@ std::vector<uint16_t> TiffFile::ReadUnsignedShortArray(const TiffIfdEntry& entry
 /// <param name="entry">The TiffIfdEntry to read.</param>
 /// <returns>A double floating point value represented by the 2 read LONG values.</returns>
 /// <exception cref="::std::runtime_error">When insufficient data is available, an exception is thrown.</exception>
-double TiffFile::ReadRational(const TiffIfdEntry& entry) {
+double TiffFile::ReadRational(const TiffIfdEntry& entry) const {
 	if (entry.TagType != TiffTagType::RATIONAL)
 		throw std::runtime_error("unexpected type for IFD tag encountered, should be RATIONAL");
 
-	AssertOffset(entry.ValueOffset);
-
-	auto offset = m_Stream.tellg();
-
-	m_Stream.seekg(entry.ValueOffset, std::ios::beg);
-
-	AssertSizeLeft(sizeof(std::uint32_t) * 2);
+	std::vector<uint8_t> buffer;
+	auto bytes = ReadRange(GetValueOffset(entry), sizeof(std::uint32_t) * 2, buffer);
 
-	auto numerator = (double)m_IntegerReader.Uint32();
-	auto denominator = (double)m_IntegerReader.Uint32();
-	auto result = 0.0;
+	return Dispatch([&](auto endian) {
+		auto numerator = (double)endian.Uint32(bytes.Data());
+		auto denominator = (double)endian.Uint32(bytes.Data() + sizeof(std::uint32_t));
 
-	m_Stream.seekg(offset, std::ios::beg);
+		if (denominator == 0)
+			return 0.0;
 
-	if (denominator == 0)
-		return result;
-
-	return numerator / denominator;
+		return numerator / denominator;
+	});
 }
 
 /// <summary>
@@ -467,7 +817,7 @@ double TiffFile::ReadRational(const TiffIfdEntry& entry) {
 /// <param name="entry">The TiffIfdEntry to read.</param>
 /// <returns>The resulting string, or an empty string when its length was 0.</returns>
 /// <exception cref="::std::runtime_error">When insufficient data is available, an exception is thrown.</exception>
-std::string TiffFile::ReadAsciiString(const TiffIfdEntry& entry) {
+std::string TiffFile::ReadAsciiString(const TiffIfdEntry& entry) const {
 	if (entry.TagType != TiffTagType::ASCII)
 		throw std::runtime_error("unexpected type for IFD tag encountered, should be ASCII");
 
@@ -475,16 +825,8 @@ std::string TiffFile::ReadAsciiString(const TiffIfdEntry& entry) {
 	if (entry.ValueCount <= 1)
 		return "";
 
-	AssertOffset(entry.ValueOffset);
-
-	auto offset = m_Stream.tellg();
-	std::string result(static_cast<size_t>(entry.ValueCount - 1), ' ');
-
-	AssertSizeLeft(entry.ValueCount - 1);
+	std::vector<uint8_t> buffer;
+	auto bytes = ReadRange(GetValueOffset(entry), entry.ValueCount - 1, buffer);
 
-	m_Stream.seekg(entry.ValueOffset, std::ios::beg);
-	m_Stream.read(&result[0], entry.ValueCount - 1);
-	m_Stream.seekg(offset, std::ios::beg);
-
-	return result;
-}
\ No newline at end of file
+	return std::string(reinterpret_cast<const char*>(bytes.Data()), bytes.Size());
+}
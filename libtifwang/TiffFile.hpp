@@ -4,46 +4,34 @@
 
 #ifndef tiff_file_h
 #define tiff_file_h
+	#include "MappedFile.hpp"
+	#include "TiffEndian.hpp"
 
 	namespace TiffWang {
 		namespace Tiff {
 			constexpr const char*	IntelEndian	 = "II";		// Start bytes of Tiff files, little endian.
 			constexpr const char*	MotorolaEndian = "MM";		// Start bytes of Tiff files, big endian.
 			constexpr uint16_t		Magic = 42;					// Magic number in Tiff header.
+			constexpr uint16_t		BigTiffMagic = 43;			// Magic number in BigTIFF header.
+			constexpr uint16_t		BigTiffOffsetSize = 8;		// The size of offsets in BigTIFF files, as stored in the header.
 
 			/// <summary>
-			/// A struct allowing for defining how to read integers (and floating point numbers) dynamically. This is
-			/// used to read both little endian and big endian streams.
+			/// Describes how a <see cref="TiffFile"/> accesses the underlying file.
 			/// </summary>
-			struct TiffNumericReader {
-				std::function<int16_t()>	Int16;
-				std::function<uint16_t()>	Uint16;
-				std::function<int32_t()>	Int32;
-				std::function<uint32_t()>	Uint32;
-				std::function<int64_t()>	Int64;
-				std::function<uint64_t()>	Uint64;
-				std::function<float()>		Float;
-				std::function<double()>		Double;
-
-				std::function<int16_t()>	Int16Le;
-				std::function<uint16_t()>	Uint16Le;
-				std::function<int32_t()>	Int32Le;
-				std::function<uint32_t()>	Uint32Le;
-				std::function<int64_t()>	Int64Le;
-				std::function<uint64_t()>	Uint64Le;
-				std::function<float()>		FloatLe;
-				std::function<double()>		DoubleLe;
+			enum class TiffAccessMode {
+				Stream,		// Read the file through a file stream, seeking for every tag value.
+				Mapped		// Map the file into memory once, tag values can be accessed as views without copying.
 			};
 
 #pragma pack( push, 1 )
 
 			/// <summary>
-			/// The Tiff file header
+			/// The Tiff file header, for both classic Tiff and BigTIFF files.
 			/// </summary>
 			struct TiffHeader {
 				char		ByteOrder[2];		// Should be either II or MM.
-				uint16_t	Magic;				// 42.
-				uint32_t	OffsetFirstIfd;		// Offset from beginning of stream to first IFD.
+				uint16_t	Magic;				// 42 for classic Tiff, 43 for BigTIFF.
+				uint64_t	OffsetFirstIfd;		// Offset from beginning of stream to first IFD.
 			};
 
 			/// <summary>
@@ -52,8 +40,9 @@
 			struct TiffIfdEntry {
 				TiffTagId	TagId;				// The identification of this tag.
 				TiffTagType	TagType;			// The type of this tag.
-				uint32_t	ValueCount;			// The number of values referenced by this tag (in bytes, that is sizeof(TagType) * ValueCount).
-				uint32_t	ValueOffset;		// The offset (from the beginning of the stream) to the first value.
+				uint64_t	ValueCount;			// The number of values referenced by this tag (in bytes, that is sizeof(TagType) * ValueCount).
+				uint64_t	ValueOffset;		// The offset (from the beginning of the stream) to the first value.
+				uint64_t	InlineOffset;		// The offset (from the beginning of the stream) of the ValueOffset field itself, values of 4 (BigTIFF: 8) bytes or less are stored there.
 				bool		IsWangTag;			// True when this tag refers to an eiStream/Wang tag.
 			};
 
@@ -74,6 +63,39 @@
 				TiffResolutionUnit	ResolutionUnit = TiffResolutionUnit::NoAbsoluteMeasurement;
 			};
 
+			/// <summary>
+			/// The layout and encoding of the image data of an IFD (Tiff page), which is required to decode the image natively.
+			/// </summary>
+			struct TiffImageLayout {
+				TiffCompression			Compression = TiffCompression::None;				// The compression scheme of the strips.
+				TiffPhotometric			Photometric = TiffPhotometric::WhiteIsZero;		// The interpretation of pixel values.
+				TiffFillOrder			FillOrder = TiffFillOrder::MsbToLsb;			// The order of bits within a byte.
+				uint16_t				BitsPerSample = 1;								// The number of bits per component.
+				uint16_t				SamplesPerPixel = 1;							// The number of components per pixel.
+				uint32_t				RowsPerStrip = UINT32_MAX;						// The number of rows in each strip, except possibly the last one.
+				uint32_t				T4Options = 0;									// Options for TiffCompression::CcittT4, see TiffT4Options.
+				uint32_t				T6Options = 0;									// Options for TiffCompression::CcittT6.
+				std::vector<uint64_t>	StripOffsets;									// The offset (from the beginning of the stream) of each strip.
+				std::vector<uint64_t>	StripByteCounts;								// The number of (compressed) bytes in each strip.
+			};
+
+			/// <summary>
+			/// A single IFD (page) in the page index of a <see cref="TiffFile"/>. Only the location of the IFD is known 
+			/// after scanning, the tags and the information derived from them are decoded on first access.
+			/// </summary>
+			struct TiffPage {
+				uint64_t					Offset = 0;			// The offset (from the beginning of the stream) to the IFD.
+				uint64_t					EntryCount = 0;		// The number of tags in the IFD.
+				bool						Loaded = false;		// True when the tags below have been decoded.
+
+				std::vector<TiffIfdEntry>	Entries;			// The tags in this IFD.
+				TiffDimensions				Dimensions;			// The dimensions and resolution of this IFD.
+				TiffImageLayout				Layout;				// The layout and encoding of the image data of this IFD.
+				std::string					Software;			// The software that wrote this IFD, if available.
+				std::string					DateTime;			// The formatted creation date and time of this IFD, if available.
+				std::string					Artist;				// The artist name, if available.
+			};
+
 			/// <summary>
 			/// The TiffFile class is capable of handling a Tiff file on binary level, so not on graphical level. It does not decode 
 			/// the image, it merely parses the structure of the file and enumerates all the tags. With this information, a developer
@@ -85,23 +107,24 @@
 				/// </summary>
 				friend class WangAnnotationReader;
 
-				using TiffIfdList		= std::vector<std::vector<TiffIfdEntry>>;	// A list of image file directories, which are lists of tags, i.e. [1] is the IFD of page 2.
-				using TiffDimensionList = std::vector<TiffDimensions>;				// A list of IFD dimensions, i.e. [1] is the dimensions of page 2.
-				using TiffStringList	= std::vector<std::string>;					// A simple alias for a vector of strings.
+				using TiffPageList		= std::vector<TiffPage>;	// A list of IFDs in the order they were found in the file.
+				using TiffPageOrder		= std::vector<size_t>;		// A permutation of page indices to indices in the TiffPageList, i.e. [1] is the IFD of page 2.
 
 				private:
 					#pragma warning ( push )
 					#pragma warning ( disable: 4251 ) /* "needs to have dll-interface to be used by clients of class" - members are not public and have no friends outside the DLL */
 					mutable std::ifstream	m_Stream;
-					size_t					m_StreamSize;
-					TiffNumericReader		m_IntegerReader;
+					uint64_t				m_StreamSize;
+					TiffAccessMode			m_Mode = TiffAccessMode::Stream;
+					std::shared_ptr<const void>	m_Owner;	/* keeps the memory behind m_View alive */
+					ByteView				m_View;
+					TiffByteOrder			m_ByteOrder = TiffByteOrder::Intel;
 					TiffHeader				m_Header;
-					TiffIfdList				m_PageIfdCollection;
-					TiffDimensionList		m_Dimensions;
-
-					TiffStringList			m_Software;
-					TiffStringList			m_DateTime;
-					TiffStringList			m_Artist;
+					mutable TiffPageList	m_Pages;
+					TiffPageOrder			m_PageOrder;
+					TiffPageOrder			m_ChainOrder;	/* the inverse of m_PageOrder, the page index of each IFD in the chain */
+					mutable std::mutex		m_PageMutex;	/* guards decoding pages on first access */
+					mutable std::mutex		m_StreamMutex;	/* guards the stream position while reading */
 
 					#pragma warning ( pop )
 				public:
@@ -109,15 +132,34 @@
 					/// Construct a new TiffFile instance from ascii filepath.
 					/// </summary>
 					/// <param name="filepath">The Tiff-file to parse.</param>
-					TiffFile(const std::string& filepath);
+					/// <param name="mode">How to access the file, either streamed or memory mapped.</param>
+					TiffFile(const std::string& filepath, TiffAccessMode mode = TiffAccessMode::Stream);
 
 					/// <summary>
 					/// Construct a new TiffFile instance from unicode filepath.
 					/// </summary>
 					/// <param name="filepath">The Tiff-file to parse.</param>
-					TiffFile(const std::wstring& filepath);
+					/// <param name="mode">How to access the file, either streamed or memory mapped.</param>
+					TiffFile(const std::wstring& filepath, TiffAccessMode mode = TiffAccessMode::Stream);
+
+					/// <summary>
+					/// Construct a new TiffFile instance over Tiff data that is already in memory, such as a <see cref="MappedFile"/> 
+					/// that is shared with the image decoder. No data is copied, the instance behaves as if it was opened in 
+					/// <see cref="TiffAccessMode::Mapped"/> mode.
+					/// </summary>
+					/// <param name="data">The Tiff data.</param>
+					/// <param name="owner">The owner of the memory <paramref name="data"/> refers to, which is kept alive for as long as this instance lives.</param>
+					TiffFile(ByteView data, std::shared_ptr<const void> owner);
 
 				private:
+					/// <summary>
+					/// Open the file either as stream or as memory mapped file.
+					/// </summary>
+					/// <param name="filepath">The Tiff-file to open.</param>
+					/// <param name="mode">How to access the file.</param>
+					template <typename TPath>
+					void Open(const TPath& filepath, TiffAccessMode mode);
+
 					/// <summary>
 					/// Initialize the opened file stream, read and process the file header.
 					/// </summary>
@@ -130,7 +172,8 @@
 					TiffFile& operator=(TiffFile&&) = delete;
 
 					/// <summary>
-					/// Process all the Image File Directories.
+					/// Index all the Image File Directories. This only records the location of each IFD and determines the 
+					/// page order, the tags of a page are decoded when the page is accessed for the first time.
 					/// </summary>
 					void ReadIfdCollection();
 
@@ -140,6 +183,24 @@
 					/// <returns>The number of directories (or pages).</returns>
 					size_t GetPageCount() const noexcept;
 
+					/// <summary>
+					/// Get the position of an IFD (page) in the IFD chain of the file. Pages are ordered by their page number 
+					/// tags when these are present, decoders that count pages along the chain must be given this index instead.
+					/// </summary>
+					/// <param name="pageIndex">The IFD (page) index.</param>
+					/// <returns>The index of the IFD in the order of reading.</returns>
+					/// <exception cref="std::out_of_range">When the index is out of range.</exception>
+					size_t GetPageIfdChainIndex(size_t pageIndex) const;
+
+					/// <summary>
+					/// Get the page index of an IFD by its position in the IFD chain of the file, the inverse of 
+					/// <see cref="GetPageIfdChainIndex"/>.
+					/// </summary>
+					/// <param name="ifdChainIndex">The index of the IFD in the order of reading.</param>
+					/// <returns>The IFD (page) index.</returns>
+					/// <exception cref="std::out_of_range">When the index is out of range.</exception>
+					size_t GetPageIndexOfIfdChainIndex(size_t ifdChainIndex) const;
+
 					/// <summary>
 					/// Get the total number of tags in a specific IFD (page).
 					/// </summary>
@@ -165,6 +226,25 @@
 					/// <exception cref="std::out_of_range">When indices are out of range.</exception>
 					const TiffDimensions& GetDimensions(size_t pageIndex) const;
 
+					/// <summary>
+					/// Get the layout and encoding of the image data for a specific IFD (page).
+					/// </summary>
+					/// <param name="pageIndex">The IFD (page) index.</param>
+					/// <returns>A const reference to the image layout.</returns>
+					/// <exception cref="std::out_of_range">When indices are out of range.</exception>
+					const TiffImageLayout& GetImageLayout(size_t pageIndex) const;
+
+					/// <summary>
+					/// Get the raw (compressed) data of a single strip of a specific IFD (page).
+					/// </summary>
+					/// <param name="pageIndex">The IFD (page) index.</param>
+					/// <param name="strip">The strip index.</param>
+					/// <param name="buffer">The buffer to read to when the file is not mapped.</param>
+					/// <returns>A view on the strip data, valid until <paramref name="buffer"/> is modified or this instance is destroyed.</returns>
+					/// <exception cref="std::out_of_range">When indices are out of range.</exception>
+					/// <exception cref="std::runtime_error">When the strip is out of bounds of the file.</exception>
+					ByteView GetStripData(size_t pageIndex, size_t strip, std::vector<uint8_t>& buffer) const;
+
 					/// <summary>
 					/// Get the name of the software that wrote a specific IFD (page).
 					/// </summary>
@@ -189,33 +269,146 @@
 					/// <exception cref="std::out_of_range">When indices are out of range.</exception>
 					const std::string& GetArtist(size_t pageIndex) const;
 
+					/// <summary>
+					/// Determines if this file was opened in <see cref="TiffAccessMode::Mapped"/> mode.
+					/// </summary>
+					/// <returns>True when the file is memory mapped.</returns>
+					bool IsMapped() const noexcept;
+
+					/// <summary>
+					/// Determines if this file is a BigTIFF file, with 64-bit offsets and counts.
+					/// </summary>
+					/// <returns>True when the file is a BigTIFF file.</returns>
+					bool IsBigTiff() const noexcept;
+
+					/// <summary>
+					/// Get a view on the raw value bytes of a tag, directly in the memory mapped file. No data is copied, the
+					/// view remains valid for as long as this <see cref="TiffFile"/> instance lives.
+					/// </summary>
+					/// <param name="entry">The TiffIfdEntry to get the values for.</param>
+					/// <returns>A view on all the value bytes of the tag, in file byte order.</returns>
+					/// <exception cref="::std::runtime_error">When the file is not mapped or the values are out of bounds.</exception>
+					ByteView GetValueView(const TiffIfdEntry& entry) const;
+
+					/// <summary>
+					/// Get the size of a single value of a certain tag type.
+					/// </summary>
+					/// <param name="type">The tag type.</param>
+					/// <returns>The size in bytes, or 0 for unknown types.</returns>
+					static size_t GetTypeSize(TiffTagType type) noexcept;
+
 				private:
 					/// <summary>
-					/// Correct the order of IFD collections based on page index tags, if any. If one of 
-					/// the IFDs (pages) does not contain a page index tag, the order of reading is maintained.
+					/// Find the page number of an IFD, by only looking at the tag identifiers.
 					/// </summary>
-					void CorrectIfdOrder();
+					/// <param name="endian">The decoder for the byte order of this file.</param>
+					/// <param name="page">The page index entry of the IFD.</param>
+					/// <param name="entries">The raw entries of the IFD.</param>
+					/// <param name="pageNumber">The resulting page number, if found.</param>
+					/// <returns>True when the IFD contains a valid page number tag.</returns>
+					template <typename TEndian>
+					bool FindPageNumber(TEndian endian, const TiffPage& page, ByteView entries, size_t& pageNumber) const;
 
 					/// <summary>
-					/// Determines how many bytes there are left in the stream to read.
+					/// Build the page order permutation based on page number tags, if any. If one of the IFDs (pages) 
+					/// does not contain a valid page number tag, the order of reading is maintained.
 					/// </summary>
-					/// <returns>Number of bytes left</returns>
-					size_t SizeLeft() const;
+					/// <param name="pageNumbers">The page number of each IFD, in the order of reading, or an empty list when not all are known.</param>
+					void BuildPageOrder(const std::vector<size_t>& pageNumbers);
 
 					/// <summary>
-					/// Throw an exception if there is not enough data left to read.
+					/// Get a page from the index by page index, decoding its tags when this has not been done before. This is safe to call
+					/// from multiple threads, so pages of one file can be processed concurrently.
 					/// </summary>
-					/// <param name="required">The number of bytes required in the stream.</param>
-					/// <exception cref="std::runtime_error">When required &lt; SizeLeft().</exception>
-					void AssertSizeLeft(size_t required) const;
+					/// <param name="pageIndex">The IFD (page) index.</param>
+					/// <returns>A const reference to the decoded page.</returns>
+					/// <exception cref="std::out_of_range">When the index is out of range.</exception>
+					const TiffPage& GetPage(size_t pageIndex) const;
 
+					/// <summary>
+					/// Decode all the tags of a page and the information derived from them.
+					/// </summary>
+					/// <param name="page">The page to decode.</param>
+					void LoadPage(TiffPage& page) const;
+
+					/// <summary>
+					/// Invoke a function with the <see cref="TiffEndian"/> decoder for the byte order of this file. The byte order 
+					/// is only tested here, so everything inside <paramref name="function"/> decodes with inlined byte swaps.
+					/// </summary>
+					/// <param name="function">A generic callable, accepting either <see cref="TiffIntelEndian"/> or <see cref="TiffMotorolaEndian"/>.</param>
+					/// <returns>The result of <paramref name="function"/>.</returns>
+					template <typename TFunction>
+					auto Dispatch(TFunction&& function) const;
+
+					/// <summary>
+					/// Decode a single IFD entry.
+					/// </summary>
+					/// <param name="endian">The decoder for the byte order of this file.</param>
+					/// <param name="data">The raw entry, <see cref="GetEntrySize"/>() bytes.</param>
+					/// <param name="position">The offset (from the beginning of the stream) of the raw entry.</param>
+					/// <returns>The entry.</returns>
+					template <typename TEndian>
+					TiffIfdEntry DecodeEntry(TEndian endian, const uint8_t* data, uint64_t position) const noexcept;
+
+					/// <summary>
+					/// Decode an offset or count, which is a LONG in classic Tiff files and a LONG8 in BigTIFF files.
+					/// </summary>
+					/// <param name="endian">The decoder for the byte order of this file.</param>
+					/// <param name="data">The raw value, <see cref="GetOffsetSize"/>() bytes.</param>
+					/// <returns>The decoded value.</returns>
+					template <typename TEndian>
+					uint64_t DecodeOffset(TEndian endian, const uint8_t* data) const noexcept;
+
+					/// <summary>
+					/// Get the size of a single IFD entry, 12 bytes in classic Tiff files and 20 bytes in BigTIFF files.
+					/// </summary>
+					/// <returns>The size in bytes.</returns>
+					uint64_t GetEntrySize() const noexcept;
+
+					/// <summary>
+					/// Get the size of the entry count at the start of an IFD, 2 bytes in classic Tiff files and 8 bytes in BigTIFF files.
+					/// </summary>
+					/// <returns>The size in bytes.</returns>
+					uint64_t GetEntryCountSize() const noexcept;
+
+					/// <summary>
+					/// Get the size of an offset, 4 bytes in classic Tiff files and 8 bytes in BigTIFF files.
+					/// </summary>
+					/// <returns>The size in bytes.</returns>
+					uint64_t GetOffsetSize() const noexcept;
+
+					/// <summary>
+					/// Get a range of raw bytes from the file. In <see cref="TiffAccessMode::Mapped"/> mode this is a view in the 
+					/// mapping, otherwise the range is read into <paramref name="buffer"/> with a single read.
+					/// </summary>
+					/// <param name="offset">The offset from the beginning of the file.</param>
+					/// <param name="size">The number of bytes.</param>
+					/// <param name="buffer">The buffer to read to when the file is not mapped.</param>
+					/// <returns>A view on the requested range, valid until <paramref name="buffer"/> is modified.</returns>
+					/// <exception cref="std::runtime_error">When the range is out of bounds or cannot be read.</exception>
+					ByteView ReadRange(uint64_t offset, uint64_t size, std::vector<uint8_t>& buffer) const;
+
+					/// <summary>
+					/// Get the total size of the values referenced by a tag.
+					/// </summary>
+					/// <param name="entry">The TiffIfdEntry.</param>
+					/// <returns>The size in bytes.</returns>
+					static uint64_t GetValueSize(const TiffIfdEntry& entry) noexcept;
 
 					/// <summary>
-					/// Throw an exception if a certain offset in a stream does not exist.
+					/// Get the location of the values referenced by a tag, taking values stored inline in the tag into account.
+					/// </summary>
+					/// <param name="entry">The TiffIfdEntry.</param>
+					/// <returns>The offset from the beginning of the file.</returns>
+					uint64_t GetValueOffset(const TiffIfdEntry& entry) const noexcept;
+
+					/// <summary>
+					/// Throw an exception if a certain range in a stream does not exist.
 					/// </summary>
 					/// <param name="offset">The offset to test</param>
-					/// <exception cref="std::runtime_error">When the offset is out of bounds.</exception>
-					void AssertOffset(size_t offset) const;
+					/// <param name="size">The number of bytes that should be available at <paramref name="offset"/>.</param>
+					/// <exception cref="std::runtime_error">When the range is out of bounds.</exception>
+					void AssertRange(uint64_t offset, uint64_t size) const;
 
 					/// <summary>
 					/// Throw an exception if the IFD (page) index is out of range.
@@ -232,36 +425,6 @@
 					/// <exception cref="std::out_of_range">When either index is out of bounds.</exception>
 					void AssertPageIfdIndex(size_t pageIndex, size_t ifdIndex) const;
 
-					/// <summary>
-					/// Read a struct or class value from the stream.
-					/// </summary>
-					/// <param name="value">A reference to the value to read to.</param>
-					/// <typeparam name="The type of struct or class to read."></typeparam>
-					/// <exception cref="::std::runtime_error">When insufficient data is available, an exception is thrown.</exception>
-					template <
-						typename TValue,
-						std::enable_if_t<std::is_class_v<TValue>, int> = 0
-					>
-					void Read(TValue& value);
-					
-					/// <summary>
-					/// Read an integral or floating point value from the stream.
-					/// </summary>
-					/// <typeparam name="TValue">The type of integral or floating point value to read.</typeparam>
-					/// <returns>The read value.</returns>
-					/// <exception cref="::std::runtime_error">When insufficient data is available, an exception is thrown.</exception>
-					template <typename TValue,
-						std::enable_if_t<
-							std::conjunction<
-								std::disjunction<std::is_integral<TValue>, std::is_floating_point<TValue>>,
-								std::negation<std::is_pointer<TValue>>,
-								std::negation<std::is_reference<TValue>>
-							>::value,
-							int
-						> = 0
-					>
-					TValue Read();
-
 					/// <summary>
 					/// Read all the associated tag data from a BYTE tag to a buffer.
 					/// </summary>
@@ -285,7 +448,23 @@
 					/// <param name="entry">The TiffIfdEntry to read.</param>
 					/// <returns>A vector of read unsigned shorts.</returns>
 					/// <exception cref="::std::runtime_error">When insufficient data is available, an exception is thrown.</exception>
-					std::vector<uint16_t> ReadUnsignedShortArray(const TiffIfdEntry& entry);
+					std::vector<uint16_t> ReadUnsignedShortArray(const TiffIfdEntry& entry) const;
+
+					/// <summary>
+					/// Read all values of a SHORT, LONG or LONG8 tag as unsigned integers.
+					/// </summary>
+					/// <param name="entry">The TiffIfdEntry to read.</param>
+					/// <returns>A vector of read values.</returns>
+					/// <exception cref="::std::runtime_error">When insufficient data is available or the type is not an unsigned integer type, an exception is thrown.</exception>
+					std::vector<uint64_t> ReadUnsignedIntegerArray(const TiffIfdEntry& entry) const;
+
+					/// <summary>
+					/// Read the first value of a BYTE, SHORT, LONG or LONG8 tag as unsigned integer.
+					/// </summary>
+					/// <param name="entry">The TiffIfdEntry to read.</param>
+					/// <returns>The value.</returns>
+					/// <exception cref="::std::runtime_error">When insufficient data is available or the type is not an unsigned integer type, an exception is thrown.</exception>
+					uint64_t ReadUnsignedInteger(const TiffIfdEntry& entry) const;
 
 					/// <summary>
 					/// Read a rational number (two TiffTagType::LONG values) and produce a rational number,
@@ -294,7 +473,7 @@
 					/// <param name="entry">The TiffIfdEntry to read.</param>
 					/// <returns>A double floating point value represented by the 2 read LONG values.</returns>
 					/// <exception cref="::std::runtime_error">When insufficient data is available, an exception is thrown.</exception>
-					double ReadRational(const TiffIfdEntry& entry);
+					double ReadRational(const TiffIfdEntry& entry) const;
 
 					/// <summary>
 					/// Read a NUL-terminated Ascii-string, ignoring the NUL character.
@@ -302,7 +481,7 @@
 					/// <param name="entry">The TiffIfdEntry to read.</param>
 					/// <returns>The resulting string, or an empty string when its length was 0.</returns>
 					/// <exception cref="::std::runtime_error">When insufficient data is available, an exception is thrown.</exception>
-					std::string ReadAsciiString(const TiffIfdEntry& entry);
+					std::string ReadAsciiString(const TiffIfdEntry& entry) const;
 			};
 
 		}
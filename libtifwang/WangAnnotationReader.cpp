@@ -20,6 +20,7 @@ using namespace TiffWang::Tiff;
 /// </summary>
 /// <param name="file">The opened Tiff file.</param>
 /// <param name="tag">The eiStream/Wang tag to process.</param>
+/// <remarks>When <paramref name="file"/> is memory mapped, the tag data is read in place and is not copied.</remarks>
 /// <exception cref="std::runtime_error">Thrown when the <paramref name="tag"/> is not an eiStream/Wang tag or when insufficient data is available to read.</exception>
 WangAnnotationReader::WangAnnotationReader(TiffFile& file, const TiffIfdEntry& tag)
 	: m_File(file), m_Tag(tag) {
@@ -30,8 +31,14 @@ WangAnnotationReader::WangAnnotationReader(TiffFile& file, const TiffIfdEntry& t
 	if (m_Tag.ValueCount == 0)
 		throw std::runtime_error("cannot process provided TiffIfdEntry as eiStream/WANG Annotation data, entry holds no values");
 
-	file.Read(tag, m_AnnotationData);
-	m_Size = m_AnnotationData.size();
+	if (file.IsMapped()) {
+		m_AnnotationData = file.GetValueView(tag);
+	} else {
+		file.Read(tag, m_AnnotationBuffer);
+		m_AnnotationData = ByteView(m_AnnotationBuffer);
+	}
+
+	m_Size = m_AnnotationData.Size();
 }
 
 /// <summary>
@@ -432,8 +439,8 @@ template <
 		int
 	>
 >
-TValue* WangAnnotationReader::GetAddress() {
-	return reinterpret_cast<TValue*>(&m_AnnotationData[m_Offset]);
+const TValue* WangAnnotationReader::GetAddress() const {
+	return reinterpret_cast<const TValue*>(m_AnnotationData.Data() + m_Offset);
 }
 
 /// <summary>
@@ -489,7 +496,7 @@ template <typename TValue, std::enable_if_t<std::is_class_v<TValue>, int >>
 [[nodiscard]] bool WangAnnotationReader::Read(std::string& value, size_t length) {
 	if (SizeLeft() < length)
 		return false;
-	value = std::string(reinterpret_cast<const char*>(&m_AnnotationData[m_Offset]), length);
+	value = std::string(reinterpret_cast<const char*>(m_AnnotationData.Data() + m_Offset), length);
 	m_Offset += length;
 	return true;
 }
@@ -503,8 +510,7 @@ template <typename TValue, std::enable_if_t<std::is_class_v<TValue>, int >>
 [[nodiscard]] bool WangAnnotationReader::Read(std::vector<uint8_t>& value, size_t length) {
 	if (SizeLeft() < length)
 		return false;
-	value.resize(length);
-	memcpy(reinterpret_cast<void*>(&value[0]), reinterpret_cast<const void*>(&m_AnnotationData[m_Offset]), length);
+	value.assign(m_AnnotationData.Data() + m_Offset, m_AnnotationData.Data() + m_Offset + length);
 	m_Offset += length;
 	return true;
 }
\ No newline at end of file
@@ -20,7 +20,8 @@
 					#pragma warning ( disable: 4251 ) /* "needs to have dll-interface to be used by clients of class" - members are not public */
 					TiffFile&				m_File;
 					const TiffIfdEntry&		m_Tag;
-					std::vector<uint8_t>	m_AnnotationData;
+					ByteView				m_AnnotationData;		// A view on the tag data, either in the mapped file or in m_AnnotationBuffer.
+					std::vector<uint8_t>	m_AnnotationBuffer;		// A copy of the tag data, only used when the file is not memory mapped.
 					size_t					m_Offset = 0;
 					size_t					m_Size;
 
@@ -34,6 +35,7 @@
 					/// </summary>
 					/// <param name="file">The opened Tiff file.</param>
 					/// <param name="tag">The eiStream/Wang tag to process.</param>
+					/// <remarks>When <paramref name="file"/> is memory mapped, the tag data is read in place and is not copied.</remarks>
 					/// <exception cref="std::runtime_error">Thrown when the <paramref name="tag"/> is not an eiStream/Wang tag or when insufficient data is available to read.</exception>
 					WangAnnotationReader(TiffFile& file, const TiffIfdEntry& tag);
 
@@ -113,7 +115,7 @@
 							int
 						> = 0
 					>
-					[[nodiscard]] TValue* GetAddress();
+					[[nodiscard]] const TValue* GetAddress() const;
 
 					/// <summary>
 					/// Read an integral or floating point value from the current state.
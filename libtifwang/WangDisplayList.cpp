@@ -0,0 +1,315 @@
+#include "pch.h"
+#include "WangDisplayList.hpp"
+#include "WangAnnotationReader.hpp"
+#include <algorithm>
+
+using namespace TiffWang::Tiff;
+
+/// <summary>
+/// The Recorder class is the <see cref="IWangAnnotationCallback"/> that appends the marks emitted by a
+/// <see cref="WangAnnotationReader"/> to a display list.
+/// </summary>
+class WangDisplayList::Recorder : public IWangAnnotationCallback {
+	private:
+		WangDisplayList& m_List;
+
+	public:
+		/// <summary>
+		/// Construct a new recorder for a display list.
+		/// </summary>
+		/// <param name="list">The list to append the marks to.</param>
+		Recorder(WangDisplayList& list) : m_List(list) {
+
+		}
+
+		/// <summary>
+		/// Record a line mark.
+		/// </summary>
+		void RenderLine(const RECT& bounds, const std::vector<POINT>& points, const RGBQUAD& color, uint32_t size, bool highlight, bool transparent) override {
+			auto& command = Add(CommandType::Line, bounds, highlight, transparent);
+			command.Color = color;
+			command.Size  = size;
+			command.First = static_cast<uint32_t>(m_List.m_Points.size());
+			command.Count = static_cast<uint32_t>(points.size());
+			m_List.m_Points.insert(m_List.m_Points.end(), points.begin(), points.end());
+		}
+
+		/// <summary>
+		/// Record a filled rectangle mark.
+		/// </summary>
+		void RenderRect(const RECT& bounds, const RGBQUAD& color, bool highlight, bool transparent) override {
+			Add(CommandType::Rect, bounds, highlight, transparent).Color = color;
+		}
+
+		/// <summary>
+		/// Record a filled and outlined rectangle mark.
+		/// </summary>
+		void RenderBorderedRect(const RECT& bounds, const RGBQUAD& color, const RGBQUAD& borderColor, uint32_t lineSize, bool highlight, bool transparent) override {
+			auto& command = Add(CommandType::BorderedRect, bounds, highlight, transparent);
+			command.Color       = color;
+			command.BorderColor = borderColor;
+			command.Size        = lineSize;
+		}
+
+		/// <summary>
+		/// Record an outlined rectangle mark.
+		/// </summary>
+		void RenderOutlinedRect(const RECT& bounds, const RGBQUAD& color, uint32_t lineSize, bool highlight, bool transparent) override {
+			auto& command = Add(CommandType::OutlinedRect, bounds, highlight, transparent);
+			command.Color = color;
+			command.Size  = lineSize;
+		}
+
+		/// <summary>
+		/// Record a text mark.
+		/// </summary>
+		void RenderText(const std::string& text, const RECT& bounds, const LOGFONTA& font, const OIAN_TEXTPRIVDATA& info, const RGBQUAD& color) override {
+			auto& command = Add(CommandType::Text, bounds, false, false);
+			command.Color = color;
+			AddText(command, text, m_List.m_Characters);
+			AddStyle(command, font, info);
+		}
+
+		/// <summary>
+		/// Record a text mark with wide characters.
+		/// </summary>
+		void RenderText(const std::wstring& text, const RECT& bounds, const LOGFONTA& font, const OIAN_TEXTPRIVDATA& info, const RGBQUAD& color) override {
+			auto& command = Add(CommandType::WideText, bounds, false, false);
+			command.Color = color;
+			AddText(command, text, m_List.m_WideCharacters);
+			AddStyle(command, font, info);
+		}
+
+		/// <summary>
+		/// Record a bitmask mark.
+		/// </summary>
+		void RenderMask(const std::string& filename, const RECT& bounds, const AN_NEW_ROTATE_STRUCT& rotation) override {
+			auto& command = Add(CommandType::Mask, bounds, false, false);
+			AddText(command, filename, m_List.m_Characters);
+			AddRotation(command, rotation);
+		}
+
+		/// <summary>
+		/// Record an image reference mark.
+		/// </summary>
+		void RenderImageReference(const std::string& filename, const RECT& bounds, const AN_NEW_ROTATE_STRUCT& rotation, bool highlight, bool transparent) override {
+			auto& command = Add(CommandType::ImageReference, bounds, highlight, transparent);
+			AddText(command, filename, m_List.m_Characters);
+			AddRotation(command, rotation);
+		}
+
+		/// <summary>
+		/// Record an image block (DIB data) mark.
+		/// </summary>
+		void RenderImage(const std::string& filename, const RECT& bounds, const AN_NEW_ROTATE_STRUCT& rotation, const std::vector<uint8_t>& data, bool highlight, bool transparent) override {
+			auto& command = Add(CommandType::Image, bounds, highlight, transparent);
+			AddText(command, filename, m_List.m_Characters);
+			AddRotation(command, rotation);
+
+			command.Size = static_cast<uint32_t>(m_List.m_Images.size());
+			m_List.m_Images.push_back(data);
+		}
+
+	private:
+		/// <summary>
+		/// Append a new command to the list.
+		/// </summary>
+		/// <param name="type">The kind of mark.</param>
+		/// <param name="bounds">The bounds of the mark.</param>
+		/// <param name="highlight">Whether the highlight filter is applied.</param>
+		/// <param name="transparent">Whether the transparent filter is applied.</param>
+		/// <returns>A reference to the command, valid until the next command is added.</returns>
+		Command& Add(CommandType type, const RECT& bounds, bool highlight, bool transparent) {
+			Command command = {};
+			command.Type        = type;
+			command.Bounds      = bounds;
+			command.Highlight   = highlight;
+			command.Transparent = transparent;
+
+			m_List.m_Commands.push_back(command);
+			return m_List.m_Commands.back();
+		}
+
+		/// <summary>
+		/// Store the characters of a string in a pool and refer to them from a command.
+		/// </summary>
+		/// <param name="command">The command.</param>
+		/// <param name="text">The string.</param>
+		/// <param name="pool">The pool of characters.</param>
+		template <typename TChar>
+		static void AddText(Command& command, const std::basic_string<TChar>& text, std::vector<TChar>& pool) {
+			command.First = static_cast<uint32_t>(pool.size());
+			command.Count = static_cast<uint32_t>(text.size());
+			pool.insert(pool.end(), text.begin(), text.end());
+		}
+
+		/// <summary>
+		/// Store the font and scaling of a text mark.
+		/// </summary>
+		/// <param name="command">The command.</param>
+		/// <param name="font">The font.</param>
+		/// <param name="info">The scaling information.</param>
+		void AddStyle(Command& command, const LOGFONTA& font, const OIAN_TEXTPRIVDATA& info) {
+			command.Attributes = static_cast<uint32_t>(m_List.m_Styles.size());
+			m_List.m_Styles.push_back({ font, info });
+		}
+
+		/// <summary>
+		/// Store the rotation of a mask or image mark.
+		/// </summary>
+		/// <param name="command">The command.</param>
+		/// <param name="rotation">The rotation.</param>
+		void AddRotation(Command& command, const AN_NEW_ROTATE_STRUCT& rotation) {
+			command.Attributes = static_cast<uint32_t>(m_List.m_Rotations.size());
+			m_List.m_Rotations.push_back(rotation);
+		}
+};
+
+/// <summary>
+/// Compile the eiStream/Wang tags of a page into a display list.
+/// </summary>
+/// <param name="file">The opened Tiff file.</param>
+/// <param name="pageIndex">The IFD (page) index.</param>
+/// <returns>A shared pointer to the display list, which is empty when the page has no eiStream/Wang tags.</returns>
+/// <exception cref="std::runtime_error">Thrown when a tag cannot be read.</exception>
+std::shared_ptr<const WangDisplayList> WangDisplayList::Compile(TiffFile& file, size_t pageIndex) {
+	auto list = std::make_shared<WangDisplayList>();
+
+	for (size_t ifdIndex = 0; ifdIndex < file.GetPageIfdCount(pageIndex); ifdIndex++) {
+		const auto& ifd = file.GetPageIfd(pageIndex, ifdIndex);
+		if (ifd.IsWangTag)
+			list->Append(file, ifd);
+	}
+
+	return list;
+}
+
+/// <summary>
+/// Compile a single eiStream/Wang tag into a display list.
+/// </summary>
+/// <param name="file">The opened Tiff file.</param>
+/// <param name="tag">The eiStream/Wang tag to compile.</param>
+/// <returns>A shared pointer to the display list.</returns>
+/// <exception cref="std::runtime_error">Thrown when the tag is not an eiStream/Wang tag or cannot be read.</exception>
+std::shared_ptr<const WangDisplayList> WangDisplayList::Compile(TiffFile& file, const TiffIfdEntry& tag) {
+	auto list = std::make_shared<WangDisplayList>();
+	list->Append(file, tag);
+	return list;
+}
+
+/// <summary>
+/// Replay every mark into a handler, in the order the marks were read.
+/// </summary>
+/// <param name="handler">The handler to invoke for every mark.</param>
+void WangDisplayList::Replay(IWangAnnotationCallback& handler) const {
+	std::vector<POINT> points;
+
+	for (const auto& command : m_Commands) {
+		switch (command.Type) {
+			case CommandType::Line:
+				points.assign(m_Points.begin() + command.First, m_Points.begin() + command.First + command.Count);
+				handler.RenderLine(command.Bounds, points, command.Color, command.Size, command.Highlight, command.Transparent);
+				break;
+			case CommandType::Rect:
+				handler.RenderRect(command.Bounds, command.Color, command.Highlight, command.Transparent);
+				break;
+			case CommandType::BorderedRect:
+				handler.RenderBorderedRect(command.Bounds, command.Color, command.BorderColor, command.Size, command.Highlight, command.Transparent);
+				break;
+			case CommandType::OutlinedRect:
+				handler.RenderOutlinedRect(command.Bounds, command.Color, command.Size, command.Highlight, command.Transparent);
+				break;
+			case CommandType::Text: {
+				const auto& style = m_Styles[command.Attributes];
+				handler.RenderText(std::string(m_Characters.begin() + command.First, m_Characters.begin() + command.First + command.Count), command.Bounds, style.Font, style.Info, command.Color);
+				break;
+			}
+			case CommandType::WideText: {
+				const auto& style = m_Styles[command.Attributes];
+				handler.RenderText(std::wstring(m_WideCharacters.begin() + command.First, m_WideCharacters.begin() + command.First + command.Count), command.Bounds, style.Font, style.Info, command.Color);
+				break;
+			}
+			case CommandType::Mask:
+				handler.RenderMask(std::string(m_Characters.begin() + command.First, m_Characters.begin() + command.First + command.Count), command.Bounds, m_Rotations[command.Attributes]);
+				break;
+			case CommandType::ImageReference:
+				handler.RenderImageReference(std::string(m_Characters.begin() + command.First, m_Characters.begin() + command.First + command.Count), command.Bounds, m_Rotations[command.Attributes], command.Highlight, command.Transparent);
+				break;
+			case CommandType::Image:
+				handler.RenderImage(std::string(m_Characters.begin() + command.First, m_Characters.begin() + command.First + command.Count), command.Bounds, m_Rotations[command.Attributes], m_Images[command.Size], command.Highlight, command.Transparent);
+				break;
+		}
+	}
+}
+
+/// <summary>
+/// Get the area of the page every mark draws onto, in the order the marks were read. This is the bounding 
+/// rectangle (lrBounds) of the mark, normalized and grown to include the points of lines and the width of 
+/// lines and outlines. Masks and image references are not drawn and have no area.
+/// </summary>
+/// <returns>The areas of the marks that draw onto the page.</returns>
+std::vector<RECT> WangDisplayList::GetBounds() const {
+	std::vector<RECT> result;
+	result.reserve(m_Commands.size());
+
+	for (const auto& command : m_Commands) {
+		if (command.Type == CommandType::Mask || command.Type == CommandType::ImageReference)
+			continue;
+
+		RECT bounds;
+		bounds.left   = (std::min)(command.Bounds.left, command.Bounds.right);
+		bounds.top    = (std::min)(command.Bounds.top, command.Bounds.bottom);
+		bounds.right  = (std::max)(command.Bounds.left, command.Bounds.right);
+		bounds.bottom = (std::max)(command.Bounds.top, command.Bounds.bottom);
+
+		// The points of a line are relative to the top left of its bounds.
+		if (command.Type == CommandType::Line) {
+			for (uint32_t i = command.First; i < command.First + command.Count; ++i) {
+				bounds.left   = (std::min)(bounds.left, command.Bounds.left + m_Points[i].x);
+				bounds.top    = (std::min)(bounds.top, command.Bounds.top + m_Points[i].y);
+				bounds.right  = (std::max)(bounds.right, command.Bounds.left + m_Points[i].x);
+				bounds.bottom = (std::max)(bounds.bottom, command.Bounds.top + m_Points[i].y);
+			}
+		}
+
+		// Lines and outlines are centered on their path.
+		if (command.Type == CommandType::Line || command.Type == CommandType::BorderedRect || command.Type == CommandType::OutlinedRect) {
+			auto margin = static_cast<LONG>(command.Size / 2 + 1);
+			bounds.left   -= margin;
+			bounds.top    -= margin;
+			bounds.right  += margin;
+			bounds.bottom += margin;
+		}
+
+		result.push_back(bounds);
+	}
+
+	return result;
+}
+
+/// <summary>
+/// Get the number of marks in the list.
+/// </summary>
+/// <returns>The number of marks.</returns>
+size_t WangDisplayList::GetSize() const noexcept {
+	return m_Commands.size();
+}
+
+/// <summary>
+/// Determine if the list holds no marks.
+/// </summary>
+/// <returns>True when the list is empty.</returns>
+bool WangDisplayList::IsEmpty() const noexcept {
+	return m_Commands.empty();
+}
+
+/// <summary>
+/// Read an eiStream/Wang tag and append its marks to this list.
+/// </summary>
+/// <param name="file">The opened Tiff file.</param>
+/// <param name="tag">The eiStream/Wang tag to read.</param>
+void WangDisplayList::Append(TiffFile& file, const TiffIfdEntry& tag) {
+	WangAnnotationReader reader(file, tag);
+	reader.SetHandler(std::make_shared<Recorder>(*this));
+	reader.Read();
+}
\ No newline at end of file
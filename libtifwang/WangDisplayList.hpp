@@ -0,0 +1,140 @@
+#pragma once
+
+#include "pch.h"
+
+#ifndef wang_display_list_h
+#define wang_display_list_h
+	#include "TiffFile.hpp"
+	#include "IWangAnnotationCallback.hpp"
+
+	namespace TiffWang {
+		namespace Tiff {
+			/// <summary>
+			/// The WangDisplayList class is an immutable, compiled form of the marks in one or more eiStream/Wang annotation tags.
+			/// The tags are parsed once by the <see cref="WangAnnotationReader"/> into a flat list of commands, with the points,
+			/// strings, fonts and embedded images of the marks stored in shared pools. The list can be replayed into any
+			/// <see cref="IWangAnnotationCallback"/> as often as needed, in the same order as the marks were read, without
+			/// parsing the tags again. Handlers that transform the marks, such as to a scaled output or a band of the page,
+			/// can replay the same list at any scale.
+			/// </summary>
+			class __EXPORTED_API WangDisplayList {
+				private:
+					/// <summary>
+					/// The kind of mark a command draws, one for every method of <see cref="IWangAnnotationCallback"/>.
+					/// </summary>
+					enum class CommandType : uint8_t {
+						Line,
+						Rect,
+						BorderedRect,
+						OutlinedRect,
+						Text,
+						WideText,
+						Mask,
+						ImageReference,
+						Image
+					};
+
+					/// <summary>
+					/// A single mark. Variable length data is referred to by a range in one of the pools.
+					/// </summary>
+					struct Command {
+						CommandType	Type;
+						bool		Highlight;
+						bool		Transparent;
+						RECT		Bounds;
+						RGBQUAD		Color;
+						RGBQUAD		BorderColor;
+						uint32_t	Size;		// The line size of lines and outlines, or the index of the image of image marks.
+						uint32_t	First;		// The first point or character of the command in its pool.
+						uint32_t	Count;		// The number of points or characters.
+						uint32_t	Attributes;	// The index of the text style or rotation of the command.
+					};
+
+					/// <summary>
+					/// The font and scaling of a text mark.
+					/// </summary>
+					struct TextStyle {
+						LOGFONTA			Font;
+						OIAN_TEXTPRIVDATA	Info;
+					};
+
+					class Recorder;
+
+					#pragma warning ( push )
+					#pragma warning ( disable: 4251 ) /* "needs to have dll-interface to be used by clients of class" - members are not public */
+					std::vector<Command>				m_Commands;
+					std::vector<POINT>					m_Points;
+					std::vector<char>					m_Characters;
+					std::vector<wchar_t>				m_WideCharacters;
+					std::vector<TextStyle>				m_Styles;
+					std::vector<AN_NEW_ROTATE_STRUCT>	m_Rotations;
+					std::vector<std::vector<uint8_t>>	m_Images;		// The DIB data of image marks, kept whole so that it is replayed without copying.
+					#pragma warning ( pop )
+
+				public:
+					/// <summary>
+					/// Construct a new, empty display list.
+					/// </summary>
+					WangDisplayList() = default;
+
+					WangDisplayList(const WangDisplayList&) = delete;
+					WangDisplayList& operator=(const WangDisplayList&) = delete;
+					WangDisplayList(WangDisplayList&&) = delete;
+					WangDisplayList& operator=(WangDisplayList&&) = delete;
+
+					/// <summary>
+					/// Compile the eiStream/Wang tags of a page into a display list.
+					/// </summary>
+					/// <param name="file">The opened Tiff file.</param>
+					/// <param name="pageIndex">The IFD (page) index.</param>
+					/// <returns>A shared pointer to the display list, which is empty when the page has no eiStream/Wang tags.</returns>
+					/// <exception cref="std::runtime_error">Thrown when a tag cannot be read.</exception>
+					static std::shared_ptr<const WangDisplayList> Compile(TiffFile& file, size_t pageIndex);
+
+					/// <summary>
+					/// Compile a single eiStream/Wang tag into a display list.
+					/// </summary>
+					/// <param name="file">The opened Tiff file.</param>
+					/// <param name="tag">The eiStream/Wang tag to compile.</param>
+					/// <returns>A shared pointer to the display list.</returns>
+					/// <exception cref="std::runtime_error">Thrown when the tag is not an eiStream/Wang tag or cannot be read.</exception>
+					static std::shared_ptr<const WangDisplayList> Compile(TiffFile& file, const TiffIfdEntry& tag);
+
+					/// <summary>
+					/// Replay every mark into a handler, in the order the marks were read.
+					/// </summary>
+					/// <param name="handler">The handler to invoke for every mark.</param>
+					void Replay(IWangAnnotationCallback& handler) const;
+
+					/// <summary>
+					/// Get the area of the page every mark draws onto, in the order the marks were read. This is the bounding 
+					/// rectangle (lrBounds) of the mark, normalized and grown to include the points of lines and the width of 
+					/// lines and outlines. Masks and image references are not drawn and have no area.
+					/// </summary>
+					/// <returns>The areas of the marks that draw onto the page.</returns>
+					std::vector<RECT> GetBounds() const;
+
+					/// <summary>
+					/// Get the number of marks in the list.
+					/// </summary>
+					/// <returns>The number of marks.</returns>
+					size_t GetSize() const noexcept;
+
+					/// <summary>
+					/// Determine if the list holds no marks.
+					/// </summary>
+					/// <returns>True when the list is empty.</returns>
+					bool IsEmpty() const noexcept;
+
+				private:
+					/// <summary>
+					/// Read an eiStream/Wang tag and append its marks to this list.
+					/// </summary>
+					/// <param name="file">The opened Tiff file.</param>
+					/// <param name="tag">The eiStream/Wang tag to read.</param>
+					void Append(TiffFile& file, const TiffIfdEntry& tag);
+			};
+		}
+	}
+
+#endif
@@ -9,9 +9,11 @@
 #include <fstream>
 #include <cstdint>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 #include <unordered_map>
+#include <unordered_set>
 
 #ifdef LIBTIFWANG_EXPORT
 # define __EXPORTED_API __declspec(dllexport)
@@ -26,9 +28,19 @@ enum class TiffTagId : uint16_t {
 	TIFF_WANG_TAG			   = 0x80a4,
 	TIFF_IMAGE_WIDTH_TAG	   = 0x0100,
 	TIFF_IMAGE_LENGTH_TAG	   = 0x0101,
+	TIFF_IMAGE_BITS_PER_SAMPLE = 0x0102,
+	TIFF_IMAGE_COMPRESSION     = 0x0103,
+	TIFF_IMAGE_PHOTOMETRIC     = 0x0106,
+	TIFF_IMAGE_FILL_ORDER      = 0x010A,
+	TIFF_IMAGE_STRIP_OFFSETS   = 0x0111,
+	TIFF_IMAGE_SAMPLES_PER_PIXEL = 0x0115,
+	TIFF_IMAGE_ROWS_PER_STRIP  = 0x0116,
+	TIFF_IMAGE_STRIP_BYTE_COUNTS = 0x0117,
 	TIFF_IMAGE_XRESOLUTION	   = 0x011A,
 	TIFF_IMAGE_YRESOLUTION	   = 0x011B,
 	TIFF_IMAGE_RESOLUTION_UNIT = 0x0128,
+	TIFF_IMAGE_T4_OPTIONS      = 0x0124,
+	TIFF_IMAGE_T6_OPTIONS      = 0x0125,
 	TIFF_PAGE_NUMBER		   = 0x0129,
 	TIFF_IMAGE_SOFTWARE        = 0x0131,
 	TIFF_IMAGE_DATETIME        = 0x0132,
@@ -43,7 +55,18 @@ enum class TiffTagType : uint16_t {
 	ASCII,			// ASCII 8-bit byte that contains a 7-bit ASCII code; the last byte must be NUL (binary zero).
 	SHORT,			// SHORT 16-bit (2-byte) unsigned integer.
 	LONG,			// LONG 32-bit (4-byte) unsigned integer.
-	RATIONAL		// RATIONAL Two LONGs: the first represents the numerator of a fraction; the second, the denominator.
+	RATIONAL,		// RATIONAL Two LONGs: the first represents the numerator of a fraction; the second, the denominator.
+	SBYTE,			// SBYTE An 8-bit signed (twos-complement) integer.
+	UNDEFINED,		// UNDEFINED An 8-bit byte that may contain anything, depending on the definition of the field.
+	SSHORT,			// SSHORT A 16-bit (2-byte) signed (twos-complement) integer.
+	SLONG,			// SLONG A 32-bit (4-byte) signed (twos-complement) integer.
+	SRATIONAL,		// SRATIONAL Two SLONGs: the first represents the numerator of a fraction, the second the denominator.
+	FLOAT,			// FLOAT Single precision (4-byte) IEEE format.
+	DOUBLE,			// DOUBLE Double precision (8-byte) IEEE format.
+	IFD,			// IFD A 32-bit (4-byte) unsigned integer, pointing to a sub-IFD.
+	LONG8 = 16,		// LONG8 BigTIFF 64-bit (8-byte) unsigned integer.
+	SLONG8,			// SLONG8 BigTIFF 64-bit (8-byte) signed (twos-complement) integer.
+	IFD8			// IFD8 BigTIFF 64-bit (8-byte) unsigned integer, pointing to a sub-IFD.
 };
 
 /// <summary>
@@ -55,6 +78,48 @@ enum class TiffResolutionUnit : uint16_t {
 	Centimeter
 };
 
+/// <summary>
+/// An enum describing the compression scheme of the image data in Tiff IFDs.
+/// </summary>
+enum class TiffCompression : uint16_t {
+	None = 1,			// No compression, but pack data into bytes as tightly as possible.
+	CcittRle,			// CCITT Group 3 1-Dimensional Modified Huffman run length encoding, rows are byte aligned.
+	CcittT4,			// CCITT T.4 bi-level encoding (Group 3 fax), 1D or 2D depending on the T4Options tag.
+	CcittT6,			// CCITT T.6 bi-level encoding (Group 4 fax).
+	Lzw,				// Lempel-Ziv & Welch.
+	OldJpeg,			// Obsolete Tiff 6.0 JPEG compression.
+	Jpeg,				// JPEG compression (Technical Note #2).
+	Deflate,			// Adobe Deflate (zlib).
+	PackBits = 32773	// Macintosh RLE.
+};
+
+/// <summary>
+/// An enum describing the interpretation of pixel values in Tiff IFDs.
+/// </summary>
+enum class TiffPhotometric : uint16_t {
+	WhiteIsZero,		// Bilevel and grayscale, 0 is imaged as white.
+	BlackIsZero,		// Bilevel and grayscale, 0 is imaged as black.
+	Rgb,				// Full color.
+	Palette				// Palette color.
+};
+
+/// <summary>
+/// An enum describing the logical order of bits within a byte in Tiff IFDs.
+/// </summary>
+enum class TiffFillOrder : uint16_t {
+	MsbToLsb = 1,		// Pixels with lower column values are stored in the higher-order bits of the byte.
+	LsbToMsb			// Pixels with lower column values are stored in the lower-order bits of the byte.
+};
+
+/// <summary>
+/// Flags in the T4Options tag.
+/// </summary>
+enum class TiffT4Options : uint32_t {
+	TwoDimensional	= 0x1,	// 2-dimensional coding is used, each row starts with a bit indicating 1D or 2D.
+	Uncompressed	= 0x2,	// Uncompressed mode may be used.
+	FillBits		= 0x4	// Fill bits have been added before EOL codes, so that each EOL ends on a byte boundary.
+};
+
 _Check_return_ float _cdecl _byteswap_float(_In_ float _Number);
 _Check_return_ double _cdecl _byteswap_double(_In_ double _Number);
 
@@ -42,10 +42,25 @@ namespace TiffConvert {
 		static constexpr const OptionDescriptor DESC_MAXHEIGHT(NAME_MAXHEIGHT, "-y,--max-height", "The maxium height in pixels for a single page in the TIFF file.");
 
 		static constexpr auto NAME_SCALESMOOTH = "scalesmooth";
-		static constexpr const OptionDescriptor DESC_SCALESMOOTH(NAME_SCALESMOOTH, "-s,--scale-smooth", "Use interpolation when the pages have to be scaled.");
+		static constexpr const OptionDescriptor DESC_SCALESMOOTH(NAME_SCALESMOOTH, "-s,--scale-smooth", "Use interpolation when the pages have to be scaled, the same as --scale-filter bilinear.");
+
+		static constexpr auto NAME_SCALEFILTER = "scalefilter";
+		static constexpr const OptionDescriptor DESC_SCALEFILTER(NAME_SCALEFILTER, "-f,--scale-filter", "The filter to use when the pages have to be scaled, one of: ");
+
+		static constexpr auto NAME_JOBS = "jobs";
+		static constexpr const OptionDescriptor DESC_JOBS(NAME_JOBS, "-j,--jobs", "The number of pages to process in parallel, 0 uses one thread per processor core.");
+
+		static constexpr auto NAME_BANDED = "banded";
+		static constexpr const OptionDescriptor DESC_BANDED(NAME_BANDED, "-b,--banded", "Decode, render and write bilevel CCITT pages in bands of rows, for very large pages. Only applies to unscaled pages written as bitmap.");
+
+		static constexpr auto NAME_VECTORWANG = "vectorwang";
+		static constexpr const OptionDescriptor DESC_VECTORWANG(NAME_VECTORWANG, "-w,--vector-wang", "Draw eiStream/WANG tags as paths and text over each page instead of prerendering them, when present. Only applies to the pdf command.");
+
+		static constexpr auto NAME_MRC = "mrc";
+		static constexpr const OptionDescriptor DESC_MRC(NAME_MRC, "-m,--mrc", "Burn eiStream/WANG tags onto bilevel CCITT Group 4 pages as small color regions over the untouched page, instead of encoding the whole page in color. Only applies to the pdf command with --prerender-wang.");
 
 		static constexpr auto NAME_TIFFILE = "tiffpath";
-		static constexpr const OptionDescriptor DESC_TIFFILE(NAME_TIFFILE, "tiff-file", "The TIFF image to convert.");
+		static constexpr const OptionDescriptor DESC_TIFFILE(NAME_TIFFILE, "tiff-file", "The TIFF image to convert. BigTIFF is not supported by the decoder: BigTIFF files, and files over 4 GB, can only be converted with --banded or by copying their pages into a PDF.");
 
 		static constexpr auto NAME_OUTBASE = "outbase";
 		static constexpr const OptionDescriptor DESC_OUTBASE(NAME_OUTBASE, "basename", "The base image path for the output.");
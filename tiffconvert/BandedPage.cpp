@@ -0,0 +1,163 @@
+#include "BandedPage.hpp"
+#include <CcittDecoder.hpp>
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <vector>
+#include <stdexcept>
+
+using namespace TiffConvert;
+using namespace TiffWang::Tiff;
+
+/// <summary>
+/// The 24-bit pixels of every byte of a bit-packed row, a set bit is black.
+/// </summary>
+static constexpr auto Expansion = []() {
+	std::array<std::array<uint8_t, 24>, 256> table = {};
+	for (uint32_t i = 0; i < 256; ++i) {
+		for (uint32_t bit = 0; bit < 8; ++bit) {
+			auto value = static_cast<uint8_t>((i & (0x80u >> bit)) ? 0 : 255);
+			table[i][bit * 3 + 0] = value;
+			table[i][bit * 3 + 1] = value;
+			table[i][bit * 3 + 2] = value;
+		}
+	}
+	return table;
+}();
+
+/// <summary>
+/// Expand a bit-packed row into 24-bit pixels.
+/// </summary>
+/// <param name="bits">The bit-packed row, a set bit is black.</param>
+/// <param name="output">The output row.</param>
+/// <param name="width">The number of pixels.</param>
+/// <param name="inverted">Whether a set bit is white instead of black.</param>
+static void ExpandRow(const uint8_t* bits, uint8_t* output, uint32_t width, bool inverted) noexcept {
+	auto mask  = static_cast<uint8_t>(inverted ? 0xFF : 0x00);
+	auto whole = width / 8;
+
+	for (uint32_t i = 0; i < whole; ++i, output += 24)
+		memcpy(output, Expansion[bits[i] ^ mask].data(), 24);
+
+	if (auto rest = width & 7)
+		memcpy(output, Expansion[bits[whole] ^ mask].data(), static_cast<size_t>(rest) * 3);
+}
+
+/// <summary>
+/// Construct a new banded page.
+/// </summary>
+/// <param name="file">The Tiff file, which must stay alive as long as this page.</param>
+/// <param name="pageIndex">The IFD (page) index.</param>
+/// <param name="bandHeight">The number of rows per band.</param>
+/// <exception cref="std::runtime_error">When the page is not supported, see <see cref="IsSupported"/>.</exception>
+BandedPage::BandedPage(const TiffFile& file, size_t pageIndex, uint32_t bandHeight)
+	: m_File(file), m_PageIndex(pageIndex) {
+
+	if (!IsSupported(file, pageIndex))
+		throw std::runtime_error("page is not a bilevel CCITT compressed image");
+
+	const auto& dimensions = file.GetDimensions(pageIndex);
+	m_Width       = dimensions.Width;
+	m_Height      = dimensions.Height;
+	m_BandHeight  = (std::max)(1u, (std::min)(bandHeight, m_Height));
+	m_BlackIsZero = file.GetImageLayout(pageIndex).Photometric == TiffPhotometric::BlackIsZero;
+}
+
+/// <summary>
+/// Determines if a page can be decoded in bands.
+/// </summary>
+/// <param name="file">The Tiff file.</param>
+/// <param name="pageIndex">The IFD (page) index.</param>
+/// <returns>True when the page is a bilevel CCITT compressed image.</returns>
+bool BandedPage::IsSupported(const TiffFile& file, size_t pageIndex) noexcept {
+	try {
+		const auto& dimensions = file.GetDimensions(pageIndex);
+		const auto& layout     = file.GetImageLayout(pageIndex);
+
+		return dimensions.Width != 0 && dimensions.Height != 0 && CcittDecoder::IsSupported(layout)
+			&& layout.StripOffsets.size() == layout.StripByteCounts.size();
+	} catch (const std::exception&) {
+		return false;
+	}
+}
+
+/// <summary>
+/// Get the width of the page.
+/// </summary>
+/// <returns>The width in pixels.</returns>
+uint32_t BandedPage::GetWidth() const noexcept {
+	return m_Width;
+}
+
+/// <summary>
+/// Get the height of the page.
+/// </summary>
+/// <returns>The height in pixels.</returns>
+uint32_t BandedPage::GetHeight() const noexcept {
+	return m_Height;
+}
+
+/// <summary>
+/// Decode the page band by band. Rows are padded to a multiple of 4 bytes, like the rows of a DIB.
+/// </summary>
+/// <param name="bitsPerPixel">1 for bit-packed bands in which a set bit is black, or 24 for BGR bands.</param>
+/// <param name="callback">The function that receives every band and the row of the page it starts at.</param>
+/// <exception cref="std::invalid_argument">When the pixel format is not supported.</exception>
+/// <exception cref="std::runtime_error">When the data is corrupt or holds less rows than the page.</exception>
+void BandedPage::Render(uint32_t bitsPerPixel, const BandCallback& callback) const {
+	if (bitsPerPixel != 1 && bitsPerPixel != 24)
+		throw std::invalid_argument("pages can only be decoded in bands with 1 or 24 bits per pixel");
+
+	const auto& layout = m_File.GetImageLayout(m_PageIndex);
+
+	auto options      = layout.Compression == TiffCompression::CcittT6 ? layout.T6Options : layout.T4Options;
+	auto rowsPerStrip = layout.RowsPerStrip == 0 ? m_Height : layout.RowsPerStrip;
+	auto stride       = TiffBitmap::GetStride(m_Width);
+
+	RasterTarget band;
+	band.Width        = m_Width;
+	band.BitsPerPixel = bitsPerPixel;
+	band.Pitch        = static_cast<ptrdiff_t>(((static_cast<size_t>(m_Width) * bitsPerPixel + 31) / 32) * 4);
+
+	std::vector<uint8_t> pixels(static_cast<size_t>(band.Pitch) * m_BandHeight, 0);
+	std::vector<uint8_t> row(bitsPerPixel == 1 ? 0 : stride);
+	std::vector<uint8_t> buffer;
+	CcittDecoder		 decoder(layout.Compression, m_Width, options, layout.FillOrder == TiffFillOrder::LsbToMsb);
+	uint32_t			 y   = 0;
+	uint32_t			 top = 0;
+
+	band.Bits = pixels.data();
+
+	for (size_t strip = 0; strip < layout.StripOffsets.size() && y < m_Height; ++strip) {
+		decoder.Reset(m_File.GetStripData(m_PageIndex, strip, buffer));
+
+		for (uint32_t i = 0; i < rowsPerStrip && y < m_Height; ++i, ++y) {
+			auto output = band.Bits + static_cast<ptrdiff_t>(y - top) * band.Pitch;
+
+			decoder.DecodeRow();
+
+			if (bitsPerPixel == 1) {
+				decoder.FillRow(output);
+
+				// The black runs of the data are white pixels, a set bit in the band is black.
+				if (m_BlackIsZero) {
+					for (size_t x = 0; x < stride; ++x)
+						output[x] = static_cast<uint8_t>(~output[x]);
+				}
+			} else {
+				decoder.FillRow(row.data());
+				ExpandRow(row.data(), output, m_Width, m_BlackIsZero);
+			}
+
+			// Hand the band over once it is full, or when the last row of the page has been decoded.
+			if (y + 1 - top == m_BandHeight || y + 1 == m_Height) {
+				band.Height = y + 1 - top;
+				callback(band, top);
+				top = y + 1;
+			}
+		}
+	}
+
+	if (y < m_Height)
+		throw std::runtime_error("page holds less rows of image data than its height");
+}
\ No newline at end of file
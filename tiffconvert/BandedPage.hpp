@@ -0,0 +1,79 @@
+#pragma once
+
+#ifndef libtiffconvert_banded_page_h
+#define libtiffconvert_banded_page_h
+
+#include "Rasterizer.hpp"
+#include <TiffFile.hpp>
+#include <cstdint>
+#include <functional>
+
+namespace TiffConvert {
+	/// <summary>
+	/// BandedPage decodes a bilevel CCITT compressed page from its Tiff strips in horizontal bands of a fixed number of rows,
+	/// without ever holding the whole page in memory. Every band is handed to a callback that can draw onto it and pass it
+	/// on to a row-oriented encoder such as <see cref="BitmapWriter"/>, after which the band is reused for the next rows.
+	/// Peak memory is a single band and strip, regardless of the size of the page.
+	/// </summary>
+	class BandedPage {
+		public:
+			/// <summary>
+			/// The function that receives every band, top to bottom.
+			/// </summary>
+			using BandCallback = std::function<void(const RasterTarget& band, uint32_t top)>;
+
+		private:
+			const TiffWang::Tiff::TiffFile&	m_File;
+			size_t							m_PageIndex;
+			uint32_t						m_Width;
+			uint32_t						m_Height;
+			uint32_t						m_BandHeight;
+			bool							m_BlackIsZero;	// Whether the black runs of the CCITT data are white pixels.
+
+		public:
+			/// <summary>
+			/// Construct a new banded page.
+			/// </summary>
+			/// <param name="file">The Tiff file, which must stay alive as long as this page.</param>
+			/// <param name="pageIndex">The IFD (page) index.</param>
+			/// <param name="bandHeight">The number of rows per band.</param>
+			/// <exception cref="std::runtime_error">When the page is not supported, see <see cref="IsSupported"/>.</exception>
+			BandedPage(const TiffWang::Tiff::TiffFile& file, size_t pageIndex, uint32_t bandHeight = 256);
+
+			BandedPage(const BandedPage&) = delete;
+			BandedPage(BandedPage&&) = delete;
+			BandedPage& operator=(const BandedPage&) = delete;
+			BandedPage& operator=(BandedPage&&) = delete;
+
+			/// <summary>
+			/// Determines if a page can be decoded in bands.
+			/// </summary>
+			/// <param name="file">The Tiff file.</param>
+			/// <param name="pageIndex">The IFD (page) index.</param>
+			/// <returns>True when the page is a bilevel CCITT compressed image.</returns>
+			static bool IsSupported(const TiffWang::Tiff::TiffFile& file, size_t pageIndex) noexcept;
+
+			/// <summary>
+			/// Get the width of the page.
+			/// </summary>
+			/// <returns>The width in pixels.</returns>
+			uint32_t GetWidth() const noexcept;
+
+			/// <summary>
+			/// Get the height of the page.
+			/// </summary>
+			/// <returns>The height in pixels.</returns>
+			uint32_t GetHeight() const noexcept;
+
+			/// <summary>
+			/// Decode the page band by band. Rows are padded to a multiple of 4 bytes, like the rows of a DIB.
+			/// </summary>
+			/// <param name="bitsPerPixel">1 for bit-packed bands in which a set bit is black, or 24 for BGR bands.</param>
+			/// <param name="callback">The function that receives every band and the row of the page it starts at.</param>
+			/// <exception cref="std::invalid_argument">When the pixel format is not supported.</exception>
+			/// <exception cref="std::runtime_error">When the data is corrupt or holds less rows than the page.</exception>
+			void Render(uint32_t bitsPerPixel, const BandCallback& callback) const;
+	};
+}
+
+#endif
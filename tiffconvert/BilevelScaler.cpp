@@ -0,0 +1,175 @@
+#include "BilevelScaler.hpp"
+#include <algorithm>
+#include <array>
+#include <vector>
+#include <stdexcept>
+
+using namespace TiffConvert;
+
+/// <summary>
+/// The number of set bits in every byte.
+/// </summary>
+static constexpr auto PopCount = []() {
+	std::array<uint8_t, 256> table = {};
+	for (uint32_t i = 0; i < 256; ++i)
+		table[i] = static_cast<uint8_t>((i & 1) + table[i >> 1]);
+	return table;
+}();
+
+/// <summary>
+/// Count the set bits in a range of a bit-packed row.
+/// </summary>
+/// <param name="row">The row, the msb of a byte is the leftmost pixel.</param>
+/// <param name="begin">The first pixel.</param>
+/// <param name="end">The pixel after the last pixel, greater than <paramref name="begin"/>.</param>
+/// <returns>The number of set bits.</returns>
+static uint32_t CountBits(const uint8_t* row, uint32_t begin, uint32_t end) noexcept {
+	auto first = begin >> 3;
+	auto last  = (end - 1) >> 3;
+	auto head  = static_cast<uint8_t>(0xFF >> (begin & 7));
+	auto tail  = static_cast<uint8_t>(0xFF << (7 - ((end - 1) & 7)));
+
+	if (first == last)
+		return PopCount[row[first] & head & tail];
+
+	uint32_t count = PopCount[row[first] & head] + PopCount[row[last] & tail];
+	for (auto i = first + 1; i < last; ++i)
+		count += PopCount[row[i]];
+
+	return count;
+}
+
+/// <summary>
+/// Add the set bits of a row to the counts of the output pixels, for an integer ratio of at most 8. Every block fits in
+/// the 16 bits of the byte it starts in and the next byte, so a single shift and mask extract it.
+/// </summary>
+/// <param name="row">The row.</param>
+/// <param name="stride">The number of bytes in the row.</param>
+/// <param name="counts">The counts of the output pixels.</param>
+/// <param name="width">The number of output pixels.</param>
+template <uint32_t Factor>
+static void CountFixed(const uint8_t* row, uint32_t stride, uint32_t* counts, uint32_t width) noexcept {
+	static_assert(Factor >= 1 && Factor <= 8, "blocks must fit in two bytes");
+	constexpr uint32_t mask = (1u << Factor) - 1;
+
+	for (uint32_t x = 0; x < width; ++x) {
+		auto bit    = x * Factor;
+		auto index  = bit >> 3;
+		auto window = static_cast<uint32_t>(row[index]) << 8;
+
+		if (index + 1 < stride)
+			window |= row[index + 1];
+
+		counts[x] += PopCount[(window >> (16 - Factor - (bit & 7))) & mask];
+	}
+}
+
+/// <summary>
+/// Store a row of gray output pixels from the set bits counted in their blocks.
+/// </summary>
+/// <param name="output">The output row.</param>
+/// <param name="counts">The number of set bits in the block of every pixel.</param>
+/// <param name="areas">The number of pixels in the block of every pixel, or nullptr when all blocks have <paramref name="area"/> pixels.</param>
+/// <param name="area">The number of pixels in every block, when <paramref name="areas"/> is nullptr.</param>
+/// <param name="width">The number of output pixels.</param>
+/// <param name="bytesPerPixel">The size of an output pixel, 3 or 4 bytes.</param>
+/// <param name="inverted">Whether a set bit is white instead of black.</param>
+static void StoreGray(uint8_t* output, const uint32_t* counts, const uint32_t* areas, uint32_t area, uint32_t width, uint32_t bytesPerPixel, bool inverted) noexcept {
+	for (uint32_t x = 0; x < width; ++x, output += bytesPerPixel) {
+		auto size  = areas ? areas[x] : area;
+		auto black = static_cast<uint8_t>((static_cast<uint64_t>(counts[x]) * 255 + size / 2) / size);
+		auto gray  = inverted ? black : static_cast<uint8_t>(255 - black);
+
+		output[0] = gray;
+		output[1] = gray;
+		output[2] = gray;
+
+		if (bytesPerPixel == 4)
+			output[3] = 255;
+	}
+}
+
+/// <summary>
+/// Downscale a bilevel page to gray with an integer ratio that is known at compile time.
+/// </summary>
+/// <param name="source">The bit-packed rows of the page.</param>
+/// <param name="destination">The gray image, exactly Factor times smaller than the page.</param>
+template <uint32_t Factor>
+static void ScaleFixed(const tiff_page_bits& source, const RasterTarget& destination) {
+	std::vector<uint32_t> counts(destination.Width);
+	auto bytes = destination.BitsPerPixel / 8;
+
+	for (uint32_t y = 0; y < destination.Height; ++y) {
+		std::fill(counts.begin(), counts.end(), 0u);
+
+		for (uint32_t k = 0; k < Factor; ++k)
+			CountFixed<Factor>(source.Bits + static_cast<size_t>(y * Factor + k) * source.Stride, source.Stride, counts.data(), destination.Width);
+
+		StoreGray(destination.Bits + static_cast<ptrdiff_t>(y) * destination.Pitch, counts.data(), nullptr, Factor * Factor, destination.Width, bytes, source.Inverted != 0);
+	}
+}
+
+/// <summary>
+/// Downscale a bilevel page to gray with any ratio, the blocks of neighbouring pixels differ at most one pixel in size.
+/// </summary>
+/// <param name="source">The bit-packed rows of the page.</param>
+/// <param name="destination">The gray image, at most as large as the page.</param>
+static void ScaleAny(const tiff_page_bits& source, const RasterTarget& destination) {
+	std::vector<uint32_t> columns(static_cast<size_t>(destination.Width) + 1);
+	std::vector<uint32_t> counts(destination.Width);
+	std::vector<uint32_t> areas(destination.Width);
+	auto bytes = destination.BitsPerPixel / 8;
+
+	for (uint32_t x = 0; x <= destination.Width; ++x)
+		columns[x] = static_cast<uint32_t>(static_cast<uint64_t>(x) * source.Width / destination.Width);
+
+	for (uint32_t y = 0; y < destination.Height; ++y) {
+		auto top    = static_cast<uint32_t>(static_cast<uint64_t>(y) * source.Height / destination.Height);
+		auto bottom = static_cast<uint32_t>(static_cast<uint64_t>(y + 1) * source.Height / destination.Height);
+
+		std::fill(counts.begin(), counts.end(), 0u);
+
+		for (auto row = top; row < bottom; ++row) {
+			auto bits = source.Bits + static_cast<size_t>(row) * source.Stride;
+			for (uint32_t x = 0; x < destination.Width; ++x)
+				counts[x] += CountBits(bits, columns[x], columns[x + 1]);
+		}
+
+		for (uint32_t x = 0; x < destination.Width; ++x)
+			areas[x] = (columns[x + 1] - columns[x]) * (bottom - top);
+
+		StoreGray(destination.Bits + static_cast<ptrdiff_t>(y) * destination.Pitch, counts.data(), areas.data(), 0, destination.Width, bytes, source.Inverted != 0);
+	}
+}
+
+/// <summary>
+/// Downscale a bilevel page to gray.
+/// </summary>
+/// <param name="source">The bit-packed rows of the page.</param>
+/// <param name="destination">The gray image, 24 or 32 bits per pixel and at most as large as the page.</param>
+/// <exception cref="std::invalid_argument">When the destination is larger than the page or has an unsupported pixel format.</exception>
+void BilevelScaler::ScaleToGray(const tiff_page_bits& source, const RasterTarget& destination) {
+	if (destination.Width == 0 || destination.Height == 0 || destination.Width > source.Width || destination.Height > source.Height)
+		throw std::invalid_argument("the page can only be downscaled to gray");
+
+	if (destination.BitsPerPixel != 24 && destination.BitsPerPixel != 32)
+		throw std::invalid_argument("the gray image has an unsupported pixel format");
+
+	auto factor = source.Width / destination.Width;
+	auto exact  = (destination.Width * factor == source.Width) && (destination.Height * factor == source.Height);
+
+	switch (exact ? factor : 0) {
+		case 2:
+			ScaleFixed<2>(source, destination);
+			break;
+		case 3:
+			ScaleFixed<3>(source, destination);
+			break;
+		case 4:
+			ScaleFixed<4>(source, destination);
+			break;
+		default:
+			ScaleAny(source, destination);
+			break;
+	}
+}
\ No newline at end of file
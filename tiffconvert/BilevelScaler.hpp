@@ -0,0 +1,28 @@
+#pragma once
+
+#ifndef libtiffconvert_bilevel_scaler_h
+#define libtiffconvert_bilevel_scaler_h
+
+#include "libtiffconvert.h"
+#include "Rasterizer.hpp"
+#include <cstdint>
+
+namespace TiffConvert {
+	/// <summary>
+	/// BilevelScaler provides a class of static methods that downscale bilevel pages straight from their packed bits. Every
+	/// output pixel is the average of the block of source pixels it covers, computed by counting the set bits in the block,
+	/// which antialiases the page to gray without expanding it to RGB first. The common integer ratios are specialized.
+	/// </summary>
+	class BilevelScaler {
+		public:
+			/// <summary>
+			/// Downscale a bilevel page to gray.
+			/// </summary>
+			/// <param name="source">The bit-packed rows of the page.</param>
+			/// <param name="destination">The gray image, 24 or 32 bits per pixel and at most as large as the page.</param>
+			/// <exception cref="std::invalid_argument">When the destination is larger than the page or has an unsupported pixel format.</exception>
+			static void ScaleToGray(const tiff_page_bits& source, const RasterTarget& destination);
+	};
+}
+
+#endif
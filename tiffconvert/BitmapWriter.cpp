@@ -0,0 +1,141 @@
+#include "BitmapWriter.hpp"
+#include <cstdio>
+#include <stdexcept>
+#include <utility>
+
+using namespace TiffConvert;
+
+/// <summary>
+/// Create a new bitmap file and write its headers.
+/// </summary>
+/// <param name="filepath">The file to create, an existing file is overwritten.</param>
+/// <param name="width">The width of the image in pixels.</param>
+/// <param name="height">The height of the image in pixels.</param>
+/// <param name="bitsPerPixel">1 for bit-packed rows in which a set bit is black, or 24 for BGR rows.</param>
+/// <param name="inverted">Whether a set bit is white instead of black, for bit-packed rows.</param>
+/// <exception cref="std::invalid_argument">When the dimensions or pixel format are not supported.</exception>
+/// <exception cref="std::runtime_error">When the file cannot be written.</exception>
+BitmapWriter::BitmapWriter(const std::string& filepath, uint32_t width, uint32_t height, uint32_t bitsPerPixel, bool inverted)
+	: m_Filepath(filepath), m_Width(width), m_Height(height), m_BitsPerPixel(bitsPerPixel), m_Stride(0) {
+
+	if (bitsPerPixel != 1 && bitsPerPixel != 24)
+		throw std::invalid_argument("bitmaps can only be written with 1 or 24 bits per pixel");
+
+	if (width == 0 || height == 0 || width > INT32_MAX || height > INT32_MAX)
+		throw std::invalid_argument("the bitmap has invalid dimensions");
+
+	// Rows are padded to a multiple of 4 bytes.
+	auto stride  = ((static_cast<uint64_t>(width) * bitsPerPixel + 31) / 32) * 4;
+	auto palette = static_cast<uint32_t>((bitsPerPixel == 1) ? 2 * sizeof(RGBQUAD) : 0);
+	auto offset  = static_cast<uint32_t>(sizeof(BITMAPFILEHEADER) + sizeof(BITMAPINFOHEADER)) + palette;
+	auto size    = stride * height + offset;
+
+	if (size > UINT32_MAX)
+		throw std::invalid_argument("the bitmap is too large to be stored");
+
+	m_Stride = static_cast<uint32_t>(stride);
+
+	BITMAPFILEHEADER file = {};
+	file.bfType    = 0x4D42; // "BM"
+	file.bfSize    = static_cast<DWORD>(size);
+	file.bfOffBits = offset;
+
+	// A negative height stores the rows top-down, in the order they are produced.
+	BITMAPINFOHEADER info = {};
+	info.biSize        = sizeof(BITMAPINFOHEADER);
+	info.biWidth       = static_cast<LONG>(width);
+	info.biHeight      = -static_cast<LONG>(height);
+	info.biPlanes      = 1;
+	info.biBitCount    = static_cast<WORD>(bitsPerPixel);
+	info.biCompression = BI_RGB;
+	info.biSizeImage   = static_cast<DWORD>(stride * height);
+	info.biClrUsed     = (bitsPerPixel == 1) ? 2 : 0;
+
+	m_Stream.open(filepath, std::ios::binary | std::ios::trunc);
+	if (!m_Stream)
+		throw std::runtime_error("cannot create bitmap file " + filepath);
+
+	m_Stream.write(reinterpret_cast<const char*>(&file), sizeof(file));
+	m_Stream.write(reinterpret_cast<const char*>(&info), sizeof(info));
+
+	if (bitsPerPixel == 1) {
+		// Index 0 is a clear bit, index 1 a set bit.
+		RGBQUAD colors[2] = { { 255, 255, 255, 0 }, { 0, 0, 0, 0 } };
+		if (inverted)
+			std::swap(colors[0], colors[1]);
+
+		m_Stream.write(reinterpret_cast<const char*>(colors), sizeof(colors));
+	}
+
+	if (!m_Stream) {
+		// The destructor does not run when the constructor throws.
+		m_Stream.close();
+		std::remove(filepath.c_str());
+		throw std::runtime_error("cannot write bitmap file " + filepath);
+	}
+}
+
+/// <summary>
+/// The destructor deletes the file when it has not been closed, as it is incomplete.
+/// </summary>
+BitmapWriter::~BitmapWriter() {
+	if (!m_Closed) {
+		m_Stream.close();
+		std::remove(m_Filepath.c_str());
+	}
+}
+
+/// <summary>
+/// Append the rows of a band to the image.
+/// </summary>
+/// <param name="band">The rows, of the width and pixel format of the image. 24-bit pixels are stored blue first.</param>
+/// <exception cref="std::invalid_argument">When the band does not match the image or holds more rows than are left.</exception>
+/// <exception cref="std::runtime_error">When the file cannot be written.</exception>
+void BitmapWriter::Write(const RasterTarget& band) {
+	if (band.Width != m_Width || band.BitsPerPixel != m_BitsPerPixel || (m_BitsPerPixel == 24 && !band.Bgr))
+		throw std::invalid_argument("the band does not match the bitmap");
+
+	if (band.Height > m_Height - m_Rows)
+		throw std::invalid_argument("the band holds more rows than are left in the bitmap");
+
+	if (band.Pitch == static_cast<ptrdiff_t>(m_Stride)) {
+		// The band is laid out exactly like the file, including the padding.
+		m_Stream.write(reinterpret_cast<const char*>(band.Bits), static_cast<std::streamsize>(m_Stride) * band.Height);
+	} else {
+		static const char padding[4] = {};
+		auto bytes = static_cast<uint32_t>((static_cast<uint64_t>(m_Width) * m_BitsPerPixel + 7) / 8);
+
+		for (uint32_t y = 0; y < band.Height; ++y) {
+			m_Stream.write(reinterpret_cast<const char*>(band.Bits + static_cast<ptrdiff_t>(y) * band.Pitch), bytes);
+			m_Stream.write(padding, m_Stride - bytes);
+		}
+	}
+
+	if (!m_Stream)
+		throw std::runtime_error("cannot write bitmap file");
+
+	m_Rows += band.Height;
+}
+
+/// <summary>
+/// Finish the file, every row of the image must have been written.
+/// </summary>
+/// <exception cref="std::runtime_error">When rows are missing or the file cannot be written.</exception>
+void BitmapWriter::Close() {
+	if (m_Rows != m_Height)
+		throw std::runtime_error("the bitmap is missing rows");
+
+	m_Stream.close();
+	if (m_Stream.fail())
+		throw std::runtime_error("cannot write bitmap file");
+
+	m_Closed = true;
+}
+
+/// <summary>
+/// Get the number of bytes per row in the file, a band with this pitch is written in a single write.
+/// </summary>
+/// <returns>The stride in bytes.</returns>
+uint32_t BitmapWriter::GetStride() const noexcept {
+	return m_Stride;
+}
\ No newline at end of file
@@ -0,0 +1,73 @@
+#pragma once
+
+#ifndef libtiffconvert_bitmap_writer_h
+#define libtiffconvert_bitmap_writer_h
+
+#include "Rasterizer.hpp"
+#include <cstdint>
+#include <string>
+#include <fstream>
+
+namespace TiffConvert {
+	/// <summary>
+	/// BitmapWriter is a row-oriented BMP encoder. The headers are written up front and the rows are appended top to bottom
+	/// as they become available, so that a page never has to be held in memory in its entirety. Bilevel rows are stored
+	/// bit-packed with a black and white palette, other rows as 24-bit BGR pixels. A file that is not closed is deleted.
+	/// </summary>
+	class BitmapWriter {
+		private:
+			std::string		m_Filepath;
+			std::ofstream	m_Stream;
+			uint32_t		m_Width;
+			uint32_t		m_Height;
+			uint32_t		m_BitsPerPixel;
+			uint32_t		m_Stride;		// The number of bytes per row in the file, a multiple of 4.
+			uint32_t		m_Rows = 0;		// The number of rows written so far.
+			bool			m_Closed = false;
+
+		public:
+			/// <summary>
+			/// Create a new bitmap file and write its headers.
+			/// </summary>
+			/// <param name="filepath">The file to create, an existing file is overwritten.</param>
+			/// <param name="width">The width of the image in pixels.</param>
+			/// <param name="height">The height of the image in pixels.</param>
+			/// <param name="bitsPerPixel">1 for bit-packed rows in which a set bit is black, or 24 for BGR rows.</param>
+			/// <param name="inverted">Whether a set bit is white instead of black, for bit-packed rows.</param>
+			/// <exception cref="std::invalid_argument">When the dimensions or pixel format are not supported.</exception>
+			/// <exception cref="std::runtime_error">When the file cannot be written.</exception>
+			BitmapWriter(const std::string& filepath, uint32_t width, uint32_t height, uint32_t bitsPerPixel, bool inverted = false);
+
+			/// <summary>
+			/// The destructor deletes the file when it has not been closed, as it is incomplete.
+			/// </summary>
+			~BitmapWriter();
+
+			BitmapWriter(const BitmapWriter&) = delete;
+			BitmapWriter(BitmapWriter&&) = delete;
+			BitmapWriter& operator=(const BitmapWriter&) = delete;
+			BitmapWriter& operator=(BitmapWriter&&) = delete;
+
+			/// <summary>
+			/// Append the rows of a band to the image.
+			/// </summary>
+			/// <param name="band">The rows, of the width and pixel format of the image. 24-bit pixels are stored blue first.</param>
+			/// <exception cref="std::invalid_argument">When the band does not match the image or holds more rows than are left.</exception>
+			/// <exception cref="std::runtime_error">When the file cannot be written.</exception>
+			void Write(const RasterTarget& band);
+
+			/// <summary>
+			/// Finish the file, every row of the image must have been written.
+			/// </summary>
+			/// <exception cref="std::runtime_error">When rows are missing or the file cannot be written.</exception>
+			void Close();
+
+			/// <summary>
+			/// Get the number of bytes per row in the file, a band with this pitch is written in a single write.
+			/// </summary>
+			/// <returns>The stride in bytes.</returns>
+			uint32_t GetStride() const noexcept;
+	};
+}
+
+#endif
@@ -0,0 +1,733 @@
+#include "Deflater.hpp"
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <exception>
+#include <thread>
+#include <utility>
+
+using namespace TiffConvert;
+using namespace TiffWang::Tiff;
+
+static constexpr size_t		WindowSize		= 32768;			// The maximum distance of a match, the size of the dictionary.
+static constexpr size_t		HashBits		= 15;				// The number of bits of the hash of 4 bytes.
+static constexpr size_t		MinimumMatch	= 4;				// The minimum length of a match, the number of bytes that are hashed.
+static constexpr size_t		MaximumMatch	= 258;				// The maximum length of a match.
+static constexpr size_t		NiceMatch		= 128;				// The length of a match after which no longer match is searched for.
+static constexpr uint32_t	MaximumChain	= 16;				// The maximum number of earlier positions a match is searched at.
+static constexpr size_t		InsertMatch		= 16;				// All positions of matches up to this length are hashed, only the first of longer ones.
+static constexpr size_t		BlockSymbols	= 32768;			// The number of literals and matches in a block.
+static constexpr size_t		MinimumChunk	= 256 * 1024;		// The minimum number of bytes in a chunk that is compressed by a thread.
+static constexpr size_t		StoredSize		= 65535;			// The maximum size of a stored block.
+static constexpr uint32_t	AdlerBase		= 65521;			// The modulus of Adler-32.
+static constexpr size_t		AdlerBlock		= 5552;				// The maximum number of bytes that are summed before the sums would overflow.
+
+static constexpr size_t		LiteralCodes	= 288;				// The number of literal/length codes, 286 and 287 are not used.
+static constexpr size_t		DistanceCodes	= 30;				// The number of distance codes.
+static constexpr size_t		LengthCodes		= 19;				// The number of code length codes.
+static constexpr uint32_t	EndOfBlock		= 256;				// The literal/length code that ends a block.
+
+static constexpr uint16_t LengthBase[29]		= { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+static constexpr uint8_t  LengthExtra[29]		= { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+static constexpr uint16_t DistanceBase[30]		= { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+static constexpr uint8_t  DistanceExtra[30]		= { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+static constexpr uint8_t  LengthOrder[19]		= { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+/// <summary>
+/// A literal or a match found by the LZ77 stage.
+/// </summary>
+struct DeflateSymbol {
+	uint16_t Length;		// The length of the match, or the literal byte when the distance is 0.
+	uint16_t Distance;		// The distance of the match, or 0 for a literal.
+};
+
+/// <summary>
+/// A set of Huffman codes, the codes are bit reversed so that they can be written lsb first.
+/// </summary>
+template <size_t TCount>
+struct HuffmanCodes {
+	std::array<uint8_t, TCount>		Lengths;
+	std::array<uint16_t, TCount>	Codes;
+};
+
+/// <summary>
+/// The lookup tables from match lengths and distances to their codes, and the fixed Huffman codes.
+/// </summary>
+struct DeflateTables {
+	std::array<uint8_t, MaximumMatch + 1>	LengthCode;
+	std::array<uint8_t, WindowSize + 1>		DistanceCode;
+	HuffmanCodes<LiteralCodes>				FixedLiterals;
+	HuffmanCodes<DistanceCodes>				FixedDistances;
+
+	DeflateTables();
+};
+
+/// <summary>
+/// Reverse the lowest bits of a code.
+/// </summary>
+/// <param name="code">The code.</param>
+/// <param name="length">The number of bits.</param>
+/// <returns>The reversed code.</returns>
+static uint16_t Reverse(uint32_t code, uint32_t length) noexcept {
+	uint32_t result = 0;
+
+	for (uint32_t i = 0; i < length; ++i, code >>= 1)
+		result = (result << 1) | (code & 1);
+
+	return static_cast<uint16_t>(result);
+}
+
+/// <summary>
+/// Assign the canonical codes of a set of code lengths.
+/// </summary>
+/// <param name="codes">The code lengths, the codes are stored in it.</param>
+template <size_t TCount>
+static void AssignCodes(HuffmanCodes<TCount>& codes) noexcept {
+	uint32_t count[16] = { 0 };
+	uint32_t next[16]  = { 0 };
+
+	for (auto length : codes.Lengths)
+		++count[length];
+
+	count[0] = 0;
+	for (uint32_t bits = 1, code = 0; bits < 16; ++bits) {
+		code       = (code + count[bits - 1]) << 1;
+		next[bits] = code;
+	}
+
+	for (size_t i = 0; i < TCount; ++i)
+		codes.Codes[i] = codes.Lengths[i] != 0 ? Reverse(next[codes.Lengths[i]]++, codes.Lengths[i]) : 0;
+}
+
+DeflateTables::DeflateTables() {
+	for (uint8_t code = 0; code < 29; ++code) {
+		auto last = (code == 28) ? MaximumMatch : static_cast<size_t>(LengthBase[code + 1]) - 1;
+		for (size_t length = LengthBase[code]; length <= last; ++length)
+			LengthCode[length] = code;
+	}
+
+	for (uint8_t code = 0; code < 30; ++code) {
+		auto last = (code == 29) ? WindowSize : static_cast<size_t>(DistanceBase[code + 1]) - 1;
+		for (size_t distance = DistanceBase[code]; distance <= last; ++distance)
+			DistanceCode[distance] = code;
+	}
+
+	for (size_t i = 0; i < LiteralCodes; ++i)
+		FixedLiterals.Lengths[i] = static_cast<uint8_t>((i < 144) ? 8 : (i < 256) ? 9 : (i < 280) ? 7 : 8);
+
+	FixedDistances.Lengths.fill(5);
+	AssignCodes(FixedLiterals);
+	AssignCodes(FixedDistances);
+}
+
+/// <summary>
+/// Get the lookup tables, they are built once.
+/// </summary>
+/// <returns>The tables.</returns>
+static const DeflateTables& GetTables() {
+	static const DeflateTables tables;
+	return tables;
+}
+
+/// <summary>
+/// Compute the lengths of a minimum redundancy code in place, by the algorithm of Moffat and Katajainen.
+/// </summary>
+/// <param name="a">The frequencies of the symbols in ascending order, replaced by their code lengths.</param>
+/// <param name="n">The number of symbols, at least 2.</param>
+static void MinimumRedundancy(uint32_t* a, size_t n) noexcept {
+	size_t root = 0, leaf = 2;
+
+	a[0] += a[1];
+	for (size_t next = 1; next < n - 1; ++next) {
+		if (leaf >= n || a[root] < a[leaf]) {
+			a[next]   = a[root];
+			a[root++] = static_cast<uint32_t>(next);
+		} else {
+			a[next] = a[leaf++];
+		}
+
+		if (leaf >= n || (root < next && a[root] < a[leaf])) {
+			a[next]  += a[root];
+			a[root++] = static_cast<uint32_t>(next);
+		} else {
+			a[next] += a[leaf++];
+		}
+	}
+
+	a[n - 2] = 0;
+	for (auto next = static_cast<ptrdiff_t>(n) - 3; next >= 0; --next)
+		a[next] = a[a[next]] + 1;
+
+	auto available = 1, used = 0;
+	auto depth = 0u;
+	auto rootIndex = static_cast<ptrdiff_t>(n) - 2;
+	auto nextIndex = static_cast<ptrdiff_t>(n) - 1;
+
+	while (available > 0) {
+		while (rootIndex >= 0 && a[rootIndex] == depth) {
+			++used;
+			--rootIndex;
+		}
+
+		while (available > used) {
+			a[nextIndex--] = depth;
+			--available;
+		}
+
+		available = 2 * used;
+		++depth;
+		used = 0;
+	}
+}
+
+/// <summary>
+/// Build the Huffman codes of a set of symbol frequencies, limited to a maximum code length. Code lengths beyond the
+/// limit are shortened and the shortest codes of the least frequent symbols lengthened until the code is complete.
+/// </summary>
+/// <param name="frequencies">The frequencies of the symbols.</param>
+/// <param name="limit">The maximum code length.</param>
+/// <param name="codes">Receives the code lengths and the codes.</param>
+template <size_t TCount>
+static void BuildCodes(const std::array<uint32_t, TCount>& frequencies, uint32_t limit, HuffmanCodes<TCount>& codes) {
+	std::vector<std::pair<uint32_t, uint16_t>> symbols;
+
+	codes.Lengths.fill(0);
+	for (size_t i = 0; i < TCount; ++i) {
+		if (frequencies[i] != 0)
+			symbols.emplace_back(frequencies[i], static_cast<uint16_t>(i));
+	}
+
+	if (symbols.size() == 1)
+		codes.Lengths[symbols[0].second] = 1;
+
+	if (symbols.size() > 1) {
+		std::sort(symbols.begin(), symbols.end());
+
+		std::vector<uint32_t> lengths(symbols.size());
+		for (size_t i = 0; i < symbols.size(); ++i)
+			lengths[i] = symbols[i].first;
+
+		MinimumRedundancy(lengths.data(), lengths.size());
+
+		uint32_t count[16] = { 0 };
+		for (auto length : lengths)
+			++count[(std::min)(length, limit)];
+
+		uint32_t total = 0;
+		for (uint32_t bits = 1; bits <= limit; ++bits)
+			total += count[bits] << (limit - bits);
+
+		while (total != (1u << limit)) {
+			--count[limit];
+			for (auto bits = limit - 1; bits > 0; --bits) {
+				if (count[bits] != 0) {
+					--count[bits];
+					count[bits + 1] += 2;
+					break;
+				}
+			}
+
+			--total;
+		}
+
+		// The least frequent symbols get the longest codes.
+		size_t index = 0;
+		for (auto bits = limit; bits > 0; --bits) {
+			for (auto n = count[bits]; n > 0; --n)
+				codes.Lengths[symbols[index++].second] = static_cast<uint8_t>(bits);
+		}
+	}
+
+	AssignCodes(codes);
+}
+
+/// <summary>
+/// Writes bits lsb first, as deflate streams are packed.
+/// </summary>
+class BitWriter {
+	private:
+		std::vector<uint8_t>&	m_Output;
+		uint64_t				m_Bits  = 0;
+		uint32_t				m_Count = 0;
+
+	public:
+		BitWriter(std::vector<uint8_t>& output) : m_Output(output) {}
+
+		/// <summary>
+		/// Write bits.
+		/// </summary>
+		/// <param name="bits">The bits.</param>
+		/// <param name="count">The number of bits, at most 32.</param>
+		void Write(uint32_t bits, uint32_t count) {
+			m_Bits  |= static_cast<uint64_t>(bits) << m_Count;
+			m_Count += count;
+
+			if (m_Count >= 32) {
+				for (auto i = 0; i < 4; ++i, m_Bits >>= 8)
+					m_Output.push_back(static_cast<uint8_t>(m_Bits));
+				m_Count -= 32;
+			}
+		}
+
+		/// <summary>
+		/// Pad the bits written with zeroes to a byte boundary and write them out.
+		/// </summary>
+		void Align() {
+			for (; m_Count > 0; m_Count = (m_Count >= 8) ? m_Count - 8 : 0, m_Bits >>= 8)
+				m_Output.push_back(static_cast<uint8_t>(m_Bits));
+			m_Bits = 0;
+		}
+
+		/// <summary>
+		/// Write bytes, the bits written must be aligned.
+		/// </summary>
+		/// <param name="data">The bytes.</param>
+		void Write(ByteView data) {
+			m_Output.insert(m_Output.end(), data.begin(), data.end());
+		}
+};
+
+/// <summary>
+/// Write the symbols of a block with a set of Huffman codes.
+/// </summary>
+/// <param name="writer">The writer.</param>
+/// <param name="symbols">The symbols.</param>
+/// <param name="literals">The literal/length codes.</param>
+/// <param name="distances">The distance codes.</param>
+static void WriteSymbols(BitWriter& writer, const std::vector<DeflateSymbol>& symbols, const HuffmanCodes<LiteralCodes>& literals, const HuffmanCodes<DistanceCodes>& distances) {
+	auto& tables = GetTables();
+
+	for (auto symbol : symbols) {
+		if (symbol.Distance == 0) {
+			writer.Write(literals.Codes[symbol.Length], literals.Lengths[symbol.Length]);
+			continue;
+		}
+
+		auto length   = tables.LengthCode[symbol.Length];
+		auto distance = tables.DistanceCode[symbol.Distance];
+
+		writer.Write(literals.Codes[257u + length], literals.Lengths[257u + length]);
+		writer.Write(static_cast<uint32_t>(symbol.Length - LengthBase[length]), LengthExtra[length]);
+		writer.Write(distances.Codes[distance], distances.Lengths[distance]);
+		writer.Write(static_cast<uint32_t>(symbol.Distance - DistanceBase[distance]), DistanceExtra[distance]);
+	}
+
+	writer.Write(literals.Codes[EndOfBlock], literals.Lengths[EndOfBlock]);
+}
+
+/// <summary>
+/// Write a block in the form that is smallest: with dynamic Huffman codes, with the fixed codes or stored.
+/// </summary>
+/// <param name="writer">The writer.</param>
+/// <param name="symbols">The symbols of the block.</param>
+/// <param name="raw">The bytes the symbols encode.</param>
+/// <param name="last">Whether this is the last block of the stream.</param>
+static void WriteBlock(BitWriter& writer, const std::vector<DeflateSymbol>& symbols, ByteView raw, bool last) {
+	auto& tables = GetTables();
+
+	std::array<uint32_t, LiteralCodes>	literalFrequencies  = { 0 };
+	std::array<uint32_t, DistanceCodes>	distanceFrequencies = { 0 };
+	uint64_t extra = 0;
+
+	for (auto symbol : symbols) {
+		if (symbol.Distance == 0) {
+			++literalFrequencies[symbol.Length];
+			continue;
+		}
+
+		auto length   = tables.LengthCode[symbol.Length];
+		auto distance = tables.DistanceCode[symbol.Distance];
+
+		++literalFrequencies[257u + length];
+		++distanceFrequencies[distance];
+		extra += static_cast<uint64_t>(LengthExtra[length]) + DistanceExtra[distance];
+	}
+
+	literalFrequencies[EndOfBlock] = 1;
+
+	// A block without matches still needs a distance code.
+	if (std::all_of(distanceFrequencies.begin(), distanceFrequencies.end(), [](uint32_t frequency) { return frequency == 0; }))
+		distanceFrequencies[0] = 1;
+
+	HuffmanCodes<LiteralCodes>	literals;
+	HuffmanCodes<DistanceCodes>	distances;
+	BuildCodes(literalFrequencies, 15, literals);
+	BuildCodes(distanceFrequencies, 15, distances);
+
+	// The code lengths are run-length coded with the code length codes 16 (repeat the previous length), 17 and 18
+	// (repeat a zero length).
+	size_t literalCount  = 257;
+	size_t distanceCount = 1;
+	for (size_t i = literalCount; i < LiteralCodes; ++i) {
+		if (literals.Lengths[i] != 0)
+			literalCount = i + 1;
+	}
+
+	for (size_t i = distanceCount; i < DistanceCodes; ++i) {
+		if (distances.Lengths[i] != 0)
+			distanceCount = i + 1;
+	}
+
+	std::vector<uint8_t> lengths(literals.Lengths.begin(), literals.Lengths.begin() + static_cast<ptrdiff_t>(literalCount));
+	lengths.insert(lengths.end(), distances.Lengths.begin(), distances.Lengths.begin() + static_cast<ptrdiff_t>(distanceCount));
+
+	std::vector<std::pair<uint8_t, uint8_t>> runs;
+	std::array<uint32_t, LengthCodes> lengthFrequencies = { 0 };
+
+	for (size_t i = 0; i < lengths.size(); ) {
+		auto value = lengths[i];
+		auto run   = static_cast<size_t>(1);
+
+		while (i + run < lengths.size() && lengths[i + run] == value)
+			++run;
+		i += run;
+
+		if (value == 0) {
+			for (; run >= 11; run -= (std::min)(run, static_cast<size_t>(138)))
+				runs.emplace_back(18, static_cast<uint8_t>((std::min)(run, static_cast<size_t>(138)) - 11));
+			if (run >= 3) {
+				runs.emplace_back(17, static_cast<uint8_t>(run - 3));
+				run = 0;
+			}
+		} else {
+			runs.emplace_back(value, 0);
+			for (--run; run >= 3; run -= (std::min)(run, static_cast<size_t>(6)))
+				runs.emplace_back(16, static_cast<uint8_t>((std::min)(run, static_cast<size_t>(6)) - 3));
+		}
+
+		for (; run > 0; --run)
+			runs.emplace_back(value, 0);
+	}
+
+	for (auto& run : runs)
+		++lengthFrequencies[run.first];
+
+	HuffmanCodes<LengthCodes> lengthCodes;
+	BuildCodes(lengthFrequencies, 7, lengthCodes);
+
+	size_t lengthCount = 4;
+	for (size_t i = lengthCount; i < LengthCodes; ++i) {
+		if (lengthCodes.Lengths[LengthOrder[i]] != 0)
+			lengthCount = i + 1;
+	}
+
+	uint64_t dynamicBits = 3 + 5 + 5 + 4 + 3 * lengthCount + extra;
+	uint64_t fixedBits   = 3 + extra;
+
+	for (auto& run : runs)
+		dynamicBits += lengthCodes.Lengths[run.first] + ((run.first == 16) ? 2 : (run.first == 17) ? 3 : (run.first == 18) ? 7 : 0);
+
+	for (size_t i = 0; i < LiteralCodes; ++i) {
+		dynamicBits += static_cast<uint64_t>(literalFrequencies[i]) * literals.Lengths[i];
+		fixedBits   += static_cast<uint64_t>(literalFrequencies[i]) * tables.FixedLiterals.Lengths[i];
+	}
+
+	for (size_t i = 0; i < DistanceCodes; ++i) {
+		dynamicBits += static_cast<uint64_t>(distanceFrequencies[i]) * distances.Lengths[i];
+		fixedBits   += static_cast<uint64_t>(distanceFrequencies[i]) * tables.FixedDistances.Lengths[i];
+	}
+
+	auto storedBits = (raw.Size() / StoredSize + 1) * (3 + 7 + 32) + static_cast<uint64_t>(raw.Size()) * 8;
+
+	if (storedBits < dynamicBits && storedBits < fixedBits) {
+		size_t offset = 0;
+
+		do {
+			auto size = (std::min)(raw.Size() - offset, StoredSize);
+
+			writer.Write((last && offset + size == raw.Size()) ? 1 : 0, 1);
+			writer.Write(0, 2);
+			writer.Align();
+			writer.Write(static_cast<uint32_t>(size), 16);
+			writer.Write(static_cast<uint32_t>(size ^ 0xFFFF), 16);
+			writer.Write(raw.SubView(offset, size));
+
+			offset += size;
+		} while (offset < raw.Size());
+	} else if (fixedBits <= dynamicBits) {
+		writer.Write(last ? 1 : 0, 1);
+		writer.Write(1, 2);
+		WriteSymbols(writer, symbols, tables.FixedLiterals, tables.FixedDistances);
+	} else {
+		writer.Write(last ? 1 : 0, 1);
+		writer.Write(2, 2);
+		writer.Write(static_cast<uint32_t>(literalCount - 257), 5);
+		writer.Write(static_cast<uint32_t>(distanceCount - 1), 5);
+		writer.Write(static_cast<uint32_t>(lengthCount - 4), 4);
+
+		for (size_t i = 0; i < lengthCount; ++i)
+			writer.Write(lengthCodes.Lengths[LengthOrder[i]], 3);
+
+		for (auto& run : runs) {
+			writer.Write(lengthCodes.Codes[run.first], lengthCodes.Lengths[run.first]);
+
+			if (run.first == 16)
+				writer.Write(run.second, 2);
+			else if (run.first == 17)
+				writer.Write(run.second, 3);
+			else if (run.first == 18)
+				writer.Write(run.second, 7);
+		}
+
+		WriteSymbols(writer, symbols, literals, distances);
+	}
+}
+
+/// <summary>
+/// Hash the 4 bytes at a position.
+/// </summary>
+/// <param name="data">The bytes.</param>
+/// <returns>The hash.</returns>
+static uint32_t Hash(const uint8_t* data) noexcept {
+	uint32_t value;
+	memcpy(&value, data, sizeof(value));
+	return (value * 0x1E35A7BDu) >> (32 - HashBits);
+}
+
+/// <summary>
+/// Compute the length of the match between two positions.
+/// </summary>
+/// <param name="a">The earlier position.</param>
+/// <param name="b">The current position.</param>
+/// <param name="limit">The maximum length.</param>
+/// <returns>The length of the match.</returns>
+static size_t MatchLength(const uint8_t* a, const uint8_t* b, size_t limit) noexcept {
+	size_t length = 0;
+
+	for (uint64_t x, y; length + 8 <= limit; length += 8) {
+		memcpy(&x, a + length, 8);
+		memcpy(&y, b + length, 8);
+
+		if (x != y)
+			break;
+	}
+
+	while (length < limit && a[length] == b[length])
+		++length;
+
+	return length;
+}
+
+/// <summary>
+/// Split a number of bytes into chunks and process every chunk on its own thread, the first chunk is processed on the
+/// calling thread.
+/// </summary>
+/// <param name="size">The number of bytes.</param>
+/// <param name="chunks">The number of chunks.</param>
+/// <param name="function">Processes a chunk, it receives the chunk index and the offset and size of the chunk.</param>
+template <typename TFunction>
+static void ForEachChunk(size_t size, size_t chunks, TFunction function) {
+	std::vector<std::thread>		workers;
+	std::vector<std::exception_ptr>	errors(chunks);
+	auto chunk = [size, chunks](size_t index) { return static_cast<size_t>(static_cast<uint64_t>(size) * index / chunks); };
+	auto run   = [&](size_t index) {
+		try {
+			function(index, chunk(index), chunk(index + 1) - chunk(index));
+		} catch (...) {
+			errors[index] = std::current_exception();
+		}
+	};
+
+	try {
+		for (size_t t = 1; t < chunks; ++t)
+			workers.emplace_back(run, t);
+	} catch (...) {
+		for (auto& worker : workers)
+			worker.join();
+		throw;
+	}
+
+	run(0);
+
+	for (auto& worker : workers)
+		worker.join();
+
+	for (auto& error : errors) {
+		if (error)
+			std::rethrow_exception(error);
+	}
+}
+
+/// <summary>
+/// Compress data into a zlib stream.
+/// </summary>
+/// <param name="data">The data.</param>
+/// <param name="threads">The maximum number of threads to compress with.</param>
+/// <returns>The zlib stream.</returns>
+std::vector<uint8_t> Deflater::Compress(ByteView data, uint32_t threads) {
+	auto chunks = (std::max)(static_cast<size_t>(1), (std::min)(static_cast<size_t>(threads), data.Size() / MinimumChunk));
+
+	std::vector<std::vector<uint8_t>>	blocks(chunks);
+	std::vector<uint32_t>				checksums(chunks);
+
+	ForEachChunk(data.Size(), chunks, [&](size_t index, size_t offset, size_t size) {
+		blocks[index]    = CompressChunk(data, offset, size, index + 1 == chunks);
+		checksums[index] = Adler32(data.SubView(offset, size));
+	});
+
+	// CMF 0x78 is deflate with a 32 KiB window, FLG 0x01 is the fastest level and makes the header a multiple of 31.
+	std::vector<uint8_t> output = { 0x78, 0x01 };
+	size_t total = output.size() + 4;
+	for (auto& block : blocks)
+		total += block.size();
+
+	output.reserve(total);
+	for (auto& block : blocks)
+		output.insert(output.end(), block.begin(), block.end());
+
+	// The checksums of the chunks are combined the way zlib's adler32_combine does.
+	auto adler = checksums[0];
+	for (size_t i = 1; i < chunks; ++i) {
+		auto size      = static_cast<uint32_t>(((static_cast<uint64_t>(data.Size()) * (i + 1)) / chunks - (static_cast<uint64_t>(data.Size()) * i) / chunks) % AdlerBase);
+		auto low       = adler & 0xFFFF;
+		auto high      = static_cast<uint32_t>((static_cast<uint64_t>(size) * low) % AdlerBase);
+
+		low  += (checksums[i] & 0xFFFF) + AdlerBase - 1;
+		high += (adler >> 16) + (checksums[i] >> 16) + AdlerBase - size;
+
+		if (low >= AdlerBase) low -= AdlerBase;
+		if (low >= AdlerBase) low -= AdlerBase;
+		if (high >= (AdlerBase << 1)) high -= (AdlerBase << 1);
+		if (high >= AdlerBase) high -= AdlerBase;
+
+		adler = low | (high << 16);
+	}
+
+	for (auto shift = 24; shift >= 0; shift -= 8)
+		output.push_back(static_cast<uint8_t>(adler >> shift));
+
+	return output;
+}
+
+/// <summary>
+/// Compute the Adler-32 checksum of data, as used by zlib streams.
+/// </summary>
+/// <param name="data">The data.</param>
+/// <param name="adler">The checksum of the data that precedes it, or 1.</param>
+/// <returns>The checksum.</returns>
+uint32_t Deflater::Adler32(ByteView data, uint32_t adler) noexcept {
+	uint32_t low  = adler & 0xFFFF;
+	uint32_t high = adler >> 16;
+	auto bytes = data.Data();
+	auto size  = data.Size();
+
+	while (size > 0) {
+		auto block = (std::min)(size, AdlerBlock);
+		size -= block;
+
+		for (; block > 0; --block) {
+			low  += *bytes++;
+			high += low;
+		}
+
+		low  %= AdlerBase;
+		high %= AdlerBase;
+	}
+
+	return low | (high << 16);
+}
+
+/// <summary>
+/// Compress a chunk of data into raw deflate blocks. The chunk ends on a byte boundary, with a final block when it
+/// is the last chunk and with an empty stored block otherwise.
+/// </summary>
+/// <param name="data">All of the data, the 32 KiB before the chunk are used as its dictionary.</param>
+/// <param name="offset">The offset of the chunk in the data.</param>
+/// <param name="size">The size of the chunk.</param>
+/// <param name="last">Whether this is the last chunk of the stream.</param>
+/// <returns>The deflate blocks.</returns>
+std::vector<uint8_t> Deflater::CompressChunk(ByteView data, size_t offset, size_t size, bool last) {
+	auto base  = offset >= WindowSize ? offset - WindowSize : 0;
+	auto bytes = data.Data();
+	auto end   = offset + size;
+
+	// Positions are stored relative to the start of the dictionary plus 1, 0 is the end of a chain.
+	std::vector<uint32_t>		heads(static_cast<size_t>(1) << HashBits, 0);
+	std::vector<uint32_t>		chains(WindowSize, 0);
+	std::vector<DeflateSymbol>	symbols;
+	std::vector<uint8_t>		output;
+	BitWriter					writer(output);
+
+	auto insert = [&](size_t position) {
+		auto hash     = Hash(bytes + position);
+		auto relative = static_cast<uint32_t>(position - base);
+
+		chains[relative & (WindowSize - 1)] = heads[hash];
+		heads[hash] = relative + 1;
+	};
+
+	for (auto position = base; position < offset && position + MinimumMatch <= data.Size(); ++position)
+		insert(position);
+
+	output.reserve(size / 2 + 64);
+	symbols.reserve(BlockSymbols);
+
+	auto blockStart = offset;
+	for (auto position = offset; position < end; ) {
+		size_t bestLength   = 0;
+		size_t bestDistance = 0;
+
+		if (position + MinimumMatch <= end) {
+			auto limit     = (std::min)(MaximumMatch, end - position);
+			auto candidate = heads[Hash(bytes + position)];
+
+			for (auto depth = MaximumChain; candidate != 0 && depth > 0; --depth) {
+				auto earlier  = base + candidate - 1;
+				auto distance = position - earlier;
+
+				if (earlier >= position || distance > WindowSize)
+					break;
+
+				if (bytes[earlier + bestLength] == bytes[position + bestLength] || bestLength == 0) {
+					auto length = MatchLength(bytes + earlier, bytes + position, limit);
+
+					if (length > bestLength) {
+						bestLength   = length;
+						bestDistance = distance;
+
+						if (length >= (std::min)(NiceMatch, limit))
+							break;
+					}
+				}
+
+				candidate = chains[(candidate - 1) & (WindowSize - 1)];
+			}
+		}
+
+		if (bestLength >= MinimumMatch) {
+			symbols.push_back({ static_cast<uint16_t>(bestLength), static_cast<uint16_t>(bestDistance) });
+
+			auto inserted = (bestLength <= InsertMatch) ? bestLength : 1;
+			for (size_t i = 0; i < inserted && position + i + MinimumMatch <= data.Size(); ++i)
+				insert(position + i);
+
+			position += bestLength;
+		} else {
+			symbols.push_back({ bytes[position], 0 });
+
+			if (position + MinimumMatch <= data.Size())
+				insert(position);
+
+			++position;
+		}
+
+		if (symbols.size() >= BlockSymbols && position < end) {
+			WriteBlock(writer, symbols, data.SubView(blockStart, position - blockStart), false);
+			symbols.clear();
+			blockStart = position;
+		}
+	}
+
+	WriteBlock(writer, symbols, data.SubView(blockStart, end - blockStart), last);
+
+	// An empty stored block aligns the chunk to a byte boundary, so that the next chunk can be appended to it.
+	if (!last) {
+		writer.Write(0, 3);
+		writer.Align();
+		writer.Write(0x0000, 16);
+		writer.Write(0xFFFF, 16);
+	}
+
+	writer.Align();
+	return output;
+}
\ No newline at end of file
@@ -0,0 +1,50 @@
+#pragma once
+
+#ifndef libtiffconvert_deflater_h
+#define libtiffconvert_deflater_h
+
+#include <ByteView.hpp>
+#include <cstdint>
+#include <vector>
+
+namespace TiffConvert {
+	/// <summary>
+	/// Deflater is a native zlib (RFC 1950 and 1951) compressor that favours speed over ratio, like the fastest levels of
+	/// zlib and libdeflate: greedy LZ77 matching on hash chains of a limited depth, with every block coded with dynamic
+	/// Huffman codes, the fixed codes or stored, whichever is smallest. Large inputs are split into chunks that are
+	/// compressed on several threads at once. Every chunk is primed with the 32 KiB of input that precede it and ends on a
+	/// byte boundary with an empty stored block, so that the chunks concatenate into a single stream.
+	/// </summary>
+	class Deflater {
+		public:
+			/// <summary>
+			/// Compress data into a zlib stream.
+			/// </summary>
+			/// <param name="data">The data.</param>
+			/// <param name="threads">The maximum number of threads to compress with.</param>
+			/// <returns>The zlib stream.</returns>
+			static std::vector<uint8_t> Compress(TiffWang::Tiff::ByteView data, uint32_t threads = 1);
+
+			/// <summary>
+			/// Compute the Adler-32 checksum of data, as used by zlib streams.
+			/// </summary>
+			/// <param name="data">The data.</param>
+			/// <param name="adler">The checksum of the data that precedes it, or 1.</param>
+			/// <returns>The checksum.</returns>
+			static uint32_t Adler32(TiffWang::Tiff::ByteView data, uint32_t adler = 1) noexcept;
+
+		private:
+			/// <summary>
+			/// Compress a chunk of data into raw deflate blocks. The chunk ends on a byte boundary, with a final block when it
+			/// is the last chunk and with an empty stored block otherwise.
+			/// </summary>
+			/// <param name="data">All of the data, the 32 KiB before the chunk are used as its dictionary.</param>
+			/// <param name="offset">The offset of the chunk in the data.</param>
+			/// <param name="size">The size of the chunk.</param>
+			/// <param name="last">Whether this is the last chunk of the stream.</param>
+			/// <returns>The deflate blocks.</returns>
+			static std::vector<uint8_t> CompressChunk(TiffWang::Tiff::ByteView data, size_t offset, size_t size, bool last);
+	};
+}
+
+#endif
@@ -0,0 +1,309 @@
+#include "DibImage.hpp"
+#include <algorithm>
+#include <stdexcept>
+#include <cstring>
+
+using namespace TiffConvert;
+using TiffWang::Tiff::ByteView;
+
+static constexpr uint32_t MaximumDimension = 32768;	// Larger images are considered corrupt, an RLE image is decoded into width * height bytes.
+
+/// <summary>
+/// The mapping of a pixel (u, v) of the rotated and/or mirrored image onto a pixel (x, y) of the stored image,
+/// x = X + Xu * u + Xv * v and y = Y + Yu * u + Yv * v.
+/// </summary>
+struct Orientation {
+	int64_t	X, Xu, Xv;
+	int64_t	Y, Yu, Yv;
+	bool	Swapped;	// Whether the width and height are swapped by a rotation of 90 or 270 degrees.
+};
+
+/// <summary>
+/// Get the mapping of a Wang orientation, the image is mirrored around a vertical line before it is rotated clockwise.
+/// </summary>
+/// <param name="rotation">The orientation.</param>
+/// <param name="w">The width of the stored image.</param>
+/// <param name="h">The height of the stored image.</param>
+/// <returns>The mapping.</returns>
+static Orientation GetOrientation(AN_ROTATE_TYPE rotation, int64_t w, int64_t h) noexcept {
+	switch (rotation) {
+		case AN_ROTATE_TYPE::RotateRight:					return { 0,      0,  1, h - 1, -1,  0, true };
+		case AN_ROTATE_TYPE::Flip:							return { w - 1, -1,  0, h - 1,  0, -1, false };
+		case AN_ROTATE_TYPE::RotateLeft:					return { w - 1,  0, -1, 0,      1,  0, true };
+		case AN_ROTATE_TYPE::VerticalMirror:				return { w - 1, -1,  0, 0,      0,  1, false };
+		case AN_ROTATE_TYPE::VerticalMirrorRotateRight:		return { w - 1,  0, -1, h - 1, -1,  0, true };
+		case AN_ROTATE_TYPE::VerticalMirrorFlip:			return { 0,      1,  0, h - 1,  0, -1, false };
+		case AN_ROTATE_TYPE::VerticalMirrorRotateLeft:		return { 0,      0,  1, 0,      1,  0, true };
+		default:											return { 0,      1,  0, 0,      0,  1, false };
+	}
+}
+
+/// <summary>
+/// Draw a stored image onto a target through an orientation, scaled to fill the bounds with the nearest pixel.
+/// </summary>
+/// <param name="target">The target pixels, 24 or 32-bit.</param>
+/// <param name="bounds">The bounds of the image on the target.</param>
+/// <param name="orientation">The mapping of the rotated and/or mirrored image onto the stored image.</param>
+/// <param name="width">The width of the stored image.</param>
+/// <param name="height">The height of the stored image.</param>
+/// <param name="highlight">Only paint pixels that are white.</param>
+/// <param name="transparent">Don't paint the white pixels of the image.</param>
+/// <param name="fetch">Returns the color of a pixel of the stored image as 0x00RRGGBB.</param>
+template <typename Fetch>
+static void Blit(const RasterTarget& target, const RECT& bounds, const Orientation& orientation, uint32_t width, uint32_t height, bool highlight, bool transparent, Fetch fetch) {
+	int64_t boundsWidth  = static_cast<int64_t>(bounds.right) - bounds.left;
+	int64_t boundsHeight = static_cast<int64_t>(bounds.bottom) - bounds.top;
+	if (boundsWidth <= 0 || boundsHeight <= 0)
+		return;
+
+	auto x0 = (std::max)(static_cast<int64_t>(bounds.left), int64_t(0));
+	auto x1 = (std::min)(static_cast<int64_t>(bounds.right), static_cast<int64_t>(target.Width));
+	auto y0 = (std::max)(static_cast<int64_t>(bounds.top), int64_t(0));
+	auto y1 = (std::min)(static_cast<int64_t>(bounds.bottom), static_cast<int64_t>(target.Height));
+	if (x0 >= x1 || y0 >= y1)
+		return;
+
+	int64_t orientedWidth  = orientation.Swapped ? height : width;
+	int64_t orientedHeight = orientation.Swapped ? width : height;
+
+	// Every column of the target maps onto the same column of the rotated image on every row, those are computed once.
+	std::vector<int64_t> columns(static_cast<size_t>(x1 - x0));
+	for (auto x = x0; x < x1; ++x)
+		columns[static_cast<size_t>(x - x0)] = ((x - bounds.left) * 2 + 1) * orientedWidth / (boundsWidth * 2);
+
+	auto bytes = target.BitsPerPixel / 8;
+	auto bgr   = target.Bgr;
+
+	for (auto y = y0; y < y1; ++y) {
+		auto v      = ((y - bounds.top) * 2 + 1) * orientedHeight / (boundsHeight * 2);
+		auto pixels = target.Bits + y * target.Pitch + x0 * bytes;
+		auto baseX  = orientation.X + orientation.Xv * v;
+		auto baseY  = orientation.Y + orientation.Yv * v;
+
+		for (auto u : columns) {
+			auto color = fetch(static_cast<uint32_t>(baseX + orientation.Xu * u), static_cast<uint32_t>(baseY + orientation.Yu * u));
+			auto paint = !(transparent && color == 0x00FFFFFF) && !(highlight && (pixels[0] != 255 || pixels[1] != 255 || pixels[2] != 255));
+
+			if (paint) {
+				pixels[bgr ? 0 : 2] = static_cast<uint8_t>(color);
+				pixels[1]           = static_cast<uint8_t>(color >> 8);
+				pixels[bgr ? 2 : 0] = static_cast<uint8_t>(color >> 16);
+				if (bytes == 4)
+					pixels[3] = 255;
+			}
+
+			pixels += bytes;
+		}
+	}
+}
+
+/// <summary>
+/// Construct a new image from DIB data, a BITMAPINFOHEADER or BITMAPCOREHEADER followed by the palette and the pixels.
+/// </summary>
+/// <param name="data">The DIB data, which must stay alive as long as this image.</param>
+/// <exception cref="std::runtime_error">When the format is not supported or the data is corrupt.</exception>
+DibImage::DibImage(ByteView data) {
+	if (data.Size() < sizeof(DWORD))
+		throw std::runtime_error("embedded DIB is truncated");
+
+	DWORD headerSize;
+	memcpy(&headerSize, data.Data(), sizeof(headerSize));
+
+	int64_t width, height;
+	uint32_t compression = BI_RGB, colors = 0, entrySize = sizeof(RGBQUAD);
+
+	if (headerSize == sizeof(BITMAPCOREHEADER) && data.Size() >= sizeof(BITMAPCOREHEADER)) {
+		BITMAPCOREHEADER header;
+		memcpy(&header, data.Data(), sizeof(header));
+
+		width          = header.bcWidth;
+		height         = header.bcHeight;
+		m_BitsPerPixel = header.bcBitCount;
+		entrySize      = 3;
+	} else if (headerSize >= sizeof(BITMAPINFOHEADER) && data.Size() >= headerSize) {
+		BITMAPINFOHEADER header;
+		memcpy(&header, data.Data(), sizeof(header));
+
+		width          = header.biWidth;
+		height         = header.biHeight;
+		m_BitsPerPixel = header.biBitCount;
+		compression    = header.biCompression;
+		colors         = header.biClrUsed;
+	} else {
+		throw std::runtime_error("embedded DIB has an unsupported header");
+	}
+
+	if (width <= 0 || height == 0 || width > MaximumDimension || height > MaximumDimension || -height > MaximumDimension)
+		throw std::runtime_error("embedded DIB has invalid dimensions");
+
+	auto supported = (compression == BI_RGB && (m_BitsPerPixel == 1 || m_BitsPerPixel == 4 || m_BitsPerPixel == 8 || m_BitsPerPixel == 24 || m_BitsPerPixel == 32))
+		|| (compression == BI_RLE8 && m_BitsPerPixel == 8 && height > 0)
+		|| (compression == BI_RLE4 && m_BitsPerPixel == 4 && height > 0);
+	if (!supported)
+		throw std::runtime_error("embedded DIB has an unsupported pixel format");
+
+	m_Width    = static_cast<uint32_t>(width);
+	m_Height   = static_cast<uint32_t>(height < 0 ? -height : height);
+	m_BottomUp = height > 0;
+	m_Stride   = ((static_cast<size_t>(m_Width) * m_BitsPerPixel + 31) / 32) * 4;
+
+	// Images of more than 8 bits per pixel may have a palette for displays with fewer colors, it is skipped.
+	if (m_BitsPerPixel <= 8 && (colors == 0 || colors > (1u << m_BitsPerPixel)))
+		colors = 1u << m_BitsPerPixel;
+
+	size_t offset = headerSize;
+	if (data.Size() < offset + static_cast<size_t>(colors) * entrySize)
+		throw std::runtime_error("embedded DIB is truncated");
+
+	for (uint32_t i = 0; i < colors && m_BitsPerPixel <= 8; ++i, offset += entrySize)
+		m_Palette[i] = data[offset] | (data[offset + 1] << 8) | (data[offset + 2] << 16);
+
+	if (m_BitsPerPixel > 8)
+		offset += static_cast<size_t>(colors) * entrySize;
+
+	if (compression == BI_RLE8 || compression == BI_RLE4) {
+		DecodeRle(data.SubView(offset), compression == BI_RLE4);
+		return;
+	}
+
+	if (data.Size() - offset < m_Stride * m_Height)
+		throw std::runtime_error("embedded DIB is truncated");
+
+	m_Bits = data.Data() + offset;
+}
+
+/// <summary>
+/// Get the width of the image, before it is rotated.
+/// </summary>
+/// <returns>The width in pixels.</returns>
+uint32_t DibImage::GetWidth() const noexcept {
+	return m_Width;
+}
+
+/// <summary>
+/// Get the height of the image, before it is rotated.
+/// </summary>
+/// <returns>The height in pixels.</returns>
+uint32_t DibImage::GetHeight() const noexcept {
+	return m_Height;
+}
+
+/// <summary>
+/// Draw the image onto a target, rotated and/or mirrored and scaled to fill its bounds with the nearest pixel.
+/// </summary>
+/// <param name="target">The target pixels.</param>
+/// <param name="bounds">The bounds of the image on the target, after rotation.</param>
+/// <param name="rotation">The orientation, the image is mirrored around a vertical line before it is rotated clockwise.</param>
+/// <param name="highlight">Only paint pixels that are white.</param>
+/// <param name="transparent">Don't paint the white pixels of the image.</param>
+/// <returns>True when successful, false when the target has a pixel format that is not supported.</returns>
+bool DibImage::Draw(const RasterTarget& target, const RECT& bounds, AN_ROTATE_TYPE rotation, bool highlight, bool transparent) const {
+	if (target.Bits == nullptr || (target.BitsPerPixel != 24 && target.BitsPerPixel != 32))
+		return false;
+
+	auto orientation = GetOrientation(rotation, m_Width, m_Height);
+	auto& palette    = m_Palette;
+
+	if (!m_Indexes.empty()) {
+		auto indexes = m_Indexes.data();
+		auto width   = m_Width;
+
+		Blit(target, bounds, orientation, m_Width, m_Height, highlight, transparent, [=, &palette](uint32_t x, uint32_t y) {
+			return palette[indexes[static_cast<size_t>(y) * width + x]];
+		});
+		return true;
+	}
+
+	auto bits     = m_Bits;
+	auto stride   = m_Stride;
+	auto bottomUp = m_BottomUp;
+	auto last     = m_Height - 1;
+	auto row      = [=](uint32_t y) { return bits + static_cast<size_t>(bottomUp ? last - y : y) * stride; };
+
+	switch (m_BitsPerPixel) {
+		case 1:
+			Blit(target, bounds, orientation, m_Width, m_Height, highlight, transparent, [=, &palette](uint32_t x, uint32_t y) {
+				return palette[(row(y)[x >> 3] >> (7 - (x & 7))) & 1];
+			});
+			break;
+		case 4:
+			Blit(target, bounds, orientation, m_Width, m_Height, highlight, transparent, [=, &palette](uint32_t x, uint32_t y) {
+				return palette[(row(y)[x >> 1] >> ((x & 1) ? 0 : 4)) & 0x0F];
+			});
+			break;
+		case 8:
+			Blit(target, bounds, orientation, m_Width, m_Height, highlight, transparent, [=, &palette](uint32_t x, uint32_t y) {
+				return palette[row(y)[x]];
+			});
+			break;
+		default: {
+			// The fourth byte of 32-bit BI_RGB pixels is unused, the image is opaque.
+			auto bytes = m_BitsPerPixel / 8;
+			Blit(target, bounds, orientation, m_Width, m_Height, highlight, transparent, [=](uint32_t x, uint32_t y) {
+				auto pixel = row(y) + static_cast<size_t>(x) * bytes;
+				return static_cast<uint32_t>(pixel[0] | (pixel[1] << 8) | (pixel[2] << 16));
+			});
+			break;
+		}
+	}
+
+	return true;
+}
+
+/// <summary>
+/// Decode RLE4 or RLE8 compressed pixels into <see cref="m_Indexes"/>.
+/// </summary>
+/// <param name="data">The compressed pixels.</param>
+/// <param name="rle4">True for RLE4, false for RLE8.</param>
+/// <exception cref="std::runtime_error">When the data is corrupt.</exception>
+void DibImage::DecodeRle(ByteView data, bool rle4) {
+	m_Indexes.assign(static_cast<size_t>(m_Width) * m_Height, 0);
+
+	// Rows are coded bottom-up, pixels outside of the image are dropped and pixels that are skipped keep index 0.
+	size_t x = 0, y = 0, i = 0;
+	auto put = [&](uint8_t index) {
+		if (x < m_Width && y < m_Height)
+			m_Indexes[(m_Height - 1 - y) * m_Width + x] = index;
+		++x;
+	};
+
+	while (i + 1 < data.Size() && y < m_Height) {
+		auto count = data[i];
+		auto value = data[i + 1];
+		i += 2;
+
+		if (count > 0) {
+			// Encoded mode, a run of a single index or of two alternating RLE4 indexes.
+			for (uint32_t n = 0; n < count; ++n)
+				put(rle4 ? static_cast<uint8_t>((n & 1) ? (value & 0x0F) : (value >> 4)) : value);
+			continue;
+		}
+
+		switch (value) {
+			case 0:		// End of line.
+				x = 0;
+				++y;
+				break;
+			case 1:		// End of bitmap.
+				return;
+			case 2:		// Delta.
+				if (i + 1 >= data.Size())
+					throw std::runtime_error("embedded DIB has corrupt RLE data");
+				x += data[i];
+				y += data[i + 1];
+				i += 2;
+				break;
+			default: {	// Absolute mode, a run of literal indexes padded to a 16-bit boundary.
+				size_t size = rle4 ? (value + 1) / 2 : value;
+				if (i + size > data.Size())
+					throw std::runtime_error("embedded DIB has corrupt RLE data");
+
+				for (uint32_t n = 0; n < value; ++n)
+					put(rle4 ? static_cast<uint8_t>((n & 1) ? (data[i + n / 2] & 0x0F) : (data[i + n / 2] >> 4)) : data[i + n]);
+
+				i += (size + 1) & ~static_cast<size_t>(1);
+				break;
+			}
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,79 @@
+#pragma once
+
+#ifndef libtiffconvert_dib_image_h
+#define libtiffconvert_dib_image_h
+
+#include "Rasterizer.hpp"
+#include <libtiffwang.h>
+#include <ByteView.hpp>
+#include <cstdint>
+#include <array>
+#include <vector>
+#include <Windows.h>
+
+namespace TiffConvert {
+	/// <summary>
+	/// DibImage is a native decoder for the device independent bitmaps that are embedded in Wang image marks. It supports 1, 4
+	/// and 8-bit palette images, 24 and 32-bit images and RLE4 / RLE8 compressed palette images. Uncompressed pixels are read
+	/// in place from the annotation data, which must stay alive as long as the DibImage. The image is drawn in any of the
+	/// eight Wang orientations and scaled to its bounds in a single pass, without intermediate images.
+	/// </summary>
+	class DibImage {
+		private:
+			uint32_t					m_Width        = 0;
+			uint32_t					m_Height       = 0;
+			uint32_t					m_BitsPerPixel = 0;
+			size_t						m_Stride       = 0;		// The number of bytes per row of m_Bits.
+			bool						m_BottomUp     = true;	// Whether the first row in m_Bits is the bottom row.
+			const uint8_t*				m_Bits         = nullptr;
+			std::array<uint32_t, 256>	m_Palette      = {};	// 0x00RRGGBB, colors beyond the palette of the image are black.
+			std::vector<uint8_t>		m_Indexes;				// The decoded palette indexes of RLE compressed images, top row first.
+
+		public:
+			/// <summary>
+			/// Construct a new image from DIB data, a BITMAPINFOHEADER or BITMAPCOREHEADER followed by the palette and the pixels.
+			/// </summary>
+			/// <param name="data">The DIB data, which must stay alive as long as this image.</param>
+			/// <exception cref="std::runtime_error">When the format is not supported or the data is corrupt.</exception>
+			DibImage(TiffWang::Tiff::ByteView data);
+
+			DibImage(const DibImage&) = delete;
+			DibImage(DibImage&&) = delete;
+			DibImage& operator=(const DibImage&) = delete;
+			DibImage& operator=(DibImage&&) = delete;
+
+			/// <summary>
+			/// Get the width of the image, before it is rotated.
+			/// </summary>
+			/// <returns>The width in pixels.</returns>
+			uint32_t GetWidth() const noexcept;
+
+			/// <summary>
+			/// Get the height of the image, before it is rotated.
+			/// </summary>
+			/// <returns>The height in pixels.</returns>
+			uint32_t GetHeight() const noexcept;
+
+			/// <summary>
+			/// Draw the image onto a target, rotated and/or mirrored and scaled to fill its bounds with the nearest pixel.
+			/// </summary>
+			/// <param name="target">The target pixels.</param>
+			/// <param name="bounds">The bounds of the image on the target, after rotation.</param>
+			/// <param name="rotation">The orientation, the image is mirrored around a vertical line before it is rotated clockwise.</param>
+			/// <param name="highlight">Only paint pixels that are white.</param>
+			/// <param name="transparent">Don't paint the white pixels of the image.</param>
+			/// <returns>True when successful, false when the target has a pixel format that is not supported.</returns>
+			bool Draw(const RasterTarget& target, const RECT& bounds, AN_ROTATE_TYPE rotation, bool highlight = false, bool transparent = false) const;
+
+		private:
+			/// <summary>
+			/// Decode RLE4 or RLE8 compressed pixels into <see cref="m_Indexes"/>.
+			/// </summary>
+			/// <param name="data">The compressed pixels.</param>
+			/// <param name="rle4">True for RLE4, false for RLE8.</param>
+			/// <exception cref="std::runtime_error">When the data is corrupt.</exception>
+			void DecodeRle(TiffWang::Tiff::ByteView data, bool rle4);
+	};
+}
+
+#endif
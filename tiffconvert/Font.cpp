@@ -1,5 +1,6 @@
 #include "Font.hpp"
 #include "Util.hpp"
+#include "GlyphCache.hpp"
 #include <stdexcept>
 #include <string>
 
@@ -83,9 +84,11 @@ Font::Font(const LOGFONTA& descriptor)
 }
 
 /// <summary>
-/// The destructor frees the internal font.
+/// The destructor frees the internal font and the text that has been rasterized with it, see <see cref="GlyphCache"/>.
 /// </summary>
 Font::~Font() {
+	GlyphCache::Release(*this);
+
 	if (m_Font)
 		font_close(m_Font);
 }
@@ -96,4 +99,12 @@ Font::~Font() {
 /// <returns>A const pointer to the internal font object.</returns>
 const font_handle* Font::get() const noexcept {
 	return m_Font;
+}
+
+/// <summary>
+/// Get the GDI handle of the internal font object.
+/// </summary>
+/// <returns>The font handle, or nullptr when it is not available.</returns>
+HFONT Font::GetHandle() const noexcept {
+	return m_Font ? font_get_id(m_Font) : nullptr;
 }
\ No newline at end of file
@@ -58,8 +58,13 @@ namespace TiffConvert {
 			/// <param name="descriptor">The LOGFONTA instance.</param>
 			Font(const LOGFONTA& descriptor);
 
+			Font(const Font&) = delete;
+			Font(Font&&) = delete;
+			Font& operator=(const Font&) = delete;
+			Font& operator=(Font&&) = delete;
+
 			/// <summary>
-			/// The destructor frees the internal font.
+			/// The destructor frees the internal font and the text that has been rasterized with it, see <see cref="GlyphCache"/>.
 			/// </summary>
 			~Font();
 
@@ -68,6 +73,12 @@ namespace TiffConvert {
 			/// </summary>
 			/// <returns>A const pointer to the internal font object.</returns>
 			const font_handle* get() const noexcept;
+
+			/// <summary>
+			/// Get the GDI handle of the internal font object.
+			/// </summary>
+			/// <returns>The font handle, or nullptr when it is not available.</returns>
+			HFONT GetHandle() const noexcept;
 	};
 }
 
@@ -0,0 +1,52 @@
+#include "FontCache.hpp"
+#include <algorithm>
+#include <cctype>
+#include <stdexcept>
+
+using namespace TiffConvert;
+
+std::mutex									FontCache::s_Mutex;
+std::map<FontCache::Key, std::shared_ptr<const Font>>	FontCache::s_Fonts;
+
+/// <summary>
+/// Get the font described by a LOGFONTA descriptor, it is loaded when it is not in the cache yet. When the face cannot
+/// be loaded, Arial is loaded with the same height and style instead and cached in place of the requested face.
+/// </summary>
+/// <param name="descriptor">The LOGFONTA instance, with the height already scaled to the output.</param>
+/// <returns>The font.</returns>
+/// <exception cref="std::runtime_error">When neither the requested face nor the fallback face can be loaded.</exception>
+std::shared_ptr<const Font> FontCache::Get(const LOGFONTA& descriptor) {
+	// Face names are case insensitive, the name in a mark is not guaranteed to be terminated.
+	std::string face(descriptor.lfFaceName, strnlen_s(descriptor.lfFaceName, LF_FACESIZE));
+	std::transform(face.begin(), face.end(), face.begin(), [](char c) {
+		return static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+	});
+
+	auto flags = Font::FlagsFromLogFont(descriptor);
+	Key key(face, descriptor.lfHeight, flags);
+
+	std::lock_guard<std::mutex> lock(s_Mutex);
+
+	auto it = s_Fonts.find(key);
+	if (it != s_Fonts.end())
+		return it->second;
+
+	// Loading is done while holding the lock, so that concurrent pages don't load the same font twice.
+	std::shared_ptr<const Font> font;
+	try {
+		font = std::make_shared<const Font>(std::string(descriptor.lfFaceName, face.size()), static_cast<uint32_t>(descriptor.lfHeight), flags);
+	} catch (const std::exception&) {
+		font = std::make_shared<const Font>("Arial", static_cast<uint32_t>(descriptor.lfHeight), flags);
+	}
+
+	s_Fonts.emplace(std::move(key), font);
+	return font;
+}
+
+/// <summary>
+/// Remove all fonts from the cache. Fonts that are still in use are freed when they are no longer used.
+/// </summary>
+void FontCache::Clear() {
+	std::lock_guard<std::mutex> lock(s_Mutex);
+	s_Fonts.clear();
+}
\ No newline at end of file
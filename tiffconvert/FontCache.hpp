@@ -0,0 +1,44 @@
+#pragma once
+
+#ifndef libtiffconvert_font_cache_h
+#define libtiffconvert_font_cache_h
+
+#include "Font.hpp"
+#include <string>
+#include <tuple>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <Windows.h>
+
+namespace TiffConvert {
+	/// <summary>
+	/// FontCache provides a class of static methods that keep the fonts of text marks loaded for the lifetime of the process,
+	/// so that a font is only loaded once for every combination of face name, height and style, no matter how many marks
+	/// or pages use it. The cache can be used by multiple threads at the same time.
+	/// </summary>
+	class FontCache {
+		private:
+			using Key = std::tuple<std::string, int32_t, uint32_t>;	// The lowercase face name, height and style flags.
+
+			static std::mutex								s_Mutex;
+			static std::map<Key, std::shared_ptr<const Font>>	s_Fonts;
+
+		public:
+			/// <summary>
+			/// Get the font described by a LOGFONTA descriptor, it is loaded when it is not in the cache yet. When the face cannot
+			/// be loaded, Arial is loaded with the same height and style instead and cached in place of the requested face.
+			/// </summary>
+			/// <param name="descriptor">The LOGFONTA instance, with the height already scaled to the output.</param>
+			/// <returns>The font.</returns>
+			/// <exception cref="std::runtime_error">When neither the requested face nor the fallback face can be loaded.</exception>
+			static std::shared_ptr<const Font> Get(const LOGFONTA& descriptor);
+
+			/// <summary>
+			/// Remove all fonts from the cache. Fonts that are still in use are freed when they are no longer used.
+			/// </summary>
+			static void Clear();
+	};
+}
+
+#endif
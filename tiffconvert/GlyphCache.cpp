@@ -0,0 +1,157 @@
+#include "GlyphCache.hpp"
+#include "Font.hpp"
+#include <Windows.h>
+#include <algorithm>
+#include <cstring>
+
+using namespace TiffConvert;
+
+std::mutex												GlyphCache::s_Mutex;
+std::map<GlyphCache::Key, std::shared_ptr<const GlyphCache::TextMask>>	GlyphCache::s_Masks;
+size_t													GlyphCache::s_Size = 0;
+
+/// <summary>
+/// Get the coverage mask of a line of text, it is rasterized when it is not in the cache yet.
+/// </summary>
+/// <param name="font">The font, which must stay alive while it is in use. Its masks are released when it is destroyed.</param>
+/// <param name="line">The line of text, without line breaks.</param>
+/// <returns>The mask, or nullptr when the text cannot be rasterized.</returns>
+std::shared_ptr<const GlyphCache::TextMask> GlyphCache::Get(const Font& font, const std::wstring& line) {
+	Key key(&font, line);
+
+	{
+		std::lock_guard<std::mutex> lock(s_Mutex);
+
+		auto it = s_Masks.find(key);
+		if (it != s_Masks.end())
+			return it->second;
+	}
+
+	// Rasterize without holding the lock, when two threads rasterize the same text at once the first mask is kept.
+	auto mask = Rasterize(font, line);
+	if (!mask)
+		return nullptr;
+
+	std::lock_guard<std::mutex> lock(s_Mutex);
+
+	if (s_Size + mask->Coverage.size() > MaximumSize) {
+		s_Masks.clear();
+		s_Size = 0;
+	}
+
+	auto inserted = s_Masks.emplace(std::move(key), mask);
+	if (inserted.second)
+		s_Size += mask->Coverage.size();
+
+	return inserted.first->second;
+}
+
+/// <summary>
+/// Remove all masks of a certain font from the cache.
+/// </summary>
+/// <param name="font">The font.</param>
+void GlyphCache::Release(const Font& font) {
+	std::lock_guard<std::mutex> lock(s_Mutex);
+
+	auto it = s_Masks.lower_bound(Key(&font, std::wstring()));
+	while (it != s_Masks.end() && it->first.first == &font) {
+		s_Size -= it->second->Coverage.size();
+		it = s_Masks.erase(it);
+	}
+}
+
+/// <summary>
+/// Remove all masks from the cache.
+/// </summary>
+void GlyphCache::Clear() {
+	std::lock_guard<std::mutex> lock(s_Mutex);
+	s_Masks.clear();
+	s_Size = 0;
+}
+
+/// <summary>
+/// Rasterize a line of text with GDI.
+/// </summary>
+/// <param name="font">The font.</param>
+/// <param name="line">The line of text.</param>
+/// <returns>The mask, or nullptr when the text cannot be rasterized.</returns>
+std::shared_ptr<const GlyphCache::TextMask> GlyphCache::Rasterize(const Font& font, const std::wstring& line) {
+	auto hFont = font.GetHandle();
+	if (!hFont)
+		return nullptr;
+
+	auto hDC = CreateCompatibleDC(nullptr);
+	if (!hDC)
+		return nullptr;
+
+	auto oldFont = SelectObject(hDC, hFont);
+	auto mask    = std::make_shared<TextMask>();
+
+	TEXTMETRICW metrics;
+	SIZE extent;
+
+	// A blank line advances by the height of sample text, the same as libtiffconvert does when it renders text.
+	auto blank   = line.find_first_not_of(L" \t") == std::wstring::npos;
+	auto measure = blank ? std::wstring(L"abcdefABCDEF") : line;
+
+	if (!GetTextMetricsW(hDC, &metrics) || !GetTextExtentPoint32W(hDC, measure.c_str(), static_cast<int>(measure.size()), &extent)) {
+		SelectObject(hDC, oldFont);
+		DeleteDC(hDC);
+		return nullptr;
+	}
+
+	mask->LineHeight = static_cast<uint32_t>(extent.cy);
+	if (blank) {
+		mask->OriginX = 0;
+		mask->Width   = 0;
+		mask->Height  = 0;
+		SelectObject(hDC, oldFont);
+		DeleteDC(hDC);
+		return mask;
+	}
+
+	// Italic glyphs overhang their advance width on both sides, pad the mask so that they are not clipped.
+	auto padding = metrics.tmHeight / 4 + metrics.tmOverhang;
+
+	mask->OriginX = -padding;
+	mask->Width   = static_cast<uint32_t>(extent.cx + 2 * padding);
+	mask->Height  = static_cast<uint32_t>((std::max)(extent.cy, metrics.tmHeight));
+
+	BITMAPINFO info;
+	memset(&info, 0, sizeof(info));
+	info.bmiHeader.biSize        = sizeof(BITMAPINFOHEADER);
+	info.bmiHeader.biWidth       = static_cast<LONG>(mask->Width);
+	info.bmiHeader.biHeight      = -static_cast<LONG>(mask->Height);	// Top-down.
+	info.bmiHeader.biPlanes      = 1;
+	info.bmiHeader.biBitCount    = 32;
+	info.bmiHeader.biCompression = BI_RGB;
+
+	void* bits = nullptr;
+	auto hBitmap = CreateDIBSection(hDC, &info, DIB_RGB_COLORS, &bits, nullptr, 0);
+	if (!hBitmap || !bits) {
+		SelectObject(hDC, oldFont);
+		DeleteDC(hDC);
+		return nullptr;
+	}
+
+	// The DIB section is zero initialized, white text on black leaves the coverage in every color component.
+	auto oldBitmap = SelectObject(hDC, hBitmap);
+	SetBkMode(hDC, TRANSPARENT);
+	SetTextColor(hDC, RGB(255, 255, 255));
+	TextOutW(hDC, padding, 0, line.c_str(), static_cast<int>(line.size()));
+	GdiFlush();
+
+	// Subpixel rendered text has a different coverage per component, the average is used.
+	auto pixels = static_cast<const uint8_t*>(bits);
+	auto count  = static_cast<size_t>(mask->Width) * mask->Height;
+
+	mask->Coverage.resize(count);
+	for (size_t i = 0; i < count; ++i, pixels += 4)
+		mask->Coverage[i] = static_cast<uint8_t>((pixels[0] + pixels[1] + pixels[2] + 1) / 3);
+
+	SelectObject(hDC, oldBitmap);
+	SelectObject(hDC, oldFont);
+	DeleteObject(hBitmap);
+	DeleteDC(hDC);
+	return mask;
+}
\ No newline at end of file
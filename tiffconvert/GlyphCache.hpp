@@ -0,0 +1,74 @@
+#pragma once
+
+#ifndef libtiffconvert_glyph_cache_h
+#define libtiffconvert_glyph_cache_h
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <mutex>
+
+namespace TiffConvert {
+	class Font;
+
+	/// <summary>
+	/// GlyphCache provides a class of static methods that rasterize a line of text into an 8-bit coverage mask once, so that
+	/// text marks that repeat the same string in the same font, such as stamps, are painted from the cached mask. The masks
+	/// are rasterized with GDI and the cache can be used by multiple threads at the same time.
+	/// </summary>
+	class GlyphCache {
+		public:
+			/// <summary>
+			/// The coverage of a single line of text, one byte per pixel from 0 (not covered) to 255 (fully covered).
+			/// </summary>
+			struct TextMask {
+				int32_t					OriginX;	// The column of the mask relative to the position of the text, the mask is padded for overhanging glyphs.
+				uint32_t				Width;
+				uint32_t				Height;
+				uint32_t				LineHeight;	// The distance to the top of the next line.
+				std::vector<uint8_t>	Coverage;	// Width * Height bytes, top row first.
+			};
+
+		private:
+			using Key = std::pair<const Font*, std::wstring>;
+
+			static constexpr size_t	MaximumSize = 64 * 1024 * 1024;	// The size of all masks, in bytes, after which the cache is emptied.
+
+			static std::mutex										s_Mutex;
+			static std::map<Key, std::shared_ptr<const TextMask>>	s_Masks;
+			static size_t											s_Size;
+
+		public:
+			/// <summary>
+			/// Get the coverage mask of a line of text, it is rasterized when it is not in the cache yet.
+			/// </summary>
+			/// <param name="font">The font, which must stay alive while it is in use. Its masks are released when it is destroyed.</param>
+			/// <param name="line">The line of text, without line breaks.</param>
+			/// <returns>The mask, or nullptr when the text cannot be rasterized.</returns>
+			static std::shared_ptr<const TextMask> Get(const Font& font, const std::wstring& line);
+
+			/// <summary>
+			/// Remove all masks of a certain font from the cache.
+			/// </summary>
+			/// <param name="font">The font.</param>
+			static void Release(const Font& font);
+
+			/// <summary>
+			/// Remove all masks from the cache.
+			/// </summary>
+			static void Clear();
+
+		private:
+			/// <summary>
+			/// Rasterize a line of text with GDI.
+			/// </summary>
+			/// <param name="font">The font.</param>
+			/// <param name="line">The line of text.</param>
+			/// <returns>The mask, or nullptr when the text cannot be rasterized.</returns>
+			static std::shared_ptr<const TextMask> Rasterize(const Font& font, const std::wstring& line);
+	};
+}
+
+#endif
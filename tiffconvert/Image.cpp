@@ -17,7 +17,7 @@ Image::Image(const image_handle* img)
 /// Construct an image from a vector of bytes, effectively decoding the image.
 /// </summary>
 /// <param name="data">The raw image data.</param>
-Image::Image(const std::vector<uint8_t> data, bool isDib) {
+Image::Image(const std::vector<uint8_t>& data, bool isDib) {
 	if (!isDib) {
 		auto image = image_open_p(&data[0], static_cast<uint32_t>(data.size()));
 		if (!image)
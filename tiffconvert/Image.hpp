@@ -25,7 +25,7 @@ namespace TiffConvert {
 			/// Construct an image from a vector of bytes, effectively decoding the image.
 			/// </summary>
 			/// <param name="data">The raw image data.</param>
-			Image(const std::vector<uint8_t> data, bool isDib = false);
+			Image(const std::vector<uint8_t>& data, bool isDib = false);
 
 			/// <summary>
 			/// Image destructor, will free the data allocated by the API.
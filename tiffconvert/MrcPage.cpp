@@ -0,0 +1,177 @@
+#include "MrcPage.hpp"
+#include <algorithm>
+#include <cstring>
+
+using namespace TiffConvert;
+using namespace TiffWang::Tiff;
+
+/// <summary>
+/// The number of pixels a region extends beyond the marks it holds, for the anti-aliasing and rounding of the marks.
+/// </summary>
+static constexpr LONG RegionMargin = 2;
+
+/// <summary>
+/// Determine if two rectangles with exclusive right and bottom edges overlap.
+/// </summary>
+/// <param name="a">The first rectangle.</param>
+/// <param name="b">The second rectangle.</param>
+/// <returns>True when the rectangles overlap.</returns>
+static bool Intersects(const RECT& a, const RECT& b) noexcept {
+	return a.left < b.right && b.left < a.right && a.top < b.bottom && b.top < a.bottom;
+}
+
+/// <summary>
+/// Determine if a pixel of a bit-packed row is set.
+/// </summary>
+/// <param name="row">The row.</param>
+/// <param name="x">The pixel.</param>
+/// <returns>True when the pixel is set, which is black.</returns>
+static bool IsSet(const uint8_t* row, uint32_t x) noexcept {
+	return (row[x >> 3] & (0x80 >> (x & 7))) != 0;
+}
+
+/// <summary>
+/// Construct a new MRC page, the regions are the areas the marks draw onto, merged where they overlap.
+/// </summary>
+/// <param name="file">The Tiff file, which must stay alive as long as this page.</param>
+/// <param name="pageIndex">The IFD (page) index.</param>
+/// <param name="marks">The annotations of the page.</param>
+/// <exception cref="std::runtime_error">When the page is not supported, see <see cref="BandedPage::IsSupported"/>.</exception>
+MrcPage::MrcPage(const TiffFile& file, size_t pageIndex, const WangDisplayList& marks)
+	: m_Page(file, pageIndex) {
+
+	RECT page = { 0, 0, static_cast<LONG>(m_Page.GetWidth()), static_cast<LONG>(m_Page.GetHeight()) };
+
+	for (auto bounds : marks.GetBounds()) {
+		MrcRegion region;
+		region.Bounds.left   = (std::max)(page.left, bounds.left - RegionMargin);
+		region.Bounds.top    = (std::max)(page.top, bounds.top - RegionMargin);
+		region.Bounds.right  = (std::min)(page.right, bounds.right + RegionMargin + 1);
+		region.Bounds.bottom = (std::min)(page.bottom, bounds.bottom + RegionMargin + 1);
+
+		if (region.Bounds.left < region.Bounds.right && region.Bounds.top < region.Bounds.bottom)
+			m_Regions.push_back(region);
+	}
+
+	// Merge overlapping regions until none overlap, so that no pixel is stored twice.
+	for (auto merged = true; merged; ) {
+		merged = false;
+
+		for (size_t i = 0; i < m_Regions.size() && !merged; ++i) {
+			for (size_t j = i + 1; j < m_Regions.size(); ++j) {
+				auto& a = m_Regions[i].Bounds;
+				auto& b = m_Regions[j].Bounds;
+
+				if (!Intersects(a, b))
+					continue;
+
+				a.left   = (std::min)(a.left, b.left);
+				a.top    = (std::min)(a.top, b.top);
+				a.right  = (std::max)(a.right, b.right);
+				a.bottom = (std::max)(a.bottom, b.bottom);
+
+				m_Regions.erase(m_Regions.begin() + static_cast<ptrdiff_t>(j));
+				merged = true;
+				break;
+			}
+		}
+	}
+}
+
+/// <summary>
+/// Decode the page and burn the annotations onto the bands that intersect a region.
+/// </summary>
+/// <param name="burn">The function that burns the annotations onto a band.</param>
+/// <returns>The regions in which the annotations changed at least one pixel.</returns>
+/// <exception cref="std::runtime_error">When the data is corrupt or holds less rows than the page.</exception>
+std::vector<MrcRegion> MrcPage::Render(const BurnCallback& burn) {
+	std::vector<MrcRegion> regions = m_Regions;
+	std::vector<uint8_t>   pixels;
+
+	for (auto& region : regions) {
+		auto width  = static_cast<size_t>(region.Bounds.right - region.Bounds.left);
+		auto height = static_cast<size_t>(region.Bounds.bottom - region.Bounds.top);
+
+		region.Pixels.assign(width * height * 3, 255);
+		region.Mask.assign(((width + 7) / 8) * height, 0);
+	}
+
+	if (regions.empty())
+		return regions;
+
+	RasterTarget burned;
+	burned.Width        = m_Page.GetWidth();
+	burned.BitsPerPixel = 24;
+	burned.Pitch        = static_cast<ptrdiff_t>(((static_cast<size_t>(burned.Width) * 24 + 31) / 32) * 4);
+
+	m_Page.Render(1, [&](const RasterTarget& band, uint32_t top) {
+		RECT rows = { 0, static_cast<LONG>(top), static_cast<LONG>(band.Width), static_cast<LONG>(top + band.Height) };
+
+		auto intersected = std::any_of(regions.begin(), regions.end(), [&](const MrcRegion& region) { return Intersects(region.Bounds, rows); });
+		if (!intersected)
+			return;
+
+		// Only the bands the marks draw onto are expanded to color.
+		pixels.resize(static_cast<size_t>(burned.Pitch) * band.Height);
+		burned.Bits   = pixels.data();
+		burned.Height = band.Height;
+
+		for (uint32_t y = 0; y < band.Height; ++y) {
+			auto input  = band.Bits + static_cast<ptrdiff_t>(y) * band.Pitch;
+			auto output = burned.Bits + static_cast<ptrdiff_t>(y) * burned.Pitch;
+
+			for (uint32_t x = 0; x < band.Width; ++x, output += 3)
+				memset(output, IsSet(input, x) ? 0 : 255, 3);
+		}
+
+		burn(burned, top);
+
+		for (auto& region : regions) {
+			if (Intersects(region.Bounds, rows))
+				CopyRegion(region, band, burned, top);
+		}
+	});
+
+	// Regions in which the marks changed nothing, such as white on white, do not need to be stored.
+	regions.erase(std::remove_if(regions.begin(), regions.end(), [](const MrcRegion& region) {
+		return std::all_of(region.Mask.begin(), region.Mask.end(), [](uint8_t value) { return value == 0; });
+	}), regions.end());
+
+	return regions;
+}
+
+/// <summary>
+/// Copy the rows of a band that a region covers into the region, keeping the pixels that differ from the page.
+/// </summary>
+/// <param name="region">The region.</param>
+/// <param name="page">The band as it was decoded, bit-packed.</param>
+/// <param name="burned">The band with the annotations burned onto it, 24-bit BGR.</param>
+/// <param name="top">The first row of the page the band covers.</param>
+void MrcPage::CopyRegion(MrcRegion& region, const RasterTarget& page, const RasterTarget& burned, uint32_t top) {
+	auto left   = static_cast<uint32_t>(region.Bounds.left);
+	auto width  = static_cast<uint32_t>(region.Bounds.right - region.Bounds.left);
+	auto stride = static_cast<size_t>((width + 7) / 8);
+	auto first  = (std::max)(static_cast<uint32_t>(region.Bounds.top), top);
+	auto last   = (std::min)(static_cast<uint32_t>(region.Bounds.bottom), top + burned.Height);
+
+	for (auto y = first; y < last; ++y) {
+		auto input  = page.Bits + static_cast<ptrdiff_t>(y - top) * page.Pitch;
+		auto color  = burned.Bits + static_cast<ptrdiff_t>(y - top) * burned.Pitch + static_cast<ptrdiff_t>(left) * 3;
+		auto row    = static_cast<size_t>(y - region.Bounds.top);
+		auto output = region.Pixels.data() + row * width * 3;
+		auto mask   = region.Mask.data() + row * stride;
+
+		for (uint32_t x = 0; x < width; ++x, color += 3, output += 3) {
+			auto value = IsSet(input, left + x) ? 0 : 255;
+
+			// Pixels the marks did not change are left white in the region, the page shows through the mask there.
+			if (color[0] == value && color[1] == value && color[2] == value)
+				continue;
+
+			output[0] = color[2];
+			output[1] = color[1];
+			output[2] = color[0];
+			mask[x >> 3] |= static_cast<uint8_t>(0x80 >> (x & 7));
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,76 @@
+#pragma once
+
+#ifndef libtiffconvert_mrc_page_h
+#define libtiffconvert_mrc_page_h
+
+#include "BandedPage.hpp"
+#include <TiffFile.hpp>
+#include <WangDisplayList.hpp>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace TiffConvert {
+	/// <summary>
+	/// A region of a bilevel page that annotations have been burned onto, as a color layer over the page.
+	/// </summary>
+	struct MrcRegion {
+		RECT					Bounds;		// The region of the page, the right and bottom edges are exclusive.
+		std::vector<uint8_t>	Pixels;		// The burned pixels, top to bottom as RGB without row padding.
+		std::vector<uint8_t>	Mask;		// The pixels that differ from the page, bit-packed msb first with byte aligned rows, a set bit differs.
+	};
+
+	/// <summary>
+	/// MrcPage burns the eiStream/Wang annotations of a bilevel CCITT page into color regions only, for a mixed raster
+	/// content (MRC) page: the bilevel page stays as it is and only the regions that the marks cover are stored in color,
+	/// with a mask of the pixels that the marks have changed. The page is decoded in bands by a <see cref="BandedPage"/>
+	/// and only the bands that intersect a region are expanded to color and burned onto.
+	/// </summary>
+	class MrcPage {
+		public:
+			/// <summary>
+			/// The function that burns the annotations onto a band of the page, see <see cref="BandedPage::BandCallback"/>.
+			/// The band is 24-bit BGR.
+			/// </summary>
+			using BurnCallback = BandedPage::BandCallback;
+
+		private:
+			BandedPage				m_Page;
+			std::vector<MrcRegion>	m_Regions;
+
+		public:
+			/// <summary>
+			/// Construct a new MRC page, the regions are the areas the marks draw onto, merged where they overlap.
+			/// </summary>
+			/// <param name="file">The Tiff file, which must stay alive as long as this page.</param>
+			/// <param name="pageIndex">The IFD (page) index.</param>
+			/// <param name="marks">The annotations of the page.</param>
+			/// <exception cref="std::runtime_error">When the page is not supported, see <see cref="BandedPage::IsSupported"/>.</exception>
+			MrcPage(const TiffWang::Tiff::TiffFile& file, size_t pageIndex, const TiffWang::Tiff::WangDisplayList& marks);
+
+			MrcPage(const MrcPage&) = delete;
+			MrcPage(MrcPage&&) = delete;
+			MrcPage& operator=(const MrcPage&) = delete;
+			MrcPage& operator=(MrcPage&&) = delete;
+
+			/// <summary>
+			/// Decode the page and burn the annotations onto the bands that intersect a region.
+			/// </summary>
+			/// <param name="burn">The function that burns the annotations onto a band.</param>
+			/// <returns>The regions in which the annotations changed at least one pixel.</returns>
+			/// <exception cref="std::runtime_error">When the data is corrupt or holds less rows than the page.</exception>
+			std::vector<MrcRegion> Render(const BurnCallback& burn);
+
+		private:
+			/// <summary>
+			/// Copy the rows of a band that a region covers into the region, keeping the pixels that differ from the page.
+			/// </summary>
+			/// <param name="region">The region.</param>
+			/// <param name="page">The band as it was decoded, bit-packed.</param>
+			/// <param name="burned">The band with the annotations burned onto it, 24-bit BGR.</param>
+			/// <param name="top">The first row of the page the band covers.</param>
+			static void CopyRegion(MrcRegion& region, const RasterTarget& page, const RasterTarget& burned, uint32_t top);
+	};
+}
+
+#endif
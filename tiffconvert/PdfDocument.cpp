@@ -0,0 +1,524 @@
+#include "PdfDocument.hpp"
+#include "PdfWangHandler.hpp"
+#include "Deflater.hpp"
+#include <CcittDecoder.hpp>
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+using namespace TiffConvert;
+using namespace TiffWang::Tiff;
+
+/// <summary>
+/// The width of an A4 page in points, 210 mm.
+/// </summary>
+static constexpr double A4Width = 595.2756;
+
+/// <summary>
+/// The height of an A4 page in points, 297 mm.
+/// </summary>
+static constexpr double A4Height = 841.8898;
+
+/// <summary>
+/// The size of an A4 page in the orientation of a Tiff page, and the scale at which the Tiff page is fitted onto it.
+/// </summary>
+struct PageLayout {
+	double	Width;		// The width of the page in points.
+	double	Height;		// The height of the page in points.
+	double	Scale;		// The number of points per pixel.
+};
+
+/// <summary>
+/// Lay out a Tiff page on A4 paper, which is landscape when the Tiff page is wider than it is tall. The Tiff page is
+/// fitted onto the paper.
+/// </summary>
+/// <param name="width">The width of the Tiff page in pixels.</param>
+/// <param name="height">The height of the Tiff page in pixels.</param>
+/// <returns>The layout.</returns>
+static PageLayout LayoutPage(uint32_t width, uint32_t height) {
+	auto landscape = width > height;
+
+	PageLayout layout;
+	layout.Width  = landscape ? A4Height : A4Width;
+	layout.Height = landscape ? A4Width : A4Height;
+	layout.Scale  = (layout.Width * height < layout.Height * width) ? layout.Width / width : layout.Height / height;
+	return layout;
+}
+
+/// <summary>
+/// Draw an image that covers a range of rows of a Tiff page, the Tiff page is placed at the top left of the paper.
+/// </summary>
+/// <param name="layout">The layout of the Tiff page.</param>
+/// <param name="name">The resource name of the image.</param>
+/// <param name="width">The width of the image in pixels.</param>
+/// <param name="top">The first row of the Tiff page the image covers.</param>
+/// <param name="rows">The number of rows of the image.</param>
+/// <returns>The content stream operators that draw the image.</returns>
+static std::string DrawImage(const PageLayout& layout, const std::string& name, uint32_t width, uint32_t top, uint32_t rows) {
+	auto bottom = layout.Height - static_cast<double>(top + rows) * layout.Scale;
+
+	return "q " + PdfWriter::FormatNumber(width * layout.Scale) + " 0 0 " + PdfWriter::FormatNumber(rows * layout.Scale)
+		+ " 0 " + PdfWriter::FormatNumber(bottom) + " cm /" + name + " Do Q\n";
+}
+
+/// <summary>
+/// Read a big-endian 32-bit integer.
+/// </summary>
+/// <param name="data">The data.</param>
+/// <param name="offset">The offset of the integer in the data.</param>
+/// <returns>The integer.</returns>
+static uint32_t ReadBigEndian32(ByteView data, size_t offset) {
+	auto bytes = data.SubView(offset, 4);
+	return (static_cast<uint32_t>(bytes[0]) << 24) | (static_cast<uint32_t>(bytes[1]) << 16) | (static_cast<uint32_t>(bytes[2]) << 8) | bytes[3];
+}
+
+/// <summary>
+/// Read a big-endian 16-bit integer.
+/// </summary>
+/// <param name="data">The data.</param>
+/// <param name="offset">The offset of the integer in the data.</param>
+/// <returns>The integer.</returns>
+static uint32_t ReadBigEndian16(ByteView data, size_t offset) {
+	auto bytes = data.SubView(offset, 2);
+	return (static_cast<uint32_t>(bytes[0]) << 8) | bytes[1];
+}
+
+/// <summary>
+/// Describe a PNG image as an image XObject. The IDAT chunks hold a zlib stream with the same per-row predictors as
+/// FlateDecode with a PNG predictor, so they are embedded as they are.
+/// </summary>
+/// <param name="data">The PNG image.</param>
+/// <returns>The image.</returns>
+/// <exception cref="std::runtime_error">When the image is corrupt, interlaced or has an alpha channel.</exception>
+static PdfImage DescribePng(ByteView data) {
+	static const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+
+	if (data.Size() < sizeof(signature) || !std::equal(signature, signature + sizeof(signature), data.begin()))
+		throw std::runtime_error("the encoded page is not a png image");
+
+	PdfImage image;
+	uint32_t colorType = 0;
+	uint32_t colors    = 0;
+	bool     header    = false;
+
+	for (size_t offset = sizeof(signature); offset < data.Size(); ) {
+		auto length = ReadBigEndian32(data, offset);
+		auto type   = data.SubView(offset + 4, 4);
+		auto chunk  = data.SubView(offset + 8, length);
+		auto name   = std::string(type.begin(), type.end());
+
+		if (name == "IHDR") {
+			image.Width            = ReadBigEndian32(chunk, 0);
+			image.Height           = ReadBigEndian32(chunk, 4);
+			image.BitsPerComponent = chunk.At(8);
+			colorType              = chunk.At(9);
+			header                 = true;
+
+			if (chunk.At(12) != 0)
+				throw std::runtime_error("interlaced png images are not supported in pdf");
+
+			switch (colorType) {
+				case 0: colors = 1; image.ColorSpace = "/DeviceGray"; break;
+				case 2: colors = 3; image.ColorSpace = "/DeviceRGB";  break;
+				case 3: colors = 1; break;
+				default:
+					throw std::runtime_error("png images with an alpha channel are not supported in pdf");
+			}
+
+			if (image.BitsPerComponent > 8)
+				throw std::runtime_error("png images with 16 bits per component are not supported in pdf");
+		} else if (name == "PLTE" && chunk.Size() >= 3) {
+			static const char digits[] = "0123456789ABCDEF";
+
+			std::string palette;
+			for (auto value : chunk) {
+				palette += digits[value >> 4];
+				palette += digits[value & 15];
+			}
+
+			image.ColorSpace = "[/Indexed /DeviceRGB " + std::to_string(chunk.Size() / 3 - 1) + " <" + palette + ">]";
+		} else if (name == "IDAT") {
+			image.Data.push_back(chunk);
+		} else if (name == "IEND") {
+			break;
+		}
+
+		offset += static_cast<size_t>(length) + 12;
+	}
+
+	if (!header || image.Data.empty() || image.ColorSpace.empty())
+		throw std::runtime_error("the encoded png image is incomplete");
+
+	image.Filter      = "/FlateDecode";
+	image.DecodeParms = "<< /Predictor 15 /Colors " + std::to_string(colors) + " /BitsPerComponent " + std::to_string(image.BitsPerComponent) + " /Columns " + std::to_string(image.Width) + " >>";
+	return image;
+}
+
+/// <summary>
+/// Describe a JPEG image as an image XObject, the image is embedded as it is.
+/// </summary>
+/// <param name="data">The JPEG image.</param>
+/// <returns>The image.</returns>
+/// <exception cref="std::runtime_error">When the image is corrupt.</exception>
+static PdfImage DescribeJpeg(ByteView data) {
+	if (ReadBigEndian16(data, 0) != 0xFFD8)
+		throw std::runtime_error("the encoded page is not a jpeg image");
+
+	for (size_t offset = 2; offset + 4 <= data.Size(); ) {
+		if (data[offset] != 0xFF) {
+			++offset;
+			continue;
+		}
+
+		auto marker = data[offset + 1];
+
+		// Markers without a length: fill bytes, TEM and RSTn.
+		if (marker == 0xFF || marker == 0x01 || (marker >= 0xD0 && marker <= 0xD7)) {
+			++offset;
+			continue;
+		}
+
+		// Any start of frame marker, except for DHT, JPG and DAC which share the range.
+		if (marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC) {
+			auto frame = data.SubView(offset + 4);
+
+			PdfImage image;
+			image.BitsPerComponent = frame.At(0);
+			image.Height           = ReadBigEndian16(frame, 1);
+			image.Width            = ReadBigEndian16(frame, 3);
+			image.Filter           = "/DCTDecode";
+
+			switch (frame.At(5)) {
+				case 1: image.ColorSpace = "/DeviceGray"; break;
+				case 3: image.ColorSpace = "/DeviceRGB";  break;
+				case 4: image.ColorSpace = "/DeviceCMYK"; break;
+				default:
+					throw std::runtime_error("the encoded jpeg image has an unsupported number of components");
+			}
+
+			image.Data.push_back(data);
+			return image;
+		}
+
+		offset += static_cast<size_t>(ReadBigEndian16(data, offset + 2)) + 2;
+	}
+
+	throw std::runtime_error("the encoded jpeg image has no frame");
+}
+
+/// <summary>
+/// Create a new, empty PDF document.
+/// </summary>
+/// <param name="filepath">The filename to save the PDF as, an existing file is overwritten.</param>
+/// <param name="codec">The codec to use to encode each page.</param>
+/// <param name="options">Options for the codec.</param>
+/// <param name="threads">The number of threads to encode a PNG page with, see <see cref="PngEncoder"/>.</param>
+/// <exception cref="std::runtime_error">When the file cannot be created, or the codec is not supported in PDF.</exception>
+PdfDocument::PdfDocument(const std::string& filepath, tiff_export_format codec, uint32_t options, uint32_t threads)
+	: m_Writer(filepath), m_Codec(codec), m_Options(options), m_Threads(threads) {
+
+	if (codec != tiff_export_format::TIFF_EXPORT_PNG && codec != tiff_export_format::TIFF_EXPORT_JPEG && codec != tiff_export_format::TIFF_EXPORT_JPEG2000)
+		throw std::runtime_error("cannot create pdf document, the codec is not supported in pdf");
+}
+
+/// <summary>
+/// Encode a Tiff page and add it to the document as a new page.
+/// </summary>
+/// <param name="image">The Tiff image the page belongs to.</param>
+/// <param name="page">The page number.</param>
+/// <returns>True when successful, false otherwise.</returns>
+bool PdfDocument::AddPage(const TiffImage& image, uint32_t page) {
+	try {
+		return AddEncodedPage(EncodePage(image, page));
+	} catch (const std::exception&) {
+		return false;
+	}
+}
+
+/// <summary>
+/// Encode a Tiff page in the format of this document, without adding it. This does not modify the document and
+/// can be called from multiple threads at once. PNG pages are encoded natively in the smallest format that holds
+/// their pixels, see <see cref="TiffImage::EncodePng"/>, other codecs are encoded by libtiffconvert.
+/// </summary>
+/// <param name="image">The Tiff image the page belongs to.</param>
+/// <param name="page">The page number.</param>
+/// <returns>The encoded page.</returns>
+/// <exception cref="std::runtime_error">When the page cannot be encoded.</exception>
+PdfEncodedPage PdfDocument::EncodePage(const TiffImage& image, uint32_t page) const {
+	PdfEncodedPage result;
+	result.Width  = image.GetPageWidth(page);
+	result.Height = image.GetPageHeight(page);
+
+	// PDF images have no alpha channel, pages whose pixels cannot be encoded natively are encoded by libtiffconvert.
+	if (m_Codec == tiff_export_format::TIFF_EXPORT_PNG) {
+		try {
+			auto png = std::make_shared<std::vector<uint8_t>>(image.EncodePng(page, m_Threads, false));
+
+			result.Data = std::shared_ptr<const void>(png, png->data());
+			result.Size = static_cast<uint32_t>(png->size());
+			return result;
+		} catch (const std::runtime_error& ex) {
+			std::cout << "[WARN] " << ex.what() << " natively, the page is encoded by libtiffconvert instead.\n";
+		}
+	}
+
+	uint32_t size   = 0;
+	void*    buffer = tiff_image_export_page_p24(image.get(), page, &size, m_Codec, m_Options);
+
+	if (!buffer)
+		throw std::runtime_error("cannot encode page " + std::to_string(page));
+
+	auto encoded = std::make_shared<DestructibleBuffer>(buffer, size);
+	result.Data = std::shared_ptr<const void>(encoded, encoded->get());
+	result.Size = size;
+	return result;
+}
+
+/// <summary>
+/// Add a page that was encoded by <see cref="EncodePage"/> to the document as a new page.
+/// </summary>
+/// <param name="page">The encoded page.</param>
+/// <param name="marks">The annotations to draw over the page, if any.</param>
+/// <returns>True when successful, false otherwise.</returns>
+bool PdfDocument::AddEncodedPage(const PdfEncodedPage& page, const PdfMarks& marks) {
+	if (!page.Data || page.Width == 0 || page.Height == 0)
+		return false;
+
+	try {
+		auto layout  = LayoutPage(page.Width, page.Height);
+		auto content = DrawImage(layout, "Im0", page.Width, 0, page.Height);
+
+		PdfResources resources;
+		resources.XObjects.emplace_back("Im0", m_Writer.AddImage(DescribePage(page)));
+
+		DrawMarks(marks, page.Width * layout.Scale, page.Height * layout.Scale, layout.Height, content, resources);
+		m_Writer.AddPage(layout.Width, layout.Height, content, resources);
+		return true;
+	} catch (const std::exception&) {
+		return false;
+	}
+}
+
+/// <summary>
+/// Determine if a page can be copied into a document as it is, see <see cref="CopyPage"/>.
+/// </summary>
+/// <param name="file">The Tiff file.</param>
+/// <param name="pageIndex">The IFD (page) index.</param>
+/// <returns>True when the page is a bilevel CCITT Group 4 compressed image in the default fill order.</returns>
+bool PdfDocument::CanCopyPage(const TiffFile& file, size_t pageIndex) noexcept {
+	try {
+		const auto& dimensions = file.GetDimensions(pageIndex);
+		const auto& layout     = file.GetImageLayout(pageIndex);
+
+		if (dimensions.Width == 0 || dimensions.Height == 0 || !CcittDecoder::IsSupported(layout))
+			return false;
+
+		// Every row of the page must be covered by a strip.
+		auto rowsPerStrip = (layout.RowsPerStrip == 0) ? dimensions.Height : (std::min)(layout.RowsPerStrip, dimensions.Height);
+		auto strips       = (static_cast<size_t>(dimensions.Height) + rowsPerStrip - 1) / rowsPerStrip;
+
+		// CCITTFaxDecode only reads the bits of a byte from the most significant bit onward.
+		return layout.Compression == TiffCompression::CcittT6
+			&& layout.FillOrder == TiffFillOrder::MsbToLsb
+			&& (layout.Photometric == TiffPhotometric::WhiteIsZero || layout.Photometric == TiffPhotometric::BlackIsZero)
+			&& layout.StripOffsets.size() == layout.StripByteCounts.size()
+			&& layout.StripOffsets.size() >= strips;
+	} catch (const std::exception&) {
+		return false;
+	}
+}
+
+/// <summary>
+/// Add a CCITT Group 4 compressed page to the document as a new page, without decoding it. The compressed data of 
+/// every strip is copied from the Tiff file into an image XObject that is decoded by the CCITTFaxDecode filter.
+/// </summary>
+/// <param name="file">The Tiff file.</param>
+/// <param name="pageIndex">The IFD (page) index.</param>
+/// <param name="inverted">Whether the colors of the page are inverted.</param>
+/// <param name="marks">The annotations to draw over the page, if any.</param>
+/// <param name="regions">Annotations that have been burned into color regions to draw over the page, see <see cref="EncodeRegions"/>.</param>
+/// <returns>True when successful, false otherwise.</returns>
+bool PdfDocument::CopyPage(const TiffFile& file, size_t pageIndex, bool inverted, const PdfMarks& marks, const std::vector<PdfEncodedRegion>& regions) {
+	if (!CanCopyPage(file, pageIndex))
+		return false;
+
+	try {
+		const auto& dimensions = file.GetDimensions(pageIndex);
+		const auto& tiff       = file.GetImageLayout(pageIndex);
+
+		auto layout       = LayoutPage(dimensions.Width, dimensions.Height);
+		auto rowsPerStrip = (tiff.RowsPerStrip == 0) ? dimensions.Height : (std::min)(tiff.RowsPerStrip, dimensions.Height);
+
+		// The black runs of the data are decoded to 0, which is black, unless black is zero in the Tiff.
+		auto blackIs1 = (tiff.Photometric == TiffPhotometric::BlackIsZero) != inverted;
+
+		std::string				content;
+		PdfResources			resources;
+		std::vector<uint8_t>	buffer;
+
+		// Every strip is encoded on its own, starting from an all white reference row, so every strip becomes an image.
+		for (uint32_t strip = 0, top = 0; top < dimensions.Height; ++strip, top += rowsPerStrip) {
+			auto rows = (std::min)(rowsPerStrip, dimensions.Height - top);
+			auto name = "Im" + std::to_string(strip);
+
+			PdfImage image;
+			image.Width            = dimensions.Width;
+			image.Height           = rows;
+			image.BitsPerComponent = 1;
+			image.ColorSpace       = "/DeviceGray";
+			image.Filter           = "/CCITTFaxDecode";
+			image.DecodeParms      = "<< /K -1 /Columns " + std::to_string(dimensions.Width) + " /Rows " + std::to_string(rows) + (blackIs1 ? " /BlackIs1 true" : "") + " >>";
+			image.Data.push_back(file.GetStripData(pageIndex, strip, buffer));
+
+			resources.XObjects.emplace_back(name, m_Writer.AddImage(image));
+			content += DrawImage(layout, name, dimensions.Width, top, rows);
+		}
+
+		DrawRegions(regions, layout.Scale, layout.Height, content, resources);
+		DrawMarks(marks, dimensions.Width * layout.Scale, dimensions.Height * layout.Scale, layout.Height, content, resources);
+		m_Writer.AddPage(layout.Width, layout.Height, content, resources);
+		return true;
+	} catch (const std::exception&) {
+		return false;
+	}
+}
+
+/// <summary>
+/// Compress the color regions that annotations have been burned into, see <see cref="MrcPage"/>, to draw them over
+/// a page that is copied by <see cref="CopyPage"/>. This does not modify the document and can be called from 
+/// multiple threads at once.
+/// </summary>
+/// <param name="regions">The burned regions of the page.</param>
+/// <param name="inverted">Whether the colors of the page are inverted.</param>
+/// <returns>The compressed regions.</returns>
+std::vector<PdfEncodedRegion> PdfDocument::EncodeRegions(const std::vector<MrcRegion>& regions, bool inverted) const {
+	std::vector<PdfEncodedRegion>	encoded(regions.size());
+	std::vector<uint8_t>			pixels;
+
+	for (size_t i = 0; i < regions.size(); ++i) {
+		const auto& region = regions[i];
+
+		pixels = region.Pixels;
+		if (inverted) {
+			for (auto& pixel : pixels)
+				pixel = static_cast<uint8_t>(~pixel);
+		}
+
+		// The mask and the colors are mostly flat, which the native deflater compresses well at hardly any cost.
+		encoded[i].Bounds = region.Bounds;
+		encoded[i].Pixels = Deflater::Compress(pixels, m_Threads);
+		encoded[i].Mask   = Deflater::Compress(region.Mask, m_Threads);
+	}
+
+	return encoded;
+}
+
+/// <summary>
+/// Finish the document, a document can only be closed once. A document that is destroyed without being closed
+/// is discarded.
+/// </summary>
+/// <returns>True when successful, false otherwise.</returns>
+bool PdfDocument::Close() {
+	if (m_Writer.GetPageCount() == 0)
+		return false;
+
+	try {
+		m_Writer.Close();
+		return true;
+	} catch (const std::exception&) {
+		return false;
+	}
+}
+
+/// <summary>
+/// Describe an encoded page as an image XObject, without copying its data.
+/// </summary>
+/// <param name="page">The encoded page.</param>
+/// <returns>The image.</returns>
+/// <exception cref="std::runtime_error">When the encoded page is corrupt or cannot be embedded.</exception>
+PdfImage PdfDocument::DescribePage(const PdfEncodedPage& page) const {
+	ByteView data(static_cast<const uint8_t*>(page.Data.get()), page.Size);
+
+	switch (m_Codec) {
+		case tiff_export_format::TIFF_EXPORT_PNG:
+			return DescribePng(data);
+		case tiff_export_format::TIFF_EXPORT_JPEG:
+			return DescribeJpeg(data);
+		default: {
+			// JPEG 2000 codestreams specify their own dimensions, colorspace and bit depth.
+			PdfImage image;
+			image.Width            = page.Width;
+			image.Height           = page.Height;
+			image.BitsPerComponent = 0;
+			image.Filter           = "/JPXDecode";
+			image.Data.push_back(data);
+			return image;
+		}
+	}
+}
+
+/// <summary>
+/// Draw color regions over an image that covers the entire page, every region is an image with a stencil mask.
+/// </summary>
+/// <param name="regions">The compressed regions.</param>
+/// <param name="scale">The number of points per pixel of the page.</param>
+/// <param name="pageHeight">The height of the page in points.</param>
+/// <param name="content">The content stream of the page, to which the operators that draw the regions are appended.</param>
+/// <param name="resources">The resources of the page, to which the images of the regions are added.</param>
+void PdfDocument::DrawRegions(const std::vector<PdfEncodedRegion>& regions, double scale, double pageHeight, std::string& content, PdfResources& resources) {
+	for (size_t i = 0; i < regions.size(); ++i) {
+		const auto& region = regions[i];
+
+		auto width  = static_cast<uint32_t>(region.Bounds.right - region.Bounds.left);
+		auto height = static_cast<uint32_t>(region.Bounds.bottom - region.Bounds.top);
+		auto name   = "Mrc" + std::to_string(i);
+
+		PdfImage mask;
+		mask.Width            = width;
+		mask.Height           = height;
+		mask.BitsPerComponent = 1;
+		mask.ImageMask        = true;
+		mask.Filter           = "/FlateDecode";
+		mask.Data.push_back(region.Mask);
+
+		PdfImage image;
+		image.Width      = width;
+		image.Height     = height;
+		image.ColorSpace = "/DeviceRGB";
+		image.Filter     = "/FlateDecode";
+		image.Mask       = std::to_string(m_Writer.AddImage(mask)) + " 0 R";
+		image.Data.push_back(region.Pixels);
+
+		resources.XObjects.emplace_back(name, m_Writer.AddImage(image));
+
+		auto left   = region.Bounds.left * scale;
+		auto bottom = pageHeight - region.Bounds.bottom * scale;
+		content += "q " + PdfWriter::FormatNumber(width * scale) + " 0 0 " + PdfWriter::FormatNumber(height * scale) + " " 
+			+ PdfWriter::FormatNumber(left) + " " + PdfWriter::FormatNumber(bottom) + " cm /" + name + " Do Q\n";
+	}
+}
+
+/// <summary>
+/// Draw annotations over an image that covers the entire page.
+/// </summary>
+/// <param name="marks">The annotations.</param>
+/// <param name="width">The width of the image on the page in points.</param>
+/// <param name="height">The height of the image on the page in points.</param>
+/// <param name="pageHeight">The height of the page in points.</param>
+/// <param name="content">The content stream of the page, to which the operators that draw the marks are appended.</param>
+/// <param name="resources">The resources of the page, to which the resources of the marks are added.</param>
+void PdfDocument::DrawMarks(const PdfMarks& marks, double width, double height, double pageHeight, std::string& content, PdfResources& resources) {
+	if (!marks.List || marks.List->IsEmpty() || marks.Width == 0 || marks.Height == 0)
+		return;
+
+	// The marks are placed on the page as it is stored, which may have been scaled since.
+	Handlers::PdfWangHandler handler(m_Writer, width / marks.Width, height / marks.Height, pageHeight, marks.Inverted);
+	marks.List->Replay(handler);
+
+	const auto& drawn = handler.GetResources();
+	content += handler.GetContent();
+	resources.XObjects.insert(resources.XObjects.end(), drawn.XObjects.begin(), drawn.XObjects.end());
+	resources.Fonts.insert(resources.Fonts.end(), drawn.Fonts.begin(), drawn.Fonts.end());
+	resources.States.insert(resources.States.end(), drawn.States.begin(), drawn.States.end());
+}
\ No newline at end of file
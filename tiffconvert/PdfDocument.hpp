@@ -0,0 +1,177 @@
+#pragma once
+
+#ifndef libtiffconvert_pdf_document_h
+#define libtiffconvert_pdf_document_h
+
+#include "libtiffconvert.h"
+#include "TiffImage.hpp"
+#include "DestructibleBuffer.hpp"
+#include "PdfWriter.hpp"
+#include "MrcPage.hpp"
+#include <TiffFile.hpp>
+#include <WangDisplayList.hpp>
+#include <string>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace TiffConvert {
+	/// <summary>
+	/// A Tiff page that has been encoded for a <see cref="PdfDocument"/>, but has not been added to it yet.
+	/// </summary>
+	struct PdfEncodedPage {
+		std::shared_ptr<const void>	Data;			// The encoded page, owned by libtiffconvert or encoded natively.
+		uint32_t					Size   = 0;		// The size of the encoded page in bytes.
+		uint32_t					Width  = 0;		// The width of the page in pixels.
+		uint32_t					Height = 0;		// The height of the page in pixels.
+	};
+
+	/// <summary>
+	/// A color region of a copied page that has been compressed for a <see cref="PdfDocument"/>, but has not been added to it yet.
+	/// </summary>
+	struct PdfEncodedRegion {
+		RECT					Bounds;		// The region of the page, the right and bottom edges are exclusive.
+		std::vector<uint8_t>	Pixels;		// The burned pixels as RGB rows in a zlib stream, inverted when the page is.
+		std::vector<uint8_t>	Mask;		// The stencil mask of the pixels that differ from the page in a zlib stream.
+	};
+
+	/// <summary>
+	/// The eiStream/Wang annotations of a Tiff page, drawn by a <see cref="PdfDocument"/> as paths and text over the page.
+	/// </summary>
+	struct PdfMarks {
+		std::shared_ptr<const TiffWang::Tiff::WangDisplayList>	List;				// The compiled marks, or nullptr for none.
+		uint32_t												Width    = 0;		// The width of the page the marks were placed on.
+		uint32_t												Height   = 0;		// The height of the page the marks were placed on.
+		bool													Inverted = false;	// Whether the colors of the page are inverted.
+	};
+
+	/// <summary>
+	/// PdfDocument describes a PDF that is built up one Tiff page at a time, each Tiff page becomes an A4 page with the image
+	/// fitted onto it. Each page is encoded the moment it is added and streamed to file by a <see cref="PdfWriter"/>, after 
+	/// which neither the decoded Tiff page nor the encoded image are needed by the document. Encoding can also be done 
+	/// separately from adding, through <see cref="EncodePage"/> and <see cref="AddEncodedPage"/>, so that pages can be 
+	/// encoded concurrently. CCITT Group 4 pages that need no processing can be copied into the document without being
+	/// decoded or encoded at all, through <see cref="CopyPage"/>. Annotations can be drawn over either kind of page as 
+	/// vector marks, see <see cref="PdfMarks"/>, which keeps the page image untouched. Copied pages can also have their
+	/// annotations burned into small color regions that are drawn over them, as mixed raster content.
+	/// </summary>
+	class PdfDocument {
+		private:
+			PdfWriter			m_Writer;
+			tiff_export_format	m_Codec;
+			uint32_t			m_Options;
+			uint32_t			m_Threads;
+
+		public:
+			/// <summary>
+			/// Create a new, empty PDF document.
+			/// </summary>
+			/// <param name="filepath">The filename to save the PDF as, an existing file is overwritten.</param>
+			/// <param name="codec">The codec to use to encode each page.</param>
+			/// <param name="options">Options for the codec.</param>
+			/// <param name="threads">The number of threads to encode a PNG page with, see <see cref="PngEncoder"/>.</param>
+			/// <exception cref="std::runtime_error">When the file cannot be created, or the codec is not supported in PDF.</exception>
+			PdfDocument(const std::string& filepath, tiff_export_format codec, uint32_t options, uint32_t threads = 1);
+
+			PdfDocument(const PdfDocument&) = delete;
+			PdfDocument(PdfDocument&&) = delete;
+			PdfDocument& operator=(const PdfDocument&) = delete;
+			PdfDocument& operator=(PdfDocument&&) = delete;
+
+			/// <summary>
+			/// Encode a Tiff page and add it to the document as a new page.
+			/// </summary>
+			/// <param name="image">The Tiff image the page belongs to.</param>
+			/// <param name="page">The page number.</param>
+			/// <returns>True when successful, false otherwise.</returns>
+			bool AddPage(const TiffImage& image, uint32_t page);
+
+			/// <summary>
+			/// Encode a Tiff page in the format of this document, without adding it. This does not modify the document and 
+			/// can be called from multiple threads at once. PNG pages are encoded natively in the smallest format that holds
+			/// their pixels, see <see cref="TiffImage::EncodePng"/>, other codecs are encoded by libtiffconvert.
+			/// </summary>
+			/// <param name="image">The Tiff image the page belongs to.</param>
+			/// <param name="page">The page number.</param>
+			/// <returns>The encoded page.</returns>
+			/// <exception cref="std::runtime_error">When the page cannot be encoded.</exception>
+			PdfEncodedPage EncodePage(const TiffImage& image, uint32_t page) const;
+
+			/// <summary>
+			/// Add a page that was encoded by <see cref="EncodePage"/> to the document as a new page.
+			/// </summary>
+			/// <param name="page">The encoded page.</param>
+			/// <param name="marks">The annotations to draw over the page, if any.</param>
+			/// <returns>True when successful, false otherwise.</returns>
+			bool AddEncodedPage(const PdfEncodedPage& page, const PdfMarks& marks = PdfMarks());
+
+			/// <summary>
+			/// Determine if a page can be copied into a document as it is, see <see cref="CopyPage"/>.
+			/// </summary>
+			/// <param name="file">The Tiff file.</param>
+			/// <param name="pageIndex">The IFD (page) index.</param>
+			/// <returns>True when the page is a bilevel CCITT Group 4 compressed image in the default fill order.</returns>
+			static bool CanCopyPage(const TiffWang::Tiff::TiffFile& file, size_t pageIndex) noexcept;
+
+			/// <summary>
+			/// Add a CCITT Group 4 compressed page to the document as a new page, without decoding it. The compressed data of 
+			/// every strip is copied from the Tiff file into an image XObject that is decoded by the CCITTFaxDecode filter.
+			/// </summary>
+			/// <param name="file">The Tiff file.</param>
+			/// <param name="pageIndex">The IFD (page) index.</param>
+			/// <param name="inverted">Whether the colors of the page are inverted.</param>
+			/// <param name="marks">The annotations to draw over the page, if any.</param>
+			/// <param name="regions">Annotations that have been burned into color regions to draw over the page, see <see cref="EncodeRegions"/>.</param>
+			/// <returns>True when successful, false otherwise.</returns>
+			bool CopyPage(const TiffWang::Tiff::TiffFile& file, size_t pageIndex, bool inverted, const PdfMarks& marks = PdfMarks(), const std::vector<PdfEncodedRegion>& regions = {});
+
+			/// <summary>
+			/// Compress the color regions that annotations have been burned into, see <see cref="MrcPage"/>, to draw them over
+			/// a page that is copied by <see cref="CopyPage"/>. This does not modify the document and can be called from 
+			/// multiple threads at once.
+			/// </summary>
+			/// <param name="regions">The burned regions of the page.</param>
+			/// <param name="inverted">Whether the colors of the page are inverted.</param>
+			/// <returns>The compressed regions.</returns>
+			std::vector<PdfEncodedRegion> EncodeRegions(const std::vector<MrcRegion>& regions, bool inverted) const;
+
+			/// <summary>
+			/// Finish the document, a document can only be closed once. A document that is destroyed without being closed
+			/// is discarded.
+			/// </summary>
+			/// <returns>True when successful, false otherwise.</returns>
+			bool Close();
+
+		private:
+			/// <summary>
+			/// Describe an encoded page as an image XObject, without copying its data.
+			/// </summary>
+			/// <param name="page">The encoded page.</param>
+			/// <returns>The image.</returns>
+			/// <exception cref="std::runtime_error">When the encoded page is corrupt or cannot be embedded.</exception>
+			PdfImage DescribePage(const PdfEncodedPage& page) const;
+
+			/// <summary>
+			/// Draw color regions over an image that covers the entire page, every region is an image with a stencil mask.
+			/// </summary>
+			/// <param name="regions">The compressed regions.</param>
+			/// <param name="scale">The number of points per pixel of the page.</param>
+			/// <param name="pageHeight">The height of the page in points.</param>
+			/// <param name="content">The content stream of the page, to which the operators that draw the regions are appended.</param>
+			/// <param name="resources">The resources of the page, to which the images of the regions are added.</param>
+			void DrawRegions(const std::vector<PdfEncodedRegion>& regions, double scale, double pageHeight, std::string& content, PdfResources& resources);
+
+			/// <summary>
+			/// Draw annotations over an image that covers the entire page.
+			/// </summary>
+			/// <param name="marks">The annotations.</param>
+			/// <param name="width">The width of the image on the page in points.</param>
+			/// <param name="height">The height of the image on the page in points.</param>
+			/// <param name="pageHeight">The height of the page in points.</param>
+			/// <param name="content">The content stream of the page, to which the operators that draw the marks are appended.</param>
+			/// <param name="resources">The resources of the page, to which the resources of the marks are added.</param>
+			void DrawMarks(const PdfMarks& marks, double width, double height, double pageHeight, std::string& content, PdfResources& resources);
+	};
+}
+
+#endif
@@ -0,0 +1,454 @@
+#include "PdfWangHandler.hpp"
+#include "Util.hpp"
+#include "DibImage.hpp"
+#include "Deflater.hpp"
+#include <iostream>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+
+using namespace TiffConvert::Handlers;
+using namespace TiffConvert;
+
+/// <summary>
+/// The vertical resolution of the display the font heights of text marks are scaled for, like the burned marks.
+/// </summary>
+static constexpr double DisplayResolution = 96.0;
+
+/// <summary>
+/// The distance from the top of a line of text to its baseline and from one baseline to the next, relative to the font size.
+/// </summary>
+static constexpr double Ascent  = 0.8;
+static constexpr double Leading = 1.15;
+
+static constexpr double Pi = 3.14159265358979323846;
+
+/// <summary>
+/// Escape a string for use as a PDF literal string, characters outside of printable ASCII are written as octal escapes.
+/// </summary>
+/// <param name="text">The string.</param>
+/// <returns>The literal string, including its parentheses.</returns>
+static std::string EscapeString(const std::string& text) {
+	static const char digits[] = "01234567";
+
+	std::string result = "(";
+	for (auto c : text) {
+		auto value = static_cast<uint8_t>(c);
+
+		if (value == '(' || value == ')' || value == '\\') {
+			result += '\\';
+			result += c;
+		} else if (value < 0x20 || value > 0x7E) {
+			result += '\\';
+			result += digits[value >> 6];
+			result += digits[(value >> 3) & 7];
+			result += digits[value & 7];
+		} else {
+			result += c;
+		}
+	}
+
+	return result + ")";
+}
+
+#pragma warning ( push )
+#pragma warning ( disable: 4100 ) // unreferenced formal parameter, this is an event handler interface; not all parameters are used in every implementation
+
+/// <summary>
+/// Construct a new PdfWangHandler that draws the marks of a page over the image of the page. The image is placed
+/// at the top left of the PDF page.
+/// </summary>
+/// <param name="writer">The writer of the document, to which embedded images are written.</param>
+/// <param name="scaleX">The width of the image on the PDF page in points, divided by the width of the Tiff page.</param>
+/// <param name="scaleY">The height of the image on the PDF page in points, divided by the height of the Tiff page.</param>
+/// <param name="height">The height of the PDF page in points.</param>
+/// <param name="inverted">Whether the colors of the image are inverted, the marks are then inverted as well.</param>
+PdfWangHandler::PdfWangHandler(PdfWriter& writer, double scaleX, double scaleY, double height, bool inverted)
+	: m_Writer(writer), m_ScaleX(scaleX), m_ScaleY(scaleY), m_Height(height), m_Inverted(inverted) {
+
+}
+
+/// <summary>
+/// A callback method which will be invoked when the <see cref="WangAnnotationReader"/> encounters a line mark.
+/// </summary>
+/// <param name="bounds">The translation of the points.</param>
+/// <param name="points">All the points on the line.</param>
+/// <param name="color">The color.</param>
+/// <param name="size">The size (thickness).</param>
+/// <param name="highlight">Whether or not the highlight filter should be applied (only render on white).</param>
+/// <param name="transparent">Whether or not the transparent filter should be applied (don't render white).</param>
+void PdfWangHandler::RenderLine(const RECT& bounds, const std::vector<POINT>& points, const RGBQUAD& color, uint32_t size, bool highlight, bool transparent) {
+	if (points.empty() || (transparent && Util::IsWhite(color)))
+		return;
+
+	auto translated = Util::TranslatePoints(bounds, points);
+
+	BeginMark(highlight);
+	m_Content += FormatColor(color) + " RG " + PdfWriter::FormatNumber(Transform(size)) + " w 1 J 1 j\n";
+
+	for (size_t i = 0; i < translated.size(); ++i) {
+		m_Content += PdfWriter::FormatNumber(translated[i].x * m_ScaleX) + " " + PdfWriter::FormatNumber(m_Height - translated[i].y * m_ScaleY);
+		m_Content += (i == 0) ? " m\n" : " l\n";
+	}
+
+	// A line of a single point is drawn as a dot by its round cap.
+	if (translated.size() == 1)
+		m_Content += PdfWriter::FormatNumber(translated[0].x * m_ScaleX) + " " + PdfWriter::FormatNumber(m_Height - translated[0].y * m_ScaleY) + " l\n";
+
+	m_Content += "S Q\n";
+}
+
+/// <summary>
+/// The callback method which will be invoked when the <see cref="WangAnnotationReader"/> encounters a filled rectangle mark.
+/// </summary>
+/// <param name="bounds">The bounds for the rectangle.</param>
+/// <param name="color">The fill color to use.</param>
+/// <param name="highlight">Whether or not the highlight filter should be applied (only render on white).</param>
+/// <param name="transparent">Whether or not the transparent filter should be applied (don't render white).</param>
+void PdfWangHandler::RenderRect(const RECT& bounds, const RGBQUAD& color, bool highlight, bool transparent) {
+	if (transparent && Util::IsWhite(color))
+		return;
+
+	BeginMark(highlight);
+	m_Content += FormatColor(color) + " rg " + FormatRect(bounds) + " re f Q\n";
+}
+
+/// <summary>
+/// The callback method which will be invoked when the <see cref="WangAnnotationReader"/> encounters a filled and outlined rectangle mark.
+/// </summary>
+/// <param name="bounds">The bounds for the rectangle.</param>
+/// <param name="color">The fill color to use.</param>
+/// <param name="borderColor">The stroke color to use.</param>
+/// <param name="lineSize">The size of the outline.</param>
+/// <param name="highlight">Whether or not the highlight filter should be applied (only render on white).</param>
+/// <param name="transparent">Whether or not the transparent filter should be applied (don't render white).</param>
+void PdfWangHandler::RenderBorderedRect(const RECT& bounds, const RGBQUAD& color, const RGBQUAD& borderColor, uint32_t lineSize, bool highlight, bool transparent) {
+	RenderRect(bounds, color, highlight, transparent);
+	RenderOutlinedRect(bounds, borderColor, lineSize, highlight, transparent);
+}
+
+/// <summary>
+/// The callback method which will be invoked when the <see cref="WangAnnotationReader"/> encounters an outlined rectangle mark.
+/// </summary>
+/// <param name="bounds">The bounds for the rectangle.</param>
+/// <param name="color">The stroke color to use.</param>
+/// <param name="lineSize">The size of the outline.</param>
+/// <param name="highlight">Whether or not the highlight filter should be applied (only render on white).</param>
+/// <param name="transparent">Whether or not the transparent filter should be applied (don't render white).</param>
+void PdfWangHandler::RenderOutlinedRect(const RECT& bounds, const RGBQUAD& color, uint32_t lineSize, bool highlight, bool transparent) {
+	if (transparent && Util::IsWhite(color))
+		return;
+
+	BeginMark(highlight);
+	m_Content += FormatColor(color) + " RG " + PdfWriter::FormatNumber(Transform(lineSize)) + " w " + FormatRect(bounds) + " re S Q\n";
+}
+
+/// <summary>
+/// The callback method which will be invoked when the <see cref="WangAnnotationReader"/> encounters text.
+/// </summary>
+/// <param name="text">The string of text.</param>
+/// <param name="bounds">The bounding box for the text, if available.</param>
+/// <param name="font">The font information.</param>
+/// <param name="info">The text information.</param>
+/// <param name="color">The color.</param>
+void PdfWangHandler::RenderText(const std::string& text, const RECT& bounds, const LOGFONTA& font, const OIAN_TEXTPRIVDATA& info, const RGBQUAD& color) {
+	// The text of the mark is in the Windows ANSI code page, which is what WinAnsiEncoding describes.
+	AddText(text, bounds, font, info, color);
+}
+
+/// <summary>
+/// The callback method which will be invoked when the <see cref="WangAnnotationReader"/> encounters text.
+/// </summary>
+/// <param name="text">The string of text.</param>
+/// <param name="bounds">The bounding box for the text, if available.</param>
+/// <param name="font">The font information.</param>
+/// <param name="info">The text information.</param>
+/// <param name="color">The color.</param>
+void PdfWangHandler::RenderText(const std::wstring& text, const RECT& bounds, const LOGFONTA& font, const OIAN_TEXTPRIVDATA& info, const RGBQUAD& color) {
+	// The standard fonts only hold the characters of WinAnsiEncoding, Latin-1 maps onto it and anything else is replaced.
+	std::string encoded;
+	encoded.reserve(text.size());
+
+	for (auto c : text)
+		encoded += (c < 0x80 || (c >= 0xA0 && c <= 0xFF)) ? static_cast<char>(c) : '?';
+
+	AddText(encoded, bounds, font, info, color);
+}
+
+/// <summary>
+/// The callback method which will be invoked when the <see cref="WangAnnotationReader"/> encounters a bitmask.
+/// <br/>
+/// Note: the bitmask is applied to a full IFD (image) and should prevent anything from being rendered on a masked area.
+/// </summary>
+/// <param name="filename">The path to the bitmask image.</param>
+/// <param name="bounds">The bounding rectangle.</param>
+/// <param name="rotation">Rotation information.</param>
+void PdfWangHandler::RenderMask(const std::string& filename, const RECT& bounds, const AN_NEW_ROTATE_STRUCT& rotation) {
+	std::cout << "[WARN] forms (image masks) are not supported as they refer to a file on the filesystem, which is not considered secure.\n";
+}
+
+/// <summary>
+/// The callback method which will be invoked when the <see cref="WangAnnotationReader"/> encounters an image reference.
+/// </summary>
+/// <param name="filename">The path to the image file to render.</param>
+/// <param name="bounds">The image bounding box.</param>
+/// <param name="rotation">Rotation information.</param>
+/// <param name="highlight">Whether or not the highlight filter should be applied (only render on white).</param>
+/// <param name="transparent">Whether or not the transparent filter should be applied (don't render white).</param>
+void PdfWangHandler::RenderImageReference(const std::string& filename, const RECT& bounds, const AN_NEW_ROTATE_STRUCT& rotation, bool highlight, bool transparent) {
+	std::cout << "[WARN] images by reference are not supported as they refer to a file on the filesystem, which is not considered secure.\n";
+}
+
+/// <summary>
+/// The callback method which will be invoked when the <see cref="WangAnnotationReader"/> encounters an image block (DIB data).
+/// </summary>
+/// <param name="filename">The path to the image file to render.</param>
+/// <param name="bounds">The image bounding box.</param>
+/// <param name="rotation">Rotation information.</param>
+/// <param name="data">The standard DIB image data. Prepend a BITMAPFILEHEADER struct and you'll have a BMP you can decode.</param>
+/// <param name="highlight">Whether or not the highlight filter should be applied (only render on white).</param>
+/// <param name="transparent">Whether or not the transparent filter should be applied (don't render white).</param>
+void PdfWangHandler::RenderImage(const std::string& filename, const RECT& bounds, const AN_NEW_ROTATE_STRUCT& rotation, const std::vector<uint8_t>& data, bool highlight, bool transparent) {
+	// filename is to be ignored, it's the name of the original file that was embedded.
+
+	RasterTarget target;
+	std::vector<uint8_t> pixels;
+
+	// The DIB is decoded in its orientation at its own resolution, the PDF reader scales it to its bounds.
+	try {
+		DibImage dib(data);
+
+		auto swapped = rotation.rotation == AN_ROTATE_TYPE::RotateRight || rotation.rotation == AN_ROTATE_TYPE::RotateLeft
+			|| rotation.rotation == AN_ROTATE_TYPE::VerticalMirrorRotateRight || rotation.rotation == AN_ROTATE_TYPE::VerticalMirrorRotateLeft;
+
+		target.Width        = swapped ? dib.GetHeight() : dib.GetWidth();
+		target.Height       = swapped ? dib.GetWidth() : dib.GetHeight();
+		target.BitsPerPixel = 24;
+		target.Bgr          = false;
+		target.Pitch        = static_cast<ptrdiff_t>(target.Width) * 3;
+
+		pixels.assign(static_cast<size_t>(target.Pitch) * target.Height, 255);
+		target.Bits = pixels.data();
+
+		RECT rect = { 0, 0, static_cast<LONG>(target.Width), static_cast<LONG>(target.Height) };
+		if (target.Width == 0 || target.Height == 0 || !dib.Draw(target, rect, rotation.rotation))
+			throw std::runtime_error("the embedded image cannot be drawn");
+	} catch (const std::runtime_error&) {
+		std::cout << "[WARN] the embedded image named '" << filename << "' could not be decoded, codec might not be supported.\n";
+		return;
+	}
+
+	// White is transparent in transparent images, the soft mask is taken before the image is inverted.
+	std::vector<uint8_t> alpha;
+	if (transparent) {
+		alpha.resize(static_cast<size_t>(target.Width) * target.Height);
+
+		for (size_t i = 0; i < alpha.size(); ++i) {
+			auto pixel = pixels.data() + i * 3;
+			alpha[i] = (pixel[0] == 255 && pixel[1] == 255 && pixel[2] == 255) ? 0 : 255;
+		}
+	}
+
+	if (m_Inverted) {
+		for (auto& pixel : pixels)
+			pixel = static_cast<uint8_t>(~pixel);
+	}
+
+	auto compressed = Deflater::Compress(pixels);
+
+	PdfImage image;
+	image.Width      = target.Width;
+	image.Height     = target.Height;
+	image.ColorSpace = "/DeviceRGB";
+	image.Filter     = "/FlateDecode";
+	image.Data.push_back(compressed);
+
+	if (transparent) {
+		auto compressedAlpha = Deflater::Compress(alpha);
+
+		PdfImage mask;
+		mask.Width      = target.Width;
+		mask.Height     = target.Height;
+		mask.ColorSpace = "/DeviceGray";
+		mask.Filter     = "/FlateDecode";
+		mask.Data.push_back(compressedAlpha);
+
+		image.SMask = std::to_string(m_Writer.AddImage(mask)) + " 0 R";
+	}
+
+	auto name   = "Wm" + std::to_string(m_Resources.XObjects.size());
+	auto left   = (std::min)(bounds.left, bounds.right) * m_ScaleX;
+	auto bottom = m_Height - (std::max)(bounds.top, bounds.bottom) * m_ScaleY;
+	auto width  = std::abs(static_cast<double>(bounds.right) - bounds.left) * m_ScaleX;
+	auto height = std::abs(static_cast<double>(bounds.bottom) - bounds.top) * m_ScaleY;
+
+	m_Resources.XObjects.emplace_back(name, m_Writer.AddImage(image));
+
+	BeginMark(highlight);
+	m_Content += PdfWriter::FormatNumber(width) + " 0 0 " + PdfWriter::FormatNumber(height) + " " + PdfWriter::FormatNumber(left) + " "
+		+ PdfWriter::FormatNumber(bottom) + " cm /" + name + " Do Q\n";
+}
+
+#pragma warning ( pop )
+
+/// <summary>
+/// Get the content stream operators that draw the marks handled so far.
+/// </summary>
+/// <returns>The operators.</returns>
+const std::string& PdfWangHandler::GetContent() const noexcept {
+	return m_Content;
+}
+
+/// <summary>
+/// Get the resources the content stream refers to.
+/// </summary>
+/// <returns>The resources.</returns>
+const PdfResources& PdfWangHandler::GetResources() const noexcept {
+	return m_Resources;
+}
+
+/// <summary>
+/// Start drawing a mark, in a graphics state of its own.
+/// </summary>
+/// <param name="highlight">Whether the mark is blended with the page instead of painted over it.</param>
+void PdfWangHandler::BeginMark(bool highlight) {
+	m_Content += "q ";
+
+	if (!highlight)
+		return;
+
+	// A highlight multiplies with the page, on an inverted page the inverse of that is a screen.
+	if (m_Resources.States.empty())
+		m_Resources.States.emplace_back("Hl", m_Writer.AddSharedObject(std::string("<< /Type /ExtGState /BM ") + (m_Inverted ? "/Screen" : "/Multiply") + " >>"));
+
+	m_Content += "/Hl gs ";
+}
+
+/// <summary>
+/// Draw a line of text, or several lines separated by line feeds.
+/// </summary>
+/// <param name="text">The text, encoded in WinAnsiEncoding.</param>
+/// <param name="bounds">The bounding box for the text.</param>
+/// <param name="font">The font information.</param>
+/// <param name="info">The text information.</param>
+/// <param name="color">The color.</param>
+void PdfWangHandler::AddText(const std::string& text, const RECT& bounds, const LOGFONTA& font, const OIAN_TEXTPRIVDATA& info, const RGBQUAD& color) {
+	if (text.empty())
+		return;
+
+	// The font height is scaled by the creation scale of the mark, like the burned marks are.
+	auto height = std::abs(static_cast<double>(font.lfHeight));
+	if (info.uCreationScale != 0)
+		height *= (72000.0 / DisplayResolution) / info.uCreationScale;
+
+	// The orientation is the angle of the baseline in tenths of a degree, counterclockwise. The text starts at the corner 
+	// of the bounds that is the top left corner of the text once it is turned back upright.
+	auto angle    = ((info.nCurrentOrientation % 3600) + 3600) % 3600;
+	auto radians  = angle * Pi / 1800.0;
+	auto sideways = (angle >= 450 && angle < 1350) || (angle >= 2250 && angle < 3150);
+
+	auto size   = height * (sideways ? m_ScaleX : m_ScaleY);
+	auto name   = GetFont(font);
+	auto left   = (std::min)(bounds.left, bounds.right) * m_ScaleX;
+	auto right  = (std::max)(bounds.left, bounds.right) * m_ScaleX;
+	auto top    = m_Height - (std::min)(bounds.top, bounds.bottom) * m_ScaleY;
+	auto bottom = m_Height - (std::max)(bounds.top, bounds.bottom) * m_ScaleY;
+	auto turns  = angle / 900;
+	auto x      = (turns < 2) ? left : right;
+	auto y      = (turns == 1 || turns == 2) ? bottom : top;
+
+	auto cosine = std::cos(radians);
+	auto sine   = std::sin(radians);
+
+	// The text matrix rotates the text space around the corner, the first baseline is an ascent below it.
+	BeginMark(false);
+	m_Content += FormatColor(color) + " rg BT /" + name + " " + PdfWriter::FormatNumber(size) + " Tf " + PdfWriter::FormatNumber(size * Leading) + " TL "
+		+ PdfWriter::FormatNumber(cosine) + " " + PdfWriter::FormatNumber(sine) + " " + PdfWriter::FormatNumber(-sine) + " " + PdfWriter::FormatNumber(cosine) + " "
+		+ PdfWriter::FormatNumber(x) + " " + PdfWriter::FormatNumber(y) + " Tm 0 " + PdfWriter::FormatNumber(-size * Ascent) + " Td\n";
+
+	size_t start = 0;
+	while (true) {
+		auto end  = text.find('\n', start);
+		auto line = text.substr(start, (end == std::string::npos) ? std::string::npos : end - start);
+		if (!line.empty() && line.back() == '\r')
+			line.pop_back();
+
+		m_Content += EscapeString(line) + ((start == 0) ? " Tj\n" : " '\n");
+
+		if (end == std::string::npos)
+			break;
+
+		start = end + 1;
+	}
+
+	m_Content += "ET Q\n";
+}
+
+/// <summary>
+/// Get the resource name of the standard PDF font that is closest to a font.
+/// </summary>
+/// <param name="font">The font.</param>
+/// <returns>The resource name.</returns>
+std::string PdfWangHandler::GetFont(const LOGFONTA& font) {
+	std::string face(font.lfFaceName, strnlen(font.lfFaceName, sizeof(font.lfFaceName)));
+	std::transform(face.begin(), face.end(), face.begin(), [](char c) { return static_cast<char>(tolower(static_cast<uint8_t>(c))); });
+
+	auto bold   = font.lfWeight >= FW_SEMIBOLD;
+	auto italic = font.lfItalic != 0;
+
+	std::string baseFont;
+	if (face.find("times") != std::string::npos || face.find("roman") != std::string::npos || (face.find("serif") != std::string::npos && face.find("sans") == std::string::npos))
+		baseFont = bold ? (italic ? "Times-BoldItalic" : "Times-Bold") : (italic ? "Times-Italic" : "Times-Roman");
+	else if (face.find("courier") != std::string::npos || face.find("mono") != std::string::npos)
+		baseFont = std::string("Courier") + (bold ? (italic ? "-BoldOblique" : "-Bold") : (italic ? "-Oblique" : ""));
+	else
+		baseFont = std::string("Helvetica") + (bold ? (italic ? "-BoldOblique" : "-Bold") : (italic ? "-Oblique" : ""));
+
+	auto object = m_Writer.AddSharedObject("<< /Type /Font /Subtype /Type1 /BaseFont /" + baseFont + " /Encoding /WinAnsiEncoding >>");
+
+	for (const auto& existing : m_Resources.Fonts) {
+		if (existing.second == object)
+			return existing.first;
+	}
+
+	auto name = "F" + std::to_string(m_Resources.Fonts.size());
+	m_Resources.Fonts.emplace_back(name, object);
+	return name;
+}
+
+/// <summary>
+/// Format a rectangle in page space as the operands of a PDF re operator.
+/// </summary>
+/// <param name="bounds">The rectangle in page space.</param>
+/// <returns>The operands.</returns>
+std::string PdfWangHandler::FormatRect(const RECT& bounds) const {
+	auto left   = (std::min)(bounds.left, bounds.right) * m_ScaleX;
+	auto bottom = m_Height - (std::max)(bounds.top, bounds.bottom) * m_ScaleY;
+	auto width  = std::abs(static_cast<double>(bounds.right) - bounds.left) * m_ScaleX;
+	auto height = std::abs(static_cast<double>(bounds.bottom) - bounds.top) * m_ScaleY;
+
+	return PdfWriter::FormatNumber(left) + " " + PdfWriter::FormatNumber(bottom) + " " + PdfWriter::FormatNumber(width) + " " + PdfWriter::FormatNumber(height);
+}
+
+/// <summary>
+/// Format a color as the operands of a PDF rg or RG operator.
+/// </summary>
+/// <param name="color">The color.</param>
+/// <returns>The operands.</returns>
+std::string PdfWangHandler::FormatColor(const RGBQUAD& color) const {
+	auto component = [this](uint8_t value) {
+		return PdfWriter::FormatNumber((m_Inverted ? 255 - value : value) / 255.0);
+	};
+
+	return component(color.rgbRed) + " " + component(color.rgbGreen) + " " + component(color.rgbBlue);
+}
+
+/// <summary>
+/// Transform a line size from the space of the page to points.
+/// </summary>
+/// <param name="size">The size in page space.</param>
+/// <returns>The size in points.</returns>
+double PdfWangHandler::Transform(uint32_t size) const noexcept {
+	return (std::max)(1u, size) * (m_ScaleX + m_ScaleY) / 2.0;
+}
\ No newline at end of file
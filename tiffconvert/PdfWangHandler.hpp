@@ -0,0 +1,197 @@
+#pragma once
+
+#ifndef pdf_wang_handler_h
+#define pdf_wang_handler_h
+
+#include "PdfWriter.hpp"
+#include <IWangAnnotationCallback.hpp>
+#include <TiffFile.hpp>
+#include <string>
+
+namespace TiffConvert {
+	namespace Handlers {
+
+		/// <summary>
+		/// PdfWangHandler is an implementation of <see cref="TiffWang::Tiff::IWangAnnotationCallback"/> that handles events
+		/// from the <see cref="Tiffwang::Tiff::WangAnnotationReader"/>. Instead of burning the annotations onto the image, this
+		/// implementation translates them to the operators of a PDF content stream that draw them over the image as paths and
+		/// text. Text is set in the standard PDF fonts, so that it stays searchable, and rotated along with its orientation.
+		/// Highlighted marks are drawn with a Multiply blend mode and white is masked out of transparent images by a soft mask.
+		/// Embedded images are compressed and written to the <see cref="PdfWriter"/> right away, the content stream and the
+		/// resources it refers to are written along with the page.
+		/// </summary>
+		class PdfWangHandler : public TiffWang::Tiff::IWangAnnotationCallback {
+			private:
+				PdfWriter&		m_Writer;
+				double			m_ScaleX;		// The number of points per pixel of the page, horizontally.
+				double			m_ScaleY;		// The number of points per pixel of the page, vertically.
+				double			m_Height;		// The height of the PDF page in points, the y-axis of a PDF page points up.
+				bool			m_Inverted;		// Whether the colors of the page are inverted.
+				std::string		m_Content;
+				PdfResources	m_Resources;
+
+			public:
+				/// <summary>
+				/// Construct a new PdfWangHandler that draws the marks of a page over the image of the page. The image is placed
+				/// at the top left of the PDF page.
+				/// </summary>
+				/// <param name="writer">The writer of the document, to which embedded images are written.</param>
+				/// <param name="scaleX">The width of the image on the PDF page in points, divided by the width of the Tiff page.</param>
+				/// <param name="scaleY">The height of the image on the PDF page in points, divided by the height of the Tiff page.</param>
+				/// <param name="height">The height of the PDF page in points.</param>
+				/// <param name="inverted">Whether the colors of the image are inverted, the marks are then inverted as well.</param>
+				PdfWangHandler(PdfWriter& writer, double scaleX, double scaleY, double height, bool inverted);
+
+				/// <summary>
+				/// A callback method which will be invoked when the <see cref="WangAnnotationReader"/> encounters a line mark.
+				/// </summary>
+				/// <param name="bounds">The translation of the points.</param>
+				/// <param name="points">All the points on the line.</param>
+				/// <param name="color">The color.</param>
+				/// <param name="size">The size (thickness).</param>
+				/// <param name="highlight">Whether or not the highlight filter should be applied (only render on white).</param>
+				/// <param name="transparent">Whether or not the transparent filter should be applied (don't render white).</param>
+				void RenderLine(const RECT& bounds, const std::vector<POINT>& points, const RGBQUAD& color, uint32_t size, bool highlight, bool transparent) override;
+
+				/// <summary>
+				/// The callback method which will be invoked when the <see cref="WangAnnotationReader"/> encounters a filled rectangle mark.
+				/// </summary>
+				/// <param name="bounds">The bounds for the rectangle.</param>
+				/// <param name="color">The fill color to use.</param>
+				/// <param name="highlight">Whether or not the highlight filter should be applied (only render on white).</param>
+				/// <param name="transparent">Whether or not the transparent filter should be applied (don't render white).</param>
+				void RenderRect(const RECT& bounds, const RGBQUAD& color, bool highlight, bool transparent) override;
+
+				/// <summary>
+				/// The callback method which will be invoked when the <see cref="WangAnnotationReader"/> encounters a filled and outlined rectangle mark.
+				/// </summary>
+				/// <param name="bounds">The bounds for the rectangle.</param>
+				/// <param name="color">The fill color to use.</param>
+				/// <param name="borderColor">The stroke color to use.</param>
+				/// <param name="lineSize">The size of the outline.</param>
+				/// <param name="highlight">Whether or not the highlight filter should be applied (only render on white).</param>
+				/// <param name="transparent">Whether or not the transparent filter should be applied (don't render white).</param>
+				void RenderBorderedRect(const RECT& bounds, const RGBQUAD& color, const RGBQUAD& borderColor, uint32_t lineSize, bool highlight, bool transparent) override;
+
+				/// <summary>
+				/// The callback method which will be invoked when the <see cref="WangAnnotationReader"/> encounters an outlined rectangle mark.
+				/// </summary>
+				/// <param name="bounds">The bounds for the rectangle.</param>
+				/// <param name="color">The stroke color to use.</param>
+				/// <param name="lineSize">The size of the outline.</param>
+				/// <param name="highlight">Whether or not the highlight filter should be applied (only render on white).</param>
+				/// <param name="transparent">Whether or not the transparent filter should be applied (don't render white).</param>
+				void RenderOutlinedRect(const RECT& bounds, const RGBQUAD& color, uint32_t lineSize, bool highlight, bool transparent) override;
+
+				/// <summary>
+				/// The callback method which will be invoked when the <see cref="WangAnnotationReader"/> encounters text.
+				/// </summary>
+				/// <param name="text">The string of text.</param>
+				/// <param name="bounds">The bounding box for the text, if available.</param>
+				/// <param name="font">The font information.</param>
+				/// <param name="info">The text information.</param>
+				/// <param name="color">The color.</param>
+				void RenderText(const std::string& text, const RECT& bounds, const LOGFONTA& font, const OIAN_TEXTPRIVDATA& info, const RGBQUAD& color) override;
+
+				/// <summary>
+				/// The callback method which will be invoked when the <see cref="WangAnnotationReader"/> encounters text.
+				/// </summary>
+				/// <param name="text">The string of text.</param>
+				/// <param name="bounds">The bounding box for the text, if available.</param>
+				/// <param name="font">The font information.</param>
+				/// <param name="info">The text information.</param>
+				/// <param name="color">The color.</param>
+				void RenderText(const std::wstring& text, const RECT& bounds, const LOGFONTA& font, const OIAN_TEXTPRIVDATA& info, const RGBQUAD& color) override;
+
+				/// <summary>
+				/// The callback method which will be invoked when the <see cref="WangAnnotationReader"/> encounters a bitmask.
+				/// <br/>
+				/// Note: the bitmask is applied to a full IFD (image) and should prevent anything from being rendered on a masked area.
+				/// </summary>
+				/// <param name="filename">The path to the bitmask image.</param>
+				/// <param name="bounds">The bounding rectangle.</param>
+				/// <param name="rotation">Rotation information.</param>
+				void RenderMask(const std::string& filename, const RECT& bounds, const AN_NEW_ROTATE_STRUCT& rotation) override;
+
+				/// <summary>
+				/// The callback method which will be invoked when the <see cref="WangAnnotationReader"/> encounters an image reference.
+				/// </summary>
+				/// <param name="filename">The path to the image file to render.</param>
+				/// <param name="bounds">The image bounding box.</param>
+				/// <param name="rotation">Rotation information.</param>
+				/// <param name="highlight">Whether or not the highlight filter should be applied (only render on white).</param>
+				/// <param name="transparent">Whether or not the transparent filter should be applied (don't render white).</param>
+				void RenderImageReference(const std::string& filename, const RECT& bounds, const AN_NEW_ROTATE_STRUCT& rotation, bool highlight, bool transparent) override;
+
+				/// <summary>
+				/// The callback method which will be invoked when the <see cref="WangAnnotationReader"/> encounters an image block (DIB data).
+				/// </summary>
+				/// <param name="filename">The path to the image file to render.</param>
+				/// <param name="bounds">The image bounding box.</param>
+				/// <param name="rotation">Rotation information.</param>
+				/// <param name="data">The standard DIB image data. Prepend a BITMAPFILEHEADER struct and you'll have a BMP you can decode.</param>
+				/// <param name="highlight">Whether or not the highlight filter should be applied (only render on white).</param>
+				/// <param name="transparent">Whether or not the transparent filter should be applied (don't render white).</param>
+				void RenderImage(const std::string& filename, const RECT& bounds, const AN_NEW_ROTATE_STRUCT& rotation, const std::vector<uint8_t>& data, bool highlight, bool transparent) override;
+
+				/// <summary>
+				/// Get the content stream operators that draw the marks handled so far.
+				/// </summary>
+				/// <returns>The operators.</returns>
+				const std::string& GetContent() const noexcept;
+
+				/// <summary>
+				/// Get the resources the content stream refers to.
+				/// </summary>
+				/// <returns>The resources.</returns>
+				const PdfResources& GetResources() const noexcept;
+
+			private:
+				/// <summary>
+				/// Start drawing a mark, in a graphics state of its own.
+				/// </summary>
+				/// <param name="highlight">Whether the mark is blended with the page instead of painted over it.</param>
+				void BeginMark(bool highlight);
+
+				/// <summary>
+				/// Draw a line of text, or several lines separated by line feeds.
+				/// </summary>
+				/// <param name="text">The text, encoded in WinAnsiEncoding.</param>
+				/// <param name="bounds">The bounding box for the text.</param>
+				/// <param name="font">The font information.</param>
+				/// <param name="info">The text information.</param>
+				/// <param name="color">The color.</param>
+				void AddText(const std::string& text, const RECT& bounds, const LOGFONTA& font, const OIAN_TEXTPRIVDATA& info, const RGBQUAD& color);
+
+				/// <summary>
+				/// Get the resource name of the standard PDF font that is closest to a font.
+				/// </summary>
+				/// <param name="font">The font.</param>
+				/// <returns>The resource name.</returns>
+				std::string GetFont(const LOGFONTA& font);
+
+				/// <summary>
+				/// Format a rectangle in page space as the operands of a PDF re operator.
+				/// </summary>
+				/// <param name="bounds">The rectangle in page space.</param>
+				/// <returns>The operands.</returns>
+				std::string FormatRect(const RECT& bounds) const;
+
+				/// <summary>
+				/// Format a color as the operands of a PDF rg or RG operator.
+				/// </summary>
+				/// <param name="color">The color.</param>
+				/// <returns>The operands.</returns>
+				std::string FormatColor(const RGBQUAD& color) const;
+
+				/// <summary>
+				/// Transform a line size from the space of the page to points.
+				/// </summary>
+				/// <param name="size">The size in page space.</param>
+				/// <returns>The size in points.</returns>
+				double Transform(uint32_t size) const noexcept;
+		};
+	}
+}
+
+#endif
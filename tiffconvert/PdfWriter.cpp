@@ -0,0 +1,253 @@
+#include "PdfWriter.hpp"
+#include <cstdio>
+#include <stdexcept>
+
+using namespace TiffConvert;
+using namespace TiffWang::Tiff;
+
+/// <summary>
+/// The object number of the catalog, which is written last.
+/// </summary>
+static constexpr uint32_t CatalogObject = 1;
+
+/// <summary>
+/// The object number of the page tree, which is referred to by every page but written last.
+/// </summary>
+static constexpr uint32_t PagesObject = 2;
+
+/// <summary>
+/// Create a new PDF file and write its header.
+/// </summary>
+/// <param name="filepath">The file to create, an existing file is overwritten.</param>
+/// <exception cref="std::runtime_error">When the file cannot be written.</exception>
+PdfWriter::PdfWriter(const std::string& filepath)
+	: m_Filepath(filepath) {
+
+	m_Stream.open(filepath, std::ios::binary | std::ios::trunc);
+	if (!m_Stream)
+		throw std::runtime_error("cannot create pdf file " + filepath);
+
+	// The comment of 4 bytes over 127 marks the file as binary.
+	Write("%PDF-1.5\n%\xE2\xE3\xCF\xD3\n");
+
+	Allocate(); // CatalogObject
+	Allocate(); // PagesObject
+}
+
+/// <summary>
+/// The destructor deletes the file when it has not been closed, as it is incomplete.
+/// </summary>
+PdfWriter::~PdfWriter() {
+	if (!m_Closed) {
+		m_Stream.close();
+		std::remove(m_Filepath.c_str());
+	}
+}
+
+/// <summary>
+/// Write an image XObject to file.
+/// </summary>
+/// <param name="image">The image, its data is no longer needed once this returns.</param>
+/// <returns>The object number of the image, to refer to it from pages.</returns>
+/// <exception cref="std::runtime_error">When the file cannot be written.</exception>
+uint32_t PdfWriter::AddImage(const PdfImage& image) {
+	std::string dictionary = "/Type /XObject /Subtype /Image /Width " + std::to_string(image.Width) + " /Height " + std::to_string(image.Height);
+
+	if (!image.ColorSpace.empty())
+		dictionary += " /ColorSpace " + image.ColorSpace;
+	if (image.BitsPerComponent != 0)
+		dictionary += " /BitsPerComponent " + std::to_string(image.BitsPerComponent);
+	if (!image.Filter.empty())
+		dictionary += " /Filter " + image.Filter;
+	if (!image.DecodeParms.empty())
+		dictionary += " /DecodeParms " + image.DecodeParms;
+	if (image.ImageMask)
+		dictionary += " /ImageMask true /Decode [1 0]";
+	if (!image.Mask.empty())
+		dictionary += " /Mask " + image.Mask;
+	if (!image.SMask.empty())
+		dictionary += " /SMask " + image.SMask;
+
+	auto object = Allocate();
+	WriteStream(object, dictionary, image.Data);
+	return object;
+}
+
+/// <summary>
+/// Write an object that is shared by pages, such as a font, to file. An object is written only once, adding an
+/// object that has been written before returns the object number it was written as.
+/// </summary>
+/// <param name="object">The object, such as a dictionary.</param>
+/// <returns>The object number of the object.</returns>
+/// <exception cref="std::runtime_error">When the file cannot be written.</exception>
+uint32_t PdfWriter::AddSharedObject(const std::string& object) {
+	auto existing = m_Shared.find(object);
+	if (existing != m_Shared.end())
+		return existing->second;
+
+	auto number = Allocate();
+	Begin(number);
+	Write(object + "\nendobj\n");
+
+	m_Shared.emplace(object, number);
+	return number;
+}
+
+/// <summary>
+/// Write a page and its content stream to file.
+/// </summary>
+/// <param name="width">The width of the page in points.</param>
+/// <param name="height">The height of the page in points.</param>
+/// <param name="content">The content stream of the page.</param>
+/// <param name="resources">The resources the content stream refers to.</param>
+/// <exception cref="std::runtime_error">When the file cannot be written.</exception>
+void PdfWriter::AddPage(double width, double height, const std::string& content, const PdfResources& resources) {
+	auto contents = Allocate();
+	WriteStream(contents, "", { ByteView(reinterpret_cast<const uint8_t*>(content.data()), content.size()) });
+
+	auto page = Allocate();
+	Begin(page);
+	Write("<< /Type /Page /Parent " + std::to_string(PagesObject) + " 0 R /MediaBox [0 0 " + FormatNumber(width) + " " + FormatNumber(height) + "]"
+		+ " /Resources << /XObject " + FormatResources(resources.XObjects) + " /Font " + FormatResources(resources.Fonts)
+		+ " /ExtGState " + FormatResources(resources.States) + " >> /Contents " + std::to_string(contents) + " 0 R >>\nendobj\n");
+
+	m_Pages.push_back(page);
+}
+
+/// <summary>
+/// Write the page tree, catalog and cross-reference table and close the file. Nothing can be added afterwards.
+/// </summary>
+/// <exception cref="std::runtime_error">When the file cannot be written.</exception>
+void PdfWriter::Close() {
+	std::string kids;
+	for (auto page : m_Pages)
+		kids += std::to_string(page) + " 0 R ";
+
+	Begin(PagesObject);
+	Write("<< /Type /Pages /Kids [ " + kids + "] /Count " + std::to_string(m_Pages.size()) + " >>\nendobj\n");
+
+	Begin(CatalogObject);
+	Write("<< /Type /Catalog /Pages " + std::to_string(PagesObject) + " 0 R >>\nendobj\n");
+
+	// Every entry of the cross-reference table is exactly 20 bytes, including the line ending.
+	auto xref = m_Position;
+	auto size = std::to_string(m_Offsets.size() + 1);
+	Write("xref\n0 " + size + "\n0000000000 65535 f \n");
+
+	char entry[32];
+	for (auto offset : m_Offsets) {
+		snprintf(entry, sizeof(entry), "%010llu 00000 n \n", static_cast<unsigned long long>(offset));
+		Write(entry);
+	}
+
+	Write("trailer\n<< /Size " + size + " /Root " + std::to_string(CatalogObject) + " 0 R >>\nstartxref\n" + std::to_string(xref) + "\n%%EOF\n");
+
+	m_Stream.close();
+	if (m_Stream.fail())
+		throw std::runtime_error("cannot write pdf file " + m_Filepath);
+
+	m_Closed = true;
+}
+
+/// <summary>
+/// Get the number of pages added so far.
+/// </summary>
+/// <returns>The number of pages.</returns>
+size_t PdfWriter::GetPageCount() const noexcept {
+	return m_Pages.size();
+}
+
+/// <summary>
+/// Format a number for use in a PDF, with at most 4 decimals and without a trailing zero fraction.
+/// </summary>
+/// <param name="value">The number.</param>
+/// <returns>The formatted number.</returns>
+std::string PdfWriter::FormatNumber(double value) {
+	char buffer[64];
+	snprintf(buffer, sizeof(buffer), "%.4f", value);
+
+	std::string result(buffer);
+	result.erase(result.find_last_not_of('0') + 1);
+	if (result.back() == '.')
+		result.pop_back();
+	if (result == "-0")
+		result = "0";
+
+	return result;
+}
+
+/// <summary>
+/// Format a resource dictionary, which maps names to objects.
+/// </summary>
+/// <param name="resources">The name and object number of every resource.</param>
+/// <returns>The dictionary.</returns>
+std::string PdfWriter::FormatResources(const std::vector<std::pair<std::string, uint32_t>>& resources) {
+	std::string result = "<<";
+	for (const auto& resource : resources)
+		result += " /" + resource.first + " " + std::to_string(resource.second) + " 0 R";
+
+	return result + " >>";
+}
+
+/// <summary>
+/// Reserve an object number, the object can be written later on.
+/// </summary>
+/// <returns>The object number.</returns>
+uint32_t PdfWriter::Allocate() {
+	m_Offsets.push_back(0);
+	return static_cast<uint32_t>(m_Offsets.size());
+}
+
+/// <summary>
+/// Start writing an object, recording its byte offset.
+/// </summary>
+/// <param name="object">The object number, as returned by <see cref="Allocate"/>.</param>
+void PdfWriter::Begin(uint32_t object) {
+	m_Offsets.at(static_cast<size_t>(object) - 1) = m_Position;
+	Write(std::to_string(object) + " 0 obj\n");
+}
+
+/// <summary>
+/// Write a stream object in its entirety.
+/// </summary>
+/// <param name="object">The object number, as returned by <see cref="Allocate"/>.</param>
+/// <param name="dictionary">The entries of the stream dictionary, excluding /Length.</param>
+/// <param name="data">The data of the stream, which may be split into several chunks.</param>
+void PdfWriter::WriteStream(uint32_t object, const std::string& dictionary, const std::vector<ByteView>& data) {
+	size_t length = 0;
+	for (const auto& chunk : data)
+		length += chunk.Size();
+
+	Begin(object);
+	Write("<< " + (dictionary.empty() ? std::string() : dictionary + " ") + "/Length " + std::to_string(length) + " >>\nstream\n");
+
+	for (const auto& chunk : data)
+		Write(chunk.Data(), chunk.Size());
+
+	Write("\nendstream\nendobj\n");
+}
+
+/// <summary>
+/// Append text to the file.
+/// </summary>
+/// <param name="text">The text.</param>
+void PdfWriter::Write(const std::string& text) {
+	Write(text.data(), text.size());
+}
+
+/// <summary>
+/// Append bytes to the file.
+/// </summary>
+/// <param name="data">The bytes.</param>
+/// <param name="size">The number of bytes.</param>
+/// <exception cref="std::runtime_error">When the file cannot be written, or has been closed.</exception>
+void PdfWriter::Write(const void* data, size_t size) {
+	if (m_Closed)
+		throw std::runtime_error("the pdf file has already been closed");
+
+	m_Stream.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+	if (!m_Stream)
+		throw std::runtime_error("cannot write pdf file " + m_Filepath);
+
+	m_Position += size;
+}
\ No newline at end of file
@@ -0,0 +1,164 @@
+#pragma once
+
+#ifndef libtiffconvert_pdf_writer_h
+#define libtiffconvert_pdf_writer_h
+
+#include <ByteView.hpp>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <utility>
+#include <fstream>
+#include <map>
+
+namespace TiffConvert {
+	/// <summary>
+	/// An image XObject for a <see cref="PdfWriter"/>, of which the data is already encoded in a format a PDF reader can decode.
+	/// </summary>
+	struct PdfImage {
+		uint32_t								Width            = 0;
+		uint32_t								Height           = 0;
+		uint32_t								BitsPerComponent = 8;	// 0 when the data specifies it, such as for JPXDecode.
+		std::string								ColorSpace;				// A colorspace object, such as /DeviceRGB, or empty when the data specifies it.
+		std::string								Filter;					// The filter that decodes the data, such as /DCTDecode.
+		std::string								DecodeParms;			// The parameters of the filter, or empty.
+		std::string								Mask;					// A color key mask, such as [255 255 255 255 255 255], a reference to a stencil mask, or empty.
+		std::string								SMask;					// A reference to a soft mask image, or empty.
+		bool									ImageMask        = false;	// Whether the image is a 1-bit stencil mask, in which a set bit is painted.
+		std::vector<TiffWang::Tiff::ByteView>	Data;					// The encoded data, which may be split into several chunks.
+	};
+
+	/// <summary>
+	/// The resources a page refers to by name from its content stream, every resource is an object that has been written.
+	/// </summary>
+	struct PdfResources {
+		std::vector<std::pair<std::string, uint32_t>>	XObjects;	// The name and object number of every image.
+		std::vector<std::pair<std::string, uint32_t>>	Fonts;		// The name and object number of every font.
+		std::vector<std::pair<std::string, uint32_t>>	States;		// The name and object number of every graphics state.
+	};
+
+	/// <summary>
+	/// PdfWriter is a streaming PDF encoder. Every object is written to file the moment it is added, so that an image and the
+	/// page that draws it no longer need to be kept in memory once the page has been added. The writer only keeps the byte
+	/// offset of every object and the object number of every page, from which the page tree and cross-reference table are
+	/// written when the file is closed, and the few small objects that are shared by pages such as fonts.
+	/// </summary>
+	class PdfWriter {
+		private:
+			std::string						m_Filepath;
+			std::ofstream					m_Stream;
+			uint64_t						m_Position = 0;		// The number of bytes written so far.
+			std::vector<uint64_t>			m_Offsets;			// The byte offset of every object, object n is at index n - 1.
+			std::vector<uint32_t>			m_Pages;			// The object number of every page, in page order.
+			std::map<std::string, uint32_t>	m_Shared;			// The object number of every shared object, by its contents.
+			bool							m_Closed = false;
+
+		public:
+			/// <summary>
+			/// Create a new PDF file and write its header.
+			/// </summary>
+			/// <param name="filepath">The file to create, an existing file is overwritten.</param>
+			/// <exception cref="std::runtime_error">When the file cannot be written.</exception>
+			PdfWriter(const std::string& filepath);
+
+			PdfWriter(const PdfWriter&) = delete;
+			PdfWriter(PdfWriter&&) = delete;
+			PdfWriter& operator=(const PdfWriter&) = delete;
+			PdfWriter& operator=(PdfWriter&&) = delete;
+
+			/// <summary>
+			/// The destructor deletes the file when it has not been closed, as it is incomplete.
+			/// </summary>
+			~PdfWriter();
+
+			/// <summary>
+			/// Write an image XObject to file.
+			/// </summary>
+			/// <param name="image">The image, its data is no longer needed once this returns.</param>
+			/// <returns>The object number of the image, to refer to it from pages.</returns>
+			/// <exception cref="std::runtime_error">When the file cannot be written.</exception>
+			uint32_t AddImage(const PdfImage& image);
+
+			/// <summary>
+			/// Write an object that is shared by pages, such as a font, to file. An object is written only once, adding an
+			/// object that has been written before returns the object number it was written as.
+			/// </summary>
+			/// <param name="object">The object, such as a dictionary.</param>
+			/// <returns>The object number of the object.</returns>
+			/// <exception cref="std::runtime_error">When the file cannot be written.</exception>
+			uint32_t AddSharedObject(const std::string& object);
+
+			/// <summary>
+			/// Write a page and its content stream to file.
+			/// </summary>
+			/// <param name="width">The width of the page in points.</param>
+			/// <param name="height">The height of the page in points.</param>
+			/// <param name="content">The content stream of the page.</param>
+			/// <param name="resources">The resources the content stream refers to.</param>
+			/// <exception cref="std::runtime_error">When the file cannot be written.</exception>
+			void AddPage(double width, double height, const std::string& content, const PdfResources& resources);
+
+			/// <summary>
+			/// Write the page tree, catalog and cross-reference table and close the file. Nothing can be added afterwards.
+			/// </summary>
+			/// <exception cref="std::runtime_error">When the file cannot be written.</exception>
+			void Close();
+
+			/// <summary>
+			/// Get the number of pages added so far.
+			/// </summary>
+			/// <returns>The number of pages.</returns>
+			size_t GetPageCount() const noexcept;
+
+			/// <summary>
+			/// Format a number for use in a PDF, with at most 4 decimals and without a trailing zero fraction.
+			/// </summary>
+			/// <param name="value">The number.</param>
+			/// <returns>The formatted number.</returns>
+			static std::string FormatNumber(double value);
+
+		private:
+			/// <summary>
+			/// Format a resource dictionary, which maps names to objects.
+			/// </summary>
+			/// <param name="resources">The name and object number of every resource.</param>
+			/// <returns>The dictionary.</returns>
+			static std::string FormatResources(const std::vector<std::pair<std::string, uint32_t>>& resources);
+
+			/// <summary>
+			/// Reserve an object number, the object can be written later on.
+			/// </summary>
+			/// <returns>The object number.</returns>
+			uint32_t Allocate();
+
+			/// <summary>
+			/// Start writing an object, recording its byte offset.
+			/// </summary>
+			/// <param name="object">The object number, as returned by <see cref="Allocate"/>.</param>
+			void Begin(uint32_t object);
+
+			/// <summary>
+			/// Write a stream object in its entirety.
+			/// </summary>
+			/// <param name="object">The object number, as returned by <see cref="Allocate"/>.</param>
+			/// <param name="dictionary">The entries of the stream dictionary, excluding /Length.</param>
+			/// <param name="data">The data of the stream, which may be split into several chunks.</param>
+			void WriteStream(uint32_t object, const std::string& dictionary, const std::vector<TiffWang::Tiff::ByteView>& data);
+
+			/// <summary>
+			/// Append text to the file.
+			/// </summary>
+			/// <param name="text">The text.</param>
+			void Write(const std::string& text);
+
+			/// <summary>
+			/// Append bytes to the file.
+			/// </summary>
+			/// <param name="data">The bytes.</param>
+			/// <param name="size">The number of bytes.</param>
+			/// <exception cref="std::runtime_error">When the file cannot be written, or has been closed.</exception>
+			void Write(const void* data, size_t size);
+	};
+}
+
+#endif
@@ -0,0 +1,462 @@
+#include "PngEncoder.hpp"
+#include "Deflater.hpp"
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+#include <unordered_set>
+
+using namespace TiffConvert;
+using namespace TiffWang::Tiff;
+
+static constexpr uint32_t	MinimumBand		= 16;				// The minimum number of rows in a band that is processed by a thread.
+static constexpr size_t		PaletteSize		= 256;				// The maximum number of colors in a palette.
+static constexpr size_t		MaximumIdat		= 1024 * 1024;		// The maximum size of an IDAT chunk.
+static constexpr uint8_t	Signature[8]	= { 0x89, 'P', 'N', 'G', 0x0D, 0x0A, 0x1A, 0x0A };
+
+/// <summary>
+/// The CRC-32 of every byte, as used by PNG chunks.
+/// </summary>
+static constexpr auto CrcTable = []() {
+	std::array<uint32_t, 256> table = {};
+	for (uint32_t i = 0; i < 256; ++i) {
+		auto crc = i;
+		for (auto k = 0; k < 8; ++k)
+			crc = (crc & 1) ? 0xEDB88320u ^ (crc >> 1) : crc >> 1;
+		table[i] = crc;
+	}
+	return table;
+}();
+
+/// <summary>
+/// The colors and alpha found in the pixels of a band of an image.
+/// </summary>
+struct PngAnalysis {
+	bool							Gray         = true;		// Whether every pixel is gray.
+	bool							Bilevel      = true;		// Whether every pixel is black or white.
+	bool							Overflow     = false;		// Whether there are more colors than fit a palette, Colors is empty then.
+	uint8_t							MinimumAlpha = 255;
+	uint8_t							MaximumAlpha = 0;
+	std::unordered_set<uint32_t>	Colors;						// The colors as 0xAARRGGBB.
+};
+
+/// <summary>
+/// Split a number of rows into bands and process every band on its own thread, the first band is processed on the
+/// calling thread.
+/// </summary>
+/// <param name="count">The number of rows.</param>
+/// <param name="threads">The maximum number of threads.</param>
+/// <param name="function">Processes a band, it receives the band index and the first and last + 1 row of the band.</param>
+template <typename TFunction>
+static void ForEachBand(uint32_t count, uint32_t threads, TFunction function) {
+	threads = (std::max)(1u, (std::min)(threads, count / MinimumBand));
+
+	std::vector<std::thread> workers;
+	auto band = [count, threads](uint32_t index) { return static_cast<uint32_t>(static_cast<uint64_t>(count) * index / threads); };
+
+	try {
+		for (uint32_t t = 1; t < threads; ++t)
+			workers.emplace_back(function, t, band(t), band(t + 1));
+
+		function(0, band(0), band(1));
+	} catch (...) {
+		for (auto& worker : workers)
+			worker.join();
+		throw;
+	}
+
+	for (auto& worker : workers)
+		worker.join();
+}
+
+/// <summary>
+/// Read a pixel of an image.
+/// </summary>
+/// <param name="image">The image.</param>
+/// <param name="pixel">The pixel.</param>
+/// <returns>The color as 0xAARRGGBB.</returns>
+static uint32_t ReadPixel(const RasterTarget& image, const uint8_t* pixel) noexcept {
+	if (image.BitsPerPixel == 8)
+		return 0xFF000000u | (pixel[0] * 0x010101u);
+
+	uint32_t red   = image.Bgr ? pixel[2] : pixel[0];
+	uint32_t blue  = image.Bgr ? pixel[0] : pixel[2];
+	uint32_t alpha = (image.BitsPerPixel == 32) ? pixel[3] : 255u;
+
+	return (alpha << 24) | (red << 16) | (static_cast<uint32_t>(pixel[1]) << 8) | blue;
+}
+
+/// <summary>
+/// Get the row of an image.
+/// </summary>
+/// <param name="image">The image.</param>
+/// <param name="y">The row.</param>
+/// <returns>The first pixel of the row.</returns>
+static const uint8_t* GetRow(const RasterTarget& image, uint32_t y) noexcept {
+	return image.Bits + static_cast<ptrdiff_t>(y) * image.Pitch;
+}
+
+/// <summary>
+/// Write a 32-bit integer big endian, as PNG stores them.
+/// </summary>
+/// <param name="output">The output.</param>
+/// <param name="value">The value.</param>
+static void WriteUInt32(std::vector<uint8_t>& output, uint32_t value) {
+	for (auto shift = 24; shift >= 0; shift -= 8)
+		output.push_back(static_cast<uint8_t>(value >> shift));
+}
+
+/// <summary>
+/// Write a PNG chunk.
+/// </summary>
+/// <param name="output">The output.</param>
+/// <param name="type">The four character chunk type.</param>
+/// <param name="data">The data of the chunk.</param>
+static void WriteChunk(std::vector<uint8_t>& output, const char* type, ByteView data) {
+	WriteUInt32(output, static_cast<uint32_t>(data.Size()));
+
+	auto start = output.size();
+	output.insert(output.end(), type, type + 4);
+	output.insert(output.end(), data.begin(), data.end());
+
+	uint32_t crc = 0xFFFFFFFFu;
+	for (auto i = start; i < output.size(); ++i)
+		crc = CrcTable[(crc ^ output[i]) & 0xFF] ^ (crc >> 8);
+
+	WriteUInt32(output, crc ^ 0xFFFFFFFFu);
+}
+
+/// <summary>
+/// Predict a byte from its neighbours the way the Paeth filter does.
+/// </summary>
+/// <param name="left">The byte of the pixel to the left.</param>
+/// <param name="up">The byte of the pixel above.</param>
+/// <param name="corner">The byte of the pixel above and to the left.</param>
+/// <returns>The neighbour that is closest to left + up - corner.</returns>
+static uint8_t Paeth(int32_t left, int32_t up, int32_t corner) noexcept {
+	auto estimate = left + up - corner;
+	auto a = std::abs(estimate - left);
+	auto b = std::abs(estimate - up);
+	auto c = std::abs(estimate - corner);
+
+	if (a <= b && a <= c)
+		return static_cast<uint8_t>(left);
+
+	return static_cast<uint8_t>((b <= c) ? up : corner);
+}
+
+/// <summary>
+/// Filter a row with the filter that minimizes the sum of the absolute values of the filtered bytes, as signed bytes.
+/// </summary>
+/// <param name="row">The row.</param>
+/// <param name="previous">The row above it, all zeroes for the first row.</param>
+/// <param name="size">The number of bytes in a row.</param>
+/// <param name="step">The number of bytes per pixel.</param>
+/// <param name="candidates">Five buffers of <paramref name="size"/> bytes for the filtered rows.</param>
+/// <param name="output">Receives the filter type and the filtered row.</param>
+static void FilterRow(const uint8_t* row, const uint8_t* previous, size_t size, size_t step, std::array<std::vector<uint8_t>, 5>& candidates, uint8_t* output) {
+	uint64_t sums[5] = { 0 };
+
+	for (size_t i = 0; i < size; ++i) {
+		int32_t left   = (i >= step) ? row[i - step] : 0;
+		int32_t up     = previous[i];
+		int32_t corner = (i >= step) ? previous[i - step] : 0;
+
+		candidates[0][i] = row[i];
+		candidates[1][i] = static_cast<uint8_t>(row[i] - left);
+		candidates[2][i] = static_cast<uint8_t>(row[i] - up);
+		candidates[3][i] = static_cast<uint8_t>(row[i] - ((left + up) >> 1));
+		candidates[4][i] = static_cast<uint8_t>(row[i] - Paeth(left, up, corner));
+
+		for (size_t f = 0; f < 5; ++f)
+			sums[f] += static_cast<uint64_t>(std::abs(static_cast<int32_t>(static_cast<int8_t>(candidates[f][i]))));
+	}
+
+	auto best = static_cast<size_t>(std::min_element(sums, sums + 5) - sums);
+
+	output[0] = static_cast<uint8_t>(best);
+	memcpy(output + 1, candidates[best].data(), size);
+}
+
+/// <summary>
+/// Construct a new PNG encoder.
+/// </summary>
+/// <param name="threads">The maximum number of threads to encode a page with.</param>
+/// <param name="alpha">Whether the alpha of 32-bit pixels is stored, otherwise every pixel is opaque.</param>
+PngEncoder::PngEncoder(uint32_t threads, bool alpha) noexcept
+	: m_Threads((std::max)(threads, 1u)), m_Alpha(alpha) {}
+
+/// <summary>
+/// Encode a bilevel page as a 1-bit gray PNG.
+/// </summary>
+/// <param name="bits">The bit-packed rows of the page.</param>
+/// <returns>The PNG file.</returns>
+std::vector<uint8_t> PngEncoder::Encode(const tiff_page_bits& bits) const {
+	auto size = static_cast<size_t>((bits.Width + 7) / 8);
+	auto tail = static_cast<uint8_t>(0xFF << ((8 - (bits.Width & 7)) & 7));
+
+	// In PNG a set bit is white, the padding of the last byte is cleared.
+	std::vector<uint8_t> rows((size + 1) * bits.Height);
+	ForEachBand(bits.Height, m_Threads, [&](uint32_t, uint32_t first, uint32_t last) {
+		for (auto y = first; y < last; ++y) {
+			auto input  = bits.Bits + static_cast<size_t>(y) * bits.Stride;
+			auto output = rows.data() + static_cast<size_t>(y) * (size + 1);
+
+			output[0] = 0;
+			for (size_t i = 0; i < size; ++i)
+				output[i + 1] = static_cast<uint8_t>(bits.Inverted ? input[i] : ~input[i]);
+
+			if (size != 0)
+				output[size] &= tail;
+		}
+	});
+
+	return Write(bits.Width, bits.Height, 1, PngFormat::Bilevel, ByteView(), ByteView(), rows);
+}
+
+/// <summary>
+/// Encode an image as PNG, in the smallest format that holds its pixels exactly.
+/// </summary>
+/// <param name="image">The image, 8, 24 or 32 bits per pixel.</param>
+/// <returns>The PNG file.</returns>
+/// <exception cref="std::invalid_argument">When the image is empty or has an unsupported pixel format.</exception>
+std::vector<uint8_t> PngEncoder::Encode(const RasterTarget& image) const {
+	if (image.BitsPerPixel != 8 && image.BitsPerPixel != 24 && image.BitsPerPixel != 32)
+		throw std::invalid_argument("unsupported pixel format");
+
+	if (image.Width == 0 || image.Height == 0)
+		throw std::invalid_argument("empty image");
+
+	auto step     = static_cast<size_t>(image.BitsPerPixel / 8);
+	auto hasAlpha = m_Alpha && image.BitsPerPixel == 32;
+	auto threads  = (std::max)(1u, (std::min)(m_Threads, image.Height / MinimumBand));
+
+	// Pass 1: every band is scanned for the colors and the alpha of its pixels, a band stops as soon as it holds too many
+	// colors for a palette and nothing else can be learned from it.
+	std::vector<PngAnalysis> analyses(threads);
+	ForEachBand(image.Height, threads, [&](uint32_t band, uint32_t first, uint32_t last) {
+		auto& analysis = analyses[band];
+		auto  previous = ~ReadPixel(image, GetRow(image, first));
+
+		for (auto y = first; y < last; ++y) {
+			auto pixel = GetRow(image, y);
+
+			for (uint32_t x = 0; x < image.Width; ++x, pixel += step) {
+				auto color = ReadPixel(image, pixel);
+				if (color == previous)
+					continue;
+
+				previous = color;
+
+				auto red   = static_cast<uint8_t>(color >> 16);
+				auto green = static_cast<uint8_t>(color >> 8);
+				auto blue  = static_cast<uint8_t>(color);
+				auto alpha = static_cast<uint8_t>(color >> 24);
+
+				if (red != green || green != blue)
+					analysis.Gray = analysis.Bilevel = false;
+				else if (red != 0 && red != 255)
+					analysis.Bilevel = false;
+
+				analysis.MinimumAlpha = (std::min)(analysis.MinimumAlpha, alpha);
+				analysis.MaximumAlpha = (std::max)(analysis.MaximumAlpha, alpha);
+
+				if (!analysis.Overflow) {
+					analysis.Colors.insert(hasAlpha ? color : (color | 0xFF000000u));
+
+					if (analysis.Colors.size() > PaletteSize) {
+						analysis.Overflow = true;
+						analysis.Colors.clear();
+					}
+				} else if (!analysis.Gray && (!hasAlpha || analysis.MinimumAlpha != analysis.MaximumAlpha)) {
+					return;
+				}
+			}
+		}
+	});
+
+	PngAnalysis total;
+	for (auto& analysis : analyses) {
+		total.Gray         = total.Gray && analysis.Gray;
+		total.Bilevel      = total.Bilevel && analysis.Bilevel;
+		total.Overflow     = total.Overflow || analysis.Overflow;
+		total.MinimumAlpha = (std::min)(total.MinimumAlpha, analysis.MinimumAlpha);
+		total.MaximumAlpha = (std::max)(total.MaximumAlpha, analysis.MaximumAlpha);
+
+		if (!total.Overflow)
+			total.Colors.insert(analysis.Colors.begin(), analysis.Colors.end());
+
+		if (total.Overflow || total.Colors.size() > PaletteSize) {
+			total.Overflow = true;
+			total.Colors.clear();
+		}
+	}
+
+	// Alpha that is the same for every pixel is not stored, the pixels are opaque then.
+	auto alpha = hasAlpha && total.MinimumAlpha != total.MaximumAlpha;
+	std::vector<uint32_t> colors;
+	for (auto color : total.Colors)
+		colors.push_back(alpha ? color : (color | 0xFF000000u));
+
+	std::sort(colors.begin(), colors.end());
+	colors.erase(std::unique(colors.begin(), colors.end()), colors.end());
+
+	// Gray images of more than 16 levels are not smaller as palette.
+	auto format = PngFormat::Rgb;
+	uint8_t depth = 8;
+
+	if (!alpha && total.Bilevel) {
+		format = PngFormat::Bilevel;
+		depth  = 1;
+	} else if (!total.Overflow && (alpha || !total.Gray || colors.size() <= 16)) {
+		format = PngFormat::Palette;
+		depth  = static_cast<uint8_t>((colors.size() <= 2) ? 1 : (colors.size() <= 4) ? 2 : (colors.size() <= 16) ? 4 : 8);
+	} else if (total.Gray && !alpha) {
+		format = PngFormat::Gray;
+	} else if (alpha) {
+		format = PngFormat::Rgba;
+	}
+
+	size_t channels = (format == PngFormat::Rgba) ? 4 : (format == PngFormat::Rgb) ? 3 : 1;
+	auto   size     = (static_cast<size_t>(image.Width) * channels * depth + 7) / 8;
+	auto   filtered = (depth == 8 && format != PngFormat::Palette);
+
+	// Pass 2: every band converts its rows to the format and filters them, the row above a band is converted as well.
+	std::vector<uint8_t> rows((size + 1) * image.Height);
+	ForEachBand(image.Height, threads, [&](uint32_t, uint32_t first, uint32_t last) {
+		std::vector<uint8_t> current(size), previous(size, 0);
+		std::array<std::vector<uint8_t>, 5> candidates;
+		size_t index  = 0;
+		auto   cached = colors.empty() ? 0 : colors[0];
+
+		if (filtered)
+			candidates.fill(std::vector<uint8_t>(size));
+
+		auto convert = [&](uint32_t y, uint8_t* row) {
+			auto pixel = GetRow(image, y);
+
+			if (depth < 8)
+				memset(row, 0, size);
+
+			for (uint32_t x = 0; x < image.Width; ++x, pixel += step) {
+				auto color = ReadPixel(image, pixel);
+				if (!alpha)
+					color |= 0xFF000000u;
+
+				switch (format) {
+					case PngFormat::Bilevel:
+						if ((color & 0xFF) != 0)
+							row[x >> 3] |= static_cast<uint8_t>(0x80 >> (x & 7));
+						break;
+					case PngFormat::Gray:
+						row[x] = static_cast<uint8_t>(color);
+						break;
+					case PngFormat::Palette:
+						if (color != cached) {
+							cached = color;
+							index  = static_cast<size_t>(std::lower_bound(colors.begin(), colors.end(), color) - colors.begin());
+						}
+
+						if (depth == 8) {
+							row[x] = static_cast<uint8_t>(index);
+						} else {
+							auto bit = static_cast<size_t>(x) * depth;
+							row[bit >> 3] |= static_cast<uint8_t>(index << (8 - depth - (bit & 7)));
+						}
+						break;
+					case PngFormat::Rgb:
+					case PngFormat::Rgba:
+						row[x * channels]     = static_cast<uint8_t>(color >> 16);
+						row[x * channels + 1] = static_cast<uint8_t>(color >> 8);
+						row[x * channels + 2] = static_cast<uint8_t>(color);
+						if (channels == 4)
+							row[x * channels + 3] = static_cast<uint8_t>(color >> 24);
+						break;
+				}
+			}
+		};
+
+		if (filtered && first > 0)
+			convert(first - 1, previous.data());
+
+		for (auto y = first; y < last; ++y) {
+			auto output = rows.data() + static_cast<size_t>(y) * (size + 1);
+
+			if (!filtered) {
+				output[0] = 0;
+				convert(y, output + 1);
+				continue;
+			}
+
+			convert(y, current.data());
+			FilterRow(current.data(), previous.data(), size, channels, candidates, output);
+			std::swap(current, previous);
+		}
+	});
+
+	std::vector<uint8_t> palette, transparency;
+	if (format == PngFormat::Palette) {
+		for (auto color : colors) {
+			palette.push_back(static_cast<uint8_t>(color >> 16));
+			palette.push_back(static_cast<uint8_t>(color >> 8));
+			palette.push_back(static_cast<uint8_t>(color));
+			transparency.push_back(static_cast<uint8_t>(color >> 24));
+		}
+
+		// Entries after the last transparent one are opaque by default.
+		while (!transparency.empty() && transparency.back() == 255)
+			transparency.pop_back();
+	}
+
+	return Write(image.Width, image.Height, depth, format, palette, transparency, rows);
+}
+
+/// <summary>
+/// Compress filtered rows and write them as PNG file.
+/// </summary>
+/// <param name="width">The width in pixels.</param>
+/// <param name="height">The height in pixels.</param>
+/// <param name="depth">The number of bits per sample, or per index for palette images.</param>
+/// <param name="format">The color type.</param>
+/// <param name="palette">The RGB entries of the palette, for palette images.</param>
+/// <param name="transparency">The alpha of the entries of the palette, empty when they are all opaque.</param>
+/// <param name="rows">The filtered rows, each preceded by its filter type.</param>
+/// <returns>The PNG file.</returns>
+std::vector<uint8_t> PngEncoder::Write(uint32_t width, uint32_t height, uint8_t depth, PngFormat format, ByteView palette, ByteView transparency, ByteView rows) const {
+	uint8_t colorType = 0;
+	switch (format) {
+		case PngFormat::Bilevel:
+		case PngFormat::Gray:		colorType = 0; break;
+		case PngFormat::Rgb:		colorType = 2; break;
+		case PngFormat::Palette:	colorType = 3; break;
+		case PngFormat::Rgba:		colorType = 6; break;
+	}
+
+	// IHDR: the dimensions, bit depth and color type, with deflate compression, adaptive filtering and no interlacing.
+	std::vector<uint8_t> header;
+	WriteUInt32(header, width);
+	WriteUInt32(header, height);
+	header.insert(header.end(), { depth, colorType, 0, 0, 0 });
+
+	auto compressed = Deflater::Compress(rows, m_Threads);
+
+	std::vector<uint8_t> png(std::begin(Signature), std::end(Signature));
+	png.reserve(compressed.size() + palette.Size() + transparency.Size() + 1024);
+
+	WriteChunk(png, "IHDR", header);
+
+	if (palette.Size() != 0)
+		WriteChunk(png, "PLTE", palette);
+
+	if (transparency.Size() != 0)
+		WriteChunk(png, "tRNS", transparency);
+
+	ByteView data(compressed);
+	for (size_t offset = 0; offset < data.Size(); offset += MaximumIdat)
+		WriteChunk(png, "IDAT", data.SubView(offset, (std::min)(MaximumIdat, data.Size() - offset)));
+
+	WriteChunk(png, "IEND", ByteView());
+	return png;
+}
\ No newline at end of file
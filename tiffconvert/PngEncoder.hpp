@@ -0,0 +1,75 @@
+#pragma once
+
+#ifndef libtiffconvert_png_encoder_h
+#define libtiffconvert_png_encoder_h
+
+#include "libtiffconvert.h"
+#include "Rasterizer.hpp"
+#include <ByteView.hpp>
+#include <cstdint>
+#include <vector>
+
+namespace TiffConvert {
+	/// <summary>
+	/// The color type and bit depth a page is stored in as PNG.
+	/// </summary>
+	enum class PngFormat {
+		Bilevel,		// 1-bit gray.
+		Gray,			// 8-bit gray.
+		Palette,		// 1, 2, 4 or 8-bit indices into at most 256 colors, with transparency when the colors have alpha.
+		Rgb,			// 24-bit color.
+		Rgba			// 32-bit color with alpha.
+	};
+
+	/// <summary>
+	/// PngEncoder encodes pages to PNG natively. The pixels of a page are scanned first to find the smallest color type that
+	/// holds them exactly: black and white pages are stored with 1 bit per pixel, other gray pages with 8, pages of at most
+	/// 256 colors as a palette and only the rest as RGB, or RGBA when the alpha of the pixels is not uniform. Every row of an
+	/// 8-bit format is filtered with the filter that minimizes the sum of its absolute differences, the rows are filtered on
+	/// several threads and compressed by a <see cref="Deflater"/> on several threads as well.
+	/// </summary>
+	class PngEncoder {
+		private:
+			uint32_t	m_Threads;
+			bool		m_Alpha;
+
+		public:
+			/// <summary>
+			/// Construct a new PNG encoder.
+			/// </summary>
+			/// <param name="threads">The maximum number of threads to encode a page with.</param>
+			/// <param name="alpha">Whether the alpha of 32-bit pixels is stored, otherwise every pixel is opaque.</param>
+			PngEncoder(uint32_t threads = 1, bool alpha = true) noexcept;
+
+			/// <summary>
+			/// Encode a bilevel page as a 1-bit gray PNG.
+			/// </summary>
+			/// <param name="bits">The bit-packed rows of the page.</param>
+			/// <returns>The PNG file.</returns>
+			std::vector<uint8_t> Encode(const tiff_page_bits& bits) const;
+
+			/// <summary>
+			/// Encode an image as PNG, in the smallest format that holds its pixels exactly.
+			/// </summary>
+			/// <param name="image">The image, 8, 24 or 32 bits per pixel.</param>
+			/// <returns>The PNG file.</returns>
+			/// <exception cref="std::invalid_argument">When the image is empty or has an unsupported pixel format.</exception>
+			std::vector<uint8_t> Encode(const RasterTarget& image) const;
+
+		private:
+			/// <summary>
+			/// Compress filtered rows and write them as PNG file.
+			/// </summary>
+			/// <param name="width">The width in pixels.</param>
+			/// <param name="height">The height in pixels.</param>
+			/// <param name="depth">The number of bits per sample, or per index for palette images.</param>
+			/// <param name="format">The color type.</param>
+			/// <param name="palette">The RGB entries of the palette, for palette images.</param>
+			/// <param name="transparency">The alpha of the entries of the palette, empty when they are all opaque.</param>
+			/// <param name="rows">The filtered rows, each preceded by its filter type.</param>
+			/// <returns>The PNG file.</returns>
+			std::vector<uint8_t> Write(uint32_t width, uint32_t height, uint8_t depth, PngFormat format, TiffWang::Tiff::ByteView palette, TiffWang::Tiff::ByteView transparency, TiffWang::Tiff::ByteView rows) const;
+	};
+}
+
+#endif
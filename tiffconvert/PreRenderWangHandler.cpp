@@ -2,7 +2,11 @@
 #include "Renderer.hpp"
 #include "Util.hpp"
 #include "Font.hpp"
+#include "FontCache.hpp"
+#include "DibImage.hpp"
 #include <iostream>
+#include <algorithm>
+#include <cmath>
 
 using namespace TiffConvert::Handlers;
 using namespace TiffConvert;
@@ -22,6 +26,24 @@ PreRenderWangHandler::PreRenderWangHandler(const TiffWang::Tiff::TiffDimensions&
 
 }
 
+/// <summary>
+/// Construct a new PreRenderWangHandler that burns the annotations onto an output that has been scaled from the 
+/// dimensions of the page. The geometry of the marks, their line sizes and font heights are transformed into the 
+/// space of the output, so that the marks are rasterized at the resolution of the output directly.
+/// </summary>
+/// <param name="dimensions">A reference to the dimensions of the current page.</param>
+/// <param name="hDc">The device context for rendering, created by <see cref="TiffConvert::Renderer"/>.</param>
+/// <param name="width">The width of the output in pixels.</param>
+/// <param name="height">The height of the output in pixels.</param>
+PreRenderWangHandler::PreRenderWangHandler(const TiffWang::Tiff::TiffDimensions& dimensions, const HDC hDc, uint32_t width, uint32_t height)
+	: m_Dimensions(dimensions), m_hDC(hDc) {
+
+	if (dimensions.Width != 0 && dimensions.Height != 0) {
+		m_ScaleX = static_cast<double>(width) / dimensions.Width;
+		m_ScaleY = static_cast<double>(height) / dimensions.Height;
+	}
+}
+
 /// <summary>
 /// A callback method which will be invoked when the <see cref="WangAnnotationReader"/> encounters a line mark.
 /// </summary>
@@ -32,7 +54,21 @@ PreRenderWangHandler::PreRenderWangHandler(const TiffWang::Tiff::TiffDimensions&
 /// <param name="highlight">Whether or not the highlight filter should be applied (only render on white).</param>
 /// <param name="transparent">Whether or not the transparent filter should be applied (don't render white).</param>
 void PreRenderWangHandler::RenderLine(const RECT& bounds, const std::vector<POINT>& points, const RGBQUAD& color, uint32_t size, bool highlight, bool transparent) {
-	Renderer::Line(Util::TranslatePoints(bounds, points), size, Util::ColorToLong(color, 255), highlight, transparent);
+	auto transformed = Transform(Util::TranslatePoints(bounds, points));
+	auto lineSize    = Transform(size);
+
+	if (m_BandHeight != 0 && !transformed.empty()) {
+		RECT extent = { transformed[0].x, transformed[0].y, transformed[0].x, transformed[0].y };
+		for (const auto& point : transformed) {
+			extent.top    = (std::min)(extent.top, point.y);
+			extent.bottom = (std::max)(extent.bottom, point.y);
+		}
+
+		if (!IsVisible(extent, lineSize))
+			return;
+	}
+
+	Renderer::Line(transformed, lineSize, Util::ColorToLong(color, 255), highlight, transparent);
 }
 
 /// <summary>
@@ -43,7 +79,9 @@ void PreRenderWangHandler::RenderLine(const RECT& bounds, const std::vector<POIN
 /// <param name="highlight">Whether or not the highlight filter should be applied (only render on white).</param>
 /// <param name="transparent">Whether or not the transparent filter should be applied (don't render white).</param>
 void PreRenderWangHandler::RenderRect(const RECT& bounds, const RGBQUAD& color, bool highlight, bool transparent) {
-	Renderer::FillRect(bounds, Util::ColorToLong(color, 255), 0, highlight, transparent);
+	auto transformed = Transform(bounds);
+	if (IsVisible(transformed, 0))
+		Renderer::FillRect(transformed, Util::ColorToLong(color, 255), 0, highlight, transparent);
 }
 
 /// <summary>
@@ -56,7 +94,11 @@ void PreRenderWangHandler::RenderRect(const RECT& bounds, const RGBQUAD& color,
 /// <param name="highlight">Whether or not the highlight filter should be applied (only render on white).</param>
 /// <param name="transparent">Whether or not the transparent filter should be applied (don't render white).</param>
 void PreRenderWangHandler::RenderBorderedRect(const RECT& bounds, const RGBQUAD& color, const RGBQUAD& borderColor, uint32_t lineSize, bool highlight, bool transparent) {
-	Renderer::FillAndStrokeRect(bounds, Util::ColorToLong(color, 255), Util::ColorToLong(borderColor, 255), lineSize, 0, highlight, transparent);
+	auto transformed = Transform(bounds);
+	auto size        = Transform(lineSize);
+
+	if (IsVisible(transformed, size))
+		Renderer::FillAndStrokeRect(transformed, Util::ColorToLong(color, 255), Util::ColorToLong(borderColor, 255), size, 0, highlight, transparent);
 }
 
 /// <summary>
@@ -68,7 +110,11 @@ void PreRenderWangHandler::RenderBorderedRect(const RECT& bounds, const RGBQUAD&
 /// <param name="highlight">Whether or not the highlight filter should be applied (only render on white).</param>
 /// <param name="transparent">Whether or not the transparent filter should be applied (don't render white).</param>
 void PreRenderWangHandler::RenderOutlinedRect(const RECT& bounds, const RGBQUAD& color, uint32_t lineSize, bool highlight, bool transparent) {
-	Renderer::StrokeRect(bounds, Util::ColorToLong(color, 255), lineSize, 0, highlight, transparent);
+	auto transformed = Transform(bounds);
+	auto size        = Transform(lineSize);
+
+	if (IsVisible(transformed, size))
+		Renderer::StrokeRect(transformed, Util::ColorToLong(color, 255), size, 0, highlight, transparent);
 }
 
 /// <summary>
@@ -82,22 +128,20 @@ void PreRenderWangHandler::RenderOutlinedRect(const RECT& bounds, const RGBQUAD&
 void PreRenderWangHandler::RenderText(const std::string& text, const RECT& bounds, const LOGFONTA& font, const OIAN_TEXTPRIVDATA& info, const RGBQUAD& color) {
 	// TODO: implement nCurrentOrientation with TextRotated
 
-	std::unique_ptr<Font> renderFont = nullptr;
+	// Lines of text may run past the bottom of their bounds, only text that starts below the band is skipped.
+	auto transformed = Transform(bounds);
+	if (m_BandHeight != 0 && transformed.top >= m_BandHeight)
+		return;
+
 	auto mutableFontInfo = font;
 
 	mutableFontInfo.lfHeight = CalculateFontHeight(mutableFontInfo, info);
 
-	try {
-		renderFont = std::make_unique<Font>(mutableFontInfo);
-	} catch (const std::exception&) {
-		try {
-			renderFont = std::make_unique<Font>("Arial", mutableFontInfo.lfHeight, Font::FlagsFromLogFont(mutableFontInfo));
-		} catch (const std::exception& ex) {
-			throw ex;
-		}
-	}
+	// The font is loaded once for all marks and pages, with Arial in place of faces that cannot be loaded.
+	auto renderFont = FontCache::Get(mutableFontInfo);
 
-	Renderer::Text(bounds, text, *renderFont.get(), color);
+	if (!Renderer::Text(transformed, text, *renderFont, color))
+		std::cout << "[WARN] a text mark with font '" << font.lfFaceName << "' could not be rendered.\n";
 }
 
 /// <summary>
@@ -111,22 +155,20 @@ void PreRenderWangHandler::RenderText(const std::string& text, const RECT& bound
 void PreRenderWangHandler::RenderText(const std::wstring& text, const RECT& bounds, const LOGFONTA& font, const OIAN_TEXTPRIVDATA& info, const RGBQUAD& color) {
 	// TODO: implement nCurrentOrientation with TextRotated
 
-	std::unique_ptr<Font> renderFont = nullptr;
+	// Lines of text may run past the bottom of their bounds, only text that starts below the band is skipped.
+	auto transformed = Transform(bounds);
+	if (m_BandHeight != 0 && transformed.top >= m_BandHeight)
+		return;
+
 	auto mutableFontInfo = font;
 
 	mutableFontInfo.lfHeight = CalculateFontHeight(mutableFontInfo, info);
 
-	try {
-		renderFont = std::make_unique<Font>(mutableFontInfo);
-	} catch (const std::exception&) {
-		try {
-			renderFont = std::make_unique<Font>("Arial", mutableFontInfo.lfHeight, Font::FlagsFromLogFont(mutableFontInfo));
-		} catch (const std::exception& ex) {
-			throw ex;
-		}
-	}
+	// The font is loaded once for all marks and pages, with Arial in place of faces that cannot be loaded.
+	auto renderFont = FontCache::Get(mutableFontInfo);
 
-	Renderer::Text(bounds, text, *renderFont.get(), color);
+	if (!Renderer::Text(transformed, text, *renderFont, color))
+		std::cout << "[WARN] a text mark with font '" << font.lfFaceName << "' could not be rendered.\n";
 }
 
 /// <summary>
@@ -165,6 +207,25 @@ void PreRenderWangHandler::RenderImageReference(const std::string& filename, con
 void PreRenderWangHandler::RenderImage(const std::string& filename, const RECT& bounds, const AN_NEW_ROTATE_STRUCT& rotation, const std::vector<uint8_t>& data, bool highlight, bool transparent) {
 	// filename is to be ignored, it's the name of the original file that was embedded.
 
+	auto transformed = Transform(bounds);
+	if (!IsVisible(transformed, 0))
+		return;
+
+	// The DIB is decoded natively in place and drawn in its orientation in one pass.
+	try {
+		DibImage dib(data);
+		if (Renderer::Image(transformed, dib, rotation.rotation, highlight, transparent))
+			return;
+	} catch (const std::runtime_error&) {
+		// Formats the native decoder does not support are decoded by libtiffconvert below.
+	}
+
+	// libtiffconvert cannot draw into a band, there is no point in decoding the image for it.
+	if (Renderer::IsBanded()) {
+		std::cout << "[WARN] the embedded image named '" << filename << "' could not be decoded natively and cannot be rendered into a band, image is not rendered.\n";
+		return;
+	}
+
 	std::shared_ptr<Image> image = nullptr;
 	try {
 		image = std::make_shared<Image>(data, true);
@@ -205,7 +266,8 @@ void PreRenderWangHandler::RenderImage(const std::string& filename, const RECT&
 		return;
 	}
 
-	Renderer::Image(bounds, image, highlight, transparent);
+	if (!Renderer::Image(transformed, image, highlight, transparent))
+		std::cout << "[WARN] the embedded image named '" << filename << "' could not be rendered.\n";
 }
 
 /// <summary>
@@ -220,10 +282,82 @@ uint32_t PreRenderWangHandler::CalculateFontHeight(const LOGFONTA& font, const O
 	auto scale		= static_cast<double>(info.uCreationScale);
 	auto lfHeight	= static_cast<double>(font.lfHeight);
 	auto tscale		= 72000.0 / dpiY; /* target scale, 72000 divided by vertical res of output */
-	auto tscalef	= tscale / scale; /* target scale factor */
+	auto tscalef	= tscale / scale * m_ScaleY; /* target scale factor, including the scale of the output */
 
 	// return the scaled vertical size of the font.
 	return static_cast<uint32_t>(lfHeight * tscalef);
 }
 
+/// <summary>
+/// Render the marks into a horizontal band of the output only, see <see cref="TiffConvert::Renderer::BeginBand"/>. 
+/// Marks are translated to the top of the band and marks that lie entirely outside of the band are skipped.
+/// </summary>
+/// <param name="top">The first row of the band in the output.</param>
+/// <param name="height">The number of rows in the band.</param>
+void PreRenderWangHandler::SetBand(uint32_t top, uint32_t height) noexcept {
+	m_BandTop    = static_cast<LONG>(top);
+	m_BandHeight = static_cast<LONG>(height);
+}
+
+/// <summary>
+/// Determine if a rectangle in the space of the band touches the band.
+/// </summary>
+/// <param name="bounds">The rectangle, transformed to the space of the band.</param>
+/// <param name="margin">The number of pixels the mark may extend beyond the rectangle, such as half its line size.</param>
+/// <returns>True when the mark has to be rendered, false when it lies outside of the band.</returns>
+bool PreRenderWangHandler::IsVisible(const RECT& bounds, uint32_t margin) const noexcept {
+	if (m_BandHeight == 0)
+		return true;
+
+	auto top    = static_cast<int64_t>((std::min)(bounds.top, bounds.bottom)) - margin;
+	auto bottom = static_cast<int64_t>((std::max)(bounds.top, bounds.bottom)) + margin;
+	return bottom >= 0 && top < m_BandHeight;
+}
+
+/// <summary>
+/// Transform a rectangle from the space of the page to the space of the output, or the band when rendering a band.
+/// </summary>
+/// <param name="bounds">The rectangle in page space.</param>
+/// <returns>The rectangle in output space.</returns>
+RECT PreRenderWangHandler::Transform(const RECT& bounds) const noexcept {
+	if (m_ScaleX == 1.0 && m_ScaleY == 1.0 && m_BandTop == 0)
+		return bounds;
+
+	RECT result;
+	result.left   = static_cast<LONG>(std::lround(bounds.left * m_ScaleX));
+	result.top    = static_cast<LONG>(std::lround(bounds.top * m_ScaleY)) - m_BandTop;
+	result.right  = static_cast<LONG>(std::lround(bounds.right * m_ScaleX));
+	result.bottom = static_cast<LONG>(std::lround(bounds.bottom * m_ScaleY)) - m_BandTop;
+	return result;
+}
+
+/// <summary>
+/// Transform points from the space of the page to the space of the output, or the band when rendering a band.
+/// </summary>
+/// <param name="points">The points in page space.</param>
+/// <returns>The points in output space.</returns>
+std::vector<POINT> PreRenderWangHandler::Transform(std::vector<POINT> points) const {
+	if (m_ScaleX == 1.0 && m_ScaleY == 1.0 && m_BandTop == 0)
+		return points;
+
+	for (auto& point : points) {
+		point.x = static_cast<LONG>(std::lround(point.x * m_ScaleX));
+		point.y = static_cast<LONG>(std::lround(point.y * m_ScaleY)) - m_BandTop;
+	}
+
+	return points;
+}
+
+/// <summary>
+/// Transform a line size from the space of the page to the space of the output, a visible line stays at least 1 pixel.
+/// </summary>
+/// <param name="size">The size in page space.</param>
+/// <returns>The size in output space.</returns>
+uint32_t PreRenderWangHandler::Transform(uint32_t size) const noexcept {
+	if (size == 0 || (m_ScaleX == 1.0 && m_ScaleY == 1.0))
+		return size;
+
+	return (std::max)(1u, static_cast<uint32_t>(std::lround(size * (m_ScaleX + m_ScaleY) / 2.0)));
+}
+
 #pragma warning ( pop )
\ No newline at end of file
@@ -18,6 +18,10 @@ namespace TiffConvert {
 			private:
 				const TiffWang::Tiff::TiffDimensions& m_Dimensions;
 				const HDC m_hDC;
+				double m_ScaleX = 1.0;	// The width of the output divided by the width of the page, marks are described in page space.
+				double m_ScaleY = 1.0;	// The height of the output divided by the height of the page.
+				LONG m_BandTop = 0;		// The first row of the band that is rendered to, in output space.
+				LONG m_BandHeight = 0;	// The number of rows in the band, 0 when the whole output is rendered to.
 
 			public:
 				/// <summary>
@@ -29,6 +33,17 @@ namespace TiffConvert {
 				/// <param name="hDc">The device context for rendering, created by <see cref="TiffConvert::Renderer"/>.</param>
 				PreRenderWangHandler(const TiffWang::Tiff::TiffDimensions& dimensions, const HDC hDc);
 
+				/// <summary>
+				/// Construct a new PreRenderWangHandler that burns the annotations onto an output that has been scaled from the 
+				/// dimensions of the page. The geometry of the marks, their line sizes and font heights are transformed into the 
+				/// space of the output, so that the marks are rasterized at the resolution of the output directly.
+				/// </summary>
+				/// <param name="dimensions">A reference to the dimensions of the current page.</param>
+				/// <param name="hDc">The device context for rendering, created by <see cref="TiffConvert::Renderer"/>.</param>
+				/// <param name="width">The width of the output in pixels.</param>
+				/// <param name="height">The height of the output in pixels.</param>
+				PreRenderWangHandler(const TiffWang::Tiff::TiffDimensions& dimensions, const HDC hDc, uint32_t width, uint32_t height);
+
 				/// <summary>
 				/// A callback method which will be invoked when the <see cref="WangAnnotationReader"/> encounters a line mark.
 				/// </summary>
@@ -129,6 +144,44 @@ namespace TiffConvert {
 				/// <param name="info">Scaling information.</param>
 				/// <returns>The translated font size, truncated (i.e. 43.75 becomes 43, required by libtiffconvert)</returns>
 				uint32_t CalculateFontHeight(const LOGFONTA& font, const OIAN_TEXTPRIVDATA& info);
+
+				/// <summary>
+				/// Render the marks into a horizontal band of the output only, see <see cref="TiffConvert::Renderer::BeginBand"/>. 
+				/// Marks are translated to the top of the band and marks that lie entirely outside of the band are skipped.
+				/// </summary>
+				/// <param name="top">The first row of the band in the output.</param>
+				/// <param name="height">The number of rows in the band.</param>
+				void SetBand(uint32_t top, uint32_t height) noexcept;
+
+			private:
+				/// <summary>
+				/// Determine if a rectangle in the space of the band touches the band.
+				/// </summary>
+				/// <param name="bounds">The rectangle, transformed to the space of the band.</param>
+				/// <param name="margin">The number of pixels the mark may extend beyond the rectangle, such as half its line size.</param>
+				/// <returns>True when the mark has to be rendered, false when it lies outside of the band.</returns>
+				bool IsVisible(const RECT& bounds, uint32_t margin) const noexcept;
+
+				/// <summary>
+				/// Transform a rectangle from the space of the page to the space of the output, or the band when rendering a band.
+				/// </summary>
+				/// <param name="bounds">The rectangle in page space.</param>
+				/// <returns>The rectangle in output space.</returns>
+				RECT Transform(const RECT& bounds) const noexcept;
+
+				/// <summary>
+				/// Transform points from the space of the page to the space of the output, or the band when rendering a band.
+				/// </summary>
+				/// <param name="points">The points in page space.</param>
+				/// <returns>The points in output space.</returns>
+				std::vector<POINT> Transform(std::vector<POINT> points) const;
+
+				/// <summary>
+				/// Transform a line size from the space of the page to the space of the output, a visible line stays at least 1 pixel.
+				/// </summary>
+				/// <param name="size">The size in page space.</param>
+				/// <returns>The size in output space.</returns>
+				uint32_t Transform(uint32_t size) const noexcept;
 		};
 
 	}
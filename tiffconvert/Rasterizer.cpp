@@ -0,0 +1,360 @@
+#include "Rasterizer.hpp"
+#include "SpanBlend.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <utility>
+
+using namespace TiffConvert;
+
+static constexpr double Pi = 3.14159265358979323846;
+
+/// <summary>
+/// Convert a color to a gray level, using the ITU-R BT.601 luma weights.
+/// </summary>
+/// <param name="r">The red component.</param>
+/// <param name="g">The green component.</param>
+/// <param name="b">The blue component.</param>
+/// <returns>The gray level.</returns>
+static inline uint8_t Luma(uint32_t r, uint32_t g, uint32_t b) noexcept {
+	return static_cast<uint8_t>((r * 299 + g * 587 + b * 114 + 500) / 1000);
+}
+
+/// <summary>
+/// Blend a single color component over another.
+/// </summary>
+/// <param name="top">The new component.</param>
+/// <param name="bottom">The existing component.</param>
+/// <param name="alpha">The opacity of the new component.</param>
+/// <returns>The blended component.</returns>
+static inline uint8_t Blend(uint32_t top, uint32_t bottom, uint32_t alpha) noexcept {
+	return static_cast<uint8_t>((top * alpha + bottom * (255 - alpha) + 127) / 255);
+}
+
+/// <summary>
+/// Set or clear a range of pixels in a bit-packed row.
+/// </summary>
+/// <param name="row">The bit-packed row.</param>
+/// <param name="start">The first pixel.</param>
+/// <param name="end">The pixel after the last pixel, greater than start.</param>
+/// <param name="ink">True to set the pixels (black), false to clear them (white).</param>
+static void FillBits(uint8_t* row, uint32_t start, uint32_t end, bool ink) noexcept {
+	auto first = start >> 3;
+	auto last  = (end - 1) >> 3;
+	auto head  = static_cast<uint8_t>(0xFF >> (start & 7));
+	auto tail  = static_cast<uint8_t>(0xFF << (7 - ((end - 1) & 7)));
+
+	if (first == last)
+		head &= tail;
+
+	row[first] = static_cast<uint8_t>(ink ? (row[first] | head) : (row[first] & ~head));
+	if (first == last)
+		return;
+
+	if (last > first + 1)
+		memset(row + first + 1, ink ? 0xFF : 0x00, last - first - 1);
+
+	row[last] = static_cast<uint8_t>(ink ? (row[last] | tail) : (row[last] & ~tail));
+}
+
+/// <summary>
+/// Remove all polygons.
+/// </summary>
+void Rasterizer::Clear() noexcept {
+	m_Edges.clear();
+}
+
+/// <summary>
+/// Add a closed polygon.
+/// </summary>
+/// <param name="points">The vertices of the polygon.</param>
+void Rasterizer::AddPolygon(const std::vector<Point>& points) {
+	if (points.size() < 3)
+		return;
+
+	for (size_t i = 0; i < points.size(); ++i)
+		AddEdge(points[i], points[(i + 1) % points.size()]);
+}
+
+/// <summary>
+/// Add the outline of a stroked polyline with round joins and caps: a rectangle for every segment and a disc for 
+/// every vertex, all with the same orientation so that they are filled as one shape.
+/// </summary>
+/// <param name="points">The vertices of the polyline.</param>
+/// <param name="halfWidth">Half the width of the stroke.</param>
+void Rasterizer::AddStroke(const std::vector<POINT>& points, double halfWidth) {
+	if (points.empty() || halfWidth <= 0.0)
+		return;
+
+	// Use enough segments for the discs that they deviate less than a quarter pixel from a true circle.
+	auto segments = 8;
+	if (halfWidth > 0.25)
+		segments = std::clamp(static_cast<int>(std::ceil(Pi / std::acos(1.0 - 0.25 / halfWidth))), 8, 128);
+
+	std::vector<Point> disc(static_cast<size_t>(segments));
+	for (auto i = 0; i < segments; ++i) {
+		// Clockwise, like the segment rectangles below.
+		auto angle = -2.0 * Pi * i / segments;
+		disc[static_cast<size_t>(i)] = { halfWidth * std::cos(angle), halfWidth * std::sin(angle) };
+	}
+
+	std::vector<Point> polygon;
+	polygon.reserve(disc.size());
+
+	for (size_t i = 0; i < points.size(); ++i) {
+		auto& a = points[i];
+
+		if (i == 0 || a.x != points[i - 1].x || a.y != points[i - 1].y) {
+			polygon.clear();
+			for (auto& offset : disc)
+				polygon.push_back({ a.x + offset.X, a.y + offset.Y });
+
+			AddPolygon(polygon);
+		}
+
+		if (i + 1 == points.size())
+			break;
+
+		auto& b      = points[i + 1];
+		auto  dx     = static_cast<double>(b.x) - a.x;
+		auto  dy     = static_cast<double>(b.y) - a.y;
+		auto  length = std::hypot(dx, dy);
+		if (length == 0.0)
+			continue;
+
+		auto nx = -dy / length * halfWidth;
+		auto ny =  dx / length * halfWidth;
+
+		AddPolygon({
+			{ a.x + nx, a.y + ny },
+			{ b.x + nx, b.y + ny },
+			{ b.x - nx, b.y - ny },
+			{ a.x - nx, a.y - ny }
+		});
+	}
+}
+
+/// <summary>
+/// Add a filled rectangle, covering the same pixels as a PureBasic Box() of the same bounds.
+/// </summary>
+/// <param name="bounds">The bounds, right and bottom are exclusive.</param>
+void Rasterizer::AddRectangle(const RECT& bounds) {
+	auto left   = bounds.left - 0.5;
+	auto top    = bounds.top - 0.5;
+	auto right  = bounds.right - 0.5;
+	auto bottom = bounds.bottom - 0.5;
+
+	// Clockwise, like the shapes of a stroke.
+	AddPolygon({ { left, top }, { left, bottom }, { right, bottom }, { right, top } });
+}
+
+/// <summary>
+/// Add the outline of a rectangle, covering the same pixels as nested PureBasic outlined Box() calls that each shrink 
+/// the bounds by one pixel on every side.
+/// </summary>
+/// <param name="bounds">The outer bounds, right and bottom are exclusive.</param>
+/// <param name="thickness">The thickness of the outline in pixels.</param>
+void Rasterizer::AddFrame(const RECT& bounds, uint32_t thickness) {
+	if (thickness == 0)
+		return;
+
+	AddRectangle(bounds);
+
+	// An outline that is thicker than half the rectangle covers all of it.
+	auto inset = static_cast<LONG>(thickness);
+	if (bounds.right - bounds.left <= 2 * inset || bounds.bottom - bounds.top <= 2 * inset)
+		return;
+
+	// The hole runs counter-clockwise, so that its winding cancels out the outer rectangle.
+	auto left   = bounds.left + inset - 0.5;
+	auto top    = bounds.top + inset - 0.5;
+	auto right  = bounds.right - inset - 0.5;
+	auto bottom = bounds.bottom - inset - 0.5;
+
+	AddPolygon({ { left, top }, { right, top }, { right, bottom }, { left, bottom } });
+}
+
+/// <summary>
+/// Fill all polygons onto a target in a certain color.
+/// </summary>
+/// <param name="target">The target pixels.</param>
+/// <param name="color">The RGBA color (red in the least significant byte), alpha below 255 is blended.</param>
+/// <param name="highlight">Only paint pixels that are white, see <see cref="Renderer::HighlightFilter"/>.</param>
+/// <param name="transparent">Don't paint when the color is white, see <see cref="Renderer::TransparentFilter"/>.</param>
+void Rasterizer::Fill(const RasterTarget& target, uint32_t color, bool highlight, bool transparent) const {
+	auto r = color & 0xFF;
+	auto g = (color >> 8) & 0xFF;
+	auto b = (color >> 16) & 0xFF;
+	auto a = (color >> 24) & 0xFF;
+
+	if (target.Bits == nullptr || a == 0 || (transparent && r == 255 && g == 255 && b == 255))
+		return;
+
+	auto row = [&target](int64_t y) { return target.Bits + y * target.Pitch; };
+
+	switch (target.BitsPerPixel) {
+		case 1: {
+			// Bilevel targets have no partial opacity, a color is either ink or paper. Highlighting only paints 
+			// onto paper, which makes painting paper a no-op and painting ink the same as without highlighting.
+			auto ink = Luma(r, g, b) < 128;
+			if (highlight && !ink)
+				return;
+
+			Scan(target.Width, target.Height, [&](int64_t y, uint32_t x0, uint32_t x1) {
+				FillBits(row(y), x0, x1, ink);
+			});
+			break;
+		}
+		case 8: {
+			auto gray = Luma(r, g, b);
+
+			Scan(target.Width, target.Height, [&](int64_t y, uint32_t x0, uint32_t x1) {
+				auto pixels = row(y);
+				if (a == 255 && !highlight) {
+					memset(pixels + x0, gray, x1 - x0);
+					return;
+				}
+
+				for (auto x = x0; x < x1; ++x) {
+					if (highlight && pixels[x] != 255)
+						continue;
+
+					pixels[x] = Blend(gray, pixels[x], a);
+				}
+			});
+			break;
+		}
+		case 24:
+		case 32: {
+			auto bytes = target.BitsPerPixel / 8;
+			auto pixel = SpanBlend::Pack(r, g, b, a, target.Bgr);
+
+			Scan(target.Width, target.Height, [&](int64_t y, uint32_t x0, uint32_t x1) {
+				SpanBlend::Fill(row(y) + static_cast<size_t>(x0) * bytes, x1 - x0, bytes, pixel, highlight);
+			});
+			break;
+		}
+	}
+}
+
+/// <summary>
+/// Stroke a polyline onto a target, the stroke covers every pixel within lineSize / 2 pixels of the polyline. 
+/// </summary>
+/// <param name="target">The target pixels.</param>
+/// <param name="points">The vertices of the polyline, at least 2.</param>
+/// <param name="lineSize">The thickness of the line.</param>
+/// <param name="color">The RGBA color (red in the least significant byte).</param>
+/// <param name="highlight">Only paint pixels that are white.</param>
+/// <param name="transparent">Don't paint when the color is white.</param>
+/// <returns>True when successful, false otherwise.</returns>
+bool Rasterizer::StrokePolyline(const RasterTarget& target, const std::vector<POINT>& points, uint32_t lineSize, uint32_t color, bool highlight, bool transparent) {
+	if (points.size() <= 1)
+		return false;
+
+	switch (target.BitsPerPixel) {
+		case 1:
+		case 8:
+		case 24:
+		case 32:
+			break;
+		default:
+			return false;
+	}
+
+	// The stroke matches a circle of radius lineSize / 2 moved along the line. The extra half pixel puts the outline 
+	// between pixel centers, so that a horizontal line is exactly 2 * (lineSize / 2) + 1 pixels thick.
+	Rasterizer rasterizer;
+	rasterizer.AddStroke(points, (lineSize / 2) + 0.5);
+	rasterizer.Fill(target, color, highlight, transparent);
+	return true;
+}
+
+/// <summary>
+/// Add a single polygon edge.
+/// </summary>
+/// <param name="a">The start of the edge.</param>
+/// <param name="b">The end of the edge.</param>
+void Rasterizer::AddEdge(const Point& a, const Point& b) {
+	// Horizontal edges never cross a row of pixel centers.
+	if (a.Y == b.Y)
+		return;
+
+	auto& top    = (a.Y < b.Y) ? a : b;
+	auto& bottom = (a.Y < b.Y) ? b : a;
+
+	m_Edges.push_back({ top.Y, bottom.Y, top.X, (bottom.X - top.X) / (bottom.Y - top.Y), (a.Y < b.Y) ? 1 : -1 });
+}
+
+/// <summary>
+/// Walk the rows covered by the polygons and invoke a function for every span of pixels inside them.
+/// </summary>
+/// <typeparam name="TSpan">A function taking (y, x0, x1), the span covers the pixels x0 up to but not including x1.</typeparam>
+/// <param name="width">The width of the target, spans are clipped to it.</param>
+/// <param name="height">The height of the target, rows are clipped to it.</param>
+/// <param name="span">The span function.</param>
+template <typename TSpan>
+void Rasterizer::Scan(uint32_t width, uint32_t height, TSpan span) const {
+	if (m_Edges.empty() || width == 0 || height == 0)
+		return;
+
+	// Edges are activated in order of the first row they cover, and deactivated after the last.
+	std::vector<const Edge*> pending;
+	pending.reserve(m_Edges.size());
+	for (auto& edge : m_Edges)
+		pending.push_back(&edge);
+
+	std::sort(pending.begin(), pending.end(), [](const Edge* a, const Edge* b) { return a->Top < b->Top; });
+
+	std::vector<const Edge*> active;
+	std::vector<std::pair<double, int>> crossings;
+	size_t next = 0;
+
+	// A row of pixel centers y is covered by an edge when Top <= y < Bottom.
+	auto y = (std::max)(static_cast<int64_t>(0), static_cast<int64_t>(std::ceil(pending.front()->Top)));
+
+	for (; y < static_cast<int64_t>(height); ++y) {
+		auto row = static_cast<double>(y);
+
+		while (next < pending.size() && pending[next]->Top <= row)
+			active.push_back(pending[next++]);
+
+		active.erase(std::remove_if(active.begin(), active.end(), [row](const Edge* edge) { return edge->Bottom <= row; }), active.end());
+
+		if (active.empty()) {
+			if (next == pending.size())
+				break;
+
+			// Skip the rows until the next edge.
+			y = static_cast<int64_t>(std::ceil(pending[next]->Top)) - 1;
+			continue;
+		}
+
+		crossings.clear();
+		for (auto edge : active)
+			crossings.emplace_back(edge->X + (row - edge->Top) * edge->Slope, edge->Winding);
+
+		std::sort(crossings.begin(), crossings.end());
+
+		// Pixel x is inside a span [start, end) when start <= x < end, which is ceil(start) <= x < ceil(end).
+		auto winding = 0;
+		auto start   = 0.0;
+
+		for (auto& crossing : crossings) {
+			if (winding == 0)
+				start = crossing.first;
+
+			winding += crossing.second;
+			if (winding != 0)
+				continue;
+
+			auto x0 = std::ceil(start);
+			auto x1 = (std::min)(std::ceil(crossing.first), static_cast<double>(width));
+			if (x0 < 0.0)
+				x0 = 0.0;
+
+			if (x0 < x1)
+				span(y, static_cast<uint32_t>(x0), static_cast<uint32_t>(x1));
+		}
+	}
+}
@@ -0,0 +1,129 @@
+#pragma once
+
+#ifndef libtiffconvert_rasterizer_h
+#define libtiffconvert_rasterizer_h
+
+#include "libtiffconvert.h"
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+namespace TiffConvert {
+	/// <summary>
+	/// RasterTarget describes a block of pixels that the <see cref="Rasterizer"/> draws onto.
+	/// </summary>
+	struct RasterTarget {
+		uint8_t*	Bits         = nullptr;	// The first byte of the top row.
+		ptrdiff_t	Pitch        = 0;		// The number of bytes from one row to the next, negative for bottom-up buffers.
+		uint32_t	Width        = 0;		// The width in pixels.
+		uint32_t	Height       = 0;		// The height in pixels.
+		uint32_t	BitsPerPixel = 0;		// 1 (bit-packed, msb first, a set bit is black), 8 (gray), 24 or 32.
+		bool		Bgr          = true;	// Whether 24 and 32-bit pixels are stored blue first.
+	};
+
+	/// <summary>
+	/// Rasterizer is a native scanline polygon filler. Polygons are collected as edges and filled with the nonzero winding 
+	/// rule in a single pass over the rows they cover, so overlapping polygons with the same orientation are filled as their 
+	/// union and every pixel is painted at most once. A pixel is inside when its center is, there is no anti-aliasing: ink 
+	/// drawn onto a bilevel page stays black and white, which keeps the page eligible to be stored bit-packed. Spans of 24 
+	/// and 32-bit pixels are painted by the vectorized <see cref="SpanBlend"/> kernels.
+	/// </summary>
+	class Rasterizer {
+		private:
+			/// <summary>
+			/// A non-horizontal polygon edge, stored top to bottom.
+			/// </summary>
+			struct Edge {
+				double	Top;		// The y coordinate of the top end.
+				double	Bottom;		// The y coordinate of the bottom end.
+				double	X;			// The x coordinate of the top end.
+				double	Slope;		// The change in x per unit of y.
+				int		Winding;	// +1 for edges that point down, -1 for edges that point up.
+			};
+
+			std::vector<Edge>	m_Edges;
+
+		public:
+			/// <summary>
+			/// A point with sub-pixel precision, integer coordinates are pixel centers.
+			/// </summary>
+			struct Point {
+				double X;
+				double Y;
+			};
+
+			/// <summary>
+			/// Remove all polygons.
+			/// </summary>
+			void Clear() noexcept;
+
+			/// <summary>
+			/// Add a closed polygon.
+			/// </summary>
+			/// <param name="points">The vertices of the polygon.</param>
+			void AddPolygon(const std::vector<Point>& points);
+
+			/// <summary>
+			/// Add the outline of a stroked polyline with round joins and caps: a rectangle for every segment and a disc for 
+			/// every vertex, all with the same orientation so that they are filled as one shape.
+			/// </summary>
+			/// <param name="points">The vertices of the polyline.</param>
+			/// <param name="halfWidth">Half the width of the stroke.</param>
+			void AddStroke(const std::vector<POINT>& points, double halfWidth);
+
+			/// <summary>
+			/// Add a filled rectangle, covering the same pixels as a PureBasic Box() of the same bounds.
+			/// </summary>
+			/// <param name="bounds">The bounds, right and bottom are exclusive.</param>
+			void AddRectangle(const RECT& bounds);
+
+			/// <summary>
+			/// Add the outline of a rectangle, covering the same pixels as nested PureBasic outlined Box() calls that each shrink 
+			/// the bounds by one pixel on every side.
+			/// </summary>
+			/// <param name="bounds">The outer bounds, right and bottom are exclusive.</param>
+			/// <param name="thickness">The thickness of the outline in pixels.</param>
+			void AddFrame(const RECT& bounds, uint32_t thickness);
+
+			/// <summary>
+			/// Fill all polygons onto a target in a certain color.
+			/// </summary>
+			/// <param name="target">The target pixels.</param>
+			/// <param name="color">The RGBA color (red in the least significant byte), alpha below 255 is blended.</param>
+			/// <param name="highlight">Only paint pixels that are white, see <see cref="Renderer::HighlightFilter"/>.</param>
+			/// <param name="transparent">Don't paint when the color is white, see <see cref="Renderer::TransparentFilter"/>.</param>
+			void Fill(const RasterTarget& target, uint32_t color, bool highlight = false, bool transparent = false) const;
+
+			/// <summary>
+			/// Stroke a polyline onto a target, the stroke covers every pixel within lineSize / 2 pixels of the polyline. 
+			/// </summary>
+			/// <param name="target">The target pixels.</param>
+			/// <param name="points">The vertices of the polyline, at least 2.</param>
+			/// <param name="lineSize">The thickness of the line.</param>
+			/// <param name="color">The RGBA color (red in the least significant byte).</param>
+			/// <param name="highlight">Only paint pixels that are white.</param>
+			/// <param name="transparent">Don't paint when the color is white.</param>
+			/// <returns>True when successful, false otherwise.</returns>
+			static bool StrokePolyline(const RasterTarget& target, const std::vector<POINT>& points, uint32_t lineSize, uint32_t color, bool highlight = false, bool transparent = false);
+
+		private:
+			/// <summary>
+			/// Add a single polygon edge.
+			/// </summary>
+			/// <param name="a">The start of the edge.</param>
+			/// <param name="b">The end of the edge.</param>
+			void AddEdge(const Point& a, const Point& b);
+
+			/// <summary>
+			/// Walk the rows covered by the polygons and invoke a function for every span of pixels inside them.
+			/// </summary>
+			/// <typeparam name="TSpan">A function taking (y, x0, x1), the span covers the pixels x0 up to but not including x1.</typeparam>
+			/// <param name="width">The width of the target, spans are clipped to it.</param>
+			/// <param name="height">The height of the target, rows are clipped to it.</param>
+			/// <param name="span">The span function.</param>
+			template <typename TSpan>
+			void Scan(uint32_t width, uint32_t height, TSpan span) const;
+	};
+}
+
+#endif
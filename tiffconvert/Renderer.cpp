@@ -1,8 +1,12 @@
 #include "Renderer.hpp"
 #include "Util.hpp"
+#include "SpanBlend.hpp"
+#include <algorithm>
 
 using namespace TiffConvert;
 
+thread_local RasterTarget Renderer::s_Band;
+
 #pragma warning ( push )
 #pragma warning ( disable: 4100 ) // unreferenced formal parameter, filters are callback functions of which we don't use the x and y parameters
 
@@ -71,7 +75,8 @@ renderer_filter Renderer::GetHighlightFilter(bool highlight, bool transparent) {
 }
 
 /// <summary>
-/// Render a line between all the specified points, with a specific thickness and color.
+/// Render a line between all the specified points, with a specific thickness and color. The line is stroked with round
+/// joins and caps by the native <see cref="Rasterizer"/>.
 /// </summary>
 /// <param name="points">The list of points to draw a line in between.</param>
 /// <param name="lineSize">The thickness of the line.</param>
@@ -80,6 +85,17 @@ renderer_filter Renderer::GetHighlightFilter(bool highlight, bool transparent) {
 /// <param name="transparent">Whether transparency masking is applied.</param>
 /// <returns>True when successful, false otherwise.</returns>
 bool Renderer::Line(const std::vector<POINT> points, uint32_t lineSize, uint32_t color, bool highlight, bool transparent) {
+	if (points.size() <= 1)
+		return false;
+
+	// Rasterize the stroke natively straight into the output, unless the output has a pixel format the rasterizer does not support.
+	RasterTarget target;
+	if (GetTarget(target) && Rasterizer::StrokePolyline(target, points, lineSize, color, highlight, transparent))
+		return true;
+
+	if (IsBanded())
+		return false;
+
 	return renderer_line(&points[0], static_cast<uint32_t>(points.size()), lineSize, color, GetHighlightFilter(highlight, transparent));
 }
 
@@ -105,6 +121,9 @@ bool Renderer::Line(const std::vector<POINT> points, uint32_t lineSize, const RG
 /// <param name="transparent">Whether transparency masking is applied.</param>
 /// <returns>True when successful, false otherwise.</returns>
 bool Renderer::Line(const std::vector<POINT> points, uint32_t color, bool highlight, bool transparent) {
+	if (IsBanded())
+		return false;
+
 	return renderer_single_line(&points[0], static_cast<uint32_t>(points.size()), color, GetHighlightFilter(highlight, transparent));
 }
 
@@ -130,6 +149,17 @@ bool Renderer::Line(const std::vector<POINT> points, const RGBQUAD& color, bool
 /// <param name="transparent">Whether transparency masking is applied.</param>
 /// <returns>True when successful, false otherwise.</returns>
 bool Renderer::FillRect(const RECT& rectangle, uint32_t color, uint32_t cornerRadius, bool highlight, bool transparent) {
+	RasterTarget target;
+	if (cornerRadius == 0 && GetTarget(target)) {
+		Rasterizer rasterizer;
+		rasterizer.AddRectangle(rectangle);
+		rasterizer.Fill(target, color, highlight, transparent);
+		return true;
+	}
+
+	if (IsBanded())
+		return false;
+
 	return renderer_rect(&rectangle, color, 0, true, false, cornerRadius, 0, GetHighlightFilter(highlight, transparent));
 }
 
@@ -157,6 +187,17 @@ bool Renderer::FillRect(const RECT& rectangle, const RGBQUAD& color, uint32_t co
 /// <param name="transparent">Whether transparency masking is applied.</param>
 /// <returns>True when successful, false otherwise.</returns>
 bool Renderer::StrokeRect(const RECT& rectangle, uint32_t color, uint32_t strokeSize, uint32_t cornerRadius, bool highlight, bool transparent) {
+	RasterTarget target;
+	if (cornerRadius == 0 && GetTarget(target)) {
+		Rasterizer rasterizer;
+		rasterizer.AddFrame(rectangle, strokeSize);
+		rasterizer.Fill(target, color, highlight, transparent);
+		return true;
+	}
+
+	if (IsBanded())
+		return false;
+
 	return renderer_rect(&rectangle, 0, color, false, true, cornerRadius, strokeSize, GetHighlightFilter(highlight, transparent));
 }
 
@@ -186,6 +227,12 @@ bool Renderer::StrokeRect(const RECT& rectangle, const RGBQUAD& color, uint32_t
 /// <param name="transparent">Whether transparency masking is applied.</param>
 /// <returns>True when successful, false otherwise.</returns>
 bool Renderer::FillAndStrokeRect(const RECT& rectangle, uint32_t fillColor, uint32_t strokeColor, uint32_t strokeSize, uint32_t cornerRadius, bool highlight, bool transparent) {
+	if (cornerRadius == 0)
+		return FillRect(rectangle, fillColor, 0, highlight, transparent) && StrokeRect(rectangle, strokeColor, strokeSize, 0, highlight, transparent);
+
+	if (IsBanded())
+		return false;
+
 	return renderer_rect(&rectangle, fillColor, strokeColor, true, true, cornerRadius, strokeSize, GetHighlightFilter(highlight, transparent));
 }
 
@@ -215,6 +262,13 @@ bool Renderer::FillAndStrokeRect(const RECT& rectangle, const RGBQUAD& fillColor
 /// <param name="transparent">Whether transparency masking is applied.</param>
 /// <returns>True when successful, false otherwise.</returns>
 bool Renderer::Text(const RECT& bounds, const std::string& text, const Font& font, uint32_t color, bool highlight, bool transparent) {
+	RasterTarget target;
+	if (GetTarget(target))
+		return Text(bounds, Util::ToWideChar(text), font, color, highlight, transparent);
+
+	if (IsBanded())
+		return false;
+
 	return renderer_text_a(&bounds, text.c_str(), font.get(), color, GetHighlightFilter(highlight, transparent));
 }
 
@@ -229,6 +283,54 @@ bool Renderer::Text(const RECT& bounds, const std::string& text, const Font& fon
 /// <param name="transparent">Whether transparency masking is applied.</param>
 /// <returns>True when successful, false otherwise.</returns>
 bool Renderer::Text(const RECT& bounds, const std::wstring& text, const Font& font, uint32_t color, bool highlight, bool transparent) {
+	RasterTarget target;
+	if (GetTarget(target) && (target.BitsPerPixel == 24 || target.BitsPerPixel == 32)) {
+		auto r = color & 0xFF;
+		auto g = (color >> 8) & 0xFF;
+		auto b = (color >> 16) & 0xFF;
+		auto a = (color >> 24) & 0xFF;
+
+		if (a == 0 || (transparent && r == 255 && g == 255 && b == 255))
+			return true;
+
+		// Every line is painted from a cached coverage mask, all masks are collected first so that nothing is painted 
+		// when one of the lines cannot be rasterized and the text has to be rendered by libtiffconvert instead.
+		std::vector<std::shared_ptr<const GlyphCache::TextMask>> masks;
+		size_t start = 0;
+		auto complete = true;
+
+		while (complete) {
+			auto end  = text.find(L'\n', start);
+			auto line = text.substr(start, (end == std::wstring::npos) ? std::wstring::npos : end - start);
+			if (!line.empty() && line.back() == L'\r')
+				line.pop_back();
+
+			auto mask = GlyphCache::Get(font, line);
+			complete  = (mask != nullptr);
+			masks.push_back(std::move(mask));
+
+			if (end == std::wstring::npos)
+				break;
+
+			start = end + 1;
+		}
+
+		if (complete) {
+			auto pixel = SpanBlend::Pack(r, g, b, a, target.Bgr);
+			int64_t y  = bounds.top;
+
+			for (const auto& mask : masks) {
+				Blit(target, *mask, static_cast<int64_t>(bounds.left) + mask->OriginX, y, pixel, highlight);
+				y += mask->LineHeight;
+			}
+
+			return true;
+		}
+	}
+
+	if (IsBanded())
+		return false;
+
 	return renderer_text_w(&bounds, text.c_str(), font.get(), color, GetHighlightFilter(highlight, transparent));
 }
 
@@ -269,6 +371,9 @@ bool Renderer::Text(const RECT& bounds, const std::wstring& text, const Font& fo
 /// <param name="transparent">Whether transparency masking is applied.</param>
 /// <returns>True when successful, false otherwise.</returns>
 bool Renderer::Image(const RECT& bounds, std::shared_ptr<const TiffConvert::Image> image, bool highlight, bool transparent) {
+	if (IsBanded())
+		return false;
+
 	return renderer_image(&bounds, image->get(), GetHighlightFilter(highlight, transparent));
 }
 
@@ -282,5 +387,161 @@ bool Renderer::Image(const RECT& bounds, std::shared_ptr<const TiffConvert::Imag
 /// <param name="transparent">Whether transparency masking is applied.</param>
 /// <returns>True when successful, false otherwise.</returns>
 bool Renderer::Image(const RECT& bounds, std::shared_ptr<const TiffConvert::Image> image, uint8_t alpha, bool highlight, bool transparent) {
+	if (IsBanded())
+		return false;
+
 	return renderer_image_alpha(&bounds, image->get(), alpha, GetHighlightFilter(highlight, transparent));
+}
+
+/// <summary>
+/// Render an embedded DIB image onto the output, rotated and/or mirrored and scaled to its bounds in a single pass.
+/// </summary>
+/// <param name="bounds">The image rectangle, after rotation.</param>
+/// <param name="image">The image to render.</param>
+/// <param name="rotation">The orientation of the image.</param>
+/// <param name="highlight">Whether highlighting should be applied.</param>
+/// <param name="transparent">Whether transparency masking is applied.</param>
+/// <returns>True when successful, false when the output cannot be drawn onto natively.</returns>
+bool Renderer::Image(const RECT& bounds, const DibImage& image, AN_ROTATE_TYPE rotation, bool highlight, bool transparent) {
+	RasterTarget target;
+	return GetTarget(target) && image.Draw(target, bounds, rotation, highlight, transparent);
+}
+
+/// <summary>
+/// Invert the colors of the whole output, the alpha channel is kept.
+/// </summary>
+/// <returns>True when successful, false when the output cannot be inverted natively.</returns>
+bool Renderer::Invert() {
+	RasterTarget target;
+	if (!GetTarget(target) || (target.BitsPerPixel != 24 && target.BitsPerPixel != 32))
+		return false;
+
+	for (uint32_t y = 0; y < target.Height; ++y)
+		SpanBlend::Invert(target.Bits + static_cast<ptrdiff_t>(y) * target.Pitch, target.Width, target.BitsPerPixel / 8);
+
+	return true;
+}
+
+/// <summary>
+/// Resample the whole output into a new top-down buffer of the same pixel format.
+/// </summary>
+/// <param name="resampler">The resampler, for the dimensions of the output.</param>
+/// <param name="pixels">The buffer that receives the resampled pixels.</param>
+/// <param name="resampled">Receives the description of the resampled pixels in <paramref name="pixels"/>.</param>
+/// <param name="threads">The number of threads to resample with.</param>
+/// <returns>True when successful, false when the output cannot be resampled natively.</returns>
+/// <exception cref="std::invalid_argument">When the output does not match the dimensions of the resampler.</exception>
+bool Renderer::Resample(const Resampler& resampler, std::vector<uint8_t>& pixels, renderer_target& resampled, uint32_t threads) {
+	RasterTarget source;
+	if (!GetTarget(source) || (source.BitsPerPixel != 24 && source.BitsPerPixel != 32))
+		return false;
+
+	RasterTarget destination;
+	destination.Width        = resampler.GetWidth();
+	destination.Height       = resampler.GetHeight();
+	destination.BitsPerPixel = source.BitsPerPixel;
+	destination.Bgr          = source.Bgr;
+	destination.Pitch        = static_cast<ptrdiff_t>(destination.Width) * (source.BitsPerPixel / 8);
+
+	pixels.assign(static_cast<size_t>(destination.Pitch) * destination.Height, 0);
+	destination.Bits = pixels.data();
+
+	resampler.Resample(source, destination, threads);
+
+	resampled.Bits         = destination.Bits;
+	resampled.Pitch        = destination.Pitch;
+	resampled.Width        = destination.Width;
+	resampled.Height       = destination.Height;
+	resampled.BitsPerPixel = destination.BitsPerPixel;
+	resampled.Bgr          = destination.Bgr;
+	return true;
+}
+
+/// <summary>
+/// Encode the whole output as PNG.
+/// </summary>
+/// <param name="encoder">The encoder.</param>
+/// <param name="png">The buffer that receives the PNG file.</param>
+/// <returns>True when successful, false when the output cannot be encoded natively.</returns>
+bool Renderer::EncodePng(const PngEncoder& encoder, std::vector<uint8_t>& png) {
+	RasterTarget target;
+	if (!GetTarget(target) || target.Width == 0 || target.Height == 0 || (target.BitsPerPixel != 8 && target.BitsPerPixel != 24 && target.BitsPerPixel != 32))
+		return false;
+
+	png = encoder.Encode(target);
+	return true;
+}
+
+/// <summary>
+/// Render to a band of a page instead of the output of libtiffconvert, until <see cref="EndBand"/> is called on the
+/// same thread. Coordinates are relative to the top of the band. Everything that cannot be drawn natively is not drawn
+/// and reports failure, as the libtiffconvert drawing functions cannot draw onto a band.
+/// </summary>
+/// <param name="band">The pixels of the band, which must remain valid until <see cref="EndBand"/> is called.</param>
+void Renderer::BeginBand(const RasterTarget& band) noexcept {
+	s_Band = band;
+}
+
+/// <summary>
+/// Stop rendering to the band that was set with <see cref="BeginBand"/>.
+/// </summary>
+void Renderer::EndBand() noexcept {
+	s_Band = RasterTarget();
+}
+
+/// <summary>
+/// Determine if a band is rendered to on this thread, in which case the libtiffconvert drawing functions cannot be used.
+/// </summary>
+/// <returns>True when a band is rendered to, false otherwise.</returns>
+bool Renderer::IsBanded() noexcept {
+	return s_Band.Bits != nullptr;
+}
+
+/// <summary>
+/// Get the pixels of the output that is currently rendered to, so that they can be drawn onto natively.
+/// </summary>
+/// <param name="target">The target that receives the description of the output.</param>
+/// <returns>True when the output can be drawn onto natively, false when the libtiffconvert drawing functions have to be used.</returns>
+bool Renderer::GetTarget(RasterTarget& target) noexcept {
+	if (IsBanded()) {
+		target = s_Band;
+		return true;
+	}
+
+	renderer_target output;
+	if (!renderer_get_target(&output))
+		return false;
+
+	target.Bits         = output.Bits;
+	target.Pitch        = output.Pitch;
+	target.Width        = output.Width;
+	target.Height       = output.Height;
+	target.BitsPerPixel = output.BitsPerPixel;
+	target.Bgr          = output.Bgr != 0;
+	return true;
+}
+
+/// <summary>
+/// Paint a text mask onto the output in a single color, the mask is clipped to the output.
+/// </summary>
+/// <param name="target">The output.</param>
+/// <param name="mask">The text mask.</param>
+/// <param name="x">The column of the text on the output.</param>
+/// <param name="y">The row of the top of the text on the output.</param>
+/// <param name="pixel">The color as stored in memory, see <see cref="SpanBlend::Pack"/>.</param>
+/// <param name="highlight">Only paint pixels that are white.</param>
+void Renderer::Blit(const RasterTarget& target, const GlyphCache::TextMask& mask, int64_t x, int64_t y, uint32_t pixel, bool highlight) noexcept {
+	auto x0 = (std::max)(x, int64_t(0));
+	auto x1 = (std::min)(x + mask.Width, static_cast<int64_t>(target.Width));
+	auto y0 = (std::max)(y, int64_t(0));
+	auto y1 = (std::min)(y + mask.Height, static_cast<int64_t>(target.Height));
+	if (x0 >= x1 || y0 >= y1)
+		return;
+
+	auto bytes = target.BitsPerPixel / 8;
+	for (auto row = y0; row < y1; ++row) {
+		auto pixels   = target.Bits + row * target.Pitch + x0 * bytes;
+		auto coverage = mask.Coverage.data() + (row - y) * mask.Width + (x0 - x);
+		SpanBlend::FillMasked(pixels, coverage, static_cast<uint32_t>(x1 - x0), bytes, pixel, highlight);
+	}
 }
\ No newline at end of file
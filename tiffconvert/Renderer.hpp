@@ -6,14 +6,23 @@
 #include "libtiffconvert.h"
 #include "Font.hpp"
 #include "Image.hpp"
+#include "Rasterizer.hpp"
+#include "GlyphCache.hpp"
+#include "DibImage.hpp"
+#include "Resampler.hpp"
+#include "PngEncoder.hpp"
 #include <vector>
 #include <memory>
 
 namespace TiffConvert {
 	/// <summary>
-	/// Renderer provides a class of static methods that help with rendering to an output created by libtiffconvert.
+	/// Renderer provides a class of static methods that help with rendering to an output created by libtiffconvert. Lines, 
+	/// square-cornered rectangles, text and embedded DIB images are rasterized natively, including the highlight and transparent modes.
 	/// </summary>
 	class Renderer {
+		private:
+			static thread_local RasterTarget s_Band;	// The band that is rendered to on this thread, no band when its Bits are nullptr.
+
 		public:
 			/// <summary>
 			/// The highlight filter only renders onto white.
@@ -55,7 +64,8 @@ namespace TiffConvert {
 			static renderer_filter GetHighlightFilter(bool highlight, bool transparent);
 
 			/// <summary>
-			/// Render a line between all the specified points, with a specific thickness and color.
+			/// Render a line between all the specified points, with a specific thickness and color. The line is stroked with round
+			/// joins and caps by the native <see cref="Rasterizer"/>.
 			/// </summary>
 			/// <param name="points">The list of points to draw a line in between.</param>
 			/// <param name="lineSize">The thickness of the line.</param>
@@ -236,6 +246,80 @@ namespace TiffConvert {
 			/// <param name="transparent">Whether transparency masking is applied.</param>
 			/// <returns>True when successful, false otherwise.</returns>
 			static bool Image(const RECT& bounds, std::shared_ptr<const TiffConvert::Image> image, uint8_t alpha, bool highlight = false, bool transparent = false);
+
+			/// <summary>
+			/// Render an embedded DIB image onto the output, rotated and/or mirrored and scaled to its bounds in a single pass.
+			/// </summary>
+			/// <param name="bounds">The image rectangle, after rotation.</param>
+			/// <param name="image">The image to render.</param>
+			/// <param name="rotation">The orientation of the image.</param>
+			/// <param name="highlight">Whether highlighting should be applied.</param>
+			/// <param name="transparent">Whether transparency masking is applied.</param>
+			/// <returns>True when successful, false when the output cannot be drawn onto natively.</returns>
+			static bool Image(const RECT& bounds, const DibImage& image, AN_ROTATE_TYPE rotation, bool highlight = false, bool transparent = false);
+
+			/// <summary>
+			/// Invert the colors of the whole output, the alpha channel is kept.
+			/// </summary>
+			/// <returns>True when successful, false when the output cannot be inverted natively.</returns>
+			static bool Invert();
+
+			/// <summary>
+			/// Resample the whole output into a new top-down buffer of the same pixel format.
+			/// </summary>
+			/// <param name="resampler">The resampler, for the dimensions of the output.</param>
+			/// <param name="pixels">The buffer that receives the resampled pixels.</param>
+			/// <param name="resampled">Receives the description of the resampled pixels in <paramref name="pixels"/>.</param>
+			/// <param name="threads">The number of threads to resample with.</param>
+			/// <returns>True when successful, false when the output cannot be resampled natively.</returns>
+			/// <exception cref="std::invalid_argument">When the output does not match the dimensions of the resampler.</exception>
+			static bool Resample(const Resampler& resampler, std::vector<uint8_t>& pixels, renderer_target& resampled, uint32_t threads = 1);
+
+			/// <summary>
+			/// Encode the whole output as PNG.
+			/// </summary>
+			/// <param name="encoder">The encoder.</param>
+			/// <param name="png">The buffer that receives the PNG file.</param>
+			/// <returns>True when successful, false when the output cannot be encoded natively.</returns>
+			static bool EncodePng(const PngEncoder& encoder, std::vector<uint8_t>& png);
+
+			/// <summary>
+			/// Render to a band of a page instead of the output of libtiffconvert, until <see cref="EndBand"/> is called on the
+			/// same thread. Coordinates are relative to the top of the band. Everything that cannot be drawn natively is not drawn
+			/// and reports failure, as the libtiffconvert drawing functions cannot draw onto a band.
+			/// </summary>
+			/// <param name="band">The pixels of the band, which must remain valid until <see cref="EndBand"/> is called.</param>
+			static void BeginBand(const RasterTarget& band) noexcept;
+
+			/// <summary>
+			/// Stop rendering to the band that was set with <see cref="BeginBand"/>.
+			/// </summary>
+			static void EndBand() noexcept;
+
+			/// <summary>
+			/// Determine if a band is rendered to on this thread, in which case the libtiffconvert drawing functions cannot be used.
+			/// </summary>
+			/// <returns>True when a band is rendered to, false otherwise.</returns>
+			static bool IsBanded() noexcept;
+
+		private:
+			/// <summary>
+			/// Get the pixels of the output that is currently rendered to, so that they can be drawn onto natively.
+			/// </summary>
+			/// <param name="target">The target that receives the description of the output.</param>
+			/// <returns>True when the output can be drawn onto natively, false when the libtiffconvert drawing functions have to be used.</returns>
+			static bool GetTarget(RasterTarget& target) noexcept;
+
+			/// <summary>
+			/// Paint a text mask onto the output in a single color, the mask is clipped to the output.
+			/// </summary>
+			/// <param name="target">The output.</param>
+			/// <param name="mask">The text mask.</param>
+			/// <param name="x">The column of the text on the output.</param>
+			/// <param name="y">The row of the top of the text on the output.</param>
+			/// <param name="pixel">The color as stored in memory, see <see cref="SpanBlend::Pack"/>.</param>
+			/// <param name="highlight">Only paint pixels that are white.</param>
+			static void Blit(const RasterTarget& target, const GlyphCache::TextMask& mask, int64_t x, int64_t y, uint32_t pixel, bool highlight) noexcept;
 	};
 }
 
@@ -0,0 +1,512 @@
+#include "Resampler.hpp"
+#include "SpanBlend.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+#include <immintrin.h>
+
+using namespace TiffConvert;
+
+static constexpr int32_t	Precision	= 14;						// The number of fraction bits of the filter weights.
+static constexpr int32_t	One			= 1 << Precision;			// A weight of 1.
+static constexpr int32_t	Half		= 1 << (Precision - 1);		// Added before the weighted sum is shifted, to round it.
+static constexpr uint32_t	MinimumBand	= 16;						// The minimum number of rows in a band that is processed by a thread.
+static constexpr double		Pi			= 3.14159265358979323846;
+
+/// <summary>
+/// Get the support of a filter, the distance from the center beyond which the filter is 0, when upscaling.
+/// </summary>
+/// <param name="filter">The filter.</param>
+/// <returns>The support in pixels.</returns>
+static double GetSupport(ScaleFilter filter) noexcept {
+	switch (filter) {
+		case ScaleFilter::Box:		return 0.5;
+		case ScaleFilter::Bilinear:	return 1.0;
+		case ScaleFilter::Lanczos3:	return 3.0;
+		default:					return 0.0;
+	}
+}
+
+/// <summary>
+/// The normalized sinc function.
+/// </summary>
+/// <param name="x">The distance from the center.</param>
+/// <returns>sin(pi * x) / (pi * x).</returns>
+static double Sinc(double x) noexcept {
+	if (x == 0.0)
+		return 1.0;
+
+	x *= Pi;
+	return std::sin(x) / x;
+}
+
+/// <summary>
+/// Evaluate a filter.
+/// </summary>
+/// <param name="filter">The filter.</param>
+/// <param name="x">The distance from the center, in pixels of the filter.</param>
+/// <returns>The unnormalized weight.</returns>
+static double Evaluate(ScaleFilter filter, double x) noexcept {
+	switch (filter) {
+		case ScaleFilter::Box:
+			return (x >= -0.5 && x < 0.5) ? 1.0 : 0.0;
+		case ScaleFilter::Bilinear:
+			x = std::fabs(x);
+			return (x < 1.0) ? 1.0 - x : 0.0;
+		case ScaleFilter::Lanczos3:
+			return (x > -3.0 && x < 3.0) ? Sinc(x) * Sinc(x / 3.0) : 0.0;
+		default:
+			return 0.0;
+	}
+}
+
+/// <summary>
+/// Clamp and round a weighted sum to a byte.
+/// </summary>
+/// <param name="sum">The weighted sum, including <see cref="Half"/>.</param>
+/// <returns>The byte.</returns>
+static inline uint8_t ToByte(int32_t sum) noexcept {
+	sum >>= Precision;
+	return static_cast<uint8_t>(sum < 0 ? 0 : (sum > 255 ? 255 : sum));
+}
+
+/// <summary>
+/// Expand a row of 24 or 32-bit pixels to 32-bit pixels, a 24-bit pixel gets a fourth byte of 255.
+/// </summary>
+/// <param name="source">The source row.</param>
+/// <param name="row">The expanded row.</param>
+/// <param name="width">The number of pixels.</param>
+/// <param name="bytesPerPixel">The size of a source pixel, 3 or 4 bytes.</param>
+static void ExpandRow(const uint8_t* source, uint8_t* row, uint32_t width, uint32_t bytesPerPixel) noexcept {
+	if (bytesPerPixel == 4) {
+		memcpy(row, source, static_cast<size_t>(width) * 4);
+		return;
+	}
+
+	for (uint32_t x = 0; x < width; ++x, source += 3, row += 4) {
+		row[0] = source[0];
+		row[1] = source[1];
+		row[2] = source[2];
+		row[3] = 255;
+	}
+}
+
+/// <summary>
+/// Compact a row of 32-bit pixels to 24 or 32-bit pixels, the fourth byte is dropped for 24-bit pixels.
+/// </summary>
+/// <param name="row">The 32-bit row.</param>
+/// <param name="destination">The destination row.</param>
+/// <param name="width">The number of pixels.</param>
+/// <param name="bytesPerPixel">The size of a destination pixel, 3 or 4 bytes.</param>
+static void CompactRow(const uint8_t* row, uint8_t* destination, uint32_t width, uint32_t bytesPerPixel) noexcept {
+	if (bytesPerPixel == 4) {
+		memcpy(destination, row, static_cast<size_t>(width) * 4);
+		return;
+	}
+
+	for (uint32_t x = 0; x < width; ++x, row += 4, destination += 3) {
+		destination[0] = row[0];
+		destination[1] = row[1];
+		destination[2] = row[2];
+	}
+}
+
+/// <summary>
+/// Resample a row of 32-bit pixels horizontally.
+/// </summary>
+/// <param name="row">The expanded source row, followed by at least taps pixels of padding.</param>
+/// <param name="output">The resampled row.</param>
+/// <param name="width">The number of pixels in the resampled row.</param>
+/// <param name="start">The first source pixel of every resampled pixel.</param>
+/// <param name="weights">The weights of every resampled pixel.</param>
+/// <param name="taps">The number of weights per resampled pixel, a multiple of 4.</param>
+static void HorizontalScalar(const uint8_t* row, uint8_t* output, uint32_t width, const uint32_t* start, const int16_t* weights, uint32_t taps) noexcept {
+	for (uint32_t x = 0; x < width; ++x, weights += taps, output += 4) {
+		auto pixels = row + static_cast<size_t>(start[x]) * 4;
+		int32_t sum[4] = { Half, Half, Half, Half };
+
+		for (uint32_t k = 0; k < taps; ++k, pixels += 4) {
+			sum[0] += pixels[0] * weights[k];
+			sum[1] += pixels[1] * weights[k];
+			sum[2] += pixels[2] * weights[k];
+			sum[3] += pixels[3] * weights[k];
+		}
+
+		output[0] = ToByte(sum[0]);
+		output[1] = ToByte(sum[1]);
+		output[2] = ToByte(sum[2]);
+		output[3] = ToByte(sum[3]);
+	}
+}
+
+/// <summary>
+/// Store the weighted sums of the four components of a pixel.
+/// </summary>
+/// <param name="sum">The four weighted sums, including <see cref="Half"/>.</param>
+/// <param name="output">The pixel.</param>
+static inline void StorePixel(__m128i sum, uint8_t* output) noexcept {
+	sum = _mm_srai_epi32(sum, Precision);
+	sum = _mm_packs_epi32(sum, sum);
+	sum = _mm_packus_epi16(sum, sum);
+
+	auto pixel = _mm_cvtsi128_si32(sum);
+	memcpy(output, &pixel, sizeof(pixel));
+}
+
+/// <summary>
+/// Resample a row of 32-bit pixels horizontally, 4 weights at a time. The components of two neighbouring pixels are
+/// interleaved, so that a single multiply-add applies the weights of both.
+/// </summary>
+/// <param name="row">The expanded source row, followed by at least taps pixels of padding.</param>
+/// <param name="output">The resampled row.</param>
+/// <param name="width">The number of pixels in the resampled row.</param>
+/// <param name="start">The first source pixel of every resampled pixel.</param>
+/// <param name="weights">The weights of every resampled pixel.</param>
+/// <param name="taps">The number of weights per resampled pixel, a multiple of 4.</param>
+static void HorizontalSsse3(const uint8_t* row, uint8_t* output, uint32_t width, const uint32_t* start, const int16_t* weights, uint32_t taps) noexcept {
+	auto interleave = _mm_setr_epi8(0, -1, 4, -1, 1, -1, 5, -1, 2, -1, 6, -1, 3, -1, 7, -1);
+
+	for (uint32_t x = 0; x < width; ++x, weights += taps, output += 4) {
+		auto pixels = row + static_cast<size_t>(start[x]) * 4;
+		auto sum    = _mm_set1_epi32(Half);
+
+		for (uint32_t k = 0; k < taps; k += 4, pixels += 16) {
+			auto quad  = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(weights + k));
+			auto first = _mm_shuffle_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(pixels)), interleave);
+			auto last  = _mm_shuffle_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(pixels + 8)), interleave);
+
+			sum = _mm_add_epi32(sum, _mm_madd_epi16(first, _mm_shuffle_epi32(quad, 0x00)));
+			sum = _mm_add_epi32(sum, _mm_madd_epi16(last, _mm_shuffle_epi32(quad, 0x55)));
+		}
+
+		StorePixel(sum, output);
+	}
+}
+
+/// <summary>
+/// Resample a row of 32-bit pixels horizontally, 4 weights at a time with both 128-bit lanes applying 2 weights.
+/// </summary>
+/// <param name="row">The expanded source row, followed by at least taps pixels of padding.</param>
+/// <param name="output">The resampled row.</param>
+/// <param name="width">The number of pixels in the resampled row.</param>
+/// <param name="start">The first source pixel of every resampled pixel.</param>
+/// <param name="weights">The weights of every resampled pixel.</param>
+/// <param name="taps">The number of weights per resampled pixel, a multiple of 4.</param>
+static void HorizontalAvx2(const uint8_t* row, uint8_t* output, uint32_t width, const uint32_t* start, const int16_t* weights, uint32_t taps) noexcept {
+	auto interleave = _mm256_setr_epi8(
+		0, -1, 4, -1, 1, -1, 5, -1, 2, -1, 6, -1, 3, -1, 7, -1,
+		8, -1, 12, -1, 9, -1, 13, -1, 10, -1, 14, -1, 11, -1, 15, -1);
+
+	for (uint32_t x = 0; x < width; ++x, weights += taps, output += 4) {
+		auto pixels = row + static_cast<size_t>(start[x]) * 4;
+		auto sum    = _mm256_setzero_si256();
+
+		for (uint32_t k = 0; k < taps; k += 4, pixels += 16) {
+			auto quad   = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(weights + k));
+			auto pairs  = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_shuffle_epi32(quad, 0x00)), _mm_shuffle_epi32(quad, 0x55), 1);
+			auto values = _mm256_shuffle_epi8(_mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels))), interleave);
+
+			sum = _mm256_add_epi32(sum, _mm256_madd_epi16(values, pairs));
+		}
+
+		auto total = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+		StorePixel(_mm_add_epi32(total, _mm_set1_epi32(Half)), output);
+	}
+}
+
+/// <summary>
+/// Resample a row vertically, every byte is the weighted sum of the bytes at the same position in the source rows.
+/// </summary>
+/// <param name="rows">The source rows, one per weight.</param>
+/// <param name="weights">The weights.</param>
+/// <param name="taps">The number of weights, a multiple of 4.</param>
+/// <param name="output">The resampled row.</param>
+/// <param name="begin">The first byte to resample.</param>
+/// <param name="end">The byte after the last byte to resample.</param>
+static void VerticalScalar(const uint8_t* const* rows, const int16_t* weights, uint32_t taps, uint8_t* output, size_t begin, size_t end) noexcept {
+	for (auto i = begin; i < end; ++i) {
+		int32_t sum = Half;
+		for (uint32_t k = 0; k < taps; ++k)
+			sum += rows[k][i] * weights[k];
+
+		output[i] = ToByte(sum);
+	}
+}
+
+/// <summary>
+/// Resample a row vertically, 16 bytes at a time. The bytes of two source rows are interleaved, so that a single
+/// multiply-add applies the weights of both.
+/// </summary>
+/// <param name="rows">The source rows, one per weight.</param>
+/// <param name="weights">The weights.</param>
+/// <param name="taps">The number of weights, a multiple of 4.</param>
+/// <param name="output">The resampled row.</param>
+/// <param name="begin">The first byte to resample.</param>
+/// <param name="end">The byte after the last byte to resample.</param>
+static void VerticalSse2(const uint8_t* const* rows, const int16_t* weights, uint32_t taps, uint8_t* output, size_t begin, size_t end) noexcept {
+	auto zero = _mm_setzero_si128();
+	auto half = _mm_set1_epi32(Half);
+
+	auto i = begin;
+	for (; i + 16 <= end; i += 16) {
+		__m128i sum[4] = { half, half, half, half };
+
+		for (uint32_t k = 0; k < taps; k += 2) {
+			auto pair   = _mm_set1_epi32(static_cast<int>(static_cast<uint16_t>(weights[k]) | (static_cast<uint32_t>(static_cast<uint16_t>(weights[k + 1])) << 16)));
+			auto first  = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rows[k] + i));
+			auto second = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rows[k + 1] + i));
+			auto low    = _mm_unpacklo_epi8(first, second);
+			auto high   = _mm_unpackhi_epi8(first, second);
+
+			sum[0] = _mm_add_epi32(sum[0], _mm_madd_epi16(_mm_unpacklo_epi8(low, zero), pair));
+			sum[1] = _mm_add_epi32(sum[1], _mm_madd_epi16(_mm_unpackhi_epi8(low, zero), pair));
+			sum[2] = _mm_add_epi32(sum[2], _mm_madd_epi16(_mm_unpacklo_epi8(high, zero), pair));
+			sum[3] = _mm_add_epi32(sum[3], _mm_madd_epi16(_mm_unpackhi_epi8(high, zero), pair));
+		}
+
+		auto low  = _mm_packs_epi32(_mm_srai_epi32(sum[0], Precision), _mm_srai_epi32(sum[1], Precision));
+		auto high = _mm_packs_epi32(_mm_srai_epi32(sum[2], Precision), _mm_srai_epi32(sum[3], Precision));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(output + i), _mm_packus_epi16(low, high));
+	}
+
+	VerticalScalar(rows, weights, taps, output, i, end);
+}
+
+/// <summary>
+/// Resample a row vertically, 32 bytes at a time.
+/// </summary>
+/// <param name="rows">The source rows, one per weight.</param>
+/// <param name="weights">The weights.</param>
+/// <param name="taps">The number of weights, a multiple of 4.</param>
+/// <param name="output">The resampled row.</param>
+/// <param name="size">The number of bytes in a row.</param>
+static void VerticalAvx2(const uint8_t* const* rows, const int16_t* weights, uint32_t taps, uint8_t* output, size_t size) noexcept {
+	auto zero = _mm256_setzero_si256();
+	auto half = _mm256_set1_epi32(Half);
+
+	size_t i = 0;
+	for (; i + 32 <= size; i += 32) {
+		__m256i sum[4] = { half, half, half, half };
+
+		for (uint32_t k = 0; k < taps; k += 2) {
+			auto pair   = _mm256_set1_epi32(static_cast<int>(static_cast<uint16_t>(weights[k]) | (static_cast<uint32_t>(static_cast<uint16_t>(weights[k + 1])) << 16)));
+			auto first  = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rows[k] + i));
+			auto second = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rows[k + 1] + i));
+			auto low    = _mm256_unpacklo_epi8(first, second);
+			auto high   = _mm256_unpackhi_epi8(first, second);
+
+			// The unpacks work within 128-bit lanes, the packs below restore the order of the bytes.
+			sum[0] = _mm256_add_epi32(sum[0], _mm256_madd_epi16(_mm256_unpacklo_epi8(low, zero), pair));
+			sum[1] = _mm256_add_epi32(sum[1], _mm256_madd_epi16(_mm256_unpackhi_epi8(low, zero), pair));
+			sum[2] = _mm256_add_epi32(sum[2], _mm256_madd_epi16(_mm256_unpacklo_epi8(high, zero), pair));
+			sum[3] = _mm256_add_epi32(sum[3], _mm256_madd_epi16(_mm256_unpackhi_epi8(high, zero), pair));
+		}
+
+		auto low  = _mm256_packs_epi32(_mm256_srai_epi32(sum[0], Precision), _mm256_srai_epi32(sum[1], Precision));
+		auto high = _mm256_packs_epi32(_mm256_srai_epi32(sum[2], Precision), _mm256_srai_epi32(sum[3], Precision));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(output + i), _mm256_packus_epi16(low, high));
+	}
+
+	VerticalSse2(rows, weights, taps, output, i, size);
+}
+
+/// <summary>
+/// Split a number of rows into bands and process every band on its own thread, the first band is processed on the
+/// calling thread.
+/// </summary>
+/// <param name="count">The number of rows.</param>
+/// <param name="threads">The maximum number of threads.</param>
+/// <param name="function">Processes a band, it receives the band index and the first and last + 1 row of the band.</param>
+template <typename TFunction>
+static void ForEachBand(uint32_t count, uint32_t threads, TFunction function) {
+	threads = (std::max)(1u, (std::min)(threads, count / MinimumBand));
+
+	std::vector<std::thread> workers;
+	auto band = [count, threads](uint32_t index) { return static_cast<uint32_t>(static_cast<uint64_t>(count) * index / threads); };
+
+	try {
+		for (uint32_t t = 1; t < threads; ++t)
+			workers.emplace_back(function, t, band(t), band(t + 1));
+
+		function(0, band(0), band(1));
+	} catch (...) {
+		for (auto& worker : workers)
+			worker.join();
+		throw;
+	}
+
+	for (auto& worker : workers)
+		worker.join();
+}
+
+/// <summary>
+/// Construct a new resampler, computing the filter weights.
+/// </summary>
+/// <param name="sourceWidth">The width of the source image.</param>
+/// <param name="sourceHeight">The height of the source image.</param>
+/// <param name="width">The width of the resampled image.</param>
+/// <param name="height">The height of the resampled image.</param>
+/// <param name="filter">The filter.</param>
+/// <exception cref="std::invalid_argument">When one of the dimensions is 0.</exception>
+Resampler::Resampler(uint32_t sourceWidth, uint32_t sourceHeight, uint32_t width, uint32_t height, ScaleFilter filter)
+	: m_SourceWidth(sourceWidth), m_SourceHeight(sourceHeight), m_Width(width), m_Height(height) {
+
+	if (sourceWidth == 0 || sourceHeight == 0 || width == 0 || height == 0)
+		throw std::invalid_argument("cannot resample an empty image");
+
+	m_Horizontal = ComputeCoefficients(sourceWidth, width, filter);
+	m_Vertical   = ComputeCoefficients(sourceHeight, height, filter);
+}
+
+/// <summary>
+/// Resample an image.
+/// </summary>
+/// <param name="source">The source image, of the source dimensions. 24 or 32 bits per pixel.</param>
+/// <param name="destination">The resampled image, of the resampled dimensions and with the pixel format of the source.</param>
+/// <param name="threads">The number of threads to use, at least 1.</param>
+/// <exception cref="std::invalid_argument">When the images don't match the dimensions or pixel format.</exception>
+void Resampler::Resample(const RasterTarget& source, const RasterTarget& destination, uint32_t threads) const {
+	if (source.Width != m_SourceWidth || source.Height != m_SourceHeight || destination.Width != m_Width || destination.Height != m_Height)
+		throw std::invalid_argument("the images do not match the dimensions of the resampler");
+
+	if ((source.BitsPerPixel != 24 && source.BitsPerPixel != 32) || destination.BitsPerPixel != source.BitsPerPixel)
+		throw std::invalid_argument("the images have an unsupported pixel format");
+
+	auto instructions = SpanBlend::GetInstructionSet();
+	auto horizontal   = (instructions == SpanBlend::InstructionSet::Avx2) ? HorizontalAvx2 :
+		((instructions == SpanBlend::InstructionSet::Ssse3) ? HorizontalSsse3 : HorizontalScalar);
+
+	auto bytes  = source.BitsPerPixel / 8;
+	auto stride = static_cast<size_t>(m_Width) * 4;
+
+	// Pass 1: every source row is resampled horizontally into an intermediate image of 32-bit pixels. Source rows are
+	// expanded into a padded row first, so that the kernels can read a multiple of 4 pixels past every start pixel.
+	// The padded rows are reused by the second pass for 24-bit rows, before they are compacted.
+	threads = (std::max)(threads, 1u);
+
+	std::vector<uint8_t> intermediate(stride * m_SourceHeight);
+	std::vector<std::vector<uint8_t>> rows(threads, std::vector<uint8_t>((std::max)(static_cast<size_t>(m_SourceWidth) + m_Horizontal.Taps, static_cast<size_t>(m_Width)) * 4, 0));
+
+	ForEachBand(m_SourceHeight, threads, [&](uint32_t band, uint32_t begin, uint32_t end) {
+		auto row = rows[band].data();
+
+		for (auto y = begin; y < end; ++y) {
+			ExpandRow(source.Bits + static_cast<ptrdiff_t>(y) * source.Pitch, row, m_SourceWidth, bytes);
+			horizontal(row, intermediate.data() + stride * y, m_Width, m_Horizontal.Start.data(), m_Horizontal.Weights.data(), m_Horizontal.Taps);
+		}
+	});
+
+	// Pass 2: every destination row is resampled vertically from the intermediate image. Weights beyond the filter are 0,
+	// the rows they refer to are clamped to the image.
+	ForEachBand(m_Height, threads, [&](uint32_t band, uint32_t begin, uint32_t end) {
+		std::vector<const uint8_t*> taps(m_Vertical.Taps);
+		auto row = rows[band].data();
+
+		for (auto y = begin; y < end; ++y) {
+			for (uint32_t k = 0; k < m_Vertical.Taps; ++k)
+				taps[k] = intermediate.data() + stride * (std::min)(m_Vertical.Start[y] + k, m_SourceHeight - 1);
+
+			auto weights = m_Vertical.Weights.data() + static_cast<size_t>(y) * m_Vertical.Taps;
+			auto output  = destination.Bits + static_cast<ptrdiff_t>(y) * destination.Pitch;
+			auto target  = (bytes == 4) ? output : row;
+
+			switch (instructions) {
+				case SpanBlend::InstructionSet::Avx2:
+					VerticalAvx2(taps.data(), weights, m_Vertical.Taps, target, stride);
+					break;
+				case SpanBlend::InstructionSet::Scalar:
+					VerticalScalar(taps.data(), weights, m_Vertical.Taps, target, 0, stride);
+					break;
+				default:
+					VerticalSse2(taps.data(), weights, m_Vertical.Taps, target, 0, stride);
+					break;
+			}
+
+			if (target != output)
+				CompactRow(target, output, m_Width, bytes);
+		}
+	});
+}
+
+/// <summary>
+/// Get the width of the resampled image.
+/// </summary>
+/// <returns>The width in pixels.</returns>
+uint32_t Resampler::GetWidth() const noexcept {
+	return m_Width;
+}
+
+/// <summary>
+/// Get the height of the resampled image.
+/// </summary>
+/// <returns>The height in pixels.</returns>
+uint32_t Resampler::GetHeight() const noexcept {
+	return m_Height;
+}
+
+/// <summary>
+/// Compute the filter weights for resampling one dimension.
+/// </summary>
+/// <param name="source">The size of the dimension in the source image.</param>
+/// <param name="size">The size of the dimension in the resampled image.</param>
+/// <param name="filter">The filter.</param>
+/// <returns>The filter weights.</returns>
+Resampler::Coefficients Resampler::ComputeCoefficients(uint32_t source, uint32_t size, ScaleFilter filter) {
+	Coefficients coefficients;
+
+	auto scale = static_cast<double>(source) / size;
+
+	// When downscaling the filter is stretched over the source pixels that an output pixel covers.
+	auto filterScale = (std::max)(scale, 1.0);
+	auto support     = GetSupport(filter) * filterScale;
+	auto taps        = static_cast<uint32_t>(std::ceil(support)) * 2 + 1;
+
+	coefficients.Taps = (taps + 3) & ~3u;
+	coefficients.Start.resize(size);
+	coefficients.Weights.assign(static_cast<size_t>(size) * coefficients.Taps, 0);
+
+	std::vector<double> weights(coefficients.Taps);
+
+	for (uint32_t i = 0; i < size; ++i) {
+		auto center  = (i + 0.5) * scale;
+		auto first   = (std::max)(static_cast<int64_t>(std::floor(center - support + 0.5)), int64_t(0));
+		auto last    = (std::min)(static_cast<int64_t>(std::floor(center + support + 0.5)), static_cast<int64_t>(source));
+		auto output  = coefficients.Weights.data() + static_cast<size_t>(i) * coefficients.Taps;
+
+		// The nearest pixel is used when the filter has no weight at all, which is always the case for ScaleFilter::Nearest.
+		auto nearest = (std::min)(static_cast<int64_t>(center), static_cast<int64_t>(source) - 1);
+		auto total   = 0.0;
+		auto count   = static_cast<uint32_t>((std::max)(last - first, int64_t(0)));
+
+		for (uint32_t k = 0; k < count; ++k) {
+			weights[k] = Evaluate(filter, (first + k - center + 0.5) / filterScale);
+			total += weights[k];
+		}
+
+		if (total == 0.0) {
+			coefficients.Start[i] = static_cast<uint32_t>(nearest);
+			output[0] = static_cast<int16_t>(One);
+			continue;
+		}
+
+		// Rounding the weights to fixed point can make them add up to slightly more or less than 1, the difference
+		// is added to the largest weight.
+		int32_t sum = 0;
+		uint32_t largest = 0;
+
+		for (uint32_t k = 0; k < count; ++k) {
+			output[k] = static_cast<int16_t>(std::lround(weights[k] / total * One));
+			sum += output[k];
+
+			if (std::abs(output[k]) > std::abs(output[largest]))
+				largest = k;
+		}
+
+		output[largest] = static_cast<int16_t>(output[largest] + One - sum);
+		coefficients.Start[i] = static_cast<uint32_t>(first);
+	}
+
+	return coefficients;
+}
\ No newline at end of file
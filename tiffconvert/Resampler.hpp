@@ -0,0 +1,90 @@
+#pragma once
+
+#ifndef libtiffconvert_resampler_h
+#define libtiffconvert_resampler_h
+
+#include "Rasterizer.hpp"
+#include <cstdint>
+#include <vector>
+
+namespace TiffConvert {
+	/// <summary>
+	/// The filters a page can be scaled with.
+	/// </summary>
+	enum class ScaleFilter {
+		Nearest,	// The nearest pixel, without interpolation.
+		Box,		// The average of the area a pixel covers.
+		Bilinear,	// Linear interpolation between neighbouring pixels, over the area a pixel covers when downscaling.
+		Lanczos3	// A windowed sinc over 3 lobes, the sharpest of the filters.
+	};
+
+	/// <summary>
+	/// Resampler is a native separable image resampler for 24 and 32-bit pixels. The filter weights of every output column
+	/// and row are computed once, in 14-bit fixed point. A page is resampled horizontally into an intermediate image, which is
+	/// then resampled vertically. Both passes split the rows into bands that are processed in parallel, and the best kernel
+	/// for the processor is selected at runtime, see <see cref="SpanBlend::GetInstructionSet"/>.
+	/// </summary>
+	class Resampler {
+		private:
+			/// <summary>
+			/// The filter weights for resampling one dimension.
+			/// </summary>
+			struct Coefficients {
+				uint32_t				Taps = 0;	// The number of weights per output pixel, a multiple of 4. Weights beyond the filter are 0.
+				std::vector<uint32_t>	Start;		// The first input pixel of every output pixel.
+				std::vector<int16_t>	Weights;	// Taps weights for every output pixel, they add up to 1 << 14.
+			};
+
+			uint32_t		m_SourceWidth;
+			uint32_t		m_SourceHeight;
+			uint32_t		m_Width;
+			uint32_t		m_Height;
+			Coefficients	m_Horizontal;
+			Coefficients	m_Vertical;
+
+		public:
+			/// <summary>
+			/// Construct a new resampler, computing the filter weights.
+			/// </summary>
+			/// <param name="sourceWidth">The width of the source image.</param>
+			/// <param name="sourceHeight">The height of the source image.</param>
+			/// <param name="width">The width of the resampled image.</param>
+			/// <param name="height">The height of the resampled image.</param>
+			/// <param name="filter">The filter.</param>
+			/// <exception cref="std::invalid_argument">When one of the dimensions is 0.</exception>
+			Resampler(uint32_t sourceWidth, uint32_t sourceHeight, uint32_t width, uint32_t height, ScaleFilter filter);
+
+			/// <summary>
+			/// Resample an image.
+			/// </summary>
+			/// <param name="source">The source image, of the source dimensions. 24 or 32 bits per pixel.</param>
+			/// <param name="destination">The resampled image, of the resampled dimensions and with the pixel format of the source.</param>
+			/// <param name="threads">The number of threads to use, at least 1.</param>
+			/// <exception cref="std::invalid_argument">When the images don't match the dimensions or pixel format.</exception>
+			void Resample(const RasterTarget& source, const RasterTarget& destination, uint32_t threads = 1) const;
+
+			/// <summary>
+			/// Get the width of the resampled image.
+			/// </summary>
+			/// <returns>The width in pixels.</returns>
+			uint32_t GetWidth() const noexcept;
+
+			/// <summary>
+			/// Get the height of the resampled image.
+			/// </summary>
+			/// <returns>The height in pixels.</returns>
+			uint32_t GetHeight() const noexcept;
+
+		private:
+			/// <summary>
+			/// Compute the filter weights for resampling one dimension.
+			/// </summary>
+			/// <param name="source">The size of the dimension in the source image.</param>
+			/// <param name="size">The size of the dimension in the resampled image.</param>
+			/// <param name="filter">The filter.</param>
+			/// <returns>The filter weights.</returns>
+			static Coefficients ComputeCoefficients(uint32_t source, uint32_t size, ScaleFilter filter);
+	};
+}
+
+#endif
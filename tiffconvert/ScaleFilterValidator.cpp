@@ -0,0 +1,26 @@
+#include "ScaleFilterValidator.hpp"
+
+using namespace TiffConvert::Cli;
+
+// a static set of valid scale filter names.
+std::set<std::string> ScaleFilterValidator::Valid = {
+	"nearest", "box", "bilinear", "lanczos3"
+};
+
+// a string representing the static set of valid scale filter names.
+std::string ScaleFilterValidator::ValidString = "nearest, box, bilinear, lanczos3";
+
+// a static instance of the validator, since only one is required.
+const ScaleFilterValidator ScaleFilterValidator::Validator = ScaleFilterValidator();
+
+/// <summary>
+/// The private constructor, this is a singleton.
+/// </summary>
+ScaleFilterValidator::ScaleFilterValidator() {
+	tname = "FILTER";
+	func = [](const std::string& str) -> std::string {
+		if (!Valid.count(str))
+			return "Invalid scale filter specified: " + str;
+		return std::string();
+	};
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#ifndef cli_scale_filter_validator_h
+#define cli_scale_filter_validator_h
+
+#include "CLI11.hpp"
+
+namespace TiffConvert {
+	namespace Cli {
+		/// <summary>
+		/// ScaleFilterValidator describes a <see cref="CLI::Validator"/> that can check if the specified scale filter is valid.
+		/// </summary>
+		struct ScaleFilterValidator : public CLI::Validator {
+			public:
+				static std::set<std::string> Valid;	// a static set of valid scale filter names.
+				static std::string ValidString;		// a string representing the static set of valid scale filter names.
+				static const ScaleFilterValidator Validator;	// a static instance of the validator, since only one is required.
+
+			private:
+				/// <summary>
+				/// The private constructor, this is a singleton.
+				/// </summary>
+				ScaleFilterValidator();
+		};
+	}
+}
+
+#endif 
\ No newline at end of file
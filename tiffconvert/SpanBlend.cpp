@@ -0,0 +1,431 @@
+#include "SpanBlend.hpp"
+
+#include <cstring>
+#include <intrin.h>
+#include <immintrin.h>
+
+using namespace TiffConvert;
+
+static constexpr uint32_t ColorMask = 0x00FFFFFF;	// The color components of a packed pixel, without alpha.
+
+/// <summary>
+/// Determine if a 24 or 32-bit pixel is white, regardless of its alpha component.
+/// </summary>
+/// <param name="pixel">The pixel.</param>
+/// <returns>True when the pixel is white.</returns>
+static inline bool IsWhite(const uint8_t* pixel) noexcept {
+	return pixel[0] == 255 && pixel[1] == 255 && pixel[2] == 255;
+}
+
+/// <summary>
+/// Blend a single color component over another.
+/// </summary>
+/// <param name="top">The new component.</param>
+/// <param name="bottom">The existing component.</param>
+/// <param name="alpha">The opacity of the new component.</param>
+/// <returns>The blended component.</returns>
+static inline uint8_t BlendComponent(uint32_t top, uint32_t bottom, uint32_t alpha) noexcept {
+	return static_cast<uint8_t>((top * alpha + bottom * (255 - alpha) + 127) / 255);
+}
+
+/// <summary>
+/// Blend a translucent color over a span of pixels.
+/// </summary>
+/// <param name="pixels">The first pixel of the span.</param>
+/// <param name="count">The number of pixels in the span.</param>
+/// <param name="bytesPerPixel">The size of a pixel, 3 or 4 bytes.</param>
+/// <param name="pixel">The packed color, including its alpha component.</param>
+/// <param name="highlight">Only paint pixels that are white.</param>
+static void BlendScalar(uint8_t* pixels, uint32_t count, uint32_t bytesPerPixel, uint32_t pixel, bool highlight) noexcept {
+	auto alpha = pixel >> 24;
+
+	for (uint32_t i = 0; i < count; ++i, pixels += bytesPerPixel) {
+		if (highlight && !IsWhite(pixels))
+			continue;
+
+		pixels[0] = BlendComponent(pixel & 0xFF, pixels[0], alpha);
+		pixels[1] = BlendComponent((pixel >> 8) & 0xFF, pixels[1], alpha);
+		pixels[2] = BlendComponent((pixel >> 16) & 0xFF, pixels[2], alpha);
+		if (bytesPerPixel == 4)
+			pixels[3] = static_cast<uint8_t>(alpha + (pixels[3] * (255 - alpha) + 127) / 255);
+	}
+}
+
+/// <summary>
+/// Paint an opaque color over a span of 24-bit pixels.
+/// </summary>
+/// <param name="pixels">The first pixel of the span.</param>
+/// <param name="count">The number of pixels in the span.</param>
+/// <param name="pixel">The packed color, with an alpha component of 255.</param>
+/// <param name="highlight">Only paint pixels that are white.</param>
+static void Fill24Scalar(uint8_t* pixels, uint32_t count, uint32_t pixel, bool highlight) noexcept {
+	for (uint32_t i = 0; i < count; ++i, pixels += 3) {
+		if (highlight && !IsWhite(pixels))
+			continue;
+
+		pixels[0] = static_cast<uint8_t>(pixel);
+		pixels[1] = static_cast<uint8_t>(pixel >> 8);
+		pixels[2] = static_cast<uint8_t>(pixel >> 16);
+	}
+}
+
+/// <summary>
+/// Paint an opaque color over a span of 32-bit pixels.
+/// </summary>
+/// <param name="pixels">The first pixel of the span.</param>
+/// <param name="count">The number of pixels in the span.</param>
+/// <param name="pixel">The packed color, with an alpha component of 255.</param>
+/// <param name="highlight">Only paint pixels that are white.</param>
+static void Fill32Scalar(uint8_t* pixels, uint32_t count, uint32_t pixel, bool highlight) noexcept {
+	for (uint32_t i = 0; i < count; ++i, pixels += 4) {
+		uint32_t existing;
+		memcpy(&existing, pixels, sizeof(existing));
+
+		if (highlight && (existing & ColorMask) != ColorMask)
+			continue;
+
+		memcpy(pixels, &pixel, sizeof(pixel));
+	}
+}
+
+/// <summary>
+/// Paint an opaque color over a span of 24-bit pixels, 16 pixels (three 16-byte stores) at a time. Highlighting needs 
+/// a byte shuffle to test pixels, so it is left to the scalar kernel.
+/// </summary>
+/// <param name="pixels">The first pixel of the span.</param>
+/// <param name="count">The number of pixels in the span.</param>
+/// <param name="pixel">The packed color, with an alpha component of 255.</param>
+/// <param name="highlight">Only paint pixels that are white.</param>
+static void Fill24Sse2(uint8_t* pixels, uint32_t count, uint32_t pixel, bool highlight) noexcept {
+	if (highlight) {
+		Fill24Scalar(pixels, count, pixel, highlight);
+		return;
+	}
+
+	uint8_t pattern[48];
+	for (auto i = 0; i < 16; ++i)
+		memcpy(pattern + i * 3, &pixel, 3);
+
+	auto a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pattern));
+	auto b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pattern + 16));
+	auto c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pattern + 32));
+
+	uint32_t i = 0;
+	for (; i + 16 <= count; i += 16, pixels += 48) {
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(pixels), a);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(pixels + 16), b);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(pixels + 32), c);
+	}
+
+	Fill24Scalar(pixels, count - i, pixel, false);
+}
+
+/// <summary>
+/// Paint an opaque color over a span of 24-bit pixels. Highlighting expands 4 pixels at a time to 32-bit lanes, selects 
+/// the white lanes and packs the result back to 24-bit.
+/// </summary>
+/// <param name="pixels">The first pixel of the span.</param>
+/// <param name="count">The number of pixels in the span.</param>
+/// <param name="pixel">The packed color, with an alpha component of 255.</param>
+/// <param name="highlight">Only paint pixels that are white.</param>
+static void Fill24Ssse3(uint8_t* pixels, uint32_t count, uint32_t pixel, bool highlight) noexcept {
+	if (!highlight) {
+		Fill24Sse2(pixels, count, pixel, highlight);
+		return;
+	}
+
+	auto expand   = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+	auto compress = _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+	auto keep     = _mm_setr_epi8(0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, -1, -1, -1, -1);
+	auto white    = _mm_set1_epi32(static_cast<int>(ColorMask));
+	auto color    = _mm_set1_epi32(static_cast<int>(pixel & ColorMask));
+
+	// Each step loads 16 bytes but only changes the first 12, so 6 pixels have to remain to stay within the span.
+	uint32_t i = 0;
+	for (; i + 6 <= count; i += 4, pixels += 12) {
+		auto source = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels));
+		auto lanes  = _mm_shuffle_epi8(source, expand);
+		auto mask   = _mm_cmpeq_epi32(lanes, white);
+		auto result = _mm_or_si128(_mm_and_si128(mask, color), _mm_andnot_si128(mask, lanes));
+
+		result = _mm_or_si128(_mm_shuffle_epi8(result, compress), _mm_and_si128(source, keep));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(pixels), result);
+	}
+
+	Fill24Scalar(pixels, count - i, pixel, highlight);
+}
+
+/// <summary>
+/// Paint an opaque color over a span of 32-bit pixels, 4 pixels at a time.
+/// </summary>
+/// <param name="pixels">The first pixel of the span.</param>
+/// <param name="count">The number of pixels in the span.</param>
+/// <param name="pixel">The packed color, with an alpha component of 255.</param>
+/// <param name="highlight">Only paint pixels that are white.</param>
+static void Fill32Sse2(uint8_t* pixels, uint32_t count, uint32_t pixel, bool highlight) noexcept {
+	auto color = _mm_set1_epi32(static_cast<int>(pixel));
+	auto white = _mm_set1_epi32(static_cast<int>(ColorMask));
+
+	uint32_t i = 0;
+	for (; i + 4 <= count; i += 4, pixels += 16) {
+		auto target = reinterpret_cast<__m128i*>(pixels);
+
+		if (!highlight) {
+			_mm_storeu_si128(target, color);
+			continue;
+		}
+
+		auto existing = _mm_loadu_si128(target);
+		auto mask     = _mm_cmpeq_epi32(_mm_and_si128(existing, white), white);
+		_mm_storeu_si128(target, _mm_or_si128(_mm_and_si128(mask, color), _mm_andnot_si128(mask, existing)));
+	}
+
+	Fill32Scalar(pixels, count - i, pixel, highlight);
+}
+
+/// <summary>
+/// Paint an opaque color over a span of 32-bit pixels, 8 pixels at a time.
+/// </summary>
+/// <param name="pixels">The first pixel of the span.</param>
+/// <param name="count">The number of pixels in the span.</param>
+/// <param name="pixel">The packed color, with an alpha component of 255.</param>
+/// <param name="highlight">Only paint pixels that are white.</param>
+static void Fill32Avx2(uint8_t* pixels, uint32_t count, uint32_t pixel, bool highlight) noexcept {
+	auto color = _mm256_set1_epi32(static_cast<int>(pixel));
+	auto white = _mm256_set1_epi32(static_cast<int>(ColorMask));
+
+	uint32_t i = 0;
+	for (; i + 8 <= count; i += 8, pixels += 32) {
+		auto target = reinterpret_cast<__m256i*>(pixels);
+
+		if (!highlight) {
+			_mm256_storeu_si256(target, color);
+			continue;
+		}
+
+		auto existing = _mm256_loadu_si256(target);
+		auto mask     = _mm256_cmpeq_epi32(_mm256_and_si256(existing, white), white);
+		_mm256_storeu_si256(target, _mm256_blendv_epi8(existing, color, mask));
+	}
+
+	Fill32Sse2(pixels, count - i, pixel, highlight);
+}
+
+/// <summary>
+/// Xor a block of bytes with a repeating 32-bit mask.
+/// </summary>
+/// <param name="bytes">The first byte.</param>
+/// <param name="size">The number of bytes.</param>
+/// <param name="mask">The mask, least significant byte first.</param>
+static void XorScalar(uint8_t* bytes, size_t size, uint32_t mask) noexcept {
+	size_t i = 0;
+	for (; i + 4 <= size; i += 4) {
+		uint32_t value;
+		memcpy(&value, bytes + i, sizeof(value));
+		value ^= mask;
+		memcpy(bytes + i, &value, sizeof(value));
+	}
+
+	for (; i < size; ++i)
+		bytes[i] ^= static_cast<uint8_t>(mask >> ((i & 3) * 8));
+}
+
+/// <summary>
+/// Xor a block of bytes with a repeating 32-bit mask, 16 bytes at a time.
+/// </summary>
+/// <param name="bytes">The first byte.</param>
+/// <param name="size">The number of bytes.</param>
+/// <param name="mask">The mask, least significant byte first.</param>
+static void XorSse2(uint8_t* bytes, size_t size, uint32_t mask) noexcept {
+	auto vector = _mm_set1_epi32(static_cast<int>(mask));
+
+	size_t i = 0;
+	for (; i + 16 <= size; i += 16) {
+		auto target = reinterpret_cast<__m128i*>(bytes + i);
+		_mm_storeu_si128(target, _mm_xor_si128(_mm_loadu_si128(target), vector));
+	}
+
+	XorScalar(bytes + i, size - i, mask);
+}
+
+/// <summary>
+/// Xor a block of bytes with a repeating 32-bit mask, 32 bytes at a time.
+/// </summary>
+/// <param name="bytes">The first byte.</param>
+/// <param name="size">The number of bytes.</param>
+/// <param name="mask">The mask, least significant byte first.</param>
+static void XorAvx2(uint8_t* bytes, size_t size, uint32_t mask) noexcept {
+	auto vector = _mm256_set1_epi32(static_cast<int>(mask));
+
+	size_t i = 0;
+	for (; i + 32 <= size; i += 32) {
+		auto target = reinterpret_cast<__m256i*>(bytes + i);
+		_mm256_storeu_si256(target, _mm256_xor_si256(_mm256_loadu_si256(target), vector));
+	}
+
+	XorSse2(bytes + i, size - i, mask);
+}
+
+/// <summary>
+/// Determine the best instruction set supported by the processor and the operating system.
+/// </summary>
+/// <returns>The instruction set.</returns>
+static SpanBlend::InstructionSet DetectInstructionSet() noexcept {
+	int info[4];
+
+	__cpuid(info, 0);
+	auto maxLeaf = info[0];
+
+	__cpuid(info, 1);
+	auto sse2    = (info[3] & (1 << 26)) != 0;
+	auto ssse3   = (info[2] & (1 << 9)) != 0;
+	auto osxsave = (info[2] & (1 << 27)) != 0;
+	auto avx     = (info[2] & (1 << 28)) != 0;
+
+	// AVX2 also needs the operating system to preserve the upper halves of the ymm registers.
+	if (maxLeaf >= 7 && osxsave && avx && (_xgetbv(0) & 6) == 6) {
+		__cpuidex(info, 7, 0);
+		if ((info[1] & (1 << 5)) != 0)
+			return SpanBlend::InstructionSet::Avx2;
+	}
+
+	if (ssse3)
+		return SpanBlend::InstructionSet::Ssse3;
+	if (sse2)
+		return SpanBlend::InstructionSet::Sse2;
+	return SpanBlend::InstructionSet::Scalar;
+}
+
+/// <summary>
+/// Paint a span of pixels in a single color.
+/// </summary>
+/// <param name="pixels">The first pixel of the span.</param>
+/// <param name="count">The number of pixels in the span.</param>
+/// <param name="bytesPerPixel">The size of a pixel, 3 or 4 bytes.</param>
+/// <param name="pixel">The color as stored in memory, see <see cref="Pack"/>. Alpha below 255 is blended.</param>
+/// <param name="highlight">Only paint pixels that are white.</param>
+void SpanBlend::Fill(uint8_t* pixels, uint32_t count, uint32_t bytesPerPixel, uint32_t pixel, bool highlight) noexcept {
+	auto alpha = pixel >> 24;
+	if (count == 0 || alpha == 0 || (bytesPerPixel != 3 && bytesPerPixel != 4))
+		return;
+
+	if (alpha != 255) {
+		BlendScalar(pixels, count, bytesPerPixel, pixel, highlight);
+		return;
+	}
+
+	switch (GetInstructionSet()) {
+		case InstructionSet::Avx2:
+			if (bytesPerPixel == 4)
+				Fill32Avx2(pixels, count, pixel, highlight);
+			else 
+				Fill24Ssse3(pixels, count, pixel, highlight);
+			break;
+		case InstructionSet::Ssse3:
+			if (bytesPerPixel == 4)
+				Fill32Sse2(pixels, count, pixel, highlight);
+			else 
+				Fill24Ssse3(pixels, count, pixel, highlight);
+			break;
+		case InstructionSet::Sse2:
+			if (bytesPerPixel == 4)
+				Fill32Sse2(pixels, count, pixel, highlight);
+			else 
+				Fill24Sse2(pixels, count, pixel, highlight);
+			break;
+		default:
+			if (bytesPerPixel == 4)
+				Fill32Scalar(pixels, count, pixel, highlight);
+			else 
+				Fill24Scalar(pixels, count, pixel, highlight);
+			break;
+	}
+}
+
+/// <summary>
+/// Paint a span of pixels in a single color through a coverage mask, such as the mask of rasterized text.
+/// </summary>
+/// <param name="pixels">The first pixel of the span.</param>
+/// <param name="coverage">The coverage of each pixel in the span, from 0 (not painted) to 255 (fully painted).</param>
+/// <param name="count">The number of pixels in the span.</param>
+/// <param name="bytesPerPixel">The size of a pixel, 3 or 4 bytes.</param>
+/// <param name="pixel">The color as stored in memory, see <see cref="Pack"/>. Alpha below 255 is blended.</param>
+/// <param name="highlight">Only paint pixels that are white.</param>
+void SpanBlend::FillMasked(uint8_t* pixels, const uint8_t* coverage, uint32_t count, uint32_t bytesPerPixel, uint32_t pixel, bool highlight) noexcept {
+	auto alpha = pixel >> 24;
+	if (alpha == 0 || (bytesPerPixel != 3 && bytesPerPixel != 4))
+		return;
+
+	// Text masks are mostly runs of empty or fully covered pixels, those runs are skipped or painted as a whole.
+	uint32_t i = 0;
+	while (i < count) {
+		auto start = i;
+		auto value = coverage[i];
+
+		if (value == 0 || value == 255) {
+			while (i < count && coverage[i] == value)
+				++i;
+
+			if (value == 255)
+				Fill(pixels + static_cast<size_t>(start) * bytesPerPixel, i - start, bytesPerPixel, pixel, highlight);
+			continue;
+		}
+
+		auto weighted = (alpha * value + 127) / 255;
+		BlendScalar(pixels + static_cast<size_t>(i) * bytesPerPixel, 1, bytesPerPixel, (pixel & ColorMask) | (weighted << 24), highlight);
+		++i;
+	}
+}
+
+/// <summary>
+/// Invert the color of a span of pixels, the alpha component of 32-bit pixels is kept.
+/// </summary>
+/// <param name="pixels">The first pixel of the span.</param>
+/// <param name="count">The number of pixels in the span.</param>
+/// <param name="bytesPerPixel">The size of a pixel, 3 or 4 bytes.</param>
+void SpanBlend::Invert(uint8_t* pixels, uint32_t count, uint32_t bytesPerPixel) noexcept {
+	if (bytesPerPixel != 3 && bytesPerPixel != 4)
+		return;
+
+	// Every byte of a 24-bit pixel is a color component, so those spans are inverted as a whole.
+	auto size = static_cast<size_t>(count) * bytesPerPixel;
+	auto mask = (bytesPerPixel == 4) ? ColorMask : 0xFFFFFFFF;
+
+	switch (GetInstructionSet()) {
+		case InstructionSet::Avx2:
+			XorAvx2(pixels, size, mask);
+			break;
+		case InstructionSet::Ssse3:
+		case InstructionSet::Sse2:
+			XorSse2(pixels, size, mask);
+			break;
+		default:
+			XorScalar(pixels, size, mask);
+			break;
+	}
+}
+
+/// <summary>
+/// Pack a color into the value that is stored in memory for a pixel, least significant byte first.
+/// </summary>
+/// <param name="r">The red component.</param>
+/// <param name="g">The green component.</param>
+/// <param name="b">The blue component.</param>
+/// <param name="a">The alpha component.</param>
+/// <param name="bgr">Whether the pixels are stored blue first.</param>
+/// <returns>The packed pixel, with the alpha component in the most significant byte.</returns>
+uint32_t SpanBlend::Pack(uint32_t r, uint32_t g, uint32_t b, uint32_t a, bool bgr) noexcept {
+	if (bgr)
+		return (b & 0xFF) | ((g & 0xFF) << 8) | ((r & 0xFF) << 16) | ((a & 0xFF) << 24);
+
+	return (r & 0xFF) | ((g & 0xFF) << 8) | ((b & 0xFF) << 16) | ((a & 0xFF) << 24);
+}
+
+/// <summary>
+/// Get the instruction set of the kernels that are used on this processor.
+/// </summary>
+/// <returns>The instruction set.</returns>
+SpanBlend::InstructionSet SpanBlend::GetInstructionSet() noexcept {
+	static const auto instructionSet = DetectInstructionSet();
+	return instructionSet;
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#ifndef libtiffconvert_span_blend_h
+#define libtiffconvert_span_blend_h
+
+#include <cstdint>
+
+namespace TiffConvert {
+	/// <summary>
+	/// SpanBlend provides a class of static methods that paint horizontal spans of 24 or 32-bit pixels in a single color. 
+	/// The highlight mode, which only paints pixels that are white, is applied to the whole span at once instead of through 
+	/// a filter callback per pixel. Spans can also be inverted. The kernels are vectorized and the best kernel for the processor is selected at runtime.
+	/// </summary>
+	class SpanBlend {
+		public:
+			/// <summary>
+			/// The instruction sets the kernels are implemented with.
+			/// </summary>
+			enum class InstructionSet {
+				Scalar,
+				Sse2,
+				Ssse3,
+				Avx2
+			};
+
+			/// <summary>
+			/// Paint a span of pixels in a single color.
+			/// </summary>
+			/// <param name="pixels">The first pixel of the span.</param>
+			/// <param name="count">The number of pixels in the span.</param>
+			/// <param name="bytesPerPixel">The size of a pixel, 3 or 4 bytes.</param>
+			/// <param name="pixel">The color as stored in memory, see <see cref="Pack"/>. Alpha below 255 is blended.</param>
+			/// <param name="highlight">Only paint pixels that are white.</param>
+			static void Fill(uint8_t* pixels, uint32_t count, uint32_t bytesPerPixel, uint32_t pixel, bool highlight = false) noexcept;
+
+			/// <summary>
+			/// Paint a span of pixels in a single color through a coverage mask, such as the mask of rasterized text.
+			/// </summary>
+			/// <param name="pixels">The first pixel of the span.</param>
+			/// <param name="coverage">The coverage of each pixel in the span, from 0 (not painted) to 255 (fully painted).</param>
+			/// <param name="count">The number of pixels in the span.</param>
+			/// <param name="bytesPerPixel">The size of a pixel, 3 or 4 bytes.</param>
+			/// <param name="pixel">The color as stored in memory, see <see cref="Pack"/>. Alpha below 255 is blended.</param>
+			/// <param name="highlight">Only paint pixels that are white.</param>
+			static void FillMasked(uint8_t* pixels, const uint8_t* coverage, uint32_t count, uint32_t bytesPerPixel, uint32_t pixel, bool highlight = false) noexcept;
+
+			/// <summary>
+			/// Invert the color of a span of pixels, the alpha component of 32-bit pixels is kept.
+			/// </summary>
+			/// <param name="pixels">The first pixel of the span.</param>
+			/// <param name="count">The number of pixels in the span.</param>
+			/// <param name="bytesPerPixel">The size of a pixel, 3 or 4 bytes.</param>
+			static void Invert(uint8_t* pixels, uint32_t count, uint32_t bytesPerPixel) noexcept;
+
+			/// <summary>
+			/// Pack a color into the value that is stored in memory for a pixel, least significant byte first.
+			/// </summary>
+			/// <param name="r">The red component.</param>
+			/// <param name="g">The green component.</param>
+			/// <param name="b">The blue component.</param>
+			/// <param name="a">The alpha component.</param>
+			/// <param name="bgr">Whether the pixels are stored blue first.</param>
+			/// <returns>The packed pixel, with the alpha component in the most significant byte.</returns>
+			static uint32_t Pack(uint32_t r, uint32_t g, uint32_t b, uint32_t a, bool bgr) noexcept;
+
+			/// <summary>
+			/// Get the instruction set of the kernels that are used on this processor.
+			/// </summary>
+			/// <returns>The instruction set.</returns>
+			static InstructionSet GetInstructionSet() noexcept;
+	};
+}
+
+#endif
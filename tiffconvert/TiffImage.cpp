@@ -1,5 +1,12 @@
 #include "TiffImage.hpp"
+#include "TiffPage.hpp"
+#include "Renderer.hpp"
+#include "BilevelScaler.hpp"
+#include <CcittDecoder.hpp>
 #include <stdexcept>
+#include <algorithm>
+#include <cmath>
+#include <fstream>
 
 using namespace TiffConvert;
 
@@ -37,6 +44,35 @@ TiffImage::TiffImage(const void* buffer, uint32_t size) {
 	m_ImageHandle = image;
 }
 
+/// <summary>
+/// Construct a new TiffImage instance from a shared buffer of Tiff data, for example a mapped file that is 
+/// also parsed by a TiffFile instance. The buffer is not copied and is kept alive by this instance. The memory must
+/// be writable, libtiffconvert temporarily patches the IFD offsets in it to select the page it decodes.
+/// </summary>
+/// <param name="buffer">A pointer to the Tiff image data.</param>
+/// <param name="size">The size of the image.</param>
+/// <param name="owner">The owner of the memory <paramref name="buffer"/> points to.</param>
+TiffImage::TiffImage(const void* buffer, uint32_t size, std::shared_ptr<const void> owner)
+	: TiffImage(buffer, size) {
+
+	m_Owner = std::move(owner);
+}
+
+/// <summary>
+/// Construct a new TiffImage instance from a shared buffer of Tiff data that is also parsed by a TiffFile instance. 
+/// Bilevel CCITT compressed pages are decoded natively from the parsed file, other pages are decoded by libtiffconvert.
+/// </summary>
+/// <param name="buffer">A pointer to the Tiff image data.</param>
+/// <param name="size">The size of the image.</param>
+/// <param name="owner">The owner of the memory <paramref name="buffer"/> points to.</param>
+/// <param name="file">The Tiff file parsed from the same memory, its IFD collection must have been read.</param>
+TiffImage::TiffImage(const void* buffer, uint32_t size, std::shared_ptr<const void> owner, std::shared_ptr<const TiffWang::Tiff::TiffFile> file)
+	: TiffImage(buffer, size, std::move(owner)) {
+
+	if (file && file->GetPageCount() == GetPageCount())
+		m_File = std::move(file);
+}
+
 /// <summary>
 /// The destructor will release the internal image object.
 /// </summary>
@@ -55,6 +91,82 @@ uint32_t TiffImage::GetPageCount() const noexcept {
 	return static_cast<uint32_t>(tiff_image_page_count(m_ImageHandle));
 }
 
+/// <summary>
+/// Acquire a handle to a page, which decodes the page when it has not been decoded yet. The page stays decoded 
+/// while any handle to it is alive and is released when the last handle is destroyed. Acquiring a page that 
+/// already has a live handle returns that same handle. This instance must be owned by a std::shared_ptr.
+/// Different pages can be acquired from multiple threads at the same time, a page that is acquired by several 
+/// threads at once is decoded once.
+/// </summary>
+/// <param name="page">The page number.</param>
+/// <returns>A shared pointer to the page handle.</returns>
+std::shared_ptr<TiffPage> TiffImage::AcquirePage(uint32_t page) const {
+	if (page >= GetPageCount())
+		throw std::out_of_range("page number not within range of loaded image");
+
+	std::mutex* pageLock;
+
+	{
+		std::lock_guard<std::mutex> lock(m_PageMutex);
+		if (m_PageHandles.size() != GetPageCount()) {
+			m_PageHandles.resize(GetPageCount());
+			m_PageLocks.resize(GetPageCount());
+		}
+
+		auto handle = m_PageHandles[page].lock();
+		if (handle)
+			return handle;
+
+		if (!m_PageLocks[page])
+			m_PageLocks[page] = std::make_unique<std::mutex>();
+
+		pageLock = m_PageLocks[page].get();
+	}
+
+	// Decode the page without holding the lock, so that other pages can be decoded at the same time. A page is only 
+	// decoded by one thread at a time: two handles to one page would release the pixels the other is still using.
+	std::lock_guard<std::mutex> decode(*pageLock);
+
+	{
+		// Another thread may have decoded the page while this one was waiting for it.
+		std::lock_guard<std::mutex> lock(m_PageMutex);
+
+		auto handle = m_PageHandles[page].lock();
+		if (handle)
+			return handle;
+	}
+
+	// Bilevel CCITT pages are decoded natively, the page handle then finds the page loaded. Everything else, and pages
+	// the native decoder fails on, is decoded by libtiffconvert when the handle loads the page.
+	if (m_File)
+		DecodeNativePage(page);
+
+	auto handle = std::make_shared<TiffPage>(shared_from_this(), page);
+
+	std::lock_guard<std::mutex> lock(m_PageMutex);
+	m_PageHandles[page] = handle;
+	return handle;
+}
+
+/// <summary>
+/// Decode a page when it has not been decoded yet. Every operation on a page does this implicitly.
+/// </summary>
+/// <param name="page">The page number.</param>
+/// <returns>True when successful, false otherwise.</returns>
+bool TiffImage::LoadPage(uint32_t page) const noexcept {
+	return tiff_image_page_load(m_ImageHandle, page);
+}
+
+/// <summary>
+/// Release the decoded pixels of a page, anything rendered onto the page is lost. The next operation on the 
+/// page decodes it again.
+/// </summary>
+/// <param name="page">The page number.</param>
+/// <returns>True when successful, false otherwise.</returns>
+bool TiffImage::ReleasePage(uint32_t page) const noexcept {
+	return tiff_image_page_release(m_ImageHandle, page);
+}
+
 /// <summary>
 /// Get the width in pixels for a specific page.
 /// </summary>
@@ -74,15 +186,174 @@ uint32_t TiffImage::GetPageHeight(uint32_t page) const noexcept {
 }
 
 /// <summary>
-/// Scale a Tiff page to maximum dimensions, don't touch the image if the dimensions are already within bounds.
+/// Get the pixel format a specific page is currently stored in.
+/// </summary>
+/// <param name="page">The page number.</param>
+/// <returns>The pixel format.</returns>
+tiff_page_format TiffImage::GetPageFormat(uint32_t page) const noexcept {
+	return static_cast<tiff_page_format>(tiff_image_page_format(m_ImageHandle, page));
+}
+
+/// <summary>
+/// Scale a Tiff page to maximum dimensions, don't touch the image if the dimensions are already within bounds. The
+/// nearest filter keeps bilevel pages bilevel. The box and bilinear filters average bilevel pages to gray, see
+/// <see cref="BilevelScaler"/>, other pages and filters are resampled natively, see <see cref="Resampler"/>.
 /// </summary>
 /// <param name="page">The page number.</param>
 /// <param name="width">The maximum width in pixels.</param>
 /// <param name="height">The maximum height in pixels.</param>
-/// <param name="smooth">Use interpolation while resizing.</param>
+/// <param name="filter">The filter to resize with.</param>
+/// <param name="threads">The number of threads to resample the page with.</param>
 /// <returns>True when successful, false otherwise.</returns>
-bool TiffImage::ScaleToMaximum(uint32_t page, uint32_t width, uint32_t height, bool smooth) const noexcept {
-	return tiff_image_page_scale(m_ImageHandle, page, width, height, smooth);
+bool TiffImage::ScaleToMaximum(uint32_t page, uint32_t width, uint32_t height, ScaleFilter filter, uint32_t threads) const noexcept {
+	if (filter == ScaleFilter::Nearest || page >= GetPageCount())
+		return tiff_image_page_scale(m_ImageHandle, page, width, height, false);
+
+	auto pageWidth  = GetPageWidth(page);
+	auto pageHeight = GetPageHeight(page);
+	auto maxWidth   = (width == 0) ? pageWidth : width;
+	auto maxHeight  = (height == 0) ? pageHeight : height;
+
+	if (pageWidth <= maxWidth && pageHeight <= maxHeight)
+		return true;
+
+	// Keep the aspect ratio the same way libtiffconvert does, see tiff_image_page_scale.
+	auto scaledWidth  = maxWidth;
+	auto scaledHeight = maxHeight;
+
+	if (static_cast<uint64_t>(maxWidth) * pageHeight < static_cast<uint64_t>(maxHeight) * pageWidth)
+		scaledHeight = static_cast<uint32_t>(std::llround(static_cast<double>(pageHeight) * maxWidth / pageWidth));
+	else
+		scaledWidth = static_cast<uint32_t>(std::llround(static_cast<double>(pageWidth) * maxHeight / pageHeight));
+
+	scaledWidth  = (std::max)(scaledWidth, 1u);
+	scaledHeight = (std::max)(scaledHeight, 1u);
+
+	try {
+		std::vector<uint8_t> pixels;
+		renderer_target resampled;
+
+		// Bilevel pages are averaged to gray straight from their bits, without promoting them first.
+		tiff_page_bits bits;
+		if (filter != ScaleFilter::Lanczos3 && tiff_image_page_bits(m_ImageHandle, page, &bits)) {
+			RasterTarget gray;
+			gray.Width        = scaledWidth;
+			gray.Height       = scaledHeight;
+			gray.BitsPerPixel = 24;
+			gray.Pitch        = static_cast<ptrdiff_t>(scaledWidth) * 3;
+
+			pixels.assign(static_cast<size_t>(gray.Pitch) * scaledHeight, 0);
+			gray.Bits = pixels.data();
+
+			BilevelScaler::ScaleToGray(bits, gray);
+
+			resampled = { gray.Bits, gray.Pitch, gray.Width, gray.Height, gray.BitsPerPixel, gray.Bgr };
+			if (tiff_image_page_replace(m_ImageHandle, page, &resampled))
+				return true;
+		}
+
+		Resampler resampler(pageWidth, pageHeight, scaledWidth, scaledHeight, filter);
+
+		// Bilevel pages are promoted while they are rendered to, the resampled page introduces gray pixels and stays RGB.
+		if (!renderer_begin(m_ImageHandle, page))
+			return false;
+
+		auto done = false;
+		try {
+			done = Renderer::Resample(resampler, pixels, resampled, threads);
+		} catch (...) {
+			renderer_stop();
+			throw;
+		}
+
+		renderer_stop();
+
+		if (done && tiff_image_page_replace(m_ImageHandle, page, &resampled))
+			return true;
+	} catch (const std::exception&) {
+		// Fall back to the interpolation of libtiffconvert, for example when the intermediate image cannot be allocated.
+	}
+
+	return tiff_image_page_scale(m_ImageHandle, page, width, height, true);
+}
+
+/// <summary>
+/// Invert the colors of a Tiff page. Bilevel pages are not traversed, their inversion is applied when they are encoded
+/// or expanded. Other pages are inverted natively in a single pass over their pixels.
+/// </summary>
+/// <param name="page">The page number.</param>
+/// <returns>True when successful, false otherwise.</returns>
+bool TiffImage::InvertPage(uint32_t page) const noexcept {
+	if (page >= GetPageCount() || GetPageFormat(page) != tiff_page_format::TIFF_PAGE_RGB)
+		return tiff_image_page_invert(m_ImageHandle, page);
+
+	if (!renderer_begin(m_ImageHandle, page))
+		return false;
+
+	auto inverted = Renderer::Invert();
+	renderer_stop();
+
+	// Fall back to libtiffconvert when the pixel format of the page cannot be inverted natively.
+	return inverted || tiff_image_page_invert(m_ImageHandle, page);
+}
+
+/// <summary>
+/// Encode a Tiff page to PNG natively, in the smallest format that holds its pixels exactly, see <see cref="PngEncoder"/>.
+/// Bilevel pages are encoded straight from their bits, without promoting them first.
+/// </summary>
+/// <param name="page">The page number to encode.</param>
+/// <param name="threads">The number of threads to encode the page with.</param>
+/// <param name="alpha">Whether the alpha of 32-bit pages is stored, otherwise every pixel is opaque.</param>
+/// <returns>The PNG file.</returns>
+/// <exception cref="std::out_of_range">When the page number is not within range of the loaded image.</exception>
+/// <exception cref="std::runtime_error">When the pixels of the page cannot be encoded natively.</exception>
+std::vector<uint8_t> TiffImage::EncodePng(uint32_t page, uint32_t threads, bool alpha) const {
+	if (page >= GetPageCount())
+		throw std::out_of_range("page number not within range of loaded image");
+
+	PngEncoder encoder(threads, alpha);
+
+	tiff_page_bits bits;
+	if (tiff_image_page_bits(m_ImageHandle, page, &bits))
+		return encoder.Encode(bits);
+
+	if (!renderer_begin(m_ImageHandle, page))
+		throw std::runtime_error("cannot access the pixels of page " + std::to_string(page));
+
+	std::vector<uint8_t> png;
+	auto done = false;
+	try {
+		done = Renderer::EncodePng(encoder, png);
+	} catch (...) {
+		renderer_stop();
+		throw;
+	}
+
+	renderer_stop();
+
+	if (!done)
+		throw std::runtime_error("cannot encode the pixel format of page " + std::to_string(page));
+
+	return png;
+}
+
+/// <summary>
+/// Encode a Tiff page to PNG file natively, see <see cref="EncodePng"/>.
+/// </summary>
+/// <param name="page">The page number to encode.</param>
+/// <param name="filename">The filename to save the page as.</param>
+/// <param name="threads">The number of threads to encode the page with.</param>
+/// <returns>True when successful, false otherwise.</returns>
+bool TiffImage::ExportPng(uint32_t page, const std::string& filename, uint32_t threads) const noexcept {
+	try {
+		auto png = EncodePng(page, threads);
+
+		std::ofstream output(filename, std::ios::binary | std::ios::trunc);
+		output.write(reinterpret_cast<const char*>(png.data()), static_cast<std::streamsize>(png.size()));
+		return output.good();
+	} catch (const std::exception&) {
+		return false;
+	}
 }
 
 /// <summary>
@@ -150,6 +421,14 @@ bool TiffImage::ExportPdf(const std::wstring& filepath, tiff_export_format codec
 	return tiff_image_export_pdf_w(m_ImageHandle, filepath.c_str(), codec, options);
 }
 
+/// <summary>
+/// Get the image handle contained within this object.
+/// </summary>
+/// <returns>A pointer to the internal structure describing this image.</returns>
+const tiff_image* TiffImage::get() const noexcept {
+	return m_ImageHandle;
+}
+
 /// <summary>
 /// Begin rendering to a specific page (or IFD).
 /// </summary>
@@ -198,4 +477,39 @@ bool TiffImage::Render(uint32_t page, std::function<void(HDC dc)> f) const {
 	f(dc);
 	EndRender();
 	return true;
-}
\ No newline at end of file
+}
+
+/// <summary>
+/// Decode a bilevel CCITT compressed page natively, straight into the bits of the page.
+/// </summary>
+/// <param name="page">The page number, the index of the IFD in the chain.</param>
+/// <returns>True when the page was decoded, false when libtiffconvert must decode it instead.</returns>
+bool TiffImage::DecodeNativePage(uint32_t page) const noexcept {
+	using namespace TiffWang::Tiff;
+
+	try {
+		auto pageIndex		   = m_File->GetPageIndexOfIfdChainIndex(page);
+		const auto& dimensions = m_File->GetDimensions(pageIndex);
+		const auto& layout	   = m_File->GetImageLayout(pageIndex);
+
+		if (dimensions.Width == 0 || dimensions.Height == 0 || !CcittDecoder::IsSupported(layout))
+			return false;
+
+		// CCITT black runs are set bits, which are white pixels when zero is black.
+		auto inverted = layout.Photometric == TiffPhotometric::BlackIsZero;
+		auto bits	  = tiff_image_page_allocate(m_ImageHandle, page, dimensions.Width, dimensions.Height, inverted);
+		if (bits == nullptr)
+			return false;
+
+		try {
+			CcittDecoder::DecodePage(*m_File, pageIndex, bits, TiffBitmap::GetStride(dimensions.Width));
+		} catch (...) {
+			ReleasePage(page);
+			return false;
+		}
+
+		return true;
+	} catch (...) {
+		return false;
+	}
+}
@@ -5,17 +5,30 @@
 
 #include "libtiffconvert.h"
 #include "DestructibleBuffer.hpp"
+#include "Resampler.hpp"
+#include "PngEncoder.hpp"
+#include <TiffFile.hpp>
 #include <string>
 #include <memory>
 #include <functional>
+#include <vector>
+#include <mutex>
 
 namespace TiffConvert {
+	class TiffPage;
+
 	/// <summary>
-	/// The TiffImage class describes collection of loaded Tiff pages (1 or more) as decoded image.
+	/// The TiffImage class describes collection of loaded Tiff pages (1 or more) as decoded image. Pages are decoded 
+	/// on first use, and can be released again through <see cref="ReleasePage"/> or a <see cref="TiffPage"/> handle.
 	/// </summary>
-	class TiffImage {
+	class TiffImage : public std::enable_shared_from_this<TiffImage> {
 		private:
-			const tiff_image* m_ImageHandle = nullptr;
+			const tiff_image*								m_ImageHandle = nullptr;
+			std::shared_ptr<const void>						m_Owner;
+			std::shared_ptr<const TiffWang::Tiff::TiffFile>	m_File;				// Decodes CCITT pages natively when set.
+			mutable std::vector<std::weak_ptr<TiffPage>>	m_PageHandles;
+			mutable std::vector<std::unique_ptr<std::mutex>>	m_PageLocks;		// Held while a page is decoded by AcquirePage.
+			mutable std::mutex								m_PageMutex;		// Guards m_PageHandles and m_PageLocks.
 
 		public:
 			/// <summary>
@@ -36,6 +49,26 @@ namespace TiffConvert {
 			/// <param name="buffer">A pointer to the Tiff image data.</param>
 			/// <param name="size">The size of the image.</param>
 			TiffImage(const void* buffer, uint32_t size);
+
+			/// <summary>
+			/// Construct a new TiffImage instance from a shared buffer of Tiff data, for example a mapped file that is 
+			/// also parsed by a TiffFile instance. The buffer is not copied and is kept alive by this instance. The memory must
+			/// be writable, libtiffconvert temporarily patches the IFD offsets in it to select the page it decodes.
+			/// </summary>
+			/// <param name="buffer">A pointer to the Tiff image data.</param>
+			/// <param name="size">The size of the image.</param>
+			/// <param name="owner">The owner of the memory <paramref name="buffer"/> points to.</param>
+			TiffImage(const void* buffer, uint32_t size, std::shared_ptr<const void> owner);
+
+			/// <summary>
+			/// Construct a new TiffImage instance from a shared buffer of Tiff data that is also parsed by a TiffFile instance. 
+			/// Bilevel CCITT compressed pages are decoded natively from the parsed file, other pages are decoded by libtiffconvert.
+			/// </summary>
+			/// <param name="buffer">A pointer to the Tiff image data.</param>
+			/// <param name="size">The size of the image.</param>
+			/// <param name="owner">The owner of the memory <paramref name="buffer"/> points to.</param>
+			/// <param name="file">The Tiff file parsed from the same memory, its IFD collection must have been read.</param>
+			TiffImage(const void* buffer, uint32_t size, std::shared_ptr<const void> owner, std::shared_ptr<const TiffWang::Tiff::TiffFile> file);
 			
 			/// <summary>
 			/// The destructor will release the internal image object.
@@ -48,6 +81,34 @@ namespace TiffConvert {
 			/// <returns>The page count.</returns>
 			uint32_t GetPageCount() const noexcept;
 
+			/// <summary>
+			/// Acquire a handle to a page, which decodes the page when it has not been decoded yet. The page stays decoded 
+			/// while any handle to it is alive and is released when the last handle is destroyed. Acquiring a page that 
+			/// already has a live handle returns that same handle. This instance must be owned by a std::shared_ptr.
+			/// Different pages can be acquired from multiple threads at the same time, a page that is acquired by several 
+			/// threads at once is decoded once.
+			/// </summary>
+			/// <param name="page">The page number.</param>
+			/// <returns>A shared pointer to the page handle.</returns>
+			/// <exception cref="std::out_of_range">When the page number is not within range of the loaded image.</exception>
+			/// <exception cref="std::runtime_error">When the page cannot be decoded.</exception>
+			std::shared_ptr<TiffPage> AcquirePage(uint32_t page) const;
+
+			/// <summary>
+			/// Decode a page when it has not been decoded yet. Every operation on a page does this implicitly.
+			/// </summary>
+			/// <param name="page">The page number.</param>
+			/// <returns>True when successful, false otherwise.</returns>
+			bool LoadPage(uint32_t page) const noexcept;
+
+			/// <summary>
+			/// Release the decoded pixels of a page, anything rendered onto the page is lost. The next operation on the 
+			/// page decodes it again.
+			/// </summary>
+			/// <param name="page">The page number.</param>
+			/// <returns>True when successful, false otherwise.</returns>
+			bool ReleasePage(uint32_t page) const noexcept;
+
 			/// <summary>
 			/// Get the width in pixels for a specific page.
 			/// </summary>
@@ -63,14 +124,53 @@ namespace TiffConvert {
 			uint32_t GetPageHeight(uint32_t page) const noexcept;
 
 			/// <summary>
-			/// Scale a Tiff page to maximum dimensions, don't touch the image if the dimensions are already within bounds.
+			/// Get the pixel format a specific page is currently stored in.
+			/// </summary>
+			/// <param name="page">The page number.</param>
+			/// <returns>The pixel format.</returns>
+			tiff_page_format GetPageFormat(uint32_t page) const noexcept;
+
+			/// <summary>
+			/// Scale a Tiff page to maximum dimensions, don't touch the image if the dimensions are already within bounds. The
+			/// nearest filter keeps bilevel pages bilevel. The box and bilinear filters average bilevel pages to gray, see
+			/// <see cref="BilevelScaler"/>, other pages and filters are resampled natively, see <see cref="Resampler"/>.
 			/// </summary>
 			/// <param name="page">The page number.</param>
 			/// <param name="width">The maximum width in pixels.</param>
 			/// <param name="height">The maximum height in pixels.</param>
-			/// <param name="smooth">Use interpolation while resizing.</param>
+			/// <param name="filter">The filter to resize with.</param>
+			/// <param name="threads">The number of threads to resample the page with.</param>
 			/// <returns>True when successful, false otherwise.</returns>
-			bool ScaleToMaximum(uint32_t page, uint32_t width, uint32_t height, bool smooth = false) const noexcept;
+			bool ScaleToMaximum(uint32_t page, uint32_t width, uint32_t height, ScaleFilter filter = ScaleFilter::Nearest, uint32_t threads = 1) const noexcept;
+
+			/// <summary>
+			/// Invert the colors of a Tiff page. Bilevel pages are not traversed, their inversion is applied when they are encoded
+			/// or expanded. Other pages are inverted natively in a single pass over their pixels.
+			/// </summary>
+			/// <param name="page">The page number.</param>
+			/// <returns>True when successful, false otherwise.</returns>
+			bool InvertPage(uint32_t page) const noexcept;
+
+			/// <summary>
+			/// Encode a Tiff page to PNG natively, in the smallest format that holds its pixels exactly, see <see cref="PngEncoder"/>.
+			/// Bilevel pages are encoded straight from their bits, without promoting them first.
+			/// </summary>
+			/// <param name="page">The page number to encode.</param>
+			/// <param name="threads">The number of threads to encode the page with.</param>
+			/// <param name="alpha">Whether the alpha of 32-bit pages is stored, otherwise every pixel is opaque.</param>
+			/// <returns>The PNG file.</returns>
+			/// <exception cref="std::out_of_range">When the page number is not within range of the loaded image.</exception>
+			/// <exception cref="std::runtime_error">When the pixels of the page cannot be encoded natively.</exception>
+			std::vector<uint8_t> EncodePng(uint32_t page, uint32_t threads = 1, bool alpha = true) const;
+
+			/// <summary>
+			/// Encode a Tiff page to PNG file natively, see <see cref="EncodePng"/>.
+			/// </summary>
+			/// <param name="page">The page number to encode.</param>
+			/// <param name="filename">The filename to save the page as.</param>
+			/// <param name="threads">The number of threads to encode the page with.</param>
+			/// <returns>True when successful, false otherwise.</returns>
+			bool ExportPng(uint32_t page, const std::string& filename, uint32_t threads = 1) const noexcept;
 
 			/// <summary>
 			/// Encode a Tiff page to image file.
@@ -120,6 +220,12 @@ namespace TiffConvert {
 			/// <returns>True when successful, false otherwise.</returns>
 			bool ExportPdf(const std::wstring& filepath, tiff_export_format codec, uint32_t options);
 
+			/// <summary>
+			/// Get the image handle contained within this object.
+			/// </summary>
+			/// <returns>A pointer to the internal structure describing this image.</returns>
+			const tiff_image* get() const noexcept;
+
 			/// <summary>
 			/// Begin rendering to a specific page (or IFD).
 			/// </summary>
@@ -147,6 +253,14 @@ namespace TiffConvert {
 			/// <param name="f">The rendering function.</param>
 			/// <returns>True when successful, false otherwise.</returns>
 			bool Render(uint32_t page, std::function<void(HDC)> f) const;
+
+		private:
+			/// <summary>
+			/// Decode a bilevel CCITT compressed page natively, straight into the bits of the page.
+			/// </summary>
+			/// <param name="page">The page number, the index of the IFD in the chain.</param>
+			/// <returns>True when the page was decoded, false when libtiffconvert must decode it instead.</returns>
+			bool DecodeNativePage(uint32_t page) const noexcept;
 	};
 }
 
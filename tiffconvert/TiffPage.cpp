@@ -0,0 +1,57 @@
+#include "TiffPage.hpp"
+#include "TiffImage.hpp"
+#include <stdexcept>
+#include <string>
+
+using namespace TiffConvert;
+
+/// <summary>
+/// Construct a new page handle, decoding the page.
+/// </summary>
+/// <param name="image">The image the page belongs to.</param>
+/// <param name="page">The page number.</param>
+TiffPage::TiffPage(std::shared_ptr<const TiffImage> image, uint32_t page)
+	: m_Image(std::move(image)), m_Page(page) {
+
+	if (!m_Image->LoadPage(m_Page))
+		throw std::runtime_error("cannot decode page " + std::to_string(m_Page));
+}
+
+/// <summary>
+/// The destructor releases the decoded page.
+/// </summary>
+TiffPage::~TiffPage() {
+	m_Image->ReleasePage(m_Page);
+}
+
+/// <summary>
+/// Get the page number this handle refers to.
+/// </summary>
+/// <returns>The page number.</returns>
+uint32_t TiffPage::GetIndex() const noexcept {
+	return m_Page;
+}
+
+/// <summary>
+/// Get the width in pixels of the page.
+/// </summary>
+/// <returns>The width in pixels.</returns>
+uint32_t TiffPage::GetWidth() const noexcept {
+	return m_Image->GetPageWidth(m_Page);
+}
+
+/// <summary>
+/// Get the height in pixels of the page.
+/// </summary>
+/// <returns>The height in pixels.</returns>
+uint32_t TiffPage::GetHeight() const noexcept {
+	return m_Image->GetPageHeight(m_Page);
+}
+
+/// <summary>
+/// Get the pixel format the page is currently stored in.
+/// </summary>
+/// <returns>The pixel format.</returns>
+tiff_page_format TiffPage::GetFormat() const noexcept {
+	return m_Image->GetPageFormat(m_Page);
+}
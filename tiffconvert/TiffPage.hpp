@@ -0,0 +1,68 @@
+#pragma once
+
+#ifndef libtiffconvert_tiff_page_h
+#define libtiffconvert_tiff_page_h
+
+#include "libtiffconvert.h"
+#include <cstdint>
+#include <memory>
+
+namespace TiffConvert {
+	class TiffImage;
+
+	/// <summary>
+	/// TiffPage is a handle to a decoded page of a <see cref="TiffImage"/>. The page is decoded when the handle is 
+	/// constructed (unless it is already decoded) and released when the handle is destroyed, which keeps the number of 
+	/// decoded pages bounded by the number of live handles. Handles are acquired through <see cref="TiffImage::AcquirePage"/>.
+	/// </summary>
+	class TiffPage {
+		private:
+			std::shared_ptr<const TiffImage>	m_Image;
+			uint32_t							m_Page;
+
+		public:
+			/// <summary>
+			/// Construct a new page handle, decoding the page.
+			/// </summary>
+			/// <param name="image">The image the page belongs to.</param>
+			/// <param name="page">The page number.</param>
+			/// <exception cref="std::runtime_error">When the page cannot be decoded.</exception>
+			TiffPage(std::shared_ptr<const TiffImage> image, uint32_t page);
+
+			TiffPage(const TiffPage&) = delete;
+			TiffPage(TiffPage&&) = delete;
+			TiffPage& operator=(const TiffPage&) = delete;
+			TiffPage& operator=(TiffPage&&) = delete;
+
+			/// <summary>
+			/// The destructor releases the decoded page.
+			/// </summary>
+			~TiffPage();
+
+			/// <summary>
+			/// Get the page number this handle refers to.
+			/// </summary>
+			/// <returns>The page number.</returns>
+			uint32_t GetIndex() const noexcept;
+
+			/// <summary>
+			/// Get the width in pixels of the page.
+			/// </summary>
+			/// <returns>The width in pixels.</returns>
+			uint32_t GetWidth() const noexcept;
+
+			/// <summary>
+			/// Get the height in pixels of the page.
+			/// </summary>
+			/// <returns>The height in pixels.</returns>
+			uint32_t GetHeight() const noexcept;
+
+			/// <summary>
+			/// Get the pixel format the page is currently stored in.
+			/// </summary>
+			/// <returns>The pixel format.</returns>
+			tiff_page_format GetFormat() const noexcept;
+	};
+}
+
+#endif
@@ -21,6 +21,43 @@
 			std::negation<std::is_same<_TOfValue, char>>
 		> {};
 
+		/// <summary>
+		/// A wide stream buffer that converts everything that is written to it to the active code page and writes it to a 
+		/// narrow stream. A <see cref="VerbosePrinter"/> that logs into a buffer uses it for its wide stream, so that its 
+		/// narrow and wide output stay in the order they were written in.
+		/// </summary>
+		class NarrowingStreamBuffer : public std::wstreambuf {
+			private:
+				std::ostream&	m_Stream;
+
+			protected:
+				int_type overflow(int_type c) override {
+					if (traits_type::eq_int_type(c, traits_type::eof()))
+						return traits_type::not_eof(c);
+
+					auto ch = traits_type::to_char_type(c);
+					xsputn(&ch, 1);
+					return c;
+				}
+
+				std::streamsize xsputn(const wchar_t* s, std::streamsize n) override {
+					if (n <= 0)
+						return 0;
+
+					auto size = WideCharToMultiByte(CP_ACP, 0, s, static_cast<int>(n), nullptr, 0, nullptr, nullptr);
+					if (size <= 0)
+						return 0;
+
+					std::string narrow(static_cast<size_t>(size), '\0');
+					WideCharToMultiByte(CP_ACP, 0, s, static_cast<int>(n), narrow.data(), size, nullptr, nullptr);
+					m_Stream.write(narrow.data(), size);
+					return n;
+				}
+
+			public:
+				NarrowingStreamBuffer(std::ostream& stream) : m_Stream(stream) {}
+		};
+
 		class VerbosePrinter {
 			private:
 				std::ostream&	m_Stream;
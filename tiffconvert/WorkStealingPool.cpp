@@ -0,0 +1,118 @@
+#include "WorkStealingPool.hpp"
+
+using namespace TiffConvert;
+
+/// <summary>
+/// Construct a new pool and start its worker threads.
+/// </summary>
+/// <param name="threadCount">The number of worker threads, at least 1.</param>
+WorkStealingPool::WorkStealingPool(size_t threadCount) {
+	if (threadCount == 0)
+		threadCount = 1;
+
+	for (size_t i = 0; i < threadCount; ++i)
+		m_Queues.push_back(std::make_unique<WorkerQueue>());
+
+	for (size_t i = 0; i < threadCount; ++i)
+		m_Threads.emplace_back(&WorkStealingPool::Run, this, i);
+}
+
+/// <summary>
+/// The destructor runs all the tasks that are still queued, then stops and joins the worker threads.
+/// </summary>
+WorkStealingPool::~WorkStealingPool() {
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Stopping = true;
+	}
+
+	m_Signal.notify_all();
+
+	for (auto& thread : m_Threads)
+		thread.join();
+}
+
+/// <summary>
+/// Get the number of worker threads.
+/// </summary>
+/// <returns>The number of worker threads.</returns>
+size_t WorkStealingPool::GetThreadCount() const noexcept {
+	return m_Threads.size();
+}
+
+/// <summary>
+/// Queue a task to be run on one of the worker threads.
+/// </summary>
+/// <param name="task">The task to run.</param>
+void WorkStealingPool::Submit(Task task) {
+	size_t index;
+
+	{
+		// Count the task before it is visible in a queue, so that m_Queued never drops below the actual number.
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		index = m_Next;
+		m_Next = (m_Next + 1) % m_Queues.size();
+		++m_Queued;
+	}
+
+	{
+		auto& queue = *m_Queues[index];
+		std::lock_guard<std::mutex> lock(queue.Mutex);
+		queue.Tasks.push_back(std::move(task));
+	}
+
+	m_Signal.notify_one();
+}
+
+/// <summary>
+/// The main loop of a worker thread.
+/// </summary>
+/// <param name="index">The index of the queue that belongs to the worker.</param>
+void WorkStealingPool::Run(size_t index) {
+	for (;;) {
+		Task task;
+
+		if (!Take(index, task)) {
+			std::unique_lock<std::mutex> lock(m_Mutex);
+			m_Signal.wait(lock, [this]() { return m_Stopping || m_Queued > 0; });
+
+			// Only stop once every queue has been drained.
+			if (m_Stopping && m_Queued == 0)
+				return;
+
+			continue;
+		}
+
+		task();
+	}
+}
+
+/// <summary>
+/// Take the oldest task from the queue of a worker or, when that is empty, steal the oldest from another queue.
+/// </summary>
+/// <param name="index">The index of the queue that belongs to the worker.</param>
+/// <param name="task">The task that was taken.</param>
+/// <returns>True when a task was taken, false when all queues are empty.</returns>
+bool WorkStealingPool::Take(size_t index, Task& task) {
+	auto taken = false;
+
+	for (size_t i = 0; i < m_Queues.size() && !taken; ++i) {
+		auto& queue = *m_Queues[(index + i) % m_Queues.size()];
+		std::lock_guard<std::mutex> lock(queue.Mutex);
+
+		if (queue.Tasks.empty())
+			continue;
+
+		// Tasks are submitted in page order, taking the oldest first keeps the pages that are waited on first moving.
+		task = std::move(queue.Tasks.front());
+		queue.Tasks.pop_front();
+		taken = true;
+	}
+
+	if (taken) {
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		--m_Queued;
+	}
+
+	return taken;
+}
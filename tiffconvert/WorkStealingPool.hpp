@@ -0,0 +1,107 @@
+#pragma once
+
+#ifndef tiffconvert_work_stealing_pool_h
+#define tiffconvert_work_stealing_pool_h
+
+#include <cstdint>
+#include <deque>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <type_traits>
+
+namespace TiffConvert {
+	/// <summary>
+	/// WorkStealingPool runs tasks on a fixed number of worker threads. Each worker has its own queue; a worker takes tasks 
+	/// from the front of its own queue and, when that queue is empty, steals tasks from the front of the queues of the other 
+	/// workers. Tasks are distributed over the queues round-robin, so idle workers balance out pages that take longer, and
+	/// since every queue is first in first out, tasks finish roughly in the order they were submitted.
+	/// </summary>
+	class WorkStealingPool {
+		public:
+			using Task = std::function<void()>;	// A unit of work, it should not throw. Use Enqueue for tasks that may throw.
+
+		private:
+			/// <summary>
+			/// The queue of a single worker.
+			/// </summary>
+			struct WorkerQueue {
+				std::deque<Task>	Tasks;
+				std::mutex			Mutex;
+			};
+
+			std::vector<std::unique_ptr<WorkerQueue>>	m_Queues;
+			std::vector<std::thread>					m_Threads;
+			std::mutex									m_Mutex;
+			std::condition_variable						m_Signal;
+			size_t										m_Queued   = 0;		// The number of tasks in all queues, guarded by m_Mutex.
+			size_t										m_Next     = 0;		// The queue to submit the next task to, guarded by m_Mutex.
+			bool										m_Stopping = false;	// Guarded by m_Mutex.
+
+		public:
+			/// <summary>
+			/// Construct a new pool and start its worker threads.
+			/// </summary>
+			/// <param name="threadCount">The number of worker threads, at least 1.</param>
+			WorkStealingPool(size_t threadCount);
+
+			WorkStealingPool(const WorkStealingPool&) = delete;
+			WorkStealingPool(WorkStealingPool&&) = delete;
+			WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+			WorkStealingPool& operator=(WorkStealingPool&&) = delete;
+
+			/// <summary>
+			/// The destructor runs all the tasks that are still queued, then stops and joins the worker threads.
+			/// </summary>
+			~WorkStealingPool();
+
+			/// <summary>
+			/// Get the number of worker threads.
+			/// </summary>
+			/// <returns>The number of worker threads.</returns>
+			size_t GetThreadCount() const noexcept;
+
+			/// <summary>
+			/// Queue a task to be run on one of the worker threads.
+			/// </summary>
+			/// <param name="task">The task to run.</param>
+			void Submit(Task task);
+
+			/// <summary>
+			/// Queue a function to be run on one of the worker threads, and get a future for its result. An exception thrown 
+			/// by the function is rethrown by std::future::get.
+			/// </summary>
+			/// <typeparam name="TFunction">The type of the function.</typeparam>
+			/// <param name="function">The function to run.</param>
+			/// <returns>A future for the result of the function.</returns>
+			template <typename TFunction>
+			std::future<std::invoke_result_t<TFunction>> Enqueue(TFunction&& function) {
+				auto task   = std::make_shared<std::packaged_task<std::invoke_result_t<TFunction>()>>(std::forward<TFunction>(function));
+				auto result = task->get_future();
+
+				Submit([task]() { (*task)(); });
+				return result;
+			}
+
+		private:
+			/// <summary>
+			/// The main loop of a worker thread.
+			/// </summary>
+			/// <param name="index">The index of the queue that belongs to the worker.</param>
+			void Run(size_t index);
+
+			/// <summary>
+			/// Take the oldest task from the queue of a worker or, when that is empty, steal the oldest from another queue.
+			/// </summary>
+			/// <param name="index">The index of the queue that belongs to the worker.</param>
+			/// <param name="task">The task that was taken.</param>
+			/// <returns>True when a task was taken, false when all queues are empty.</returns>
+			bool Take(size_t index, Task& task);
+	};
+}
+
+#endif
@@ -16,6 +16,7 @@ extern "C" {
 	typedef struct __TIFF_IMAGE		tiff_image;		// internal tiff_image object
 	typedef struct __FONT_HANDLE	font_handle;	// internal font object
 	typedef struct __IMAGE_HANDLE	image_handle;	// internal image object
+	typedef struct __TIFF_PDF		tiff_pdf;		// internal pdf document object
 
 #pragma pack ( push, 1 )
 	/// <summary>
@@ -38,6 +39,15 @@ extern "C" {
 		TIFF_EXPORT_BITMAP
 	};
 
+	/// <summary>
+	/// The pixel formats a decoded Tiff page can be stored in by libtiffconvert. Bilevel pages are kept bit-packed 
+	/// and are only promoted to RGB when something that is not black or white is rendered onto them.
+	/// </summary>
+	enum class tiff_page_format : uint32_t {
+		TIFF_PAGE_BILEVEL,
+		TIFF_PAGE_RGB
+	};
+
 	/// <summary>
 	/// The fixed rotation modes supported by libtiffconvert (optimized rotation).
 	/// </summary>
@@ -55,6 +65,29 @@ extern "C" {
 		MIRROR_VERTICAL
 	};
 
+	/// <summary>
+	/// Describes the pixels of the output that is currently rendered to, see renderer_get_target.
+	/// </summary>
+	typedef struct __RENDERER_TARGET {
+		uint8_t*	Bits;			// The first byte of the top row.
+		intptr_t	Pitch;			// The number of bytes from one row to the next, negative for bottom-up buffers.
+		uint32_t	Width;
+		uint32_t	Height;
+		uint32_t	BitsPerPixel;	// 24 or 32.
+		uint32_t	Bgr;			// Whether the color components are stored blue first.
+	} renderer_target;
+
+	/// <summary>
+	/// Describes the bit-packed rows of a bilevel page, see tiff_image_page_bits.
+	/// </summary>
+	typedef struct __TIFF_PAGE_BITS {
+		const uint8_t*	Bits;			// The first byte of the top row, the msb is the leftmost pixel and a set bit is black.
+		uint32_t		Stride;			// The number of bytes per row.
+		uint32_t		Width;
+		uint32_t		Height;
+		uint32_t		Inverted;		// Whether the bits are inverted on output.
+	} tiff_page_bits;
+
 	/* rendering filter prototype */
 	typedef uint64_t (__stdcall *renderer_filter)(uint64_t x, uint64_t y, uint64_t source, uint64_t target);
 
@@ -77,23 +110,40 @@ extern "C" {
 	__API tiff_image*		__CONV tiff_image_open_a(const char* filename);
 	__API tiff_image*		__CONV tiff_image_open_w(const wchar_t* filename);
 	__API uint64_t			__CONV tiff_image_page_count(const tiff_image* handle);
+	__API uint64_t			__CONV tiff_image_page_load(const tiff_image* handle, uint32_t page);
+	__API uint64_t			__CONV tiff_image_page_release(const tiff_image* handle, uint32_t page);
 	__API void				__CONV tiff_image_close(const tiff_image* handle);
 	
 	__API uint64_t			__CONV tiff_image_page_width(const tiff_image* handle, uint32_t page);
 	__API uint64_t			__CONV tiff_image_page_height(const tiff_image* handle, uint32_t page);
+	__API uint64_t			__CONV tiff_image_page_format(const tiff_image* handle, uint32_t page);
+	__API uint64_t			__CONV tiff_image_page_bits(const tiff_image* handle, uint32_t page, tiff_page_bits* bits);
+	__API uint8_t*			__CONV tiff_image_page_allocate(const tiff_image* handle, uint32_t page, uint32_t width, uint32_t height, uint32_t inverted);
 	__API uint64_t			__CONV tiff_image_page_scale(const tiff_image* handle, uint32_t page, uint32_t maxwidth, uint32_t maxheight, uint32_t smooth);
+	__API uint64_t			__CONV tiff_image_page_replace(const tiff_image* handle, uint32_t page, const renderer_target* target);
+	__API uint64_t			__CONV tiff_image_page_invert(const tiff_image* handle, uint32_t page);
 
 	__API uint64_t			__CONV tiff_image_export_page_a(const tiff_image* handle, uint32_t page, const char* filename, tiff_export_format codec, uint32_t options);
 	__API uint64_t			__CONV tiff_image_export_page_w(const tiff_image* handle, uint32_t page, const wchar_t* filename, tiff_export_format codec, uint32_t options);
 	__API void*				__CONV tiff_image_export_page_p(const tiff_image* handle, uint32_t page, uint32_t* lpdwSize, tiff_export_format codec, uint32_t options);
+	__API void*				__CONV tiff_image_export_page_p24(const tiff_image* handle, uint32_t page, uint32_t* lpdwSize, tiff_export_format codec, uint32_t options);
 	
 	__API uint64_t			__CONV tiff_image_export_pdf_a(const tiff_image* handle, const char* filepath, tiff_export_format codec, uint32_t options);
 	__API uint64_t			__CONV tiff_image_export_pdf_w(const tiff_image* handle, const wchar_t* filepath, tiff_export_format codec, uint32_t options);
 
+	__API tiff_pdf*			__CONV tiff_pdf_create(tiff_export_format codec, uint32_t options);
+	__API void*				__CONV tiff_pdf_encode_page(const tiff_pdf* document, const tiff_image* handle, uint32_t page, uint32_t* lpdwSize);
+	__API uint64_t			__CONV tiff_pdf_add_encoded_page(const tiff_pdf* document, const void* buffer, uint32_t size, uint32_t width, uint32_t height);
+	__API uint64_t			__CONV tiff_pdf_add_page(const tiff_pdf* document, const tiff_image* handle, uint32_t page);
+	__API uint64_t			__CONV tiff_pdf_save_a(const tiff_pdf* document, const char* filepath);
+	__API uint64_t			__CONV tiff_pdf_save_w(const tiff_pdf* document, const wchar_t* filepath);
+	__API void				__CONV tiff_pdf_free(const tiff_pdf* document);
+
 	/* rendering module */
 
 	__API HDC				__CONV renderer_begin(const tiff_image* handle, uint32_t page);
 	__API void				__CONV renderer_stop();
+	__API uint64_t			__CONV renderer_get_target(renderer_target* target);
 	__API uint64_t			__CONV renderer_line(const POINT points[], uint32_t count, uint32_t size, uint32_t color, renderer_filter filter = nullptr);
 	__API uint64_t			__CONV renderer_single_line(const POINT points[], uint32_t count, uint32_t color, renderer_filter filter = nullptr);
 	__API uint64_t			__CONV renderer_rect(const RECT* bounds, uint32_t fillColor, uint32_t strokeColor, uint32_t fill, uint32_t stroke, uint32_t radius = 0, uint32_t strokeThickness = 0, renderer_filter filter = nullptr);
@@ -107,6 +157,7 @@ extern "C" {
 	__API font_handle*		__CONV font_open_a(const char* fontname, uint32_t height, uint32_t bold, uint32_t italic, uint32_t underline, uint32_t strikeout, uint32_t antialias);
 	__API font_handle*		__CONV font_open_w(const wchar_t* fontname, uint32_t height, uint32_t bold, uint32_t italic, uint32_t underline, uint32_t strikeout, uint32_t antialias);
 	__API void				__CONV font_close(const font_handle* font);
+	__API HFONT				__CONV font_get_id(const font_handle* font);
 
 	/* image module */
 	
@@ -1,33 +1,49 @@
 #include "Util.hpp"
 #include "TiffImage.hpp"
+#include "TiffPage.hpp"
+#include "PdfDocument.hpp"
+#include "WorkStealingPool.hpp"
 #include "Renderer.hpp"
 #include "DynaCli.hpp"
 #include "CodecValidator.hpp"
+#include "ScaleFilterValidator.hpp"
 #include "Arguments.hpp"
 #include "PreRenderWangHandler.hpp"
 #include "CompositeWangHandler.hpp"
 #include "VerboseWangHandler.hpp"
 #include "VerbosePrinter.hpp"
+#include "BandedPage.hpp"
+#include "BitmapWriter.hpp"
+#include "MrcPage.hpp"
 
 #include <TiffFile.hpp>
-#include <WangAnnotationReader.hpp>
+#include <WangDisplayList.hpp>
 
 #include <iostream>
 #include <string>
+#include <sstream>
 #include <vector>
 #include <unordered_map>
+#include <deque>
 #include <filesystem>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <future>
+#include <optional>
+#include <variant>
 
 namespace fs = std::filesystem;
 
 using CliContainer      = TiffConvert::Cli::DynaCli<bool, std::string, uint32_t>;    // The DynaCli container for this application.
 using TiffImage         = std::shared_ptr<TiffConvert::TiffImage>;                   // A shared pointer variant of TiffImage.
 using TiffFile          = std::shared_ptr<TiffWang::Tiff::TiffFile>;                 // A shared pointer variant of TiffFile.
-using AnotReader        = TiffWang::Tiff::WangAnnotationReader;                      // The annotation reader.
+using DisplayList       = TiffWang::Tiff::WangDisplayList;                           // The compiled annotations.
 using PreRenderer       = TiffConvert::Handlers::PreRenderWangHandler;               // The pre-render handler.
 using Composition       = TiffConvert::Handlers::CompositeWangHandler;
 using VerboseHandler    = TiffConvert::Handlers::VerboseWangHandler;
 using HandlerCollection = std::vector<std::shared_ptr<TiffWang::Tiff::IWangAnnotationCallback>>;
+using PreparedPdfPage   = std::variant<TiffConvert::PdfEncodedPage, std::vector<TiffConvert::PdfEncodedRegion>>; // An encoded page, or the compressed burned regions of a copied page.
 
 // A static mapping from codec name to extension.
 static std::unordered_map<std::string, std::string> codec_extension_map = {
@@ -45,6 +61,14 @@ static std::unordered_map<std::string, tiff_export_format> codec_map = {
     { "bitmap",   tiff_export_format::TIFF_EXPORT_BITMAP }
 };
 
+// A static mapping from scale filter name to scale filter.
+static std::unordered_map<std::string, TiffConvert::ScaleFilter> scale_filter_map = {
+    { "nearest",  TiffConvert::ScaleFilter::Nearest },
+    { "box",      TiffConvert::ScaleFilter::Box },
+    { "bilinear", TiffConvert::ScaleFilter::Bilinear },
+    { "lanczos3", TiffConvert::ScaleFilter::Lanczos3 }
+};
+
 /// <summary>
 /// Determine if the parent directory of a path exists.
 /// </summary>
@@ -70,174 +94,561 @@ std::string path_from_base_index(const std::string& path, size_t index, const st
 }
 
 /// <summary>
-/// Process the task at hand.
+/// Burn the eiStream/Wang annotations of a single page onto that page.
 /// </summary>
-/// <param name="cli">The main cli options object.</param>
-/// <param name="cli_image">The images subcommand cli options object.</param>
-/// <param name="cli_pdf">The pdf subcommand cli options object.</param>
 /// <param name="image">The decoded Tiff image.</param>
 /// <param name="file">The binary representation of the Tiff file.</param>
-/// <returns></returns>
-int process(const CliContainer& cli, const CliContainer& cli_image, const CliContainer& cli_pdf, TiffImage image, TiffFile file) {
-    auto& codec   = cli.get<std::string>(TiffConvert::Cli::NAME_OUTCODEC);
-    auto  verbose = cli.isset(TiffConvert::Cli::NAME_VERBOSE);
-    auto options  = static_cast<uint32_t>((codec.compare("jpeg") == 0 || codec.compare("jpeg2000") == 0) ? 10 : 0);
+/// <param name="pageIndex">The page to render the annotations of.</param>
+/// <param name="printer">The verbose printer, or nullptr when not running verbose.</param>
+void prerender_page(TiffImage image, TiffFile file, size_t pageIndex, std::shared_ptr<TiffConvert::Cli::VerbosePrinter> printer) {
+    auto verbose    = (printer != nullptr);
+    auto imageIndex = static_cast<uint32_t>(file->GetPageIfdChainIndex(pageIndex));
+
+    if (verbose) 
+        printer->BeginSection("TIFF IFD #" + std::to_string(pageIndex));
+
+    for (size_t ifdIndex = 0; ifdIndex < file->GetPageIfdCount(pageIndex); ifdIndex++) {
+        const auto& ifd = file->GetPageIfd(pageIndex, ifdIndex);
+        
+        if (verbose) {
+            uint32_t    multiple;
+            std::string type;
+
+            switch (ifd.TagType) {
+                case TiffTagType::SHORT:
+                    multiple = 2;
+                    type = "SHORT";
+                    break;
+                case TiffTagType::LONG:
+                    multiple = 4;
+                    type = "LONG";
+                    break;
+                case TiffTagType::RATIONAL:
+                    multiple = 8;
+                    type = "RATIONAL";
+                    break;
+                case TiffTagType::LONG8:
+                case TiffTagType::IFD8:
+                    multiple = 8;
+                    type = (ifd.TagType == TiffTagType::LONG8) ? "LONG8" : "IFD8";
+                    break;
+                case TiffTagType::ASCII:
+                case TiffTagType::BYTE:
+                    multiple = 1;
+                    type = (ifd.TagType == TiffTagType::ASCII) ? "ASCII" : "BYTE";
+                    break;
+                default:
+                    multiple = 0;
+                    type = "UNKNOWN";
+            }
 
-    std::shared_ptr<TiffConvert::Cli::VerbosePrinter> printer = nullptr;
+            printer->BeginSection("TIFF IFD ENTRY #" + std::to_string(ifdIndex));
+            printer->NumberHex("ID", static_cast<uint16_t>(ifd.TagId));
+            printer->Text("TYPE", type);
+            printer->NumberHex("OFFSET", ifd.ValueOffset, " bytes");
+            printer->Number("COUNT", ifd.ValueCount);
+            printer->Number("SIZE", ifd.ValueCount * multiple);
+            printer->Boolean("IS WANG", ifd.IsWangTag);
+        }
+
+        if (!ifd.IsWangTag) {
+            if (verbose)
+                printer->EndSection();
+            continue;
+        }
+        
+        // eiStream/Wang tag found: compile it before the page is drawn onto, then replay it onto the page.
+        auto marks = DisplayList::Compile(*file, ifd);
+
+        image->Render(imageIndex, [&](HDC hDc) {
+            // The page may have been scaled already, the marks are transformed to its current dimensions.
+            auto renderer = std::make_shared<PreRenderer>(file->GetDimensions(pageIndex), hDc, image->GetPageWidth(imageIndex), image->GetPageHeight(imageIndex));
+            
+            if (!verbose) {
+                // Not verbose, the renderer is the only handler 
+                marks->Replay(*renderer);
+            } else {
+                // Verbose, make a composition handler from the verbose handler (logger) and renderer handler 
+                Composition composition(HandlerCollection { 
+                    std::make_shared<VerboseHandler>(printer),
+                    renderer 
+                });
+
+                marks->Replay(composition);
+            }
+        });
+
+        if (verbose)
+            printer->EndSection();
+    }
 
-    // Construct a verbose printer to use for this session
     if (verbose)
-        printer = std::make_shared<TiffConvert::Cli::VerbosePrinter>(std::cout, std::wcout, true, "  ");
+        printer->EndSection();
+}
 
-    // Pass 1: Prerender eiStream/Wang annotations.
-    if (cli.isset(TiffConvert::Cli::NAME_PRERENDER)) {
-        for (size_t pageIndex = 0; pageIndex < file->GetPageCount(); ++pageIndex) {
-            if (verbose) 
-                printer->BeginSection("TIFF IFD #" + std::to_string(pageIndex));
+/// <summary>
+/// Determine if eiStream/Wang annotations are drawn as paths and text over the page, see <see cref="TiffConvert::PdfMarks"/>,
+/// instead of being burned onto it. This is requested on the command-line and only applies to the pdf command.
+/// </summary>
+/// <param name="cli">The main cli options object.</param>
+/// <returns>True when the annotations are drawn as vector marks.</returns>
+bool is_vector_wang(const CliContainer& cli) {
+    return cli.isset(TiffConvert::Cli::NAME_VECTORWANG)
+        && cli.get_chosen_subcommand_name() == TiffConvert::Cli::NAME_SUBCOMMAND_PDF;
+}
 
-            for (size_t ifdIndex = 0; ifdIndex < file->GetPageIfdCount(pageIndex); ifdIndex++) {
-                const auto& ifd = file->GetPageIfd(pageIndex, ifdIndex);
-                
-                if (verbose) {
-                    uint32_t    multiple;
-                    std::string type;
-
-                    switch (ifd.TagType) {
-                        case TiffTagType::SHORT:
-                            multiple = 2;
-                            type = "SHORT";
-                            break;
-                        case TiffTagType::LONG:
-                            multiple = 4;
-                            type = "LONG";
-                            break;
-                        case TiffTagType::RATIONAL:
-                            multiple = 8;
-                            type = "RATIONAL";
-                            break;
-                        case TiffTagType::ASCII:
-                        case TiffTagType::BYTE:
-                            multiple = 1;
-                            type = (ifd.TagType == TiffTagType::ASCII) ? "ASCII" : "BYTE";
-                            break;
-                        default:
-                            multiple = 0;
-                            type = "UNKNOWN";
-                    }
+/// <summary>
+/// Run a single page through every stage of the pipeline that precedes encoding: scaling, burning the annotations 
+/// and inverting the colors, in that order. Each stage only runs when it is enabled on the command-line.
+/// </summary>
+/// <param name="cli">The main cli options object.</param>
+/// <param name="image">The decoded Tiff image, nullptr when the file cannot be decoded.</param>
+/// <param name="file">The binary representation of the Tiff file.</param>
+/// <param name="pageIndex">The page to process.</param>
+/// <param name="printer">The verbose printer, or nullptr when not running verbose.</param>
+/// <returns>The handle to the page, which keeps the page decoded until it is destroyed.</returns>
+std::shared_ptr<TiffConvert::TiffPage> prepare_page(const CliContainer& cli, TiffImage image, TiffFile file, size_t pageIndex, std::shared_ptr<TiffConvert::Cli::VerbosePrinter> printer) {
+    auto verbose = (printer != nullptr);
+
+    // There is no decoded image for BigTIFF files and files over 4 GB, only their banded and copied pages are converted.
+    if (!image) {
+        throw std::runtime_error(file->IsBigTiff()
+            ? "BigTIFF is not supported by the decoder, page " + std::to_string(pageIndex) + " can only be converted with --banded or copied into a PDF"
+            : "tiff file is too large to be decoded, page " + std::to_string(pageIndex) + " can only be converted with --banded or copied into a PDF");
+    }
 
-                    printer->BeginSection("TIFF IFD ENTRY #" + std::to_string(ifdIndex));
-                    printer->NumberHex("ID", static_cast<uint16_t>(ifd.TagId));
-                    printer->Text("TYPE", type);
-                    printer->NumberHex("OFFSET", ifd.ValueOffset, " bytes");
-                    printer->Number("COUNT", ifd.ValueCount);
-                    printer->Number("SIZE", ifd.ValueCount * multiple);
-                    printer->Boolean("IS WANG", ifd.IsWangTag);
-                }
+    // libtiffconvert counts pages along the IFD chain, libtiffwang orders them by their page numbers.
+    auto page    = image->AcquirePage(static_cast<uint32_t>(file->GetPageIfdChainIndex(pageIndex)));
 
-                if (!ifd.IsWangTag) {
-                    printer->EndSection();
-                    continue;
-                }
-                
-                // eiStream/Wang tag found: read and render it.
-                image->Render(static_cast<uint32_t>(pageIndex), [&](HDC hDc) {
+    // Stage 1: Scale the page.
+    if (cli.anyset({ TiffConvert::Cli::NAME_MAXWIDTH, TiffConvert::Cli::NAME_MAXHEIGHT })) {
+        auto maxwidth  = cli.get_isset_or<uint32_t>(TiffConvert::Cli::NAME_MAXWIDTH, 0);
+        auto maxheight = cli.get_isset_or<uint32_t>(TiffConvert::Cli::NAME_MAXHEIGHT, 0);
+        auto filter    = TiffConvert::ScaleFilter::Nearest;
+
+        if (cli.isset(TiffConvert::Cli::NAME_SCALEFILTER))
+            filter = scale_filter_map.at(cli.get<std::string>(TiffConvert::Cli::NAME_SCALEFILTER));
+        else if (cli.isset(TiffConvert::Cli::NAME_SCALESMOOTH))
+            filter = TiffConvert::ScaleFilter::Bilinear;
+
+        // A single page at a time is resampled on every processor core, parallel pages are resampled on one thread each.
+        auto threads = (cli.get_isset_or<uint32_t>(TiffConvert::Cli::NAME_JOBS, 1) == 1) ? (std::max)(1u, std::thread::hardware_concurrency()) : 1u;
+
+        if (verbose) {
+            printer->Section("SCALE", [&]() {
+                printer->Number("PAGE", pageIndex);
+                printer->Text("FILTER", cli.get_isset_or<std::string>(TiffConvert::Cli::NAME_SCALEFILTER, (filter == TiffConvert::ScaleFilter::Bilinear) ? "bilinear" : "nearest"));
+            });
+        }
+
+        if (!image->ScaleToMaximum(page->GetIndex(), maxwidth, maxheight, filter, threads))
+            throw std::runtime_error("page scaling failed for page " + std::to_string(pageIndex));
+    }
+
+    // Stage 2: Prerender eiStream/Wang annotations, in the space of the scaled page so that they are rasterized at the
+    // resolution of the output instead of being scaled along with the page. Vector marks are drawn by the PDF instead.
+    if (cli.isset(TiffConvert::Cli::NAME_PRERENDER) && !is_vector_wang(cli))
+        prerender_page(image, file, pageIndex, printer);
+
+    // Stage 3: Invert colors
+    if (cli.isset(TiffConvert::Cli::NAME_INVERT)) {
+        if (verbose) {
+            printer->Section("INVERT", [&]() {
+                printer->Number("PAGE", pageIndex);
+                printer->Boolean("BILEVEL", page->GetFormat() == tiff_page_format::TIFF_PAGE_BILEVEL);
+            });
+        }
+
+        // Invert the page in the pixel format it is stored in, bilevel pages are inverted without promoting them to RGB.
+        if (!image->InvertPage(page->GetIndex()))
+            throw std::runtime_error("page inversion failed for page " + std::to_string(pageIndex));
+    }
+
+    return page;
+}
+
+/// <summary>
+/// Determine if a page can be converted in bands, see <see cref="TiffConvert::BandedPage"/>. Banding is requested on the 
+/// command-line and only applies to bilevel CCITT pages that are written as bitmap without being scaled.
+/// </summary>
+/// <param name="cli">The main cli options object.</param>
+/// <param name="file">The binary representation of the Tiff file.</param>
+/// <param name="pageIndex">The page to convert.</param>
+/// <returns>True when the page is converted in bands, false when it is decoded as a whole.</returns>
+bool is_banded_page(const CliContainer& cli, TiffFile file, size_t pageIndex) {
+    return cli.isset(TiffConvert::Cli::NAME_BANDED)
+        && cli.get<std::string>(TiffConvert::Cli::NAME_OUTCODEC).compare("bitmap") == 0
+        && !cli.anyset({ TiffConvert::Cli::NAME_MAXWIDTH, TiffConvert::Cli::NAME_MAXHEIGHT })
+        && TiffConvert::BandedPage::IsSupported(*file, pageIndex);
+}
+
+/// <summary>
+/// Determine if the annotations of a page are burned into color regions over the page, see <see cref="TiffConvert::MrcPage"/>,
+/// instead of onto the page as a whole. This is requested on the command-line and only applies to bilevel CCITT pages 
+/// written to PDF with prerendered annotations.
+/// </summary>
+/// <param name="cli">The main cli options object.</param>
+/// <param name="file">The binary representation of the Tiff file.</param>
+/// <param name="pageIndex">The page to convert.</param>
+/// <returns>True when the annotations are burned into color regions.</returns>
+bool is_mrc_page(const CliContainer& cli, TiffFile file, size_t pageIndex) {
+    return cli.isset(TiffConvert::Cli::NAME_MRC)
+        && cli.isset(TiffConvert::Cli::NAME_PRERENDER)
+        && cli.get_chosen_subcommand_name() == TiffConvert::Cli::NAME_SUBCOMMAND_PDF
+        && !is_vector_wang(cli)
+        && TiffConvert::BandedPage::IsSupported(*file, pageIndex);
+}
+
+/// <summary>
+/// Determine if a page is copied into a PDF as it is, see <see cref="TiffConvert::PdfDocument::CopyPage"/>. This applies
+/// to CCITT Group 4 pages that are not scaled and have no annotations to burn, inversion is done by the PDF reader. 
+/// Annotations that are drawn as vector marks or burned into color regions do not need the page to be re-encoded.
+/// </summary>
+/// <param name="cli">The main cli options object.</param>
+/// <param name="file">The binary representation of the Tiff file.</param>
+/// <param name="pageIndex">The page to convert.</param>
+/// <returns>True when the page is copied, false when it is decoded and encoded.</returns>
+bool is_copied_page(const CliContainer& cli, TiffFile file, size_t pageIndex) {
+    if (cli.anyset({ TiffConvert::Cli::NAME_MAXWIDTH, TiffConvert::Cli::NAME_MAXHEIGHT }))
+        return false;
+
+    if (cli.isset(TiffConvert::Cli::NAME_PRERENDER) && !is_vector_wang(cli) && !is_mrc_page(cli, file, pageIndex)) {
+        for (size_t ifdIndex = 0; ifdIndex < file->GetPageIfdCount(pageIndex); ++ifdIndex) {
+            if (file->GetPageIfd(pageIndex, ifdIndex).IsWangTag)
+                return false;
+        }
+    }
+
+    return TiffConvert::PdfDocument::CanCopyPage(*file, pageIndex);
+}
+
+/// <summary>
+/// Convert a page to bitmap in bands of rows: every band is decoded from the strips of the page, the annotations that 
+/// intersect the band are burned into it, it is inverted and then appended to the bitmap file. The page is never held 
+/// in memory as a whole. Without annotations to burn, the bands stay bit-packed and inversion is done by the palette.
+/// </summary>
+/// <param name="cli">The main cli options object.</param>
+/// <param name="file">The binary representation of the Tiff file.</param>
+/// <param name="pageIndex">The page to convert.</param>
+/// <param name="target">The bitmap file to write.</param>
+/// <param name="printer">The verbose printer, or nullptr when not running verbose.</param>
+void export_banded_page(const CliContainer& cli, TiffFile file, size_t pageIndex, const std::string& target, std::shared_ptr<TiffConvert::Cli::VerbosePrinter> printer) {
+    auto verbose   = (printer != nullptr);
+    auto invert    = cli.isset(TiffConvert::Cli::NAME_INVERT);
+
+    // The marks are compiled once and replayed into every band, only those that intersect the band are rasterized.
+    auto marks     = cli.isset(TiffConvert::Cli::NAME_PRERENDER) ? DisplayList::Compile(*file, pageIndex) : nullptr;
+    auto prerender = (marks != nullptr && !marks->IsEmpty());
+
+    TiffConvert::BandedPage page(*file, pageIndex);
+
+    auto bitsPerPixel = prerender ? 24u : 1u;
+    TiffConvert::BitmapWriter writer(target, page.GetWidth(), page.GetHeight(), bitsPerPixel, invert && !prerender);
+
+    if (verbose) {
+        printer->Section("BANDED", [&]() {
+            printer->Number("PAGE", pageIndex);
+            printer->Number("IFD", file->GetPageIfdChainIndex(pageIndex));
+            printer->Number("WIDTH", page.GetWidth());
+            printer->Number("HEIGHT", page.GetHeight());
+            printer->Number("BITS PER PIXEL", bitsPerPixel);
+            printer->Boolean("PRERENDER", prerender);
+            printer->Boolean("INVERT", invert);
+        });
+    }
+
+    // The fonts of text marks are sized for the resolution of a device context, there is no page to draw on.
+    auto hDc = prerender ? CreateCompatibleDC(nullptr) : nullptr;
+
+    try {
+        page.Render(bitsPerPixel, [&](const TiffConvert::RasterTarget& band, uint32_t top) {
+            if (prerender) {
+                TiffConvert::Renderer::BeginBand(band);
+
+                try {
                     auto renderer = std::make_shared<PreRenderer>(file->GetDimensions(pageIndex), hDc);
-                    AnotReader wangReader(*file, ifd);
-                    
-                    if (!verbose) {
-                        // Not verbose, just set the renderer as the only handler 
-                        wangReader.SetHandler(renderer);
-                    } else {
-                        // Verbose, make a composition handler from the verbose handler (logger) and renderer handler 
-                        wangReader.SetHandler(std::make_shared<Composition>(HandlerCollection { 
+                    renderer->SetBand(top, band.Height);
+
+                    // The marks are only logged once, while the first band is rendered.
+                    if (verbose && top == 0) {
+                        Composition composition(HandlerCollection {
                             std::make_shared<VerboseHandler>(printer),
-                            renderer 
-                        }));
+                            renderer
+                        });
+
+                        marks->Replay(composition);
+                    } else {
+                        marks->Replay(*renderer);
                     }
 
-                    // Read the eiStream/wang tags and invoke the handlers on significant events. 
-                    wangReader.Read();
-                });
+                    if (invert)
+                        TiffConvert::Renderer::Invert();
+                } catch (...) {
+                    TiffConvert::Renderer::EndBand();
+                    throw;
+                }
 
-                printer->EndSection();
+                TiffConvert::Renderer::EndBand();
             }
 
-            if (verbose)
-                printer->EndSection();
-        }
+            writer.Write(band);
+        });
+
+        writer.Close();
+    } catch (...) {
+        if (hDc)
+            DeleteDC(hDc);
+
+        throw;
     }
 
-    // Pass 2: Invert colors
-    if (cli.isset(TiffConvert::Cli::NAME_INVERT)) {
-        #pragma warning ( push )
-        #pragma warning ( disable: 4100 ) // unreferenced formal parameter, this is a callback function and we don't need all the parameters from the interface.
-        auto filter = [](uint64_t x, uint64_t y, uint64_t top, uint64_t bottom) -> uint64_t {
-            return bottom ^ 0xffffff;
-        };
-        #pragma warning ( pop ) 
-
-        for (size_t pageIndex = 0; pageIndex < file->GetPageCount(); ++pageIndex) {
-            const auto& pageDimensions = file->GetDimensions(pageIndex);
-
-            if (verbose) {
-                printer->Section("INVERT", [&]() {
-                    printer->Number("PAGE", pageIndex);
-                });
+    if (hDc)
+        DeleteDC(hDc);
+}
+
+/// <summary>
+/// Burn the annotations of a bilevel page into color regions only, see <see cref="TiffConvert::MrcPage"/>. The page is
+/// decoded in bands and only the bands the marks draw onto are burned, the page itself is copied into the PDF as it is.
+/// </summary>
+/// <param name="file">The binary representation of the Tiff file.</param>
+/// <param name="pageIndex">The page to convert.</param>
+/// <param name="printer">The verbose printer, or nullptr when not running verbose.</param>
+/// <returns>The regions to draw over the page, empty when the page has no annotations.</returns>
+std::vector<TiffConvert::MrcRegion> render_mrc_regions(TiffFile file, size_t pageIndex, std::shared_ptr<TiffConvert::Cli::VerbosePrinter> printer) {
+    auto verbose = (printer != nullptr);
+    auto marks   = DisplayList::Compile(*file, pageIndex);
+
+    if (marks->IsEmpty())
+        return {};
+
+    TiffConvert::MrcPage page(*file, pageIndex, *marks);
+    std::vector<TiffConvert::MrcRegion> regions;
+
+    // The fonts of text marks are sized for the resolution of a device context, there is no page to draw on.
+    auto hDc    = CreateCompatibleDC(nullptr);
+    auto logged = false;
+
+    try {
+        regions = page.Render([&](const TiffConvert::RasterTarget& band, uint32_t top) {
+            TiffConvert::Renderer::BeginBand(band);
+
+            try {
+                auto renderer = std::make_shared<PreRenderer>(file->GetDimensions(pageIndex), hDc);
+                renderer->SetBand(top, band.Height);
+
+                // The marks are only logged once, while the first band is burned.
+                if (verbose && !logged) {
+                    Composition composition(HandlerCollection {
+                        std::make_shared<VerboseHandler>(printer),
+                        renderer
+                    });
+
+                    marks->Replay(composition);
+                    logged = true;
+                } else {
+                    marks->Replay(*renderer);
+                }
+            } catch (...) {
+                TiffConvert::Renderer::EndBand();
+                throw;
             }
 
-            // Xor the image content with 0xffffff through a filter, effectively causing the colors to invert.
-            image->Render(static_cast<uint32_t>(pageIndex), [&] () {
-                /* 
-                    Use libtiffconvert's internal API call instead of the Renderer class so that we can 
-                    specify a custom filter. We basically draw a black rectangle (rgba(0, 0, 0, 255)) 
-                    onto the output, which is only used for the metrics. The filter used simply xor's the 
-                    bottom color with 0xffffff.
-                */
-                RECT r{ 0, 0, static_cast<LONG>(pageDimensions.Width), static_cast<LONG>(pageDimensions.Height) };
-                renderer_rect(&r, 255U << 24, 0U, true, false, 0U, 0U, filter); 
-            });
-        }
+            TiffConvert::Renderer::EndBand();
+        });
+    } catch (...) {
+        DeleteDC(hDc);
+        throw;
     }
 
-    // Pass 3: Scale pages.
-    if (cli.anyset({ TiffConvert::Cli::NAME_MAXWIDTH, TiffConvert::Cli::NAME_MAXHEIGHT })) {
-        auto maxwidth  = cli.get_isset_or<uint32_t>(TiffConvert::Cli::NAME_MAXWIDTH, 0);
-        auto maxheight = cli.get_isset_or<uint32_t>(TiffConvert::Cli::NAME_MAXHEIGHT, 0);
-        auto smooth    = cli.isset(TiffConvert::Cli::NAME_SCALESMOOTH);
+    DeleteDC(hDc);
 
-        for (size_t pageIndex = 0; pageIndex < file->GetPageCount(); ++pageIndex) {
-            if (verbose) {
-                printer->Section("SCALE", [&]() {
-                    printer->Number("PAGE", pageIndex);
-                });
+    if (verbose) {
+        printer->Section("MRC", [&]() {
+            printer->Number("PAGE", pageIndex);
+            printer->Number("IFD", file->GetPageIfdChainIndex(pageIndex));
+            printer->Number("REGIONS", regions.size());
+        });
+    }
+
+    return regions;
+}
+
+/// <summary>
+/// Run a task for every page and consume the results in page order. With more than one job the tasks run on a 
+/// work-stealing thread pool, while the results are still consumed on the calling thread in page order so that 
+/// the output is the same regardless of the number of jobs. Only twice as many pages as there are jobs are in flight
+/// at any time, the next page is submitted whenever a result is consumed, so that the results waiting to be consumed 
+/// do not grow with the size of the document. When a task or consumer fails, the remaining pages are skipped and the 
+/// first exception is rethrown.
+/// </summary>
+/// <param name="pageCount">The number of pages.</param>
+/// <param name="jobs">The number of pages to process in parallel.</param>
+/// <param name="task">The task to run for a page, it receives the page index and returns the result.</param>
+/// <param name="consume">The consumer, it receives the page index and the result of the task for that page.</param>
+template <typename TTask, typename TConsume>
+void for_each_page(size_t pageCount, uint32_t jobs, TTask task, TConsume consume) {
+    if (jobs <= 1) {
+        for (size_t pageIndex = 0; pageIndex < pageCount; ++pageIndex)
+            consume(pageIndex, task(pageIndex));
+
+        return;
+    }
+
+    using TResult = std::invoke_result_t<TTask&, size_t>;
+
+    std::atomic<bool> failed(false);
+    std::mutex errorMutex;
+    std::exception_ptr error;
+    std::deque<std::future<TResult>> results;
+    TiffConvert::WorkStealingPool pool((std::min)(static_cast<size_t>(jobs), pageCount));
+
+    auto window    = 2 * pool.GetThreadCount();
+    auto submitted = static_cast<size_t>(0);
+    auto submit    = [&]() {
+        auto pageIndex = submitted++;
+
+        results.push_back(pool.Enqueue([&failed, &errorMutex, &error, &task, pageIndex]() -> TResult {
+            if (failed)
+                throw std::runtime_error("page " + std::to_string(pageIndex) + " skipped");
+
+            try {
+                return task(pageIndex);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(errorMutex);
+                if (!error)
+                    error = std::current_exception();
+
+                failed = true;
+                throw;
             }
+        }));
+    };
+
+    try {
+        while (submitted < pageCount && submitted < window)
+            submit();
 
-            if (!image->ScaleToMaximum(static_cast<uint32_t>(pageIndex), maxwidth, maxheight, smooth))
-                throw std::runtime_error("page scaling failed for page " + std::to_string(pageIndex));
+        for (size_t pageIndex = 0; pageIndex < pageCount; ++pageIndex) {
+            auto result = results.front().get();
+            results.pop_front();
+
+            // Keep the workers busy with the next page while this one is consumed.
+            if (submitted < pageCount)
+                submit();
+
+            consume(pageIndex, std::move(result));
         }
+    } catch (...) {
+        // The pool runs the remaining tasks before it is destroyed, make them return right away. A page that is waited
+        // on may have been skipped because of a later page that failed, report the failure instead.
+        failed = true;
+
+        std::lock_guard<std::mutex> lock(errorMutex);
+        if (error)
+            std::rethrow_exception(error);
+
+        throw;
     }
+}
+
+/// <summary>
+/// Process the task at hand. Each page is decoded, prepared and encoded in one go, so that only the pages that are 
+/// being worked on are kept in memory. With --jobs, multiple pages are processed in parallel.
+/// </summary>
+/// <param name="cli">The main cli options object.</param>
+/// <param name="cli_image">The images subcommand cli options object.</param>
+/// <param name="cli_pdf">The pdf subcommand cli options object.</param>
+/// <param name="image">The decoded Tiff image.</param>
+/// <param name="file">The binary representation of the Tiff file.</param>
+/// <returns></returns>
+int process(const CliContainer& cli, const CliContainer& cli_image, const CliContainer& cli_pdf, TiffImage image, TiffFile file) {
+    auto& codec   = cli.get<std::string>(TiffConvert::Cli::NAME_OUTCODEC);
+    auto  verbose = cli.isset(TiffConvert::Cli::NAME_VERBOSE);
+    auto options  = static_cast<uint32_t>((codec.compare("jpeg") == 0 || codec.compare("jpeg2000") == 0) ? 10 : 0);
+
+    std::shared_ptr<TiffConvert::Cli::VerbosePrinter> printer = nullptr;
+
+    // Construct a verbose printer to use for this session
+    if (verbose)
+        printer = std::make_shared<TiffConvert::Cli::VerbosePrinter>(std::cout, std::wcout, true, "  ");
+
+    // Process pages in parallel, 0 jobs means one per processor core.
+    auto jobs = cli.get_isset_or<uint32_t>(TiffConvert::Cli::NAME_JOBS, 1);
+    if (jobs == 0)
+        jobs = (std::max)(1u, std::thread::hardware_concurrency());
+
+    // A single page at a time is encoded to PNG on every processor core, parallel pages are encoded on one thread each.
+    auto threads = (jobs == 1) ? (std::max)(1u, std::thread::hardware_concurrency()) : 1u;
+
+    // Held while the console is written to, so that the output of a page stays together.
+    std::mutex console;
+    auto lock_console = [&]() { return verbose ? std::unique_lock<std::mutex>(console) : std::unique_lock<std::mutex>(); };
+
+    // Pages that are processed in parallel log into a buffer of their own, which is printed in page order by the consumer,
+    // so that a page never holds the console while it is being processed. Only the console is logged to in color.
+    std::vector<std::string> logs((verbose && jobs > 1) ? file->GetPageCount() : 0);
 
-    // Pass 4: Export
+    auto log_page = [&](size_t pageIndex, const auto& work) {
+        if (logs.empty())
+            return work(printer);
+
+        std::ostringstream buffer;
+        TiffConvert::Cli::NarrowingStreamBuffer wideBuffer(buffer);
+        std::wostream wideStream(&wideBuffer);
+
+        auto result = work(std::make_shared<TiffConvert::Cli::VerbosePrinter>(buffer, wideStream, false, "  "));
+        logs[pageIndex] = buffer.str();
+        return result;
+    };
+
+    auto print_log = [&](size_t pageIndex) {
+        if (logs.empty() || logs[pageIndex].empty())
+            return;
+
+        auto lock = lock_console();
+        std::cout << logs[pageIndex];
+        std::string().swap(logs[pageIndex]);
+    };
+
+    // Stage 4: Encode and write
     if (cli.get_chosen_subcommand_name() == TiffConvert::Cli::NAME_SUBCOMMAND_IMAGE) {
         auto basepath = cli_image.get<std::string>(TiffConvert::Cli::NAME_OUTBASE);
         if (!parent_directory_exists(basepath))
             throw std::runtime_error("parent path does not exist: " + basepath);
 
-        for (size_t pageIndex = 0; pageIndex < file->GetPageCount(); ++pageIndex) {
-            auto target = path_from_base_index(basepath, pageIndex, codec_extension_map.at(codec));
+        for_each_page(file->GetPageCount(), jobs, [&](size_t pageIndex) {
+            return log_page(pageIndex, [&](std::shared_ptr<TiffConvert::Cli::VerbosePrinter> pagePrinter) {
+                auto target = path_from_base_index(basepath, pageIndex, codec_extension_map.at(codec));
 
-            if (verbose) {
-                printer->Section("EXPORT IMAGE", [&]() {
-                    printer->Number("PAGE", pageIndex);
-                    printer->Text("FILE", target);
-                });
-            }
+                // Large bilevel pages can be written in bands, without decoding the page as a whole. Like the other pages, 
+                // they are taken in the order of the page numbers, prepare_page maps it to the IFD chain index.
+                if (is_banded_page(cli, file, pageIndex)) {
+                    export_banded_page(cli, file, pageIndex, target, pagePrinter);
+                    return true;
+                }
+
+                auto page = prepare_page(cli, image, file, pageIndex, pagePrinter);
+
+                if (verbose) {
+                    pagePrinter->Section("EXPORT IMAGE", [&]() {
+                        pagePrinter->Number("PAGE", pageIndex);
+                        pagePrinter->Text("FILE", target);
+                    });
+                }
 
-            if (!image->ExportPage(static_cast<uint32_t>(pageIndex), target, codec_map.at(codec), options)) {
+                // The page is released when its handle goes out of scope, right after it has been written. PNG pages are 
+                // encoded natively, pages whose pixels cannot be encoded natively are encoded by libtiffconvert.
+                if (codec_map.at(codec) == tiff_export_format::TIFF_EXPORT_PNG && image->ExportPng(page->GetIndex(), target, threads))
+                    return true;
+
+                return image->ExportPage(page->GetIndex(), target, codec_map.at(codec), options);
+            });
+        }, [&](size_t pageIndex, bool stored) {
+            print_log(pageIndex);
+
+            if (!stored)
                 throw std::runtime_error("cannot store image");
-                return 1;
-            }
-        }
+        });
 
         if (verbose)
             printer->Section("EXPORT IMAGE", [&]() { printer->Boolean("DONE", true); });
@@ -249,10 +660,68 @@ int process(const CliContainer& cli, const CliContainer& cli_image, const CliCon
         if (verbose) 
             printer->Section("EXPORT PDF", [&]() { printer->Text("FILE", target); });
 
-        if (!image->ExportPdf(target, codec_map.at(codec), options)) {
+        TiffConvert::PdfDocument document(target, codec_map.at(codec), options, threads);
+
+        // Pages are encoded in parallel, but written to the document in page order as soon as they are encoded. Pages 
+        // that are copied as they are have nothing to encode, they are copied while they are written. Only the regions 
+        // that are burned onto copied pages are rendered and compressed in parallel. The page index is the order of the 
+        // page numbers, prepare_page maps it to the IFD chain index the decoded image knows the page by.
+        for_each_page(file->GetPageCount(), jobs, [&](size_t pageIndex) -> PreparedPdfPage {
+            return log_page(pageIndex, [&](std::shared_ptr<TiffConvert::Cli::VerbosePrinter> pagePrinter) -> PreparedPdfPage {
+                if (is_copied_page(cli, file, pageIndex)) {
+                    if (!is_mrc_page(cli, file, pageIndex))
+                        return std::vector<TiffConvert::PdfEncodedRegion>();
+
+                    // The regions are compressed here as well, so that the consumer only has to write them.
+                    return document.EncodeRegions(render_mrc_regions(file, pageIndex, pagePrinter), cli.isset(TiffConvert::Cli::NAME_INVERT));
+                }
+
+                auto page = prepare_page(cli, image, file, pageIndex, pagePrinter);
+
+                // The page is released when its handle goes out of scope, right after it has been encoded.
+                return document.EncodePage(*image, page->GetIndex());
+            });
+        }, [&](size_t pageIndex, const PreparedPdfPage& page) {
+            print_log(pageIndex);
+
+            // Vector marks are placed on the page as it is stored and drawn over the page image in the document.
+            TiffConvert::PdfMarks marks;
+            if (is_vector_wang(cli)) {
+                marks.List     = DisplayList::Compile(*file, pageIndex);
+                marks.Width    = file->GetDimensions(pageIndex).Width;
+                marks.Height   = file->GetDimensions(pageIndex).Height;
+                marks.Inverted = cli.isset(TiffConvert::Cli::NAME_INVERT);
+
+                if (verbose && !marks.List->IsEmpty()) {
+                    auto lock = lock_console();
+                    printer->BeginSection("VECTOR WANG");
+                    printer->Number("PAGE", pageIndex);
+
+                    VerboseHandler handler(printer);
+                    marks.List->Replay(handler);
+                    printer->EndSection();
+                }
+            }
+
+            if (auto regions = std::get_if<std::vector<TiffConvert::PdfEncodedRegion>>(&page)) {
+                if (verbose) {
+                    auto lock = lock_console();
+                    printer->Section("COPY", [&]() {
+                        printer->Number("PAGE", pageIndex);
+                        printer->Number("IFD", file->GetPageIfdChainIndex(pageIndex));
+                        printer->Boolean("INVERT", cli.isset(TiffConvert::Cli::NAME_INVERT));
+                    });
+                }
+
+                if (!document.CopyPage(*file, pageIndex, cli.isset(TiffConvert::Cli::NAME_INVERT), marks, *regions))
+                    throw std::runtime_error("cannot store pdf");
+            } else if (!document.AddEncodedPage(std::get<TiffConvert::PdfEncodedPage>(page), marks)) {
+                throw std::runtime_error("cannot store pdf");
+            }
+        });
+
+        if (!document.Close())
             throw std::runtime_error("cannot store pdf");
-            return 1;
-        }
 
         if (verbose) 
             printer->Section("EXPORT PDF", [&]() { printer->Boolean("DONE", true); });
@@ -287,6 +756,14 @@ int main(int argc, char* argv[]) {
     cli.add_option<uint32_t>(TiffConvert::Cli::DESC_MAXWIDTH);
     cli.add_option<uint32_t>(TiffConvert::Cli::DESC_MAXHEIGHT);
     cli.add_flag(TiffConvert::Cli::DESC_SCALESMOOTH);
+    cli.add_option<std::string>(
+        TiffConvert::Cli::DESC_SCALEFILTER.Name,
+        TiffConvert::Cli::DESC_SCALEFILTER.Flag,
+        TiffConvert::Cli::DESC_SCALEFILTER.Desc + TiffConvert::Cli::ScaleFilterValidator::ValidString)->check(TiffConvert::Cli::ScaleFilterValidator::Validator);
+    cli.add_option<uint32_t>(TiffConvert::Cli::DESC_JOBS);
+    cli.add_flag(TiffConvert::Cli::DESC_BANDED);
+    cli.add_flag(TiffConvert::Cli::DESC_VECTORWANG);
+    cli.add_flag(TiffConvert::Cli::DESC_MRC);
     cli.add_option<std::string>(TiffConvert::Cli::DESC_TIFFILE)->required(true)->check(CLI::ExistingFile);
 
     // images command
@@ -309,25 +786,31 @@ int main(int argc, char* argv[]) {
     const std::string& path = cli.get<std::string>(TiffConvert::Cli::NAME_TIFFILE);
 
     try {
-        // try decoding the image and loading the file in binary form.
-        image = std::make_shared<TiffConvert::TiffImage>(path);
-        file  = std::make_shared<TiffWang::Tiff::TiffFile>(path);
+        // map the input once, both the image decoder and the binary parser work on the same memory.
+        auto input = std::make_shared<TiffWang::Tiff::MappedFile>(path);
+        auto data  = input->GetView();
 
-        // try reading the IFD collection, effectively reading the description of each Tiff page.
+        // try loading the file in binary form and reading the IFD collection, effectively reading the description of each Tiff page.
+        file = std::make_shared<TiffWang::Tiff::TiffFile>(data, input);
         file->ReadIfdCollection();
+
+        // try decoding the image, bilevel CCITT pages are decoded natively from the parsed file. libtiffconvert only reads
+        // classic Tiff files of at most 4 GB, the pages of other files can only be converted in bands or copied into a PDF.
+        if (!file->IsBigTiff() && data.Size() <= UINT32_MAX)
+            image = std::make_shared<TiffConvert::TiffImage>(data.Data(), static_cast<uint32_t>(data.Size()), input, file);
     } catch (const std::exception& ex) {
         std::cout << "error: " << ex.what() << std::endl;
         return 1;
     }
 
     // No pages? Abort.
-    if (image->GetPageCount() == 0) {
+    if (file->GetPageCount() == 0) {
         std::cout << "error: cannot find any images in specified tiff file" << std::endl;
         return 1;
     }
 
     // Page count from binary processing does not match the page count from the decoded image? Abort.
-    if (static_cast<size_t>(image->GetPageCount()) != file->GetPageCount()) {
+    if (image && static_cast<size_t>(image->GetPageCount()) != file->GetPageCount()) {
         std::cout << "error: libtiffconvert reported a different page count than libtiffwang, cannot proceed" << std::endl;
         return 1;
     }